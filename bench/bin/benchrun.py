@@ -12,6 +12,9 @@ Usage:
   # YCSB with profile
   python3 bench/bin/benchrun.py ycsb --profile a --terminals 8 --scalefactor 100
 
+  # Concurrency control protocols x terminal counts (throughput / abort-rate tables)
+  python3 bench/bin/benchrun.py tpcc --cc silo,silo_nwr,2pl --sweep 1,16,64
+
 Prerequisites:
   - BenchBase patched and built (bench/bin/patch_benchbase.py)
 
@@ -41,6 +44,9 @@ ROOT = Path(__file__).resolve().parents[2]
 BENCHBASE_DIR = ROOT / "third_party" / "benchbase" / "benchbase-mysql"
 MYSQL_BIN = ROOT / "build" / "runtime_output_directory" / "mysql"
 
+# engine.cc_protocol values lineairdb-server accepts
+CC_PROTOCOLS = ["silo", "silo_nwr", "2pl"]
+
 YCSB_PROFILES = {
     "a": "50,0,0,50,0,0",
     "b": "95,0,0,5,0,0",
@@ -95,13 +101,13 @@ def _run_script(argv, timeout):
         return None
 
 
-def start_lineairdb_server():
+def start_lineairdb_server(server_args=()):
     """Start lineairdb-server via scripts/start_server.sh and wait for port 9999."""
     if _is_port_open("127.0.0.1", 9999):
         print("  lineairdb-server already running on port 9999, reusing")
         return True
-    print("  Starting lineairdb-server...")
-    result = _run_script([str(SCRIPTS_DIR / "start_server.sh")], timeout=30)
+    print(f"  Starting lineairdb-server {' '.join(server_args)}...")
+    result = _run_script([str(SCRIPTS_DIR / "start_server.sh"), *server_args], timeout=30)
     if result is None or result.returncode != 0:
         if result is not None:
             print(f"  ERROR starting lineairdb-server:\n{result.stdout}", file=sys.stderr)
@@ -613,8 +619,23 @@ def main():
     parser.add_argument("--no-exec", action="store_true", help="Run setup only, skip execute phase")
     parser.add_argument("--external-server", action="store_true",
                         help="Skip auto start/stop of lineairdb-server and mysqld (assume already running)")
+    parser.add_argument("--cc", type=str,
+                        help=f"Comma-separated concurrency control protocols to sweep ({','.join(CC_PROTOCOLS)}); "
+                             "restarts the servers and reloads the data for each")
     args = parser.parse_args()
 
+    cc_list = []
+    if args.cc:
+        cc_list = [c.strip() for c in args.cc.split(",") if c.strip()]
+        unknown = [c for c in cc_list if c not in CC_PROTOCOLS]
+        if unknown:
+            print(f"ERROR: Unknown CC protocol(s) {unknown}. Options: {CC_PROTOCOLS}", file=sys.stderr)
+            sys.exit(1)
+        if args.external_server or args.no_setup or args.no_exec:
+            print("ERROR: --cc restarts the servers per protocol; it cannot be combined with "
+                  "--external-server, --no-setup or --no-exec", file=sys.stderr)
+            sys.exit(1)
+
     # Validate
     jar = BENCHBASE_DIR / "benchbase.jar"
     if not jar.exists():
@@ -694,6 +715,8 @@ def main():
 
     print(f"Benchmark: {args.benchmark.upper()}")
     print(f"Threads:   {thread_list}")
+    if cc_list:
+        print(f"CC:        {cc_list}")
     print(f"SF={args.scalefactor}, Time={args.time}s, MySQL={args.mysql_host}:{args.mysql_port}")
     print(f"Results:   {result_base}")
 
@@ -709,6 +732,13 @@ def main():
         print(f"  mysqld already listening on port {args.mysql_port}, switching to external mode")
         managed = False
 
+    if cc_list:
+        if not managed:
+            print("ERROR: --cc needs to start the servers itself; stop the running mysqld first", file=sys.stderr)
+            sys.exit(1)
+        _run_cc_matrix(args, config_work, thread_list, result_base, cc_list)
+        return
+
     if managed:
         if not start_lineairdb_server():
             sys.exit(1)
@@ -747,7 +777,7 @@ def _run_bench(args, config_work, thread_list, result_base):
 
     if args.no_exec:
         print("  Skipping execute (--no-exec)")
-        return
+        return []
 
     # Execute: sweep terminal counts (data is reused)
     all_results = []
@@ -810,6 +840,89 @@ def _run_bench(args, config_work, thread_list, result_base):
         except ImportError:
             pass
 
+    return all_results
+
+
+def _abort_rate(r):
+    """Server retries as a fraction of all attempted transactions."""
+    retry = r.get("server_retry", 0)
+    attempted = r.get("requests", 0) + retry
+    return retry / attempted if attempted else 0.0
+
+
+def _run_cc_matrix(args, config_work, thread_list, result_base, cc_list):
+    """Run the terminal sweep once per CC protocol and tabulate the results.
+
+    The engine is in-memory, so each protocol gets a fresh lineairdb-server
+    and mysqld and its own load; results go under <result_base>/<protocol>/.
+    """
+    matrix = {}
+    for cc in cc_list:
+        print(f"\n{'#'*60}\n  CC protocol: {cc}\n{'#'*60}")
+        if not start_lineairdb_server([f"--engine.cc_protocol={cc}"]):
+            sys.exit(1)
+        try:
+            if not start_mysql_server(args.mysql_port, "127.0.0.1", 9999):
+                sys.exit(1)
+            cc_base = result_base / cc
+            cc_base.mkdir(parents=True, exist_ok=True)
+            matrix[cc] = {r["terminals"]: r for r in _run_bench(args, config_work, thread_list, cc_base)}
+        finally:
+            stop_all_servers()
+
+    def table(title, cell):
+        print(f"\n{title}")
+        print(f"{'CC':>10}" + "".join(f"{t:>12}" for t in thread_list))
+        print(f"{'-'*10:>10}" + "".join(f"{'-'*12:>12}" for _ in thread_list))
+        for cc in cc_list:
+            row = matrix.get(cc, {})
+            print(f"{cc:>10}" + "".join(f"{cell(row[t]) if t in row else '-':>12}" for t in thread_list))
+
+    print(f"\n{'='*60}")
+    print(f"  CC MATRIX: {args.benchmark.upper()} SF={args.scalefactor}")
+    print(f"{'='*60}")
+    table("Throughput (req/s) by terminals", lambda r: f"{r.get('throughput', 0):.1f}")
+    table("Goodput (req/s) by terminals", lambda r: f"{r.get('goodput', 0):.1f}")
+    table("Abort rate (server retries / attempts) by terminals", lambda r: f"{_abort_rate(r) * 100:.2f}%")
+
+    csv_path = result_base / "cc_matrix.csv"
+    with open(csv_path, "w") as f:
+        f.write("cc,terminals,throughput,goodput,server_retry,abort_rate,unexpected_errors\n")
+        for cc in cc_list:
+            for t in thread_list:
+                r = matrix.get(cc, {}).get(t)
+                if r:
+                    f.write(f"{cc},{t},{r.get('throughput',0):.1f},{r.get('goodput',0):.1f},{r.get('server_retry',0)},{_abort_rate(r):.4f},{r.get('unexpected_errors',0)}\n")
+    print(f"\nMatrix saved: {csv_path}")
+
+    if len(thread_list) > 1:
+        try:
+            import matplotlib
+            matplotlib.use("Agg")
+            import matplotlib.pyplot as plt
+
+            plot_dir = result_base / "_plot"
+            plot_dir.mkdir(parents=True, exist_ok=True)
+            fig, (ax_tp, ax_ab) = plt.subplots(1, 2, figsize=(14, 6))
+            for cc in cc_list:
+                row = matrix.get(cc, {})
+                ts = [t for t in thread_list if t in row]
+                ax_tp.plot(ts, [row[t].get("throughput", 0) for t in ts], "-o", label=cc, linewidth=2)
+                ax_ab.plot(ts, [_abort_rate(row[t]) * 100 for t in ts], "-o", label=cc, linewidth=2)
+            ax_tp.set_ylabel("req/s")
+            ax_ab.set_ylabel("abort rate (%)")
+            for ax in (ax_tp, ax_ab):
+                ax.set_xlabel("Terminals")
+                ax.legend()
+                ax.grid(True, alpha=0.3)
+            fig.suptitle(f"{args.benchmark.upper()} SF={args.scalefactor} by CC protocol")
+            plt.tight_layout()
+            plt.savefig(plot_dir / "cc_matrix.png", dpi=150)
+            plt.close()
+            print(f"Plot saved: {plot_dir / 'cc_matrix.png'}")
+        except ImportError:
+            pass
+
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""
+Ordo restart benchmark — how long lineairdb-server takes to come back with
+its data: reloading through MySQL vs loading a checkpoint.
+
+Usage:
+  # TPC-C at SF 10 and 100
+  python3 bench/bin/restartbench.py tpcc --scalefactors 10,100
+
+  # TPC-H, checkpoints on an NVMe file system, 16 loader threads in BenchBase
+  python3 bench/bin/restartbench.py tpch --scalefactors 10,100 \
+      --checkpoint-dir /mnt/nvme/ordo-ckpt --loader-threads 16
+
+For each scale factor it starts lineairdb-server with --checkpoint-dir and
+mysqld, loads the benchmark through BenchBase (what a restart costs without
+checkpoints), takes a checkpoint with SIGUSR1, stops both servers and starts
+them again. Restart-to-ready is the wall time until port 9999 accepts
+connections; the server's own "Time to ready" line splits it into engine
+start and checkpoint load. A row count of the largest table before and after
+the restart checks that the data came back.
+
+Prerequisites:
+  - lineairdb-server and mysqld built (bash scripts/build.sh)
+  - BenchBase patched (python3 bench/bin/patch_benchbase.py)
+"""
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+import time
+from datetime import datetime
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+from benchrun import (  # noqa: E402
+    BENCHBASE_DIR,
+    ROOT,
+    SCRIPTS_DIR,
+    _is_port_open,
+    _run_script,
+    _wait_for_port,
+    mysql_cmd,
+    setup_benchmark,
+    start_mysql_server,
+    stop_all_servers,
+    update_xml,
+)
+
+LOG_DIR = ROOT / "lineairdb_logs"
+PID_FILE = Path("/tmp/lineairdb_server.pid")
+
+# The table whose row count is compared across the restart
+COUNT_TABLES = {"tpcc": "order_line", "tpch": "lineitem", "ycsb": "usertable"}
+
+CHECKPOINT_RE = re.compile(
+    r"Checkpoint (ckpt-\d+): .*? \(([\d.]+) MiB\) in ([\d.]+) ms")
+CHECKPOINT_FAILED_RE = re.compile(r"Checkpoint (?:ckpt-\d+ (?:aborted|failed|could not)|skipped)")
+LOADED_RE = re.compile(
+    r"Loaded checkpoint .*? \(([\d.]+) MiB\) with (\d+) threads in ([\d.]+) ms")
+READY_RE = re.compile(r"Time to ready: ([\d.]+) ms")
+
+
+def _server_log(started_after):
+    """Newest lineairdb-server log created at or after started_after."""
+    logs = [p for p in LOG_DIR.glob("lineairdb_server_*.log")
+            if p.stat().st_mtime >= started_after - 1]
+    return max(logs, key=lambda p: p.stat().st_mtime) if logs else None
+
+
+def _start_server(ckpt_dir, ready_timeout):
+    """Start lineairdb-server on ckpt_dir. Returns (seconds to ready, log path)."""
+    if _is_port_open("127.0.0.1", 9999):
+        print("ERROR: something is already listening on port 9999; "
+              "run scripts/stop_server.sh first", file=sys.stderr)
+        return None, None
+    args = [f"--checkpoint-dir={ckpt_dir}", "--checkpoint.period_s=0"]
+    print(f"  Starting lineairdb-server {' '.join(args)}...")
+    start = time.time()
+    result = _run_script([str(SCRIPTS_DIR / "start_server.sh"), *args], timeout=30)
+    if result is None or result.returncode != 0:
+        if result is not None:
+            print(f"  ERROR starting lineairdb-server:\n{result.stdout}", file=sys.stderr)
+        return None, None
+    if not _wait_for_port("127.0.0.1", 9999, timeout=ready_timeout):
+        print(f"  ERROR: lineairdb-server did not become ready within {ready_timeout}s",
+              file=sys.stderr)
+        return None, None
+    ready_s = time.time() - start
+    print(f"  lineairdb-server ready in {ready_s:.1f}s")
+    return ready_s, _server_log(start)
+
+
+def _take_checkpoint(log, timeout):
+    """SIGUSR1 the server and wait for its checkpoint line.
+
+    Returns (name, MiB, seconds) or None. An aborted attempt is requested
+    again until timeout.
+    """
+    seen = len(log.read_text(errors="replace").splitlines())
+    deadline = time.time() + timeout
+    subprocess.run(["kill", "-USR1", PID_FILE.read_text().strip()], check=True)
+    while time.time() < deadline:
+        time.sleep(1)
+        new = log.read_text(errors="replace").splitlines()[seen:]
+        seen += len(new)
+        for line in new:
+            m = CHECKPOINT_RE.search(line)
+            if m:
+                return m.group(1), float(m.group(2)), float(m.group(3)) / 1000
+            if CHECKPOINT_FAILED_RE.search(line):
+                print("  checkpoint did not complete, requesting another")
+                subprocess.run(["kill", "-USR1", PID_FILE.read_text().strip()], check=True)
+    print(f"  ERROR: no checkpoint within {timeout}s", file=sys.stderr)
+    return None
+
+
+def _count_rows(args, table):
+    result = mysql_cmd(args.mysql_port, "127.0.0.1",
+                       f"SELECT COUNT(*) FROM benchbase.{table}")
+    m = re.search(r"(\d+)\s*$", result.stdout)
+    return int(m.group(1)) if m else None
+
+
+def _prepare_config(args, scalefactor):
+    config_src = ROOT / "bench" / "config" / f"{args.benchmark}.xml"
+    config_dir = ROOT / "bench" / "config" / "generated"
+    config_dir.mkdir(parents=True, exist_ok=True)
+    config_work = config_dir / f"{args.benchmark}.restart.xml"
+    shutil.copy2(config_src, config_work)
+    update_xml(config_work, scalefactor=str(scalefactor))
+    text = config_work.read_text()
+    text = re.sub(r"jdbc:mysql://[^/]+/", f"jdbc:mysql://127.0.0.1:{args.mysql_port}/", text)
+    if args.loader_threads > 1:
+        if "<loaderThreads>" in text:
+            text = re.sub(r"<loaderThreads>.*?</loaderThreads>",
+                          f"<loaderThreads>{args.loader_threads}</loaderThreads>", text)
+        else:
+            text = text.replace("</parameters>",
+                                f"    <loaderThreads>{args.loader_threads}</loaderThreads>\n</parameters>")
+    config_work.write_text(text)
+    return config_work
+
+
+def _run_one(args, scalefactor, ckpt_dir):
+    """Load, checkpoint and restart at one scale factor. Returns a result row."""
+    row = {"benchmark": args.benchmark, "sf": scalefactor}
+    shutil.rmtree(ckpt_dir, ignore_errors=True)
+    config_work = _prepare_config(args, scalefactor)
+    table = COUNT_TABLES[args.benchmark]
+
+    print(f"\n{'=' * 60}\n {args.benchmark.upper()} SF={scalefactor}\n{'=' * 60}")
+    try:
+        _, log = _start_server(ckpt_dir, args.ready_timeout)
+        if log is None or not start_mysql_server(args.mysql_port, "127.0.0.1", 9999):
+            return None
+        row["reload_s"] = setup_benchmark(args.benchmark, config_work, "127.0.0.1", args.mysql_port)
+        if row["reload_s"] is None:
+            return None
+        rows_before = None if args.no_verify else _count_rows(args, table)
+
+        print("  Taking a checkpoint (SIGUSR1)...")
+        ckpt = _take_checkpoint(log, args.checkpoint_timeout)
+        if ckpt is None:
+            return None
+        name, row["ckpt_mib"], row["ckpt_s"] = ckpt
+        print(f"  {name}: {row['ckpt_mib']:.1f} MiB in {row['ckpt_s']:.1f}s")
+        stop_all_servers()
+
+        row["restart_s"], log = _start_server(ckpt_dir, args.ready_timeout)
+        if row["restart_s"] is None:
+            return None
+        text = log.read_text(errors="replace") if log else ""
+        m = LOADED_RE.search(text)
+        if m:
+            row["load_threads"] = int(m.group(2))
+            row["ckpt_load_s"] = float(m.group(3)) / 1000
+        m = READY_RE.search(text)
+        if m:
+            row["server_ready_s"] = float(m.group(1)) / 1000
+
+        if not args.no_verify:
+            if not start_mysql_server(args.mysql_port, "127.0.0.1", 9999):
+                return None
+            rows_after = _count_rows(args, table)
+            row["rows_ok"] = rows_before is not None and rows_before == rows_after
+            print(f"  {table}: {rows_before} rows before, {rows_after} after restart")
+        return row
+    finally:
+        stop_all_servers()
+
+
+def _fmt(value, spec):
+    return format(value, spec) if value is not None else "-"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="lineairdb-server restart-to-ready benchmark")
+    parser.add_argument("benchmark", choices=sorted(COUNT_TABLES), help="Benchmark to load")
+    parser.add_argument("--scalefactors", default="10,100",
+                        help="Comma-separated scale factors (default: 10,100)")
+    parser.add_argument("--checkpoint-dir", default=str(ROOT / "restartbench-ckpt"),
+                        help="Checkpoint directory; emptied per scale factor")
+    parser.add_argument("--loader-threads", type=int, default=1,
+                        help="BenchBase loader threads (default: 1)")
+    parser.add_argument("--mysql-port", type=int, default=3307)
+    parser.add_argument("--ready-timeout", type=int, default=3600,
+                        help="Seconds to wait for the server to accept connections (default: 3600)")
+    parser.add_argument("--checkpoint-timeout", type=int, default=3600,
+                        help="Seconds to wait for a checkpoint (default: 3600)")
+    parser.add_argument("--no-verify", action="store_true",
+                        help="Skip the row count before and after the restart")
+    args = parser.parse_args()
+
+    jar = BENCHBASE_DIR / "benchbase.jar"
+    if not jar.exists():
+        print(f"ERROR: {jar} not found.\nRun: python3 bench/bin/patch_benchbase.py", file=sys.stderr)
+        sys.exit(1)
+    if _is_port_open("127.0.0.1", args.mysql_port) or _is_port_open("127.0.0.1", 9999):
+        print("ERROR: restartbench starts and stops the servers itself; stop the running ones first",
+              file=sys.stderr)
+        sys.exit(1)
+
+    scalefactors = [float(s) if "." in s else int(s)
+                    for s in (x.strip() for x in args.scalefactors.split(",")) if s]
+    now = datetime.now().strftime("%Y-%m-%d_%H%M%S")
+    result_base = ROOT / "bench" / "results" / now / f"RESTART_{args.benchmark.upper()}"
+    result_base.mkdir(parents=True, exist_ok=True)
+
+    rows = []
+    for sf in scalefactors:
+        row = _run_one(args, sf, Path(args.checkpoint_dir))
+        if row is None:
+            print(f"  SF={sf} failed, skipping", file=sys.stderr)
+            continue
+        rows.append(row)
+
+    header = (f"{'bench':>6} {'SF':>6} {'reload s':>9} {'ckpt MiB':>9} {'ckpt s':>7} "
+              f"{'restart s':>10} {'load s':>7} {'threads':>8} {'rows':>5}")
+    lines = [header]
+    for r in rows:
+        ok = {True: "ok", False: "DIFF"}.get(r.get("rows_ok"), "-")
+        lines.append(
+            f"{r['benchmark']:>6} {r['sf']:>6} {_fmt(r.get('reload_s'), '9.1f')} "
+            f"{_fmt(r.get('ckpt_mib'), '9.1f')} {_fmt(r.get('ckpt_s'), '7.1f')} "
+            f"{_fmt(r.get('restart_s'), '10.1f')} {_fmt(r.get('ckpt_load_s'), '7.1f')} "
+            f"{_fmt(r.get('load_threads'), '8d')} {ok:>5}")
+    print("\n" + "\n".join(lines))
+
+    with open(result_base / "restart.csv", "w") as f:
+        f.write("benchmark,sf,reload_s,ckpt_mib,ckpt_s,restart_s,server_ready_s,ckpt_load_s,"
+                "load_threads,rows_ok\n")
+        for r in rows:
+            f.write(",".join(str(r.get(k, "")) for k in
+                             ("benchmark", "sf", "reload_s", "ckpt_mib", "ckpt_s", "restart_s",
+                              "server_ready_s", "ckpt_load_s", "load_threads", "rows_ok")) + "\n")
+    print(f"\nResults: {result_base / 'restart.csv'}")
+
+
+if __name__ == "__main__":
+    main()
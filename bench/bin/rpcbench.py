@@ -0,0 +1,577 @@
+#!/usr/bin/env python3
+"""
+Ordo RPC microbenchmarks — drive lineairdb-server directly (no MySQL).
+
+Usage:
+  # Thread-per-connection vs epoll reactor at 64/256/1024 connections
+  python3 bench/bin/rpcbench.py io-model
+
+  # Custom sweep, including the io_uring transport (point reads, YCSB-C style)
+  python3 bench/bin/rpcbench.py io-model --models thread,reactor,io_uring \
+      --connections 64,256 --op read --duration 20
+
+  # TCP loopback vs shared-memory ring latency for TX_READ / TX_BATCH_READ
+  python3 bench/bin/rpcbench.py transport
+
+  # Protobuf vs fixed-layout binary encoding of TX_READ / TX_WRITE, table names vs handles
+  python3 bench/bin/rpcbench.py encoding
+
+  # One unpinned listener vs 1/2/4 pinned SO_REUSEPORT listener groups
+  python3 bench/bin/rpcbench.py listeners --groups 1,2,4 --model reactor
+
+  # BEGIN/END response size and latency with 10/100/1000 tables of row counts,
+  # every table's count vs only the changed ones
+  python3 bench/bin/rpcbench.py stats --tables 10,100,1000
+
+  # Scan response size with plain vs front-coded keys (protocol version 3 vs 4),
+  # for TPC-C ORDER_LINE and TPC-H LINEITEM shaped primary keys
+  python3 bench/bin/rpcbench.py scan-keys --rows 200
+
+  # YCSB-A (50% reads, 50% updates, Zipfian keys) with the server confined to
+  # 1..64 cores, one LineairDB engine thread per core
+  python3 bench/bin/rpcbench.py cores --cores 1,2,4,8,16,32,64
+
+  # Commit latency and throughput in-memory vs with the write-ahead log on an
+  # NVMe file system and on tmpfs, with and without fenced commits
+  python3 bench/bin/rpcbench.py durability --log-dirs nvme=/mnt/nvme,tmpfs=/dev/shm
+
+Prerequisites:
+  - lineairdb-server and lineairdb-rpc-bench built (bash scripts/build.sh)
+
+Each configuration restarts lineairdb-server via scripts/start_server.sh with
+the matching flags, runs build/server/lineairdb-rpc-bench against it and
+stops it again, so runs never share server state.
+"""
+
+import argparse
+import os
+import re
+import shutil
+import socket
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[2]
+SCRIPTS_DIR = ROOT / "scripts"
+RPC_BENCH_BIN = ROOT / "build" / "server" / "lineairdb-rpc-bench"
+SERVER_PID_FILE = Path("/tmp/lineairdb_server.pid")
+SERVER_PORT = 9999
+SHM_SOCKET = "/tmp/lineairdb_shm.sock"
+
+
+def _is_port_open(host, port, timeout=1.0):
+    try:
+        with socket.create_connection((host, port), timeout=timeout):
+            return True
+    except (ConnectionRefusedError, socket.timeout, OSError):
+        return False
+
+
+def start_server(server_args, cpus=None):
+    """Start lineairdb-server with extra flags and return its PID.
+
+    cpus: taskset -c list to confine the server to (default: unconfined).
+    """
+    stop_server()
+    env = dict(os.environ)
+    if cpus:
+        env["LINEAIRDB_SERVER_CPUS"] = cpus
+    result = subprocess.run(
+        [str(SCRIPTS_DIR / "start_server.sh"), *server_args],
+        stdin=subprocess.DEVNULL, capture_output=True, text=True, timeout=30, env=env,
+    )
+    if result.returncode != 0:
+        print(f"  ERROR starting lineairdb-server:\n{result.stdout}{result.stderr}", file=sys.stderr)
+        return None
+    deadline = time.time() + 30
+    while time.time() < deadline:
+        if _is_port_open("127.0.0.1", SERVER_PORT):
+            return int(SERVER_PID_FILE.read_text().strip())
+        time.sleep(0.2)
+    print("  ERROR: lineairdb-server did not become ready within 30s", file=sys.stderr)
+    return None
+
+
+def stop_server():
+    subprocess.run([str(SCRIPTS_DIR / "stop_server.sh")], capture_output=True)
+    while _is_port_open("127.0.0.1", SERVER_PORT, timeout=0.2):
+        time.sleep(0.2)
+    SERVER_PID_FILE.unlink(missing_ok=True)
+
+
+def run_rpc_bench(bench_args, server_pid, cpus=None):
+    """Run lineairdb-rpc-bench and parse its summary lines into a dict.
+
+    cpus: taskset -c list to confine the client to (default: unconfined).
+    """
+    cmd = [str(RPC_BENCH_BIN), *bench_args, "--server-pid", str(server_pid)]
+    if cpus:
+        cmd = ["taskset", "-c", cpus, *cmd]
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    if result.returncode not in (0, 2):
+        print(f"  ERROR: {' '.join(cmd)}\n{result.stdout}{result.stderr}", file=sys.stderr)
+        return None
+    out = result.stdout
+    parsed = {}
+    for key in ("throughput", "p50", "p99", "p999", "server_threads", "errors",
+                "begin_end_response_bytes", "response_bytes", "rows", "tx_throughput"):
+        m = re.search(rf"\b{key}=([\d.]+)", out)
+        parsed[key] = float(m.group(1)) if m else None
+    m = re.search(r"commit_latency_us p50=([\d.]+) p99=([\d.]+)", out)
+    parsed["commit_p50"] = float(m.group(1)) if m else None
+    parsed["commit_p99"] = float(m.group(2)) if m else None
+    return parsed
+
+
+def print_table(header, rows):
+    widths = [max(len(str(r[i])) for r in [header, *rows]) for i in range(len(header))]
+    fmt = "  ".join(f"{{:>{w}}}" for w in widths)
+    print(fmt.format(*header))
+    print(fmt.format(*("-" * w for w in widths)))
+    for row in rows:
+        print(fmt.format(*row))
+
+
+def cmd_io_model(args):
+    models = []
+    for name in args.models:
+        server_args = [f"--io-model={name}"]
+        if name != "thread" and args.io_workers:
+            server_args.append(f"--io-workers={args.io_workers}")
+        models.append((name, server_args))
+
+    rows = []
+    for conns in args.connections:
+        for name, server_args in models:
+            print(f"==> {name}, {conns} connections")
+            pid = start_server(server_args)
+            if pid is None:
+                return 1
+            try:
+                res = run_rpc_bench(
+                    ["--connections", str(conns), "--duration", str(args.duration), "--op", args.op],
+                    pid,
+                )
+            finally:
+                stop_server()
+            if res is None:
+                return 1
+            rows.append((
+                name, conns,
+                int(res["server_threads"] or 0),
+                f"{res['throughput']:.0f}",
+                f"{res['p50']:.0f}", f"{res['p99']:.0f}", f"{res['p999']:.0f}",
+                int(res["errors"] or 0),
+            ))
+
+    print()
+    print_table(
+        ("model", "conns", "srv_threads", "rpc/s", "p50_us", "p99_us", "p999_us", "errors"),
+        rows,
+    )
+    return 0
+
+
+def cmd_transport(args):
+    # One server serves both transports, so both see the same preloaded table
+    pid = start_server([f"--shm-socket={SHM_SOCKET}"])
+    if pid is None:
+        return 1
+    rows = []
+    try:
+        for op in args.ops:
+            for transport in args.transports:
+                print(f"==> {op} over {transport}")
+                res = run_rpc_bench(
+                    ["--connections", str(args.connections), "--duration", str(args.duration),
+                     "--op", op, "--batch-size", str(args.batch_size),
+                     "--value-size", str(args.value_size),
+                     "--transport", transport, "--shm-socket", SHM_SOCKET],
+                    pid,
+                )
+                if res is None:
+                    return 1
+                rows.append((
+                    op, transport, args.connections,
+                    f"{res['throughput']:.0f}",
+                    f"{res['p50']:.0f}", f"{res['p99']:.0f}", f"{res['p999']:.0f}",
+                    int(res["errors"] or 0),
+                ))
+    finally:
+        stop_server()
+
+    print()
+    print_table(
+        ("op", "transport", "conns", "rpc/s", "p50_us", "p99_us", "p999_us", "errors"),
+        rows,
+    )
+    return 0
+
+
+def cmd_encoding(args):
+    pid = start_server([])
+    if pid is None:
+        return 1
+    rows = []
+    try:
+        for op in args.ops:
+            for encoding in ("protobuf", "binary"):
+                for table in ("name", "handle"):
+                    print(f"==> {op}, {encoding}, table by {table}")
+                    bench_args = ["--connections", str(args.connections),
+                                  "--duration", str(args.duration), "--op", op,
+                                  "--value-size", str(args.value_size), "--encoding", encoding,
+                                  "--batch-size", str(args.batch_size), "--table", args.table]
+                    if table == "handle":
+                        bench_args.append("--table-handles")
+                    res = run_rpc_bench(bench_args, pid)
+                    if res is None:
+                        return 1
+                    rows.append((
+                        op, encoding, table, args.connections,
+                        f"{res['throughput']:.0f}",
+                        f"{res['p50']:.0f}", f"{res['p99']:.0f}", f"{res['p999']:.0f}",
+                        int(res["errors"] or 0),
+                    ))
+    finally:
+        stop_server()
+
+    print()
+    print_table(
+        ("op", "encoding", "table", "conns", "rpc/s", "p50_us", "p99_us", "p999_us", "errors"),
+        rows,
+    )
+    return 0
+
+
+def cmd_listeners(args):
+    # "single" is the default unpinned listener, the baseline for the groups
+    configs = [("single", [])] + [(str(g), [f"--listeners={g}"]) for g in args.groups]
+    rows = []
+    for conns in args.connections:
+        for name, listener_args in configs:
+            server_args = [f"--io-model={args.model}", *listener_args]
+            if args.model != "thread" and args.io_workers:
+                server_args.append(f"--io-workers={args.io_workers}")
+            print(f"==> listeners={name}, {args.model}, {conns} connections")
+            pid = start_server(server_args)
+            if pid is None:
+                return 1
+            try:
+                res = run_rpc_bench(
+                    ["--connections", str(conns), "--duration", str(args.duration), "--op", args.op],
+                    pid,
+                )
+            finally:
+                stop_server()
+            if res is None:
+                return 1
+            rows.append((
+                name, conns,
+                int(res["server_threads"] or 0),
+                f"{res['throughput']:.0f}",
+                f"{res['p50']:.0f}", f"{res['p99']:.0f}", f"{res['p999']:.0f}",
+                int(res["errors"] or 0),
+            ))
+
+    print()
+    print_table(
+        ("listeners", "conns", "srv_threads", "rpc/s", "p50_us", "p99_us", "p999_us", "errors"),
+        rows,
+    )
+    return 0
+
+
+def cmd_stats(args):
+    rows = []
+    for tables in args.tables:
+        for mode in ("full", "incremental"):
+            print(f"==> {tables} tables, {mode} stats")
+            # Fresh server per run: the stats tables accumulate
+            pid = start_server([])
+            if pid is None:
+                return 1
+            bench_args = ["--connections", str(args.connections), "--duration", str(args.duration),
+                          "--op", "begin_end", "--stats-tables", str(tables)]
+            if mode == "full":
+                bench_args.append("--full-stats")
+            try:
+                res = run_rpc_bench(bench_args, pid)
+            finally:
+                stop_server()
+            if res is None:
+                return 1
+            rows.append((
+                tables, mode, args.connections,
+                f"{res['begin_end_response_bytes'] or 0:.0f}",
+                f"{res['throughput']:.0f}",
+                f"{res['p50']:.0f}", f"{res['p99']:.0f}", f"{res['p999']:.0f}",
+                int(res["errors"] or 0),
+            ))
+
+    print()
+    print_table(
+        ("tables", "stats", "conns", "resp_bytes", "rpc/s", "p50_us", "p99_us", "p999_us", "errors"),
+        rows,
+    )
+    return 0
+
+
+def cmd_scan_keys(args):
+    pid = start_server([])
+    if pid is None:
+        return 1
+    rows = []
+    try:
+        for shape in args.shapes:
+            for op in args.ops:
+                for version, keys in ((3, "plain"), (4, "front-coded")):
+                    print(f"==> {shape}, {op}, {keys} keys")
+                    # A table per shape and op: index_scan needs the index
+                    # from the start
+                    bench_args = ["--connections", str(args.connections),
+                                  "--duration", str(args.duration), "--op", op,
+                                  "--key-shape", shape, "--keys", str(args.keys),
+                                  "--scan-rows", str(args.rows),
+                                  "--value-size", str(args.value_size),
+                                  "--protocol-version", str(version),
+                                  "--table", f"scankeys_{shape}_{op}"]
+                    res = run_rpc_bench(bench_args, pid)
+                    if res is None:
+                        return 1
+                    rows.append((
+                        shape, op, keys,
+                        f"{res['rows'] or 0:.0f}",
+                        f"{res['response_bytes'] or 0:.0f}",
+                        f"{res['throughput']:.0f}",
+                        f"{res['p50']:.0f}", f"{res['p99']:.0f}",
+                        int(res["errors"] or 0),
+                    ))
+    finally:
+        stop_server()
+
+    print()
+    print_table(
+        ("shape", "op", "keys", "rows", "resp_bytes", "rpc/s", "p50_us", "p99_us", "errors"),
+        rows,
+    )
+    return 0
+
+
+def _cpu_list(cpus):
+    return ",".join(str(c) for c in cpus)
+
+
+def cmd_cores(args):
+    allowed = sorted(os.sched_getaffinity(0))
+    rows = []
+    base = None
+    for cores in args.cores:
+        if cores > len(allowed):
+            print(f"==> {cores} cores: skipped, only {len(allowed)} CPUs available")
+            continue
+        # The server gets the first CPUs, the client whatever is left (or
+        # shares them when nothing is)
+        server_cpus = _cpu_list(allowed[:cores])
+        client_cpus = _cpu_list(allowed[cores:]) or None
+        server_args = [f"--io-model={args.model}", f"--engine-threads={cores}"]
+        if args.model != "thread":
+            server_args.append(f"--io-workers={cores}")
+        print(f"==> {cores} cores (server cpus {server_cpus}), {args.model}, {args.connections} connections")
+        pid = start_server(server_args, cpus=server_cpus)
+        if pid is None:
+            return 1
+        try:
+            res = run_rpc_bench(
+                ["--connections", str(args.connections), "--duration", str(args.duration),
+                 "--op", "ycsb_a", "--ops-per-tx", str(args.ops_per_tx),
+                 "--keys", str(args.keys), "--zipf", str(args.zipf),
+                 "--value-size", str(args.value_size)],
+                pid, cpus=client_cpus,
+            )
+        finally:
+            stop_server()
+        if res is None:
+            return 1
+        tps = res["tx_throughput"] or 0
+        if base is None:
+            base = tps / cores if tps else None
+        rows.append((
+            cores, f"{tps:.0f}",
+            f"{tps / (base * cores):.2f}" if base else "-",
+            f"{res['p50']:.0f}", f"{res['p99']:.0f}",
+            int(res["errors"] or 0),
+        ))
+
+    print()
+    print_table(("cores", "tx/s", "efficiency", "p50_us", "p99_us", "errors"), rows)
+    return 0
+
+
+def _log_dirs(text):
+    """label=path,... -> [(label, Path)]"""
+    dirs = []
+    for item in text.split(","):
+        label, sep, path = item.partition("=")
+        if not sep or not label or not path:
+            raise argparse.ArgumentTypeError(f"expected LABEL=PATH, got '{item}'")
+        dirs.append((label, Path(path)))
+    return dirs
+
+
+def cmd_durability(args):
+    # (label, log directory); None = in-memory
+    modes = [("memory", None)]
+    for label, base in args.log_dirs:
+        if not base.is_dir():
+            print(f"==> {label}: skipped, {base} is not a directory")
+            continue
+        modes.append((label, base / "rpcbench-wal"))
+
+    rows = []
+    for label, wal_dir in modes:
+        server_args = ["--durability=memory"]
+        if wal_dir is not None:
+            shutil.rmtree(wal_dir, ignore_errors=True)
+            server_args = ["--durability=wal", f"--log-dir={wal_dir}",
+                           f"--engine.epoch_duration_ms={args.epoch_ms}"]
+        print(f"==> {label}{f' (log in {wal_dir})' if wal_dir else ''}")
+        pid = start_server(server_args)
+        if pid is None:
+            return 1
+        try:
+            for connections in args.connections:
+                for fence in (False, True):
+                    res = run_rpc_bench(
+                        ["--connections", str(connections), "--duration", str(args.duration),
+                         "--op", "write", "--ops-per-tx", str(args.ops_per_tx),
+                         "--keys", str(args.keys), "--value-size", str(args.value_size),
+                         *(["--fence"] if fence else [])],
+                        pid,
+                    )
+                    if res is None:
+                        return 1
+                    rows.append((
+                        label, connections, "yes" if fence else "no",
+                        f"{res['tx_throughput'] or 0:.0f}",
+                        f"{res['commit_p50'] or 0:.0f}", f"{res['commit_p99'] or 0:.0f}",
+                        int(res["errors"] or 0),
+                    ))
+        finally:
+            stop_server()
+            if wal_dir is not None:
+                shutil.rmtree(wal_dir, ignore_errors=True)
+
+    print()
+    print_table(("mode", "connections", "fence", "tx/s", "commit_p50_us", "commit_p99_us", "errors"), rows)
+    return 0
+
+
+def _int_list(text):
+    return [int(x) for x in text.split(",") if x]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Ordo RPC microbenchmarks")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("io-model", help="thread-per-connection vs epoll reactor vs io_uring")
+    p.add_argument("--models", type=lambda t: t.split(","), default=["thread", "reactor"],
+                   help="comma list of thread, reactor, io_uring")
+    p.add_argument("--connections", type=_int_list, default=[64, 256, 1024])
+    p.add_argument("--duration", type=float, default=10)
+    p.add_argument("--op", default="begin_end", choices=["begin_end", "read", "batch_read", "write", "batch_write"])
+    p.add_argument("--io-workers", type=int, default=0,
+                   help="reactor/io_uring workers (default: server picks hardware threads)")
+    p.set_defaults(func=cmd_io_model)
+
+    p = sub.add_parser("transport", help="TCP loopback vs shared-memory ring")
+    p.add_argument("--transports", type=lambda t: t.split(","), default=["tcp", "shm"])
+    p.add_argument("--ops", type=lambda t: t.split(","), default=["read", "batch_read"],
+                   help="comma list of begin_end, read, batch_read, write, batch_write")
+    p.add_argument("--connections", type=int, default=1,
+                   help="concurrent connections (default 1: unloaded latency)")
+    p.add_argument("--batch-size", type=int, default=10,
+                   help="keys per TX_BATCH_READ / TX_BATCH_WRITE")
+    p.add_argument("--value-size", type=int, default=100, help="value bytes for writes")
+    p.add_argument("--duration", type=float, default=10)
+    p.set_defaults(func=cmd_transport)
+
+    p = sub.add_parser("encoding", help="protobuf vs binary point RPCs, table names vs handles")
+    p.add_argument("--ops", type=lambda t: t.split(","), default=["read", "write"],
+                   help="comma list of read, write, batch_read")
+    p.add_argument("--batch-size", type=int, default=10, help="keys per TX_BATCH_READ")
+    p.add_argument("--table", default="./tpcc/order_line",
+                   help="table name the requests carry (default: a typical TPC-C name)")
+    p.add_argument("--connections", type=int, default=1)
+    p.add_argument("--value-size", type=int, default=100, help="value bytes for writes")
+    p.add_argument("--duration", type=float, default=10)
+    p.set_defaults(func=cmd_encoding)
+
+    p = sub.add_parser("listeners", help="single listener vs pinned SO_REUSEPORT listener groups")
+    p.add_argument("--groups", type=lambda t: [g for g in t.split(",") if g], default=["1", "2", "4"],
+                   help="comma list of --listeners values (counts or numa)")
+    p.add_argument("--model", default="reactor", choices=["thread", "reactor", "io_uring"])
+    p.add_argument("--connections", type=_int_list, default=[64, 256])
+    p.add_argument("--duration", type=float, default=10)
+    p.add_argument("--op", default="read", choices=["begin_end", "read", "batch_read", "write", "batch_write"])
+    p.add_argument("--io-workers", type=int, default=0,
+                   help="total reactor/io_uring workers, split across groups (default: one per CPU)")
+    p.set_defaults(func=cmd_listeners)
+
+    p = sub.add_parser("stats", help="full vs incremental table row counts on BEGIN/END")
+    p.add_argument("--tables", type=_int_list, default=[10, 100, 1000],
+                   help="comma list of table counts")
+    p.add_argument("--connections", type=int, default=8)
+    p.add_argument("--duration", type=float, default=10)
+    p.set_defaults(func=cmd_stats)
+
+    p = sub.add_parser("scan-keys", help="plain vs front-coded keys in scan responses")
+    p.add_argument("--shapes", type=lambda t: t.split(","), default=["order_line", "lineitem"],
+                   help="comma list of order_line, lineitem, plain")
+    p.add_argument("--ops", type=lambda t: t.split(","), default=["scan", "index_scan"],
+                   help="comma list of scan (keys and values), index_scan (primary keys)")
+    p.add_argument("--rows", type=int, default=200,
+                   help="rows per scan (default 200: StockLevel's 20 orders x 10 lines)")
+    p.add_argument("--keys", type=int, default=60000, help="rows loaded per table")
+    p.add_argument("--value-size", type=int, default=60, help="value bytes per row")
+    p.add_argument("--connections", type=int, default=1)
+    p.add_argument("--duration", type=float, default=10)
+    p.set_defaults(func=cmd_scan_keys)
+
+    p = sub.add_parser("cores", help="YCSB-A throughput as the server gets more cores")
+    p.add_argument("--cores", type=_int_list, default=[1, 2, 4, 8, 16, 32, 64],
+                   help="comma list of core counts (counts above the CPUs available are skipped)")
+    p.add_argument("--model", default="reactor", choices=["thread", "reactor", "io_uring"])
+    p.add_argument("--connections", type=int, default=128)
+    p.add_argument("--ops-per-tx", type=int, default=1,
+                   help="reads/updates per transaction (YCSB: 1)")
+    p.add_argument("--keys", type=int, default=100000, help="rows loaded")
+    p.add_argument("--zipf", type=float, default=0.99, help="Zipfian theta (0 = uniform)")
+    p.add_argument("--value-size", type=int, default=100, help="value bytes per row")
+    p.add_argument("--duration", type=float, default=10)
+    p.set_defaults(func=cmd_cores)
+
+    p = sub.add_parser("durability", help="in-memory vs write-ahead log commit latency and throughput")
+    p.add_argument("--log-dirs", type=_log_dirs, default=[("tmpfs", Path("/dev/shm"))],
+                   help="comma list of LABEL=DIR to put the log on, e.g. nvme=/mnt/nvme,tmpfs=/dev/shm "
+                        "(an rpcbench-wal directory is created and removed under each)")
+    p.add_argument("--connections", type=_int_list, default=[1, 64])
+    p.add_argument("--ops-per-tx", type=int, default=1, help="TX_WRITEs per transaction")
+    p.add_argument("--keys", type=int, default=100000)
+    p.add_argument("--value-size", type=int, default=100)
+    p.add_argument("--epoch-ms", type=int, default=40, help="engine.epoch_duration_ms (group commit interval)")
+    p.add_argument("--duration", type=float, default=10)
+    p.set_defaults(func=cmd_durability)
+
+    args = parser.parse_args()
+    if not RPC_BENCH_BIN.exists():
+        print(f"ERROR: {RPC_BENCH_BIN} not found. Run: bash scripts/build.sh", file=sys.stderr)
+        return 1
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,6 +1,12 @@
 #!/usr/bin/env python3
-"""Run TPC-H Q1-Q22 individually with per-query timeout."""
+"""Run TPC-H Q1-Q22 individually with per-query timeout.
 
+With --compression the whole run is repeated once per lineairdb_compression
+setting (e.g. off,lz4,zstd) against the already running mysqld, and the
+per-query times are printed side by side.
+"""
+
+import argparse
 import subprocess
 import sys
 import time
@@ -11,12 +17,15 @@ from pathlib import Path
 ROOT = Path(__file__).resolve().parents[2]
 BENCHBASE_DIR = ROOT / "third_party" / "benchbase" / "benchbase-mysql"
 CONFIG_SRC = ROOT / "bench" / "config" / "tpch.xml"
+MYSQL_BIN = ROOT / "build" / "runtime_output_directory" / "mysql"
 TIMEOUT = 120  # seconds per query
 
-def make_query_config(query_num, out_dir):
+def make_query_config(query_num, out_dir, scale_factor=None):
     """Create a config with only one query enabled."""
     tree = ET.parse(CONFIG_SRC)
     root = tree.getroot()
+    if scale_factor is not None:
+        root.find("scalefactor").text = str(scale_factor)
 
     # Remove all existing <works> and replace with single query
     works = root.find("works")
@@ -35,9 +44,9 @@ def make_query_config(query_num, out_dir):
     return config_path
 
 
-def run_query(query_num, out_dir, result_dir):
+def run_query(query_num, out_dir, result_dir, scale_factor=None):
     """Run a single TPC-H query and return (elapsed_seconds, status)."""
-    config = make_query_config(query_num, out_dir)
+    config = make_query_config(query_num, out_dir, scale_factor)
     cmd = [
         "java", "-jar", str(BENCHBASE_DIR / "benchbase.jar"),
         "-b", "tpch",
@@ -63,22 +72,30 @@ def run_query(query_num, out_dir, result_dir):
         return elapsed, "TIMEOUT"
 
 
-def main():
-    result_dir = ROOT / "bench" / "results" / f"tpch_individual_{time.strftime('%Y%m%d_%H%M%S')}"
-    result_dir.mkdir(parents=True, exist_ok=True)
-    tmp_dir = result_dir / "configs"
-    tmp_dir.mkdir(exist_ok=True)
+def set_compression(port, codec, threshold):
+    """Switch lineairdb_compression; pooled/shared connections are rebuilt."""
+    sql = f"SET GLOBAL lineairdb_compression='{codec}';"
+    if threshold is not None:
+        sql += f" SET GLOBAL lineairdb_compression_threshold={threshold};"
+    proc = subprocess.run(
+        [str(MYSQL_BIN), "-u", "root", "--protocol=TCP", "-h", "127.0.0.1", "-P", str(port), "-e", sql],
+        capture_output=True, text=True)
+    if proc.returncode != 0:
+        print(f"ERROR: {sql}\n{proc.stderr}", file=sys.stderr)
+        return False
+    return True
 
-    print(f"TPC-H Individual Query Benchmark (SF=0.1, timeout={TIMEOUT}s)")
-    print(f"Results: {result_dir}")
-    print(f"{'Query':>7} {'Time (s)':>10} {'Status':>10}")
+
+def run_all(label, tmp_dir, result_dir, scale_factor):
+    """Run Q1-Q22 once. Returns [(query, elapsed, status)]."""
+    print(f"{'Query':>7} {'Time (s)':>10} {'Status':>10}" + (f"   [{label}]" if label else ""))
     print("-" * 30)
 
     results = []
     for q in range(1, 23):
         sys.stdout.write(f"  Q{q:02d}   ")
         sys.stdout.flush()
-        elapsed, status = run_query(q, tmp_dir, result_dir)
+        elapsed, status = run_query(q, tmp_dir, result_dir, scale_factor)
         print(f"{elapsed:10.2f} {status:>10}")
         results.append((q, elapsed, status))
 
@@ -94,15 +111,66 @@ def main():
         print(f"Timeout:   {', '.join(f'Q{q}' for q, _ in timeout)}")
     if error:
         print(f"Error:     {', '.join(f'Q{q}' for q, _ in error)}")
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--scale-factor", type=float, default=None,
+                        help="scale factor of the loaded data (default: bench/config/tpch.xml)")
+    parser.add_argument("--compression", type=lambda t: t.split(","), default=None,
+                        help="comma list of lineairdb_compression values to compare, e.g. off,lz4,zstd")
+    parser.add_argument("--compression-threshold", type=int, default=None,
+                        help="lineairdb_compression_threshold in bytes (default: leave as is)")
+    parser.add_argument("--mysql-port", type=int, default=3307)
+    args = parser.parse_args()
+
+    scale_factor = args.scale_factor
+    if scale_factor is None:
+        scale_factor = float(ET.parse(CONFIG_SRC).getroot().find("scalefactor").text)
+
+    result_dir = ROOT / "bench" / "results" / f"tpch_individual_{time.strftime('%Y%m%d_%H%M%S')}"
+    result_dir.mkdir(parents=True, exist_ok=True)
+    tmp_dir = result_dir / "configs"
+    tmp_dir.mkdir(exist_ok=True)
+
+    print(f"TPC-H Individual Query Benchmark (SF={scale_factor:g}, timeout={TIMEOUT}s)")
+    print(f"Results: {result_dir}")
+
+    runs = {}
+    for codec in args.compression or [None]:
+        if codec is not None:
+            print()
+            if not set_compression(args.mysql_port, codec, args.compression_threshold):
+                return 1
+        run_dir = result_dir / codec if codec else result_dir
+        run_dir.mkdir(exist_ok=True)
+        runs[codec] = run_all(codec, tmp_dir, run_dir, scale_factor)
 
     # Write CSV
     csv_path = result_dir / "summary.csv"
     with open(csv_path, "w") as f:
-        f.write("query,time_sec,status\n")
-        for q, t, s in results:
-            f.write(f"Q{q},{t:.2f},{s}\n")
+        if args.compression:
+            f.write("compression,query,time_sec,status\n")
+        else:
+            f.write("query,time_sec,status\n")
+        for codec, results in runs.items():
+            for q, t, s in results:
+                prefix = f"{codec}," if codec else ""
+                f.write(f"{prefix}Q{q},{t:.2f},{s}\n")
+
+    if args.compression and len(runs) > 1:
+        print()
+        print(f"{'Query':>7}" + "".join(f"{c:>10}" for c in runs))
+        for i in range(22):
+            cells = []
+            for results in runs.values():
+                q, t, s = results[i]
+                cells.append(f"{t:10.2f}" if s == "OK" else f"{s:>10}")
+            print(f"  Q{i + 1:02d}  " + "".join(cells))
     print(f"\nCSV: {csv_path}")
+    return 0
 
 
 if __name__ == "__main__":
-    main()
+    sys.exit(main())
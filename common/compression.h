@@ -0,0 +1,131 @@
+#pragma once
+
+// Optional per-message payload compression.
+//
+// A proxy offers a codec and a size threshold in its SESSION_HELLO; the
+// server then compresses responses at or above the threshold when that
+// actually makes them smaller, and marks them by setting kCompressedPayload in
+// the response header's message type. A compressed payload is
+//
+//   [codec:1B] [raw_size:4B big-endian] [codec output]
+//
+// so the receiver needs no per-connection state to undo it. Codecs are
+// compiled in with LINEAIRDB_WITH_LZ4 / LINEAIRDB_WITH_ZSTD; a peer only ever
+// receives a codec it listed itself.
+
+#include <arpa/inet.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef LINEAIRDB_WITH_LZ4
+#include <lz4.h>
+#endif
+#ifdef LINEAIRDB_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Rpc {
+
+enum class Codec : uint32_t { NONE = 0, LZ4 = 1, ZSTD = 2 };
+
+// OR'ed into MessageHeader::message_type of a compressed response
+constexpr uint32_t kCompressedPayload = 1u << 31;
+constexpr size_t kCompressedHeaderSize = 5;
+
+inline bool codec_available(Codec codec) {
+    switch (codec) {
+#ifdef LINEAIRDB_WITH_LZ4
+        case Codec::LZ4: return true;
+#endif
+#ifdef LINEAIRDB_WITH_ZSTD
+        case Codec::ZSTD: return true;
+#endif
+        default: return false;
+    }
+}
+
+inline const char* codec_name(Codec codec) {
+    switch (codec) {
+        case Codec::LZ4: return "lz4";
+        case Codec::ZSTD: return "zstd";
+        default: return "none";
+    }
+}
+
+// Compress src into out. Returns false, leaving out unspecified, when the
+// codec is not built in or the result would not be smaller than src.
+inline bool compress_payload(Codec codec, const char* src, size_t size, std::string& out) {
+    if (size > UINT32_MAX) return false;
+    size_t written;
+    switch (codec) {
+#ifdef LINEAIRDB_WITH_LZ4
+        case Codec::LZ4: {
+            if (size > static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) return false;
+            int bound = LZ4_compressBound(static_cast<int>(size));
+            out.resize(kCompressedHeaderSize + static_cast<size_t>(bound));
+            int n = LZ4_compress_default(src, &out[kCompressedHeaderSize],
+                                         static_cast<int>(size), bound);
+            if (n <= 0) return false;
+            written = static_cast<size_t>(n);
+            break;
+        }
+#endif
+#ifdef LINEAIRDB_WITH_ZSTD
+        case Codec::ZSTD: {
+            size_t bound = ZSTD_compressBound(size);
+            out.resize(kCompressedHeaderSize + bound);
+            // Level 1: the point is to beat the wire, not to win on ratio
+            size_t n = ZSTD_compress(&out[kCompressedHeaderSize], bound, src, size, 1);
+            if (ZSTD_isError(n)) return false;
+            written = n;
+            break;
+        }
+#endif
+        default:
+            (void)src;
+            return false;
+    }
+    if (kCompressedHeaderSize + written >= size) return false;
+    out[0] = static_cast<char>(codec);
+    uint32_t raw_size = htonl(static_cast<uint32_t>(size));
+    std::memcpy(&out[1], &raw_size, sizeof(raw_size));
+    out.resize(kCompressedHeaderSize + written);
+    return true;
+}
+
+// Size of the payload once decompressed, or 0 if src is not a valid
+// compressed payload.
+inline size_t decompressed_size(const char* src, size_t size) {
+    if (size < kCompressedHeaderSize) return 0;
+    uint32_t raw_size;
+    std::memcpy(&raw_size, src + 1, sizeof(raw_size));
+    return ntohl(raw_size);
+}
+
+// Decompress into dst, which must hold decompressed_size(src, size) bytes.
+inline bool decompress_payload(const char* src, size_t size, char* dst, size_t dst_size) {
+    if (size < kCompressedHeaderSize || decompressed_size(src, size) != dst_size) return false;
+    const char* body = src + kCompressedHeaderSize;
+    size_t body_size = size - kCompressedHeaderSize;
+    switch (static_cast<Codec>(static_cast<uint8_t>(src[0]))) {
+#ifdef LINEAIRDB_WITH_LZ4
+        case Codec::LZ4:
+            return LZ4_decompress_safe(body, dst, static_cast<int>(body_size),
+                                       static_cast<int>(dst_size)) == static_cast<int>(dst_size);
+#endif
+#ifdef LINEAIRDB_WITH_ZSTD
+        case Codec::ZSTD:
+            return ZSTD_decompress(dst, dst_size, body, body_size) == dst_size;
+#endif
+        default:
+            (void)body;
+            (void)body_size;
+            (void)dst;
+            return false;
+    }
+}
+
+}  // namespace Rpc
@@ -0,0 +1,258 @@
+#pragma once
+
+// Fixed-layout binary encoding of the point RPCs.
+//
+// TX_READ, TX_WRITE, TX_DELETE and the secondary-index point RPCs make up
+// almost every frame of a YCSB run, and for them protobuf's varint tags and
+// per-field string copies cost more than the work the server does. Once a
+// session has negotiated kBinaryPointOpsVersion in its SESSION_HELLO, the
+// proxy sends these opcodes with kBinaryPayload set in the message type and
+// the server answers in kind:
+//
+//   request   [transaction_id:8B] [table_len:4B][table] [len:4B][field]...
+//               TX_READ, TX_DELETE              key
+//               TX_WRITE                        key, value
+//               TX_READ_SECONDARY_INDEX         index_name, secondary_key
+//               TX_{WRITE,DELETE}_SECONDARY_INDEX
+//                                               index_name, secondary_key, primary_key
+//               TX_UPDATE_SECONDARY_INDEX       index_name, old_secondary_key,
+//                                               new_secondary_key, primary_key
+//   response  [flags:1B] (kFound, kAborted) followed by
+//               TX_READ                         [value_len:4B][value] if kFound
+//               TX_READ_SECONDARY_INDEX         [count:4B] count x [len:4B][value]
+//
+// TX_BATCH_READ has the same framing with a key list in place of the fields,
+// and answers every key in request order, like the flat scan responses:
+//
+//   request   [transaction_id:8B] [table_len:4B][table] [count:4B] count x [len:4B][key]
+//   response  [flags:1B] (kAborted) [count:4B] count x [found:1B][len:4B][value]
+//
+// From kTableHandlesVersion the table, and the index_name of the secondary
+// index RPCs, may instead be a handle from DB_RESOLVE_HANDLES: a single
+// [handle | kHandleTag:4B] in place of the length-prefixed name.
+//
+// Integers are in host byte order, as in the flat scan responses. All other
+// opcodes, and peers that negotiate an older version, keep using the
+// protobuf messages in lineairdb.proto.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Rpc {
+
+// Protocol versions exchanged in SESSION_HELLO
+//   1  protobuf for every opcode (also assumed for peers that send no version)
+//   2  binary point RPCs
+//   3  numeric table/index handles (DB_RESOLVE_HANDLES, table_id/index_id)
+//   4  front-coded scan keys (common/scan_codec.h)
+//   5  TX_MULTI envelope of heterogeneous ops
+//   6  TX_MULTI begins (transaction_id 0) and commits implicitly
+//   7  a fenced commit returns once its own epoch is durable; no DB_FENCE after it
+constexpr uint32_t kBinaryPointOpsVersion = 2;
+constexpr uint32_t kTableHandlesVersion = 3;
+constexpr uint32_t kFrontCodedKeysVersion = 4;
+constexpr uint32_t kMultiOpsVersion = 5;
+constexpr uint32_t kImplicitBeginVersion = 6;
+constexpr uint32_t kDurableFenceVersion = 7;
+constexpr uint32_t kProtocolVersion = 7;
+
+// OR'ed into MessageHeader::message_type of a binary point request/response
+constexpr uint32_t kBinaryPayload = 1u << 30;
+
+// Response flags byte
+constexpr uint8_t kFound = 1;    // read found the key / write-type op succeeded
+constexpr uint8_t kAborted = 2;  // transaction is aborted
+
+constexpr size_t kMaxPointFields = 4;
+
+// Set in a name's length word when a handle takes the name's place
+constexpr uint32_t kHandleTag = 1u << 31;
+
+// Number of length-prefixed fields after the table name for message_type
+// (OpCode numbering from lineairdb.proto), or 0 if it has no binary form.
+inline size_t point_field_count(uint32_t message_type) {
+    switch (message_type) {
+        case 3: return 1;  // TX_READ
+        case 4: return 2;  // TX_WRITE
+        case 5: return 1;  // TX_DELETE
+        case 6: return 2;  // TX_READ_SECONDARY_INDEX
+        case 7: return 3;  // TX_WRITE_SECONDARY_INDEX
+        case 8: return 3;  // TX_DELETE_SECONDARY_INDEX
+        case 9: return 4;  // TX_UPDATE_SECONDARY_INDEX
+        default: return 0;
+    }
+}
+
+// True if the first field is an index_name (the secondary-index RPCs)
+inline bool point_has_index(uint32_t message_type) {
+    return message_type >= 6 && message_type <= 9;
+}
+
+inline char* put_u32(char* dst, uint32_t value) {
+    std::memcpy(dst, &value, sizeof(value));
+    return dst + sizeof(value);
+}
+
+inline char* put_bytes(char* dst, std::string_view bytes) {
+    dst = put_u32(dst, static_cast<uint32_t>(bytes.size()));
+    if (!bytes.empty()) std::memcpy(dst, bytes.data(), bytes.size());
+    return dst + bytes.size();
+}
+
+// A table or index name, or its handle when handle != 0
+inline char* put_name(char* dst, std::string_view name, uint32_t handle) {
+    return handle != 0 ? put_u32(dst, handle | kHandleTag) : put_bytes(dst, name);
+}
+
+inline void append_u32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void append_bytes(std::string& out, std::string_view bytes) {
+    append_u32(out, static_cast<uint32_t>(bytes.size()));
+    out.append(bytes.data(), bytes.size());
+}
+
+// A non-zero table_id replaces table_name; a non-zero index_id replaces the
+// first field, which must then be the index_name.
+inline size_t point_request_size(std::string_view table_name, uint32_t table_id, uint32_t index_id,
+                                 std::initializer_list<std::string_view> fields) {
+    size_t size = sizeof(int64_t) + sizeof(uint32_t) + (table_id != 0 ? 0 : table_name.size());
+    for (std::string_view field : fields) size += sizeof(uint32_t) + field.size();
+    if (index_id != 0 && fields.size() > 0) size -= fields.begin()->size();
+    return size;
+}
+
+// dst must hold point_request_size(table_name, table_id, index_id, fields) bytes.
+inline void encode_point_request(char* dst, int64_t transaction_id, std::string_view table_name,
+                                 uint32_t table_id, uint32_t index_id,
+                                 std::initializer_list<std::string_view> fields) {
+    std::memcpy(dst, &transaction_id, sizeof(transaction_id));
+    dst = put_name(dst + sizeof(transaction_id), table_name, table_id);
+    for (auto it = fields.begin(); it != fields.end(); ++it) {
+        dst = it == fields.begin() ? put_name(dst, *it, index_id) : put_bytes(dst, *it);
+    }
+}
+
+inline size_t batch_read_request_size(std::string_view table_name, uint32_t table_id,
+                                     const std::vector<std::string>& keys) {
+    size_t size = sizeof(int64_t) + sizeof(uint32_t) + (table_id != 0 ? 0 : table_name.size()) +
+                  sizeof(uint32_t);
+    for (const std::string& key : keys) size += sizeof(uint32_t) + key.size();
+    return size;
+}
+
+// dst must hold batch_read_request_size(table_name, table_id, keys) bytes.
+inline void encode_batch_read_request(char* dst, int64_t transaction_id, std::string_view table_name,
+                                      uint32_t table_id, const std::vector<std::string>& keys) {
+    std::memcpy(dst, &transaction_id, sizeof(transaction_id));
+    dst = put_name(dst + sizeof(transaction_id), table_name, table_id);
+    dst = put_u32(dst, static_cast<uint32_t>(keys.size()));
+    for (const std::string& key : keys) dst = put_bytes(dst, key);
+}
+
+// Bounds-checked cursor over a binary payload; every read fails once the
+// input runs short, so callers only need to check the final result.
+class PointReader {
+public:
+    explicit PointReader(std::string_view data) : p_(data.data()), end_(data.data() + data.size()) {}
+
+    bool ok() const { return ok_; }
+    bool done() const { return ok_ && p_ == end_; }
+    std::string_view remaining() const { return std::string_view(p_, end_ - p_); }
+
+    template <typename T>
+    T read() {
+        T value{};
+        if (!take(sizeof(T))) return value;
+        std::memcpy(&value, p_ - sizeof(T), sizeof(T));
+        return value;
+    }
+
+    std::string_view read_bytes() {
+        uint32_t len = read<uint32_t>();
+        if (!take(len)) return {};
+        return std::string_view(p_ - len, len);
+    }
+
+    // A name written by put_name(): either the name, or its handle
+    std::string_view read_name(uint32_t& handle) {
+        uint32_t len = read<uint32_t>();
+        handle = (len & kHandleTag) ? len & ~kHandleTag : 0;
+        if (handle != 0 || !take(len)) return {};
+        return std::string_view(p_ - len, len);
+    }
+
+private:
+    bool take(size_t n) {
+        if (!ok_ || static_cast<size_t>(end_ - p_) < n) {
+            ok_ = false;
+            return false;
+        }
+        p_ += n;
+        return true;
+    }
+
+    const char* p_;
+    const char* end_;
+    bool ok_ = true;
+};
+
+// Decoded point request; fields point into the receive buffer. When the
+// proxy sent handles, table_id / index_id are set and table_name / fields[0]
+// are empty.
+struct PointRequestView {
+    int64_t transaction_id = 0;
+    std::string_view table_name;
+    uint32_t table_id = 0;
+    uint32_t index_id = 0;
+    std::string_view fields[kMaxPointFields];
+
+    bool parse(std::string_view data, uint32_t message_type) {
+        size_t num_fields = point_field_count(message_type);
+        if (num_fields == 0 || num_fields > kMaxPointFields) return false;
+        PointReader reader(data);
+        transaction_id = reader.read<int64_t>();
+        table_name = reader.read_name(table_id);
+        for (size_t i = 0; i < num_fields; i++) {
+            fields[i] = i == 0 && point_has_index(message_type) ? reader.read_name(index_id)
+                                                                : reader.read_bytes();
+        }
+        return reader.done();
+    }
+};
+
+// Decoded TX_BATCH_READ request. parse() validates the whole key list up
+// front; keys() then re-reads it from the receive buffer.
+struct BatchReadRequestView {
+    int64_t transaction_id = 0;
+    std::string_view table_name;
+    uint32_t table_id = 0;
+    uint32_t count = 0;
+
+    bool parse(std::string_view data) {
+        PointReader reader(data);
+        transaction_id = reader.read<int64_t>();
+        table_name = reader.read_name(table_id);
+        count = reader.read<uint32_t>();
+        keys_ = reader.remaining();
+        for (uint32_t i = 0; i < count && reader.ok(); i++) reader.read_bytes();
+        return reader.done();
+    }
+
+    template <typename Fn>
+    void for_each_key(Fn&& fn) const {
+        PointReader reader(keys_);
+        for (uint32_t i = 0; i < count; i++) fn(reader.read_bytes());
+    }
+
+private:
+    std::string_view keys_;
+};
+
+}  // namespace Rpc
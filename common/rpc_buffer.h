@@ -0,0 +1,170 @@
+#pragma once
+
+// Reusable framing buffers for the RPC client path.
+//
+// A frame is the 16-byte header (be64 request ID, be32 message type, be32
+// payload size; see MessageHeader) followed by the payload. FrameBuffer
+// serializes a protobuf message straight into its storage behind the header,
+// and both buffers keep their capacity between calls, so steady-state RPCs
+// perform no heap allocation and no copy for framing. Header-only and
+// protobuf-agnostic so the proxy and the benchmarks share one implementation.
+
+#include <arpa/inet.h>
+#include <endian.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace Rpc {
+
+constexpr size_t kHeaderSize = 16;
+// Storage above this size is released after use instead of being kept
+constexpr size_t kRetainLimit = 1 << 20;
+
+inline void encode_header(char* dst, uint64_t request_id, uint32_t message_type,
+                          uint32_t payload_size) {
+    uint64_t id = htobe64(request_id);
+    uint32_t type = htonl(message_type);
+    uint32_t size = htonl(payload_size);
+    std::memcpy(dst, &id, sizeof(id));
+    std::memcpy(dst + 8, &type, sizeof(type));
+    std::memcpy(dst + 12, &size, sizeof(size));
+}
+
+inline void decode_header(const char* src, uint64_t& request_id, uint32_t& message_type,
+                          uint32_t& payload_size) {
+    uint64_t id;
+    uint32_t type;
+    uint32_t size;
+    std::memcpy(&id, src, sizeof(id));
+    std::memcpy(&type, src + 8, sizeof(type));
+    std::memcpy(&size, src + 12, sizeof(size));
+    request_id = be64toh(id);
+    message_type = ntohl(type);
+    payload_size = ntohl(size);
+}
+
+// A multiplexed connection carries one request stream per proxy session; the
+// stream ID is the high half of the request ID, the low half a sequence
+// number within the stream. Stream 0 is a connection's only stream when it
+// is not multiplexed.
+inline uint64_t make_request_id(uint32_t stream, uint32_t sequence) {
+    return (static_cast<uint64_t>(stream) << 32) | sequence;
+}
+
+inline uint32_t request_stream(uint64_t request_id) {
+    return static_cast<uint32_t>(request_id >> 32);
+}
+
+// Growable byte storage that never shrinks below kRetainLimit and does not
+// zero-fill on reuse (unlike std::string/std::vector::resize).
+class ByteBuffer {
+public:
+    char* reserve(size_t n) {
+        if (n > capacity_) {
+            size_t grown = capacity_ == 0 ? 256 : capacity_;
+            while (grown < n) grown *= 2;
+            data_.reset(new char[grown]);
+            capacity_ = grown;
+        }
+        return data_.get();
+    }
+
+    // Drop oversized storage once a large message has been handled.
+    void trim() {
+        if (capacity_ > kRetainLimit) {
+            data_.reset();
+            capacity_ = 0;
+        }
+    }
+
+    char* data() { return data_.get(); }
+    const char* data() const { return data_.get(); }
+    size_t capacity() const { return capacity_; }
+
+    void swap(ByteBuffer& other) noexcept {
+        data_.swap(other.data_);
+        std::swap(capacity_, other.capacity_);
+    }
+
+private:
+    std::unique_ptr<char[]> data_;
+    size_t capacity_ = 0;
+};
+
+// One outgoing frame. build() lays out header + payload; the request ID is
+// stamped last by whoever assigns it.
+class FrameBuffer {
+public:
+    template <typename Message>
+    bool build(uint32_t message_type, const Message& message) {
+        size_t payload_size = message.ByteSizeLong();
+        char* dst = buf_.reserve(kHeaderSize + payload_size);
+        message.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(dst + kHeaderSize));
+        message_type_ = message_type;
+        payload_size_ = static_cast<uint32_t>(payload_size);
+        return true;
+    }
+
+    // Reserve payload_size bytes behind the header for the caller to fill.
+    char* build_in_place(uint32_t message_type, size_t payload_size) {
+        char* dst = buf_.reserve(kHeaderSize + payload_size);
+        message_type_ = message_type;
+        payload_size_ = static_cast<uint32_t>(payload_size);
+        return dst + kHeaderSize;
+    }
+
+    void build_raw(uint32_t message_type, const char* payload, size_t payload_size) {
+        char* dst = buf_.reserve(kHeaderSize + payload_size);
+        if (payload_size > 0) std::memcpy(dst + kHeaderSize, payload, payload_size);
+        message_type_ = message_type;
+        payload_size_ = static_cast<uint32_t>(payload_size);
+    }
+
+    void set_request_id(uint64_t request_id) {
+        encode_header(buf_.data(), request_id, message_type_, payload_size_);
+    }
+
+    const char* data() const { return buf_.data(); }
+    size_t size() const { return kHeaderSize + payload_size_; }
+    uint32_t message_type() const { return message_type_; }
+    void trim() { buf_.trim(); }
+
+private:
+    ByteBuffer buf_;
+    uint32_t message_type_ = 0;
+    uint32_t payload_size_ = 0;
+};
+
+// One incoming payload (header already consumed).
+class PayloadBuffer {
+public:
+    char* prepare(size_t n) {
+        size_ = n;
+        return buf_.reserve(n);
+    }
+
+    const char* data() const { return buf_.data(); }
+    size_t size() const { return size_; }
+    void trim() { buf_.trim(); }
+
+    // Exchange contents and storage, so a payload can change hands without a copy
+    void swap(PayloadBuffer& other) noexcept {
+        buf_.swap(other.buf_);
+        std::swap(size_, other.size_);
+    }
+
+    template <typename Message>
+    bool parse(Message& message) const {
+        return message.ParseFromArray(buf_.data(), static_cast<int>(size_));
+    }
+
+private:
+    ByteBuffer buf_;
+    size_t size_ = 0;
+};
+
+}  // namespace Rpc
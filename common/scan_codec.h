@@ -0,0 +1,211 @@
+#pragma once
+
+// Flat binary layout of the scan responses that bypass protobuf.
+//
+// TX_GET_MATCHING_KEYS_AND_VALUES_IN_RANGE and _FROM_PREFIX answer
+//
+//   [is_aborted:1B] entry... end
+//     entry   [key_len:4B][key] [value_len:4B][value]
+//     end     key_len = 0
+//
+// Keys come back in order, so neighbours share most of a composite primary
+// key: every key of an ORDER_LINE range repeats w_id and d_id, and usually
+// o_id. Sessions that negotiate kFrontCodedKeysVersion in their SESSION_HELLO
+// get each key coded against the previous key of the same response instead:
+//
+//     entry   [shared:varint][suffix_len:varint][suffix] [value_len:4B][value]
+//     end     shared = suffix_len = 0
+//
+// where the key is the first `shared` bytes of the previous key followed by
+// suffix (the first entry has shared = 0), and varints are LEB128. In those
+// sessions TX_GET_MATCHING_PRIMARY_KEYS_IN_RANGE also answers in this layout,
+// without the value fields, in place of its protobuf Response.
+//
+// Keys are never empty, which is what lets a zero length end the list. Fixed
+// integers are in host byte order, as in common/point_codec.h.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "point_codec.h"
+
+namespace Rpc {
+
+// LEB128 into p, which has room for 5 bytes; returns the end
+inline char* put_varint(char* p, uint32_t value) {
+    while (value >= 0x80) {
+        *p++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = static_cast<char>(value);
+    return p;
+}
+
+// Length of the common prefix of a and b
+inline size_t shared_prefix_length(std::string_view a, std::string_view b) {
+    size_t limit = std::min(a.size(), b.size());
+    size_t n = 0;
+    while (n + 8 <= limit) {
+        uint64_t x, y;
+        std::memcpy(&x, a.data() + n, 8);
+        std::memcpy(&y, b.data() + n, 8);
+        if (x != y) break;
+        n += 8;
+    }
+    while (n < limit && a[n] == b[n]) n++;
+    return n;
+}
+
+// Appends a scan response to out. Entries are written into out's storage
+// past its logical end, so out only holds the response once finish() has
+// run; finish() also writes the aborted flag, once the scan is over.
+class ScanResponseWriter {
+public:
+    ScanResponseWriter(std::string& out, bool front_coded) : out_(out), front_coded_(front_coded) {}
+
+    void begin() {
+        out_.clear();
+        used_ = 0;
+        *grow(1) = 0;
+        used_ = 1;
+        previous_.clear();
+    }
+
+    void add_key(std::string_view key) { put_key(grow(kMaxKeyHeader + key.size()), key); }
+
+    void add(std::string_view key, std::string_view value) {
+        char* p = put_key(grow(kMaxKeyHeader + key.size() + 4 + value.size()), key);
+        put_length(p, value.size());
+        std::memcpy(p + 4, value.data(), value.size());
+        used_ = p + 4 + value.size() - &out_[0];
+    }
+
+    // Drop every entry added since begin()
+    void discard() { begin(); }
+
+    void finish(bool is_aborted) {
+        char* p = grow(4);
+        if (front_coded_) {
+            p[0] = p[1] = 0;
+            used_ += 2;
+        } else {
+            put_length(p, 0);
+            used_ += 4;
+        }
+        out_.resize(used_);
+        out_[0] = is_aborted ? 1 : 0;
+    }
+
+private:
+    static constexpr size_t kMaxKeyHeader = 10;  // two varints, or one fixed length
+
+    // Room for n more bytes at out_[used_]
+    char* grow(size_t n) {
+        if (used_ + n > out_.size()) {
+            out_.resize(std::max(used_ + n, out_.size() * 2));
+        }
+        return &out_[used_];
+    }
+
+    static void put_length(char* p, size_t length) {
+        uint32_t value = static_cast<uint32_t>(length);
+        std::memcpy(p, &value, sizeof(value));
+    }
+
+    // Writes the key's entry header and bytes at p and returns the end
+    char* put_key(char* p, std::string_view key) {
+        if (!front_coded_) {
+            put_length(p, key.size());
+            std::memcpy(p + 4, key.data(), key.size());
+            p += 4 + key.size();
+        } else {
+            size_t shared = shared_prefix_length(key, previous_);
+            size_t suffix = key.size() - shared;
+            p = put_varint(p, static_cast<uint32_t>(shared));
+            p = put_varint(p, static_cast<uint32_t>(suffix));
+            std::memcpy(p, key.data() + shared, suffix);
+            p += suffix;
+            previous_.resize(key.size());
+            std::memcpy(&previous_[shared], key.data() + shared, suffix);
+        }
+        used_ = p - &out_[0];
+        return p;
+    }
+
+    std::string& out_;
+    const bool front_coded_;
+    size_t used_ = 0;
+    std::string previous_;
+};
+
+// Calls fn(key, value) for every entry of a scan response (value is empty
+// when with_values is false). key is only valid during the call. Returns
+// false if the response is truncated or malformed; entries before that point
+// have been delivered.
+template <typename Fn>
+bool for_each_scan_entry(std::string_view data, bool front_coded, bool with_values, bool& is_aborted,
+                         Fn&& fn) {
+    const char* p = data.data();
+    const char* end = p + data.size();
+    is_aborted = true;
+    if (p == end) return false;
+    is_aborted = *p++ != 0;
+
+    auto read_u32 = [&](uint32_t& value) {
+        if (end - p < 4) return false;
+        std::memcpy(&value, p, 4);
+        p += 4;
+        return true;
+    };
+    auto read_varint = [&](uint32_t& value) {
+        if (p != end && !(*p & 0x80)) {
+            value = static_cast<uint8_t>(*p++);
+            return true;
+        }
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (p == end) return false;
+            uint8_t byte = static_cast<uint8_t>(*p++);
+            value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    };
+
+    std::string key;  // front-coded keys are rebuilt here
+    while (true) {
+        std::string_view key_view;
+        if (front_coded) {
+            uint32_t shared, suffix_len;
+            if (!read_varint(shared) || !read_varint(suffix_len)) return false;
+            if (shared == 0 && suffix_len == 0) return true;
+            if (shared > key.size() || static_cast<size_t>(end - p) < suffix_len) return false;
+            key.resize(shared + suffix_len);
+            std::memcpy(&key[shared], p, suffix_len);
+            p += suffix_len;
+            key_view = key;
+        } else {
+            uint32_t key_len;
+            if (!read_u32(key_len)) return false;
+            if (key_len == 0) return true;
+            if (static_cast<size_t>(end - p) < key_len) return false;
+            key_view = std::string_view(p, key_len);
+            p += key_len;
+        }
+
+        std::string_view value;
+        if (with_values) {
+            uint32_t value_len;
+            if (!read_u32(value_len) || static_cast<size_t>(end - p) < value_len) return false;
+            value = std::string_view(p, value_len);
+            p += value_len;
+        }
+        fn(key_view, value);
+    }
+}
+
+}  // namespace Rpc
@@ -0,0 +1,366 @@
+#pragma once
+
+// Shared-memory transport for a proxy and server on the same host.
+//
+// One memfd per connection holds two single-producer/single-consumer byte
+// rings, proxy->server and server->proxy. Both sides push exactly the bytes
+// they would have written to the TCP socket (MessageHeader + payload), so
+// framing and request IDs are unchanged. The memfd is handed over once on a
+// Unix domain socket (SCM_RIGHTS); that socket then only serves as a liveness
+// signal. Wake-ups use futexes on counters inside the mapping, and a side
+// only issues FUTEX_WAKE when the peer has announced it is going to sleep.
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Shm {
+
+constexpr uint32_t kMagic = 0x4c445253;  // "LDRS"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kDefaultRingCapacity = 1 << 20;  // per direction, power of two
+constexpr int kSpinIterations = 2000;  // busy-wait budget before sleeping on the futex
+constexpr long kWaitTimeoutMs = 100;  // liveness re-check interval while sleeping
+
+// Control block of one ring. Producer and consumer fields sit on separate
+// cache lines.
+struct RingControl {
+    alignas(64) std::atomic<uint64_t> tail{0};        // bytes written (producer)
+    std::atomic<uint32_t> space_seq{0};               // bumped when consumer frees space
+    std::atomic<uint32_t> producer_sleeping{0};
+    alignas(64) std::atomic<uint64_t> head{0};        // bytes consumed (consumer)
+    std::atomic<uint32_t> data_seq{0};                // bumped when producer adds data
+    std::atomic<uint32_t> consumer_sleeping{0};
+};
+
+struct SegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ring_capacity;
+    alignas(64) std::atomic<uint32_t> closed{0};  // set by either side on shutdown
+    RingControl to_server;
+    RingControl to_client;
+    // followed by: to_server data[ring_capacity], to_client data[ring_capacity]
+};
+
+inline size_t segment_size(size_t ring_capacity) {
+    return sizeof(SegmentHeader) + 2 * ring_capacity;
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+inline int futex_wait(std::atomic<uint32_t>* addr, uint32_t expected, long timeout_ms) {
+    struct timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    return static_cast<int>(syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT,
+                                    expected, &ts, nullptr, 0));
+}
+
+inline void futex_wake(std::atomic<uint32_t>* addr) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/**
+ * Bidirectional byte channel over a shared segment. send()/recv() block like
+ * send(MSG_NOSIGNAL)/recv(MSG_WAITALL) on a socket and fail once the peer
+ * has closed or died.
+ */
+class Channel {
+public:
+    ~Channel() { close(); }
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    // Proxy side: create the segment and hand it to the server listening on path.
+    static std::unique_ptr<Channel> connect(const std::string& path,
+                                            size_t ring_capacity = kDefaultRingCapacity) {
+        int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (sock < 0) return nullptr;
+        struct sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (::connect(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(sock);
+            return nullptr;
+        }
+
+        int memfd = static_cast<int>(syscall(SYS_memfd_create, "lineairdb-shm", MFD_CLOEXEC));
+        size_t size = segment_size(ring_capacity);
+        if (memfd < 0 || ftruncate(memfd, static_cast<off_t>(size)) < 0) {
+            if (memfd >= 0) ::close(memfd);
+            ::close(sock);
+            return nullptr;
+        }
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+        if (base == MAP_FAILED) {
+            ::close(memfd);
+            ::close(sock);
+            return nullptr;
+        }
+        auto* header = new (base) SegmentHeader();
+        header->magic = kMagic;
+        header->version = kVersion;
+        header->ring_capacity = ring_capacity;
+
+        // Pass the memfd, then wait for the server to confirm it mapped it
+        bool ok = send_fd(sock, memfd);
+        ::close(memfd);
+        char ack = 0;
+        ok = ok && ::recv(sock, &ack, 1, MSG_WAITALL) == 1 && ack == 1;
+        if (!ok) {
+            munmap(base, size);
+            ::close(sock);
+            return nullptr;
+        }
+        return std::unique_ptr<Channel>(new Channel(sock, base, size, /*is_server=*/false));
+    }
+
+    // Server side: take the segment offered on an accepted Unix socket.
+    static std::unique_ptr<Channel> accept(int sock) {
+        int memfd = recv_fd(sock);
+        if (memfd < 0) return nullptr;
+
+        SegmentHeader probe;
+        bool ok = pread(memfd, &probe, sizeof(probe), 0) == static_cast<ssize_t>(sizeof(probe)) &&
+                  probe.magic == kMagic && probe.version == kVersion &&
+                  probe.ring_capacity > 0 && (probe.ring_capacity & (probe.ring_capacity - 1)) == 0;
+        void* base = MAP_FAILED;
+        size_t size = ok ? segment_size(probe.ring_capacity) : 0;
+        if (ok) {
+            base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+        }
+        ::close(memfd);
+        char ack = 1;
+        if (base == MAP_FAILED || ::send(sock, &ack, 1, MSG_NOSIGNAL) != 1) {
+            if (base != MAP_FAILED) munmap(base, size);
+            return nullptr;
+        }
+        return std::unique_ptr<Channel>(new Channel(sock, base, size, /*is_server=*/true));
+    }
+
+    bool send(const void* data, size_t len) {
+        const char* src = static_cast<const char*>(data);
+        RingControl& ring = *tx_;
+        while (len > 0) {
+            uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+            size_t free_bytes = capacity_ - (tail - ring.head.load(std::memory_order_acquire));
+            if (free_bytes == 0) {
+                if (!wait_for(ring.space_seq, ring.producer_sleeping,
+                              [&] { return tail - ring.head.load(std::memory_order_acquire) < capacity_; })) {
+                    return false;
+                }
+                continue;
+            }
+            size_t n = len < free_bytes ? len : free_bytes;
+            copy_in(tx_data_, tail, src, n);
+            ring.tail.store(tail + n, std::memory_order_release);
+            notify(ring.data_seq, ring.consumer_sleeping);
+            src += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    bool recv(void* data, size_t len) {
+        char* dst = static_cast<char*>(data);
+        RingControl& ring = *rx_;
+        while (len > 0) {
+            uint64_t head = ring.head.load(std::memory_order_relaxed);
+            size_t avail = ring.tail.load(std::memory_order_acquire) - head;
+            if (avail == 0) {
+                if (!wait_for(ring.data_seq, ring.consumer_sleeping,
+                              [&] { return ring.tail.load(std::memory_order_acquire) != head; })) {
+                    return false;
+                }
+                continue;
+            }
+            size_t n = len < avail ? len : avail;
+            copy_out(rx_data_, head, dst, n);
+            ring.head.store(head + n, std::memory_order_release);
+            notify(ring.space_seq, ring.producer_sleeping);
+            dst += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    // False once the peer process has closed its end or exited.
+    bool peer_alive() const {
+        struct pollfd pfd{sock_, POLLIN | POLLRDHUP, 0};
+        if (poll(&pfd, 1, 0) <= 0) return true;
+        return !(pfd.revents & (POLLHUP | POLLRDHUP | POLLERR | POLLIN));
+    }
+
+    // Fail pending and future send()/recv() on both sides without unmapping,
+    // so it is safe while another thread is blocked in one of them.
+    void shutdown() {
+        if (base_ == nullptr) return;
+        header_->closed.store(1, std::memory_order_release);
+        for (RingControl* ring : {rx_, tx_}) {
+            ring->data_seq.fetch_add(1, std::memory_order_release);
+            ring->space_seq.fetch_add(1, std::memory_order_release);
+            futex_wake(&ring->data_seq);
+            futex_wake(&ring->space_seq);
+        }
+    }
+
+    void close() {
+        if (base_ != nullptr) {
+            header_->closed.store(1, std::memory_order_release);
+            futex_wake(&rx_->space_seq);
+            futex_wake(&tx_->data_seq);
+            munmap(base_, size_);
+            base_ = nullptr;
+        }
+        if (sock_ >= 0) {
+            ::close(sock_);
+            sock_ = -1;
+        }
+    }
+
+private:
+    Channel(int sock, void* base, size_t size, bool is_server)
+        : sock_(sock), base_(base), size_(size) {
+        header_ = static_cast<SegmentHeader*>(base);
+        capacity_ = header_->ring_capacity;
+        char* to_server_data = static_cast<char*>(base) + sizeof(SegmentHeader);
+        char* to_client_data = to_server_data + capacity_;
+        if (is_server) {
+            rx_ = &header_->to_server;
+            rx_data_ = to_server_data;
+            tx_ = &header_->to_client;
+            tx_data_ = to_client_data;
+        } else {
+            tx_ = &header_->to_server;
+            tx_data_ = to_server_data;
+            rx_ = &header_->to_client;
+            rx_data_ = to_client_data;
+        }
+    }
+
+    void copy_in(char* ring_data, uint64_t pos, const char* src, size_t n) {
+        size_t off = pos & (capacity_ - 1);
+        size_t first = n < capacity_ - off ? n : capacity_ - off;
+        std::memcpy(ring_data + off, src, first);
+        std::memcpy(ring_data, src + first, n - first);
+    }
+
+    void copy_out(const char* ring_data, uint64_t pos, char* dst, size_t n) {
+        size_t off = pos & (capacity_ - 1);
+        size_t first = n < capacity_ - off ? n : capacity_ - off;
+        std::memcpy(dst, ring_data + off, first);
+        std::memcpy(dst + first, ring_data, n - first);
+    }
+
+    // Producer side of the sleep handshake: the index store above and the
+    // sleeping load below are ordered by the fence, pairing with wait_for().
+    static void notify(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& sleeping) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) {
+            seq.fetch_add(1, std::memory_order_release);
+            futex_wake(&seq);
+        }
+    }
+
+    // Spinning only pays off when the peer can run concurrently; on a single
+    // CPU it just burns the time slice the peer needs.
+    static int spin_iterations() {
+        static const int spins = std::thread::hardware_concurrency() > 1 ? kSpinIterations : 0;
+        return spins;
+    }
+
+    // Spin, then sleep on seq until ready() holds. Returns false if the
+    // channel was closed or the peer went away.
+    template <typename Ready>
+    bool wait_for(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& sleeping, Ready ready) {
+        for (int i = 0; i < spin_iterations(); i++) {
+            if (ready()) return true;
+            cpu_relax();
+        }
+        while (true) {
+            if (header_->closed.load(std::memory_order_acquire) || !peer_alive()) return false;
+            uint32_t observed = seq.load(std::memory_order_acquire);
+            sleeping.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ready()) {
+                sleeping.store(0, std::memory_order_relaxed);
+                return true;
+            }
+            futex_wait(&seq, observed, kWaitTimeoutMs);
+            sleeping.store(0, std::memory_order_relaxed);
+            if (ready()) return true;
+        }
+    }
+
+    static bool send_fd(int sock, int fd) {
+        char byte = 0;
+        struct iovec iov{&byte, 1};
+        alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        struct msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+        return sendmsg(sock, &msg, MSG_NOSIGNAL) == 1;
+    }
+
+    static int recv_fd(int sock) {
+        char byte;
+        struct iovec iov{&byte, 1};
+        alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        struct msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != 1) return -1;
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            return -1;
+        }
+        int fd;
+        std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+        return fd;
+    }
+
+    int sock_;
+    void* base_;
+    size_t size_;
+    SegmentHeader* header_;
+    size_t capacity_;
+    RingControl* tx_;
+    char* tx_data_;
+    RingControl* rx_;
+    char* rx_data_;
+};
+
+}  // namespace Shm
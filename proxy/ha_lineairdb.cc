@@ -102,6 +102,7 @@
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <string_view>
@@ -109,6 +110,8 @@
 #include <strings.h>
 
 #include "lineairdb_field_types.h"
+#include "lineairdb_mux.hh"
+#include "lineairdb_proxy_pool.hh"
 #include "lineairdb.pb.h"
 #include "my_dbug.h"
 #include "mysql/plugin.h"
@@ -141,6 +144,13 @@ constexpr unsigned char kKeyTypeOther = 0xF0;
 // LineairDB server connection target (GLOBAL sysvars backing storage)
 static char *srv_server_host = nullptr;
 static ulong srv_server_port = 9999;
+static char *srv_shm_socket = nullptr;
+static ulong srv_mux_connections = 0;
+static ulong srv_proxy_pool_size = 64;
+static ulong srv_proxy_pool_warmup = 0;
+static ulong srv_compression = 0;  // index into compression_names
+static ulong srv_compression_threshold = 64 * 1024;
+static ulong srv_protocol_version = Rpc::kProtocolVersion;
 
 // THD-scoped context
 struct LineairDBThdCtx {
@@ -148,6 +158,97 @@ struct LineairDBThdCtx {
   LineairDBTransaction *tx{nullptr};
 };
 
+// Shared server connections when lineairdb_mux_connections > 0, otherwise a
+// pool of pre-connected proxies reused across sessions. Both are rebuilt when
+// the connection sysvars change; THDs already holding an old one keep it
+// until they disconnect.
+static std::mutex connection_mutex;
+static std::shared_ptr<ConnectionMux> mux_pool;
+static std::shared_ptr<ProxyPool> proxy_pool;
+static ProxyPoolStats proxy_pool_stats;
+
+struct ConnectionTarget {
+  std::string host;
+  int port;
+  std::string shm_socket;
+  SessionOptions options;
+};
+
+static ConnectionTarget connection_target() {
+  SessionOptions options;
+  // compression_names is {"off", "lz4", "zstd"}, matching Rpc::Codec
+  options.compression = static_cast<Rpc::Codec>(srv_compression);
+  options.compression_threshold =
+      static_cast<uint32_t>(srv_compression_threshold);
+  options.protocol_version = static_cast<uint32_t>(srv_protocol_version);
+  return {srv_server_host ? srv_server_host : std::string("127.0.0.1"),
+          static_cast<int>(srv_server_port),
+          srv_shm_socket ? srv_shm_socket : std::string(), options};
+}
+
+// Caller holds connection_mutex.
+static std::shared_ptr<ProxyPool> current_proxy_pool(
+    const ConnectionTarget &target) {
+  size_t capacity = static_cast<size_t>(srv_proxy_pool_size);
+  if (!proxy_pool || !proxy_pool->matches(target.host, target.port,
+                                          target.shm_socket, target.options)) {
+    proxy_pool = std::make_shared<ProxyPool>(target.host, target.port,
+                                             target.shm_socket, target.options,
+                                             capacity, proxy_pool_stats);
+  } else {
+    proxy_pool->set_capacity(capacity);
+  }
+  return proxy_pool;
+}
+
+/**
+ * Create the RPC proxy for a new THD from the GLOBAL sysvars: a slot on one
+ * of the shared connections when multiplexing is enabled, otherwise a
+ * private connection, taken from the proxy pool when pooling is on.
+ * nullptr if no shared connection could be opened; the next call retries.
+ */
+static std::shared_ptr<LineairDBProxy> make_proxy() {
+  ConnectionTarget target = connection_target();
+  size_t mux_connections = static_cast<size_t>(srv_mux_connections);
+  if (mux_connections > 0) {
+    std::shared_ptr<ConnectionMux> pool;
+    {
+      std::lock_guard<std::mutex> lock(connection_mutex);
+      if (!mux_pool ||
+          !mux_pool->matches(target.host, target.port, target.shm_socket,
+                             target.options, mux_connections)) {
+        mux_pool = std::make_shared<ConnectionMux>(
+            target.host, target.port, target.shm_socket, target.options,
+            mux_connections);
+      }
+      pool = mux_pool;
+    }
+    std::shared_ptr<MuxConnection> connection = pool->acquire();
+    if (!connection) {
+      LOG_ERROR("Failed to connect to LineairDB service at %s:%d",
+                target.host.c_str(), target.port);
+      return nullptr;
+    }
+    return std::make_shared<LineairDBProxy>(std::move(connection));
+  }
+
+  if (srv_proxy_pool_size == 0) {
+    {
+      // Pooling was switched off: close whatever the pool still holds
+      std::lock_guard<std::mutex> lock(connection_mutex);
+      if (proxy_pool) proxy_pool->set_capacity(0);
+    }
+    return std::make_shared<LineairDBProxy>(target.host, target.port,
+                                            target.shm_socket, target.options);
+  }
+  std::shared_ptr<ProxyPool> pool;
+  {
+    std::lock_guard<std::mutex> lock(connection_mutex);
+    pool = current_proxy_pool(target);
+  }
+  return pool->checkout();
+}
+
 static int lineairdb_commit(handlerton *hton, THD *thd, bool shouldCommit);
 static int lineairdb_abort(handlerton *hton, THD *thd, bool);
 
@@ -240,6 +341,19 @@ static int lineairdb_init_func(void *p) {
   lineairdb_hton->rollback = lineairdb_abort;
   lineairdb_hton->close_connection = lineairdb_close_connection;
 
+  // Pre-connect pooled proxies so the first sessions skip the connect
+  if (srv_mux_connections == 0 && srv_proxy_pool_size > 0 &&
+      srv_proxy_pool_warmup > 0) {
+    std::shared_ptr<ProxyPool> pool;
+    {
+      std::lock_guard<std::mutex> lock(connection_mutex);
+      pool = current_proxy_pool(connection_target());
+    }
+    size_t opened = pool->warm_up(static_cast<size_t>(srv_proxy_pool_warmup));
+    LOG_INFO("lineairdb_init_func: proxy pool warmed up with %zu connections",
+             opened);
+  }
+
   return 0;
 }
 
@@ -283,10 +397,7 @@ LineairDBProxy *ha_lineairdb::get_proxy() {
     ctx = new LineairDBThdCtx();
   if (!ctx->proxy) {
     // Construct RPC proxy using GLOBAL sysvars
-    std::string host =
-        srv_server_host ? srv_server_host : std::string("127.0.0.1");
-    int port = static_cast<int>(srv_server_port);
-    ctx->proxy = std::make_shared<LineairDBProxy>(host, port);
+    ctx->proxy = make_proxy();
   }
   return ctx->proxy.get();
 }
@@ -481,14 +592,14 @@ int ha_lineairdb::write_row(uchar *buf) {
 
   auto tx = get_transaction(ha_thd());
 
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
 
   // buffer_write appends to a local buffer (no RPC yet), so no error check needed.
-  // The actual RPC is sent at flush time (buffer full, table change, or commit).
-  tx->buffer_write(db_table_name, key, write_buffer_);
+  // The actual RPC is sent at flush time (buffer full, next read, or commit).
+  tx->buffer_write(db_table_name, key, write_buffer_, &share->handles);
 
   // Write secondary index entries.
   // Non-UNIQUE indexes are buffered (batched) for performance, just like PK writes.
@@ -509,7 +620,7 @@ int ha_lineairdb::write_row(uchar *buf) {
       // data (otherwise it can't reliably detect duplicates).
       // Step 2: send this UNIQUE index write immediately via RPC.
       tx->flush_write_buffer();
-      tx->choose_table(db_table_name);
+      tx->choose_table(db_table_name, &share->handles);
       bool ok = tx->write_secondary_index(key_info.name, secondary_key, key);
       if (!ok || tx->is_aborted()) {
         thd_mark_transaction_to_rollback(ha_thd(), 1);
@@ -517,7 +628,7 @@ int ha_lineairdb::write_row(uchar *buf) {
       }
     } else {
       tx->buffer_write_secondary_index(db_table_name, key_info.name,
-                                        secondary_key, key);
+                                        secondary_key, key, &share->handles);
     }
   }
 
@@ -550,20 +661,15 @@ int ha_lineairdb::update_row(const uchar *old_data, uchar *new_data) {
 
   auto tx = get_transaction(ha_thd());
 
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
 
-  tx->choose_table(db_table_name);
-  bool is_successful = tx->write(key, write_buffer_);
-  if (!is_successful)
-    return HA_ERR_LOCK_DEADLOCK;
-
-  if (tx->is_aborted()) {
-    thd_mark_transaction_to_rollback(ha_thd(), 1);
-    return HA_ERR_LOCK_DEADLOCK;
-  }
+  // Buffered like write_row(): the row and its non-UNIQUE index moves go out
+  // with the statement's other deferred writes (TX_MULTI), and an abort
+  // surfaces at the next flush.
+  tx->buffer_write(db_table_name, key, write_buffer_, &share->handles);
 
   for (uint i = 0; i < table->s->keys; i++) {
     auto key_info = table->key_info[i];
@@ -581,15 +687,28 @@ int ha_lineairdb::update_row(const uchar *old_data, uchar *new_data) {
       continue;
     }
 
-    tx->update_secondary_index(key_info.name, old_secondary_key,
-                               new_secondary_key, key);
-
-    if (tx->is_aborted()) {
-      thd_mark_transaction_to_rollback(ha_thd(), 1);
-      return HA_ERR_LOCK_DEADLOCK;
+    if (key_info.flags & HA_NOSAME) {
+      // Duplicate check must happen now, against everything written so far
+      tx->flush_write_buffer();
+      tx->choose_table(db_table_name, &share->handles);
+      tx->update_secondary_index(key_info.name, old_secondary_key,
+                                 new_secondary_key, key);
+      if (tx->is_aborted()) {
+        thd_mark_transaction_to_rollback(ha_thd(), 1);
+        return HA_ERR_LOCK_DEADLOCK;
+      }
+    } else {
+      tx->buffer_update_secondary_index(db_table_name, key_info.name,
+                                        old_secondary_key, new_secondary_key,
+                                        key, &share->handles);
     }
   }
 
+  if (tx->is_aborted()) {
+    thd_mark_transaction_to_rollback(ha_thd(), 1);
+    return HA_ERR_LOCK_DEADLOCK;
+  }
+
   return 0;
 }
 
@@ -610,38 +729,27 @@ int ha_lineairdb::delete_row(const uchar *buf) {
 
   auto tx = get_transaction(ha_thd());
 
-  if (tx->is_aborted()) {
-    thd_mark_transaction_to_rollback(ha_thd(), 1);
-    return HA_ERR_LOCK_DEADLOCK;
-  }
-
-  tx->choose_table(db_table_name);
-  bool is_successful = tx->delete_value(key);
-  if (!is_successful)
-    return HA_ERR_LOCK_DEADLOCK;
-
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
 
+  // The delete and its index entries are buffered (see update_row())
+  tx->buffer_delete(db_table_name, key, &share->handles);
   for (uint i = 0; i < table->s->keys; i++) {
     auto key_info = table->key_info[i];
     if (i != table->s->primary_key) {
-      std::string secondary_key = build_secondary_key_from_row(buf, key_info);
-
-      bool is_successful =
-          tx->delete_secondary_index(key_info.name, secondary_key, key);
-      if (!is_successful)
-        return HA_ERR_LOCK_DEADLOCK;
-
-      if (tx->is_aborted()) {
-        thd_mark_transaction_to_rollback(ha_thd(), 1);
-        return HA_ERR_LOCK_DEADLOCK;
-      }
+      tx->buffer_delete_secondary_index(db_table_name, key_info.name,
+                                        build_secondary_key_from_row(buf, key_info),
+                                        key, &share->handles);
     }
   }
 
+  if (tx->is_aborted()) {
+    thd_mark_transaction_to_rollback(ha_thd(), 1);
+    return HA_ERR_LOCK_DEADLOCK;
+  }
+
   tx->add_rowcount_delta(share, db_table_name, -1);
 
   return 0;
@@ -655,12 +763,12 @@ int ha_lineairdb::index_read_map(uchar *buf, const uchar *key,
   stats.records = 0;
   auto tx = get_transaction(ha_thd());
 
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
 
-  tx->choose_table(db_table_name);
+  tx->choose_table(db_table_name, &share->handles);
 
   KEY *key_info = &table->key_info[active_index];
 
@@ -677,11 +785,11 @@ int ha_lineairdb::index_next(uchar *buf) {
   DBUG_TRACE;
 
   auto tx = get_transaction(ha_thd());
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
-  tx->choose_table(db_table_name);
+  tx->choose_table(db_table_name, &share->handles);
 
   // materialize mode
   if (secondary_index_results_.empty() ||
@@ -697,11 +805,11 @@ int ha_lineairdb::index_next_same(uchar *buf, const uchar *key [[maybe_unused]],
   DBUG_TRACE;
 
   auto tx = get_transaction(ha_thd());
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
-  tx->choose_table(db_table_name);
+  tx->choose_table(db_table_name, &share->handles);
 
   // materialize mode
   if (secondary_index_results_.empty() ||
@@ -721,11 +829,11 @@ int ha_lineairdb::index_prev(uchar *buf) {
   DBUG_TRACE;
 
   auto tx = get_transaction(ha_thd());
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
-  tx->choose_table(db_table_name);
+  tx->choose_table(db_table_name, &share->handles);
 
   // materialize mode
   if (secondary_index_results_.empty() || current_position_in_index_ < 2) {
@@ -776,12 +884,12 @@ int ha_lineairdb::index_last(uchar *buf) {
   last_fetched_primary_key_.clear();
 
   auto tx = get_transaction(ha_thd());
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
 
-  tx->choose_table(db_table_name);
+  tx->choose_table(db_table_name, &share->handles);
 
   if (active_index == table->s->primary_key) {
     auto key_values = tx->get_matching_keys_and_values_in_range("", "");
@@ -1023,12 +1131,12 @@ int ha_lineairdb::rnd_init(bool) {
 
   auto tx = get_transaction(ha_thd());
 
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     DBUG_RETURN(HA_ERR_LOCK_DEADLOCK);
   }
 
-  tx->choose_table(db_table_name);
+  tx->choose_table(db_table_name, &share->handles);
 
   // Predicate pushdown: propagate filter serialized by cond_push() to transaction
   if (!pushed_filter_serialized_.empty()) {
@@ -1064,11 +1172,11 @@ bool ha_lineairdb::fetch_next_batch() {
   DBUG_ENTER("ha_lineairdb::fetch_next_batch");
 
   auto tx = get_transaction(ha_thd());
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     DBUG_RETURN(false);
   }
 
-  tx->choose_table(db_table_name);
+  tx->choose_table(db_table_name, &share->handles);
 
   scanned_keys_.clear();
   scanned_values_.clear();
@@ -1111,6 +1219,7 @@ bool ha_lineairdb::fetch_next_batch() {
 void ha_lineairdb::reset_index_search_buffers() {
   secondary_index_results_.clear();
   secondary_index_payloads_.clear();
+  secondary_index_batch_.clear();
   current_position_in_index_ = 0;
 }
 
@@ -1142,7 +1251,7 @@ int ha_lineairdb::rnd_next(uchar *buf) {
 
     if (!fetch_next_batch()) {
       auto tx = get_transaction(ha_thd());
-      if (tx->is_aborted()) {
+      if (!tx || tx->is_aborted()) {
         DBUG_RETURN(HA_ERR_LOCK_DEADLOCK);
       }
       scan_exhausted_ = true;
@@ -1230,12 +1339,12 @@ int ha_lineairdb::rnd_pos(uchar *buf, uchar *pos) {
 
   auto tx = get_transaction(ha_thd());
 
-  if (tx->is_aborted()) {
+  if (!tx || tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
 
-  tx->choose_table(db_table_name);
+  tx->choose_table(db_table_name, &share->handles);
   auto result = tx->read(primary_key);
 
   if (result.first == nullptr || result.second == 0) {
@@ -1483,7 +1592,9 @@ int ha_lineairdb::external_lock(THD *thd, int lock_type) {
   }
 
   // get_transaction() will automatically start the transaction if needed
-  (void)get_transaction(thd);
+  if (get_transaction(thd) == nullptr) {
+    return HA_ERR_NO_CONNECTION;
+  }
 
   // Stats sync: apply cached table row counts from the server (received
   // in BEGIN/END responses) so the optimizer sees correct cardinalities.
@@ -1535,10 +1646,10 @@ LineairDBTransaction *&ha_lineairdb::get_transaction(THD *thd) {
   if (ctx == nullptr)
     ctx = new LineairDBThdCtx();
   if (!ctx->proxy) {
-    std::string host =
-        srv_server_host ? srv_server_host : std::string("127.0.0.1");
-    int port = static_cast<int>(srv_server_port);
-    ctx->proxy = std::make_shared<LineairDBProxy>(host, port);
+    ctx->proxy = make_proxy();
+    if (!ctx->proxy) {
+      return ctx->tx;  // nullptr: no connection to start a transaction on
+    }
   }
   if (ctx->tx == nullptr) {
     ctx->tx =
@@ -1898,6 +2009,9 @@ int ha_lineairdb::create(const char *table_name, TABLE *table, HA_CREATE_INFO *,
   // storage. The table may already exist from another node's CREATE TABLE.
   // Ignore "already exists" — MySQL-side metadata still needs to be created.
   auto proxy = get_proxy();
+  if (proxy == nullptr) {
+    return HA_ERR_NO_CONNECTION;
+  }
   proxy->db_create_table(db_table_name);
 
   // Create secondary indexes (also ignore "already exists")
@@ -1947,6 +2061,10 @@ bool ha_lineairdb::inplace_alter_table(TABLE *altered_table [[maybe_unused]],
 
   userThread = ha_thd();
   auto proxy = get_proxy();
+  if (proxy == nullptr) {
+    my_error(ER_GET_ERRNO, MYF(0), HA_ERR_NO_CONNECTION, "LineairDB");
+    return true;
+  }
 
   for (uint i = 0; i < ha_alter_info->index_add_count; i++) {
     uint key_idx = ha_alter_info->index_add_buffer[i];
@@ -2071,22 +2189,22 @@ int ha_lineairdb::multi_range_read_init(RANGE_SEQ_IF *seq, void *seq_init_param,
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
-  tx->choose_table(db_table_name);
+  tx->choose_table(db_table_name, &share->handles);
 
   if (batch_keys.empty()) return 0;
 
-  // Send all keys in a single batch RPC
-  auto results = tx->batch_read(batch_keys);
+  // Send all keys in a single batch RPC; rows land in mrr_values_
+  tx->batch_read(batch_keys, mrr_values_);
 
   if (tx->is_aborted()) {
     thd_mark_transaction_to_rollback(ha_thd(), 1);
     return HA_ERR_LOCK_DEADLOCK;
   }
 
-  // Buffer results for multi_range_read_next()
-  for (size_t i = 0; i < results.size(); i++) {
-    if (results[i].first) {
-      mrr_buffer_.push_back({std::move(results[i].second), range_infos[i]});
+  // Buffer results for multi_range_read_next(); missing rows are empty
+  for (size_t i = 0; i < mrr_values_.values.size(); i++) {
+    if (!mrr_values_.values[i].empty()) {
+      mrr_buffer_.push_back({mrr_values_.values[i], range_infos[i]});
     }
   }
 
@@ -2676,21 +2794,17 @@ int ha_lineairdb::execute_prefix_last(uchar *buf, LineairDBTransaction *tx) {
  *   2) Row fetch  → read each row by primary key
  * Without this, step 2 would issue one READ RPC per row (N rows = N RPCs).
  * This method does step 2 in bulk: it sends all primary keys in a single
- * batch_read RPC and stores the results in secondary_index_payloads_.
+ * batch_read RPC and keeps the results in secondary_index_batch_.
  * When fetch_and_set_current_result() later returns rows one by one,
  * the data is already in memory — no further RPCs needed.
  */
 void ha_lineairdb::batch_fetch_secondary_payloads(LineairDBTransaction *tx) {
+  secondary_index_payloads_.clear();
+  secondary_index_batch_.clear();
   if (secondary_index_results_.empty()) return;
 
-  auto results = tx->batch_read(secondary_index_results_);
-
-  secondary_index_payloads_.clear();
-  secondary_index_payloads_.reserve(results.size());
-  for (auto &r : results) {
-    secondary_index_payloads_.push_back(
-        r.first ? std::move(r.second) : std::string());
-  }
+  // Rows stay in the response frame they arrived in; missing rows are empty
+  tx->batch_read(secondary_index_results_, secondary_index_batch_);
 }
 
 /**
@@ -2712,18 +2826,22 @@ int ha_lineairdb::fetch_and_set_current_result(uchar *buf,
   std::string primary_key =
       secondary_index_results_[current_position_in_index_];
 
-  tx->choose_table(db_table_name);
+  tx->choose_table(db_table_name, &share->handles);
 
-  const bool has_inline_value =
-      current_position_in_index_ < secondary_index_payloads_.size();
   const std::byte *value_ptr = nullptr;
   size_t value_size = 0;
 
-  if (has_inline_value) {
+  if (current_position_in_index_ < secondary_index_payloads_.size()) {
     const std::string &inline_value =
         secondary_index_payloads_[current_position_in_index_];
     value_ptr = reinterpret_cast<const std::byte *>(inline_value.data());
     value_size = inline_value.size();
+  } else if (current_position_in_index_ <
+             secondary_index_batch_.values.size()) {
+    std::string_view batch_value =
+        secondary_index_batch_.values[current_position_in_index_];
+    value_ptr = reinterpret_cast<const std::byte *>(batch_value.data());
+    value_size = batch_value.size();
   } else {
     auto result = tx->read(primary_key);
     if (tx->is_aborted()) {
@@ -3350,10 +3468,65 @@ static MYSQL_SYSVAR_STR(server_host, srv_server_host,
 static MYSQL_SYSVAR_ULONG(server_port, srv_server_port, PLUGIN_VAR_RQCMDARG,
                           "LineairDB server TCP port.", nullptr, nullptr, 9999,
                           1, 65535, 0);
+static MYSQL_SYSVAR_STR(shm_socket, srv_shm_socket,
+                        PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_MEMALLOC,
+                        "Unix socket of a co-located LineairDB server started "
+                        "with --shm-socket. When set, new connections use the "
+                        "shared-memory transport (falling back to TCP if the "
+                        "handshake fails). Empty = TCP only.",
+                        nullptr, nullptr, "");
+static MYSQL_SYSVAR_ULONG(mux_connections, srv_mux_connections,
+                          PLUGIN_VAR_RQCMDARG,
+                          "Number of server connections shared by all client "
+                          "sessions. 0 = one private connection per session.",
+                          nullptr, nullptr, 0, 0, 1024, 0);
+static MYSQL_SYSVAR_ULONG(proxy_pool_size, srv_proxy_pool_size,
+                          PLUGIN_VAR_RQCMDARG,
+                          "Maximum number of idle server connections kept for "
+                          "reuse by later client sessions. 0 = connect and "
+                          "disconnect with every session.",
+                          nullptr, nullptr, 64, 0, 65536, 0);
+static MYSQL_SYSVAR_ULONG(proxy_pool_warmup, srv_proxy_pool_warmup,
+                          PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+                          "Number of pooled server connections opened when "
+                          "the plugin is initialized.",
+                          nullptr, nullptr, 0, 0, 65536, 0);
+
+const char *compression_names[] = {"off", "lz4", "zstd", NullS};
+TYPELIB compression_typelib = {array_elements(compression_names) - 1,
+                               "compression_typelib", compression_names,
+                               nullptr};
+static MYSQL_SYSVAR_ENUM(compression, srv_compression, PLUGIN_VAR_RQCMDARG,
+                         "Codec new TCP connections ask the server to "
+                         "compress large responses with: off, lz4 or zstd. "
+                         "Ignored for shared-memory connections.",
+                         nullptr, nullptr, 0, &compression_typelib);
+static MYSQL_SYSVAR_ULONG(compression_threshold, srv_compression_threshold,
+                          PLUGIN_VAR_RQCMDARG,
+                          "Responses smaller than this many bytes are never "
+                          "compressed.",
+                          nullptr, nullptr, 64 * 1024, 0, 1UL << 30, 0);
+static MYSQL_SYSVAR_ULONG(protocol_version, srv_protocol_version,
+                          PLUGIN_VAR_RQCMDARG,
+                          "Highest wire protocol version new connections "
+                          "offer the server: 1 = protobuf only, 2 = binary "
+                          "point reads and writes, 3 = numeric table/index "
+                          "handles, 4 = front-coded scan keys, 5 = TX_MULTI, "
+                          "6 = implicit begin/commit in TX_MULTI, 7 = durable "
+                          "fence.",
+                          nullptr, nullptr, Rpc::kProtocolVersion, 1,
+                          Rpc::kProtocolVersion, 0);
 
 static SYS_VAR *lineairdb_system_variables[] = {
     MYSQL_SYSVAR(server_host),
     MYSQL_SYSVAR(server_port),
+    MYSQL_SYSVAR(shm_socket),
+    MYSQL_SYSVAR(mux_connections),
+    MYSQL_SYSVAR(proxy_pool_size),
+    MYSQL_SYSVAR(proxy_pool_warmup),
+    MYSQL_SYSVAR(compression),
+    MYSQL_SYSVAR(compression_threshold),
+    MYSQL_SYSVAR(protocol_version),
     MYSQL_SYSVAR(enum_var),
     MYSQL_SYSVAR(ulong_var),
     MYSQL_SYSVAR(double_var),
@@ -3397,6 +3570,25 @@ static SHOW_VAR show_array_lineairdb[] = {
     {"var4", (char *)&lineairdb_vars.var4, SHOW_BOOL, SHOW_SCOPE_GLOBAL},
     {nullptr, nullptr, SHOW_UNDEF, SHOW_SCOPE_UNDEF}};
 
+// Proxy pool counters (SHOW STATUS LIKE 'lineairdb_proxy_pool%')
+template <std::atomic<uint64_t> ProxyPoolStats::*counter>
+static int show_proxy_pool_counter(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  var->type = SHOW_LONGLONG;
+  var->value = buf;
+  *reinterpret_cast<longlong *>(buf) = static_cast<longlong>(
+      (proxy_pool_stats.*counter).load(std::memory_order_relaxed));
+  return 0;
+}
+
+static int show_proxy_pool_idle(MYSQL_THD, SHOW_VAR *var, char *buf) {
+  var->type = SHOW_LONGLONG;
+  var->value = buf;
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  *reinterpret_cast<longlong *>(buf) =
+      proxy_pool ? static_cast<longlong>(proxy_pool->idle()) : 0;
+  return 0;
+}
+
 static SHOW_VAR func_status[] = {
     {"lineairdb_func_lineairdb", (char *)show_func_lineairdb, SHOW_FUNC,
      SHOW_SCOPE_GLOBAL},
@@ -3406,6 +3598,23 @@ static SHOW_VAR func_status[] = {
      SHOW_SCOPE_GLOBAL},
     {"lineairdb_status", (char *)show_array_lineairdb, SHOW_ARRAY,
      SHOW_SCOPE_GLOBAL},
+    {"lineairdb_proxy_pool_hits",
+     (char *)show_proxy_pool_counter<&ProxyPoolStats::hits>, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"lineairdb_proxy_pool_misses",
+     (char *)show_proxy_pool_counter<&ProxyPoolStats::misses>, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"lineairdb_proxy_pool_returned",
+     (char *)show_proxy_pool_counter<&ProxyPoolStats::returned>, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"lineairdb_proxy_pool_discarded",
+     (char *)show_proxy_pool_counter<&ProxyPoolStats::discarded>, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"lineairdb_proxy_pool_wait_us",
+     (char *)show_proxy_pool_counter<&ProxyPoolStats::wait_us>, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
+    {"lineairdb_proxy_pool_idle", (char *)show_proxy_pool_idle, SHOW_FUNC,
+     SHOW_SCOPE_GLOBAL},
     {nullptr, nullptr, SHOW_UNDEF, SHOW_SCOPE_UNDEF}};
 
 mysql_declare_plugin(lineairdb){
@@ -84,6 +84,9 @@ public:
 
   // Baseline for committed row count (currently unused; defaults to 0).
   std::atomic<uint64_t> stats_base_records{0};
+
+  // Server handles for this table and its indexes (protocol version 3+).
+  TableHandleCache handles;
 };
 
 /** @brief
@@ -122,6 +125,9 @@ private:
   std::unordered_map<std::string, size_t> scan_cache_;  // primary key -> index in scanned_values_
   std::vector<std::string> secondary_index_results_;
   std::vector<std::string> secondary_index_payloads_;
+  // Rows of secondary_index_results_ from batch_fetch_secondary_payloads(),
+  // when the scan did not return them in secondary_index_payloads_
+  LineairDBProxy::BatchReadValues secondary_index_batch_;
   std::string last_fetched_primary_key_;
   std::string end_range_exclusive_key_; // For HA_READ_BEFORE_KEY: exclude this key from results
   my_off_t
@@ -403,9 +409,10 @@ private:
 
   // MRR batch state
   struct MrrBufferedRow {
-    std::string value;
+    std::string_view value;  // into mrr_values_
     char *range_info;
   };
+  LineairDBProxy::BatchReadValues mrr_values_;  // batch_read() output, reused across batches
   std::vector<MrrBufferedRow> mrr_buffer_;
   size_t mrr_buffer_pos_ = 0;
   bool mrr_use_batch_ = false;
@@ -0,0 +1,305 @@
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+
+#include "lineairdb_mux.hh"
+#include "../common/log.h"
+#include "../common/shm_ring.h"
+
+int lineairdb_connect_tcp(const std::string& host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+
+    if (inet_pton(AF_INET, host.c_str(), &server_addr.sin_addr) <= 0 ||
+        ::connect(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Disable Nagle's algorithm for low-latency RPC
+    int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    return fd;
+}
+
+std::shared_ptr<MuxConnection> MuxConnection::open(const std::string& host, int port,
+                                                   const std::string& shm_socket,
+                                                   const SessionOptions& options) {
+    std::shared_ptr<MuxConnection> connection;
+    if (!shm_socket.empty()) {
+        auto shm = Shm::Channel::connect(shm_socket);
+        if (shm) {
+            connection.reset(new MuxConnection(-1, std::move(shm)));
+        } else {
+            LOG_WARNING("MuxConnection: shared-memory connect to %s failed, falling back to TCP",
+                        shm_socket.c_str());
+        }
+    }
+    if (!connection) {
+        int fd = lineairdb_connect_tcp(host, port);
+        if (fd < 0) {
+            LOG_ERROR("MuxConnection: failed to connect to %s:%d", host.c_str(), port);
+            return nullptr;
+        }
+        connection.reset(new MuxConnection(fd, nullptr));
+    }
+    if (!connection->say_hello(options)) {
+        LOG_ERROR("MuxConnection: session hello to %s:%d failed", host.c_str(), port);
+        return nullptr;
+    }
+    return connection;
+}
+
+MuxWaiter::MuxWaiter() : stream([]() {
+    static std::atomic<uint32_t> next_stream{1};
+    uint32_t id;
+    do {
+        id = next_stream.fetch_add(1, std::memory_order_relaxed);
+    } while (id == 0);  // stream 0 is an unshared connection's
+    return id;
+}()) {}
+
+// Same negotiation as LineairDBProxy::say_hello(), over the shared stream,
+// plus asking the server to run the waiters' streams independently.
+bool MuxConnection::say_hello(const SessionOptions& options) {
+    bool compress = options.compression != Rpc::Codec::NONE && !shm_;
+    if (!compress && options.protocol_version < Rpc::kBinaryPointOpsVersion) {
+        // Servers this old take no hello; they serve the connection serially
+        return true;
+    }
+    LineairDB::Protocol::SessionHello::Request request;
+    LineairDB::Protocol::SessionHello::Response response;
+    if (compress) {
+        request.add_compression_codecs(static_cast<uint32_t>(options.compression));
+        request.set_compression_threshold(options.compression_threshold);
+    }
+    request.set_protocol_version(options.protocol_version);
+    request.set_multiplexed(true);
+
+    MuxWaiter waiter;
+    Rpc::FrameBuffer frame;
+    Rpc::PayloadBuffer payload;
+    uint64_t request_id;
+    frame.build(static_cast<uint32_t>(MessageType::SESSION_HELLO), request);
+    bool ok = send(waiter, frame, request_id) && wait(waiter, request_id, payload) &&
+              payload.parse(response);
+    forget(waiter);
+    if (!ok) {
+        return false;
+    }
+    if (compress && static_cast<Rpc::Codec>(response.compression_codec()) != options.compression) {
+        LOG_WARNING("MuxConnection(%p): server does not support %s compression, continuing without",
+                    static_cast<const void*>(this), Rpc::codec_name(options.compression));
+    }
+    binary_point_ops_ = response.protocol_version() >= Rpc::kBinaryPointOpsVersion;
+    front_coded_keys_ = response.protocol_version() >= Rpc::kFrontCodedKeysVersion;
+    multi_ops_ = response.protocol_version() >= Rpc::kMultiOpsVersion;
+    implicit_begin_ = response.protocol_version() >= Rpc::kImplicitBeginVersion;
+    durable_fence_ = response.protocol_version() >= Rpc::kDurableFenceVersion;
+    if (response.protocol_version() >= Rpc::kTableHandlesVersion) {
+        handle_epoch_ = response.handle_epoch();
+    }
+    multiplexed_ = response.multiplexed();
+    if (!multiplexed_) {
+        LOG_WARNING("MuxConnection(%p): server runs shared connections serially, "
+                    "a slow request delays every session on it",
+                    static_cast<const void*>(this));
+    }
+    return true;
+}
+
+MuxConnection::MuxConnection(int socket_fd, std::unique_ptr<Shm::Channel> shm)
+    : socket_fd_(socket_fd), shm_(std::move(shm)) {
+    receiver_ = std::thread([this]() { receive_loop(); });
+}
+
+MuxConnection::~MuxConnection() {
+    mark_dead();
+    if (receiver_.joinable()) {
+        receiver_.join();
+    }
+    if (socket_fd_ >= 0) {
+        close(socket_fd_);
+    }
+}
+
+bool MuxConnection::send(MuxWaiter& waiter, Rpc::FrameBuffer& frame, uint64_t& request_id) {
+    if (!alive()) {
+        return false;
+    }
+    request_id = Rpc::make_request_id(waiter.stream, waiter.next_sequence++);
+    frame.set_request_id(request_id);
+
+    // Register before the frame leaves, or the reply could beat us to the map
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_[request_id] = &waiter;
+    }
+
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        ok = write_all(frame.data(), frame.size());
+    }
+    if (!ok) {
+        // A partial frame leaves the stream unusable for everyone
+        LOG_ERROR("MuxConnection(%p): failed to send request %lu",
+                  static_cast<const void*>(this), request_id);
+        mark_dead();
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_.erase(request_id);
+    }
+    return ok;
+}
+
+bool MuxConnection::wait(MuxWaiter& waiter, uint64_t request_id, Rpc::PayloadBuffer& response) {
+    std::unique_lock<std::mutex> lock(waiter.mutex);
+    waiter.cv.wait(lock, [&]() { return waiter.ready.count(request_id) != 0 || !alive(); });
+    auto it = waiter.ready.find(request_id);
+    if (it == waiter.ready.end()) {
+        return false;
+    }
+    // Take the receiver's buffer and give it the caller's previous one
+    response.swap(it->second);
+    it->second.trim();
+    waiter.spare.swap(it->second);
+    waiter.ready.erase(it);
+    return true;
+}
+
+void MuxConnection::forget(MuxWaiter& waiter) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (it->second == &waiter) {
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MuxConnection::receive_loop() {
+    Rpc::PayloadBuffer payload;
+    Rpc::PayloadBuffer compressed;
+    while (true) {
+        char header[Rpc::kHeaderSize];
+        if (!read_all(header, sizeof(header))) {
+            break;
+        }
+        uint64_t request_id;
+        uint32_t message_type;
+        uint32_t payload_size;
+        Rpc::decode_header(header, request_id, message_type, payload_size);
+        if (message_type & Rpc::kCompressedPayload) {
+            char* raw = compressed.prepare(payload_size);
+            if (payload_size > 0 && !read_all(raw, payload_size)) {
+                break;
+            }
+            size_t size = Rpc::decompressed_size(raw, payload_size);
+            if (!Rpc::decompress_payload(raw, payload_size, payload.prepare(size), size)) {
+                LOG_ERROR("MuxConnection(%p): failed to decompress response %lu",
+                          static_cast<const void*>(this), request_id);
+                break;
+            }
+            compressed.trim();
+        } else {
+            char* body = payload.prepare(payload_size);
+            if (payload_size > 0 && !read_all(body, payload_size)) {
+                break;
+            }
+        }
+
+        // Deliver under pending_mutex_ so forget() cannot free the waiter meanwhile
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        auto it = pending_.find(request_id);
+        if (it == pending_.end()) {
+            LOG_DEBUG("MuxConnection(%p): dropping response %lu with no waiter",
+                      static_cast<const void*>(this), request_id);
+            continue;
+        }
+        MuxWaiter* waiter = it->second;
+        pending_.erase(it);
+        {
+            // Hand the payload over without copying and continue in the
+            // waiter's spare storage, usually the buffer of its last response
+            std::lock_guard<std::mutex> waiter_lock(waiter->mutex);
+            waiter->ready[request_id].swap(payload);
+            payload.swap(waiter->spare);
+        }
+        waiter->cv.notify_one();
+    }
+
+    if (alive()) {
+        LOG_WARNING("MuxConnection(%p): connection to server lost", static_cast<const void*>(this));
+    }
+    mark_dead();
+}
+
+void MuxConnection::mark_dead() {
+    dead_.store(true, std::memory_order_release);
+    if (socket_fd_ >= 0) {
+        shutdown(socket_fd_, SHUT_RDWR);
+    }
+    if (shm_) {
+        shm_->shutdown();
+    }
+
+    // Wake everyone still waiting so they observe the failure
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    for (auto& entry : pending_) {
+        std::lock_guard<std::mutex> waiter_lock(entry.second->mutex);
+        entry.second->cv.notify_all();
+    }
+}
+
+bool MuxConnection::write_all(const void* data, size_t len) {
+    if (shm_) {
+        return shm_->send(data, len);
+    }
+    const char* p = static_cast<const char*>(data);
+    size_t total_sent = 0;
+    while (total_sent < len) {
+        ssize_t bytes_sent = ::send(socket_fd_, p + total_sent, len - total_sent, MSG_NOSIGNAL);
+        if (bytes_sent <= 0) {
+            return false;
+        }
+        total_sent += bytes_sent;
+    }
+    return true;
+}
+
+bool MuxConnection::read_all(void* data, size_t len) {
+    if (shm_) {
+        return shm_->recv(data, len);
+    }
+    return recv(socket_fd_, data, len, MSG_WAITALL) == static_cast<ssize_t>(len);
+}
+
+ConnectionMux::ConnectionMux(std::string host, int port, std::string shm_socket,
+                             SessionOptions options, size_t size)
+    : host_(std::move(host)), port_(port), shm_socket_(std::move(shm_socket)),
+      options_(options), connections_(size) {}
+
+std::shared_ptr<MuxConnection> ConnectionMux::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = connections_[next_++ % connections_.size()];
+    if (!slot || !slot->alive()) {
+        slot = MuxConnection::open(host_, port_, shm_socket_, options_);
+        if (slot) {
+            LOG_INFO("ConnectionMux: opened shared connection %p to %s",
+                     static_cast<const void*>(slot.get()),
+                     shm_socket_.empty() ? host_.c_str() : shm_socket_.c_str());
+        }
+    }
+    return slot;
+}
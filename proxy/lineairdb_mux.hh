@@ -0,0 +1,137 @@
+#ifndef LINEAIRDB_MUX_H
+#define LINEAIRDB_MUX_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "lineairdb_proxy.hh"
+#include "../common/rpc_buffer.h"
+
+namespace Shm {
+class Channel;
+}
+
+// Open a TCP connection with TCP_NODELAY set. Returns the fd or -1.
+int lineairdb_connect_tcp(const std::string& host, int port);
+
+/**
+ * Per-THD rendezvous point for responses on a shared connection. The
+ * receiver thread parks each response here under its request ID and wakes
+ * only this THD, so thousands of waiters never contend on one condvar.
+ * The waiter is also the THD's request stream: the server runs each stream's
+ * requests in order and different streams concurrently.
+ */
+struct MuxWaiter {
+    MuxWaiter();
+
+    const uint32_t stream;       // unique in this process, never 0
+    uint32_t next_sequence = 1;  // advanced by the owning THD only
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<uint64_t, Rpc::PayloadBuffer> ready;
+    // Storage wait() hands back; the receiver reads the next response into it
+    Rpc::PayloadBuffer spare;
+};
+
+/**
+ * One server connection shared by many LineairDBProxy instances.
+ *
+ * Senders serialize on a mutex only for the duration of the write; a request
+ * ID is the sending waiter's stream and sequence number (Rpc::make_request_id).
+ * A dedicated receiver thread reads response frames and hands each to the
+ * waiter that registered its ID, so a THD blocked on a slow RPC does not
+ * hold up replies addressed to others. The server runs each stream on its
+ * own thread when the connection negotiated SessionHello.multiplexed;
+ * otherwise it answers the connection's requests one at a time.
+ */
+class MuxConnection {
+public:
+    static std::shared_ptr<MuxConnection> open(const std::string& host, int port,
+                                               const std::string& shm_socket,
+                                               const SessionOptions& options);
+    ~MuxConnection();
+
+    bool alive() const { return !dead_.load(std::memory_order_acquire); }
+    // Server agreed to the binary point RPCs of common/point_codec.h
+    bool binary_point_ops() const { return binary_point_ops_; }
+    // Server sends scan keys front-coded (common/scan_codec.h)
+    bool front_coded_keys() const { return front_coded_keys_; }
+    // Server runs TX_MULTI
+    bool multi_ops() const { return multi_ops_; }
+    // TX_MULTI may begin and commit the transaction
+    bool implicit_begin() const { return implicit_begin_; }
+    // A fenced commit returns once it is durable
+    bool durable_fence() const { return durable_fence_; }
+    // Server instance whose table handles this connection may use; 0 = none
+    uint64_t handle_epoch() const { return handle_epoch_; }
+    // Server runs the waiters' streams concurrently
+    bool multiplexed() const { return multiplexed_; }
+
+    // Stamp a request ID on frame, send it and register waiter for the response.
+    bool send(MuxWaiter& waiter, Rpc::FrameBuffer& frame, uint64_t& request_id);
+    // Block until the response for request_id arrives or the connection dies.
+    bool wait(MuxWaiter& waiter, uint64_t request_id, Rpc::PayloadBuffer& response);
+    // Drop any outstanding registrations of waiter (before it is destroyed).
+    void forget(MuxWaiter& waiter);
+
+private:
+    MuxConnection(int socket_fd, std::unique_ptr<Shm::Channel> shm);
+
+    bool say_hello(const SessionOptions& options);
+    void receive_loop();
+    void mark_dead();
+    bool write_all(const void* data, size_t len);
+    bool read_all(void* data, size_t len);
+
+    int socket_fd_;
+    std::unique_ptr<Shm::Channel> shm_;
+    std::atomic<bool> dead_{false};
+    bool binary_point_ops_ = false;  // set once by say_hello() before sharing
+    bool front_coded_keys_ = false;  // likewise
+    bool multi_ops_ = false;         // likewise
+    bool implicit_begin_ = false;    // likewise
+    bool durable_fence_ = false;     // likewise
+    uint64_t handle_epoch_ = 0;      // likewise
+    bool multiplexed_ = false;       // likewise
+    std::mutex send_mutex_;
+    std::mutex pending_mutex_;
+    std::unordered_map<uint64_t, MuxWaiter*> pending_;
+    std::thread receiver_;
+};
+
+/**
+ * Fixed set of MuxConnections shared by every THD of this mysqld. acquire()
+ * hands them out round-robin and transparently replaces a connection whose
+ * receiver has seen it die.
+ */
+class ConnectionMux {
+public:
+    ConnectionMux(std::string host, int port, std::string shm_socket, SessionOptions options,
+                  size_t size);
+
+    std::shared_ptr<MuxConnection> acquire();
+
+    bool matches(const std::string& host, int port, const std::string& shm_socket,
+                 const SessionOptions& options, size_t size) const {
+        return host == host_ && port == port_ && shm_socket == shm_socket_ &&
+               options == options_ && size == connections_.size();
+    }
+
+private:
+    const std::string host_;
+    const int port_;
+    const std::string shm_socket_;
+    const SessionOptions options_;
+    std::mutex mutex_;
+    size_t next_ = 0;
+    std::vector<std::shared_ptr<MuxConnection>> connections_;
+};
+
+#endif // LINEAIRDB_MUX_H
@@ -1,4 +1,5 @@
 #include <sys/socket.h>
+#include <poll.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
@@ -9,12 +10,34 @@
 #include <vector>
 
 #include "lineairdb_proxy.hh"
+#include "lineairdb_mux.hh"
 #include "lineairdb_transaction.hh"
 #include "../common/log.h"
-
-
-LineairDBProxy::LineairDBProxy(const std::string& host, int port)
-    : socket_fd_(-1), connected_(false), host_(host), port_(port) {
+#include "../common/rpc_buffer.h"
+#include "../common/scan_codec.h"
+#include "../common/shm_ring.h"
+
+
+LineairDBProxy::LineairDBProxy(const std::string& host, int port, const std::string& shm_socket,
+                               const SessionOptions& options)
+    : socket_fd_(-1), connected_(false), options_(options), host_(host), port_(port),
+      shm_socket_(shm_socket) {
+    if (!shm_socket_.empty()) {
+        LOG_INFO("LineairDBProxy(%p): connecting via shared memory on %s",
+                 static_cast<const void*>(this), shm_socket_.c_str());
+        shm_ = Shm::Channel::connect(shm_socket_);
+        if (shm_) {
+            connected_ = true;
+            if (!say_hello()) {
+                LOG_ERROR("LineairDBProxy(%p): session hello over %s failed",
+                          static_cast<const void*>(this), shm_socket_.c_str());
+                disconnect();
+            }
+            return;
+        }
+        LOG_WARNING("LineairDBProxy(%p): shared-memory connect to %s failed, falling back to TCP",
+                    static_cast<const void*>(this), shm_socket_.c_str());
+    }
     LOG_INFO("LineairDBProxy(%p): connecting to %s:%d",
              static_cast<const void*>(this), host_.c_str(), port_);
     if (!connect(host_, port_)) {
@@ -22,6 +45,13 @@ LineairDBProxy::LineairDBProxy(const std::string& host, int port)
     }
 }
 
+LineairDBProxy::LineairDBProxy(std::shared_ptr<MuxConnection> connection)
+    : socket_fd_(-1), connected_(connection != nullptr), port_(0),
+      mux_(std::move(connection)), mux_waiter_(std::make_unique<MuxWaiter>()) {
+    LOG_DEBUG("LineairDBProxy(%p): multiplexed over connection %p",
+              static_cast<const void*>(this), static_cast<const void*>(mux_.get()));
+}
+
 LineairDBProxy::~LineairDBProxy() {
     LOG_INFO("LineairDBProxy(%p): destructor, connected=%s",
              static_cast<const void*>(this), connected_ ? "true" : "false");
@@ -33,38 +63,60 @@ bool LineairDBProxy::connect(const std::string& host, int port) {
         disconnect();
     }
 
-    // create TCP socket
-    socket_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    socket_fd_ = lineairdb_connect_tcp(host, port);
     if (socket_fd_ < 0) {
         return false;
     }
 
-    // set up server address
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-
-    if (inet_pton(AF_INET, host.c_str(), &server_addr.sin_addr) <= 0) {
-        close(socket_fd_);
-        socket_fd_ = -1;
+    connected_ = true;
+    host_ = host;
+    port_ = port;
+    if (!say_hello()) {
+        LOG_ERROR("LineairDBProxy(%p): session hello to %s:%d failed",
+                  static_cast<const void*>(this), host.c_str(), port);
+        disconnect();
         return false;
     }
+    return true;
+}
 
-    // connect
-    if (::connect(socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        close(socket_fd_);
-        socket_fd_ = -1;
+// Negotiate response compression and the protocol version. Shared memory is
+// never worth compressing for, and a proxy that wants neither skips the
+// round trip.
+bool LineairDBProxy::say_hello() {
+    bool compress = options_.compression != Rpc::Codec::NONE && !shm_;
+    binary_point_ops_ = false;
+    front_coded_keys_ = false;
+    multi_ops_ = false;
+    implicit_begin_ = false;
+    durable_fence_ = false;
+    handle_epoch_ = 0;
+    if (!compress && options_.protocol_version < Rpc::kBinaryPointOpsVersion) {
+        return true;
+    }
+    LineairDB::Protocol::SessionHello::Request request;
+    LineairDB::Protocol::SessionHello::Response response;
+    if (compress) {
+        request.add_compression_codecs(static_cast<uint32_t>(options_.compression));
+        request.set_compression_threshold(options_.compression_threshold);
+    }
+    request.set_protocol_version(options_.protocol_version);
+    if (!send_protobuf_message(request, response, MessageType::SESSION_HELLO)) {
         return false;
     }
-
-    // Disable Nagle's algorithm for low-latency RPC
-    int flag = 1;
-    setsockopt(socket_fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
-
-    connected_ = true;
-    host_ = host;
-    port_ = port;
+    Rpc::Codec accepted = static_cast<Rpc::Codec>(response.compression_codec());
+    if (compress && accepted != options_.compression) {
+        LOG_WARNING("LineairDBProxy(%p): server does not support %s compression, continuing without",
+                    static_cast<const void*>(this), Rpc::codec_name(options_.compression));
+    }
+    binary_point_ops_ = response.protocol_version() >= Rpc::kBinaryPointOpsVersion;
+    front_coded_keys_ = response.protocol_version() >= Rpc::kFrontCodedKeysVersion;
+    multi_ops_ = response.protocol_version() >= Rpc::kMultiOpsVersion;
+    implicit_begin_ = response.protocol_version() >= Rpc::kImplicitBeginVersion;
+    durable_fence_ = response.protocol_version() >= Rpc::kDurableFenceVersion;
+    if (response.protocol_version() >= Rpc::kTableHandlesVersion) {
+        handle_epoch_ = response.handle_epoch();
+    }
     return true;
 }
 
@@ -75,11 +127,30 @@ void LineairDBProxy::disconnect() {
         close(socket_fd_);
         socket_fd_ = -1;
     }
+    shm_.reset();
+    if (mux_) {
+        mux_->forget(*mux_waiter_);
+        mux_.reset();
+    }
     connected_ = false;
+    early_responses_.clear();
 }
 
 bool LineairDBProxy::is_connected() const {
-    return connected_;
+    return connected_ && (!mux_ || mux_->alive());
+}
+
+bool LineairDBProxy::is_reusable() const {
+    if (!is_connected() || !early_responses_.empty() || mux_) {
+        return false;
+    }
+    if (shm_) {
+        return shm_->peer_alive();
+    }
+    // Between requests nothing may be readable; EOF or stray bytes mean the
+    // server closed the connection or the stream is out of step.
+    struct pollfd pfd{socket_fd_, POLLIN | POLLRDHUP, 0};
+    return poll(&pfd, 1, 0) == 0;
 }
 
 int64_t LineairDBProxy::tx_begin_transaction() {
@@ -91,6 +162,7 @@ int64_t LineairDBProxy::tx_begin_transaction() {
 
     LineairDB::Protocol::TxBeginTransaction::Request request;
     LineairDB::Protocol::TxBeginTransaction::Response response;
+    request.set_stats_version(table_stats_version_);
     LOG_DEBUG("CLIENT: Created begin transaction request");
 
     if (!send_protobuf_message(request, response, MessageType::TX_BEGIN_TRANSACTION)) {
@@ -99,10 +171,7 @@ int64_t LineairDBProxy::tx_begin_transaction() {
     }
 
     // Cache table row counts from server for optimizer stats.
-    table_stats_cache_.clear();
-    for (const auto& ts : response.table_stats()) {
-        table_stats_cache_[ts.table_name()] = ts.row_count();
-    }
+    update_table_stats(response);
 
     LOG_DEBUG("CLIENT: tx_begin_transaction completed, tx_id: %ld, table_stats: %zu",
               response.transaction_id(), table_stats_cache_.size());
@@ -138,11 +207,26 @@ std::string LineairDBProxy::tx_read(LineairDBTransaction* tx, const std::string&
         return "";
     }
 
+    if (binary_point_ops()) {
+        uint8_t flags;
+        if (!call_point(MessageType::TX_READ, tx, {key}, flags)) {
+            LOG_ERROR("RPC failed: Failed to send message to server");
+            return "";
+        }
+        tx->set_aborted((flags & Rpc::kAborted) != 0);
+        if ((flags & Rpc::kFound) == 0) {
+            return "";
+        }
+        Rpc::PointReader reader(std::string_view(response_.data() + 1, response_.size() - 1));
+        std::string_view value = reader.read_bytes();
+        return reader.ok() ? std::string(value) : "";
+    }
+
     LineairDB::Protocol::TxRead::Request request;
     LineairDB::Protocol::TxRead::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     request.set_key(key);
     LOG_DEBUG("CLIENT: Created read request");
 
@@ -166,11 +250,21 @@ bool LineairDBProxy::tx_write(LineairDBTransaction* tx, const std::string& key,
         return false;
     }
 
+    if (binary_point_ops()) {
+        uint8_t flags;
+        if (!call_point(MessageType::TX_WRITE, tx, {key, value}, flags)) {
+            LOG_ERROR("RPC failed: Failed to send message to server");
+            return false;
+        }
+        tx->set_aborted((flags & Rpc::kAborted) != 0);
+        return (flags & Rpc::kFound) != 0;
+    }
+
     LineairDB::Protocol::TxWrite::Request request;
     LineairDB::Protocol::TxWrite::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     request.set_key(key);
     request.set_value(value);
     LOG_DEBUG("CLIENT: Created write request");
@@ -195,11 +289,21 @@ bool LineairDBProxy::tx_delete(LineairDBTransaction* tx, const std::string& key)
         return false;
     }
 
+    if (binary_point_ops()) {
+        uint8_t flags;
+        if (!call_point(MessageType::TX_DELETE, tx, {key}, flags)) {
+            LOG_ERROR("RPC failed: Failed to send message to server");
+            return false;
+        }
+        tx->set_aborted((flags & Rpc::kAborted) != 0);
+        return (flags & Rpc::kFound) != 0;
+    }
+
     LineairDB::Protocol::TxDelete::Request request;
     LineairDB::Protocol::TxDelete::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     request.set_key(key);
 
     if (!send_protobuf_message(request, response, MessageType::TX_DELETE)) {
@@ -213,43 +317,85 @@ bool LineairDBProxy::tx_delete(LineairDBTransaction* tx, const std::string& key)
     return response.success();
 }
 
-std::vector<LineairDBProxy::BatchReadResult> LineairDBProxy::tx_batch_read(
-    LineairDBTransaction* tx, const std::vector<std::string>& keys) {
+bool LineairDBProxy::tx_batch_read(LineairDBTransaction* tx, const std::vector<std::string>& keys,
+                                   BatchReadValues& out) {
     int64_t tx_id = tx->get_tx_id();
+    out.clear();
     if (!connected_) {
         LOG_ERROR("RPC failed: Not connected to server");
-        return {};
+        return false;
+    }
+
+    if (binary_point_ops()) {
+        // Flat response: the frame moves into out (response_ gets out's old
+        // buffer to reuse) and the values are views into it
+        uint64_t request_id;
+        uint8_t flags;
+        if (!start_batch_read_request(tx, keys, request_id) ||
+            !finish_point_request(request_id, flags)) {
+            LOG_ERROR("RPC failed: Failed to send batch_read message to server");
+            return false;
+        }
+        tx->set_aborted((flags & Rpc::kAborted) != 0);
+        out.frame.swap(response_);
+        Rpc::PointReader reader(std::string_view(out.frame.data() + 1, out.frame.size() - 1));
+        // An error response carries no entries and the aborted flag
+        bool complete = reader.read<uint32_t>() == keys.size();
+        out.values.resize(keys.size());
+        for (size_t i = 0; complete && i < keys.size(); i++) {
+            bool found = reader.read<uint8_t>() != 0;
+            std::string_view value = reader.read_bytes();
+            out.values[i] = found ? value : std::string_view();
+            complete = reader.ok();
+        }
+        if (!complete || !reader.done()) {
+            // Missing keys must not read as absent rows
+            if (!tx->is_aborted()) {
+                LOG_WARNING("tx_batch_read: malformed response for %zu keys (%zu bytes)",
+                            keys.size(), out.frame.size());
+            }
+            out.clear();
+            tx->set_aborted(true);
+            return false;
+        }
+        return true;
     }
 
     LineairDB::Protocol::TxBatchRead::Request request;
     LineairDB::Protocol::TxBatchRead::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     for (const auto& key : keys) {
         request.add_keys(key);
     }
 
     if (!send_protobuf_message(request, response, MessageType::TX_BATCH_READ)) {
         LOG_ERROR("RPC failed: Failed to send batch_read message to server");
-        return {};
+        return false;
     }
 
     tx->set_aborted(response.is_aborted());
-
-    std::vector<BatchReadResult> results;
-    results.reserve(response.results_size());
-    for (const auto& r : response.results()) {
-        results.push_back({r.found(), r.found() ? r.value() : ""});
+    if (static_cast<size_t>(response.results_size()) != keys.size()) {
+        tx->set_aborted(true);
+        return false;
     }
 
-    return results;
+    out.owned.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (response.results(i).found()) {
+            out.owned[i].swap(*response.mutable_results(i)->mutable_value());
+        }
+    }
+    out.view_owned();
+    return true;
 }
 
 bool LineairDBProxy::tx_batch_write(LineairDBTransaction* tx,
                                     const std::string& table_name,
                                     const std::vector<BatchWriteOp>& writes,
-                                    const std::vector<BatchSecondaryIndexOp>& si_writes) {
+                                    const std::vector<BatchSecondaryIndexOp>& si_writes,
+                                    TableHandleCache* handles) {
     int64_t tx_id = tx->get_tx_id();
     if (!connected_) {
         LOG_ERROR("RPC failed: Not connected to server");
@@ -260,7 +406,11 @@ bool LineairDBProxy::tx_batch_write(LineairDBTransaction* tx,
     LineairDB::Protocol::TxBatchWrite::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(table_name);
+    if (uint32_t table_id = table_handle(handles, table_name)) {
+        request.set_table_id(table_id);
+    } else {
+        request.set_table_name(table_name);
+    }
 
     for (const auto& w : writes) {
         auto* op = request.add_writes();
@@ -270,7 +420,11 @@ bool LineairDBProxy::tx_batch_write(LineairDBTransaction* tx,
 
     for (const auto& si : si_writes) {
         auto* op = request.add_secondary_index_writes();
-        op->set_index_name(si.index_name);
+        if (uint32_t index_id = index_handle(handles, table_name, si.index_name)) {
+            op->set_index_id(index_id);
+        } else {
+            op->set_index_name(si.index_name);
+        }
         op->set_secondary_key(si.secondary_key);
         op->set_primary_key(si.primary_key);
     }
@@ -284,6 +438,238 @@ bool LineairDBProxy::tx_batch_write(LineairDBTransaction* tx,
     return response.success();
 }
 
+namespace {
+using MultiOp = LineairDBProxy::MultiOp;
+using TxMulti = LineairDB::Protocol::TxMulti;
+
+static_assert(static_cast<int>(MultiOp::Kind::READ) == TxMulti::OP_READ &&
+                  static_cast<int>(MultiOp::Kind::DELETE) == TxMulti::OP_DELETE &&
+                  static_cast<int>(MultiOp::Kind::UPDATE_SECONDARY_INDEX) ==
+                      TxMulti::OP_UPDATE_SECONDARY_INDEX,
+              "MultiOp::Kind must follow TxMulti::Kind");
+
+// End of the run of WRITE / WRITE_SECONDARY_INDEX ops on ops[first]'s table
+size_t batch_write_run(const std::vector<MultiOp>& ops, size_t first) {
+    size_t end = first;
+    while (end < ops.size() &&
+           (ops[end].kind == MultiOp::Kind::WRITE ||
+            ops[end].kind == MultiOp::Kind::WRITE_SECONDARY_INDEX) &&
+           ops[end].table_name == ops[first].table_name) {
+        end++;
+    }
+    return end;
+}
+
+// Index of the first op after first that is not a DELETE_SECONDARY_INDEX on
+// first's table (first itself if it is not one)
+size_t secondary_delete_run(const std::vector<MultiOp>& ops, size_t first) {
+    size_t end = first;
+    while (end < ops.size() && ops[end].kind == MultiOp::Kind::DELETE_SECONDARY_INDEX &&
+           ops[end].table_name == ops[first].table_name) {
+        end++;
+    }
+    return end;
+}
+}  // namespace
+
+bool LineairDBProxy::tx_multi(LineairDBTransaction* tx, const std::vector<MultiOp>& ops,
+                              std::vector<MultiResult>* results) {
+    if (results) results->clear();
+    if (!connected_) {
+        LOG_ERROR("RPC failed: Not connected to server");
+        return false;
+    }
+    // TX_BATCH_WRITE's server path reads rows without copying them out of the
+    // request, so a plain run of inserts keeps using it, unless the TX_MULTI
+    // has to begin tx
+    if (ops.empty() || !multi_ops() ||
+        (batch_write_run(ops, 0) == ops.size() && tx->get_tx_id() != 0)) {
+        return run_multi_ops(tx, ops, results);
+    }
+    uint64_t request_id;
+    return start_multi(tx, ops, request_id) && finish_multi(tx, request_id, ops.size(), results);
+}
+
+bool LineairDBProxy::start_multi(LineairDBTransaction* tx, const std::vector<MultiOp>& ops,
+                                 uint64_t& request_id) {
+    if (!connected_ || !multi_ops()) {
+        return false;
+    }
+
+    TxMulti::Request request;
+    build_multi_request(tx, ops, request);
+    if (!start_protobuf_request(request, MessageType::TX_MULTI, request_id)) {
+        LOG_ERROR("RPC failed: Failed to send multi message to server");
+        return false;
+    }
+    return true;
+}
+
+bool LineairDBProxy::tx_multi_commit(LineairDBTransaction* tx, const std::vector<MultiOp>& ops,
+                                     bool isFence,
+                                     const std::vector<std::pair<std::string, int64_t>>& row_deltas) {
+    if (!connected_ || !implicit_begin()) {
+        LOG_ERROR("RPC failed: Not connected to server");
+        return false;
+    }
+
+    TxMulti::Request request;
+    TxMulti::Response response;
+    build_multi_request(tx, ops, request);
+    request.set_commit(true);
+    request.set_fence(isFence);
+    request.set_stats_version(table_stats_version_);
+    for (const auto& [table, delta] : row_deltas) {
+        auto* rd = request.add_row_deltas();
+        rd->set_table_name(table);
+        rd->set_delta(delta);
+    }
+
+    if (!send_protobuf_message(request, response, MessageType::TX_MULTI)) {
+        LOG_ERROR("RPC failed: Failed to send multi message to server");
+        return false;
+    }
+    // A commit response always carries the row counts
+    if (response.transaction_id() != 0) {
+        tx->set_tx_id(response.transaction_id());
+    }
+    update_table_stats(response);
+    tx->set_aborted(response.is_aborted());
+    LOG_DEBUG("CLIENT: tx_multi_commit ran %d of %zu ops, committed=%d", response.results_size(),
+              ops.size(), !response.is_aborted());
+    return !response.is_aborted();
+}
+
+void LineairDBProxy::build_multi_request(LineairDBTransaction* tx, const std::vector<MultiOp>& ops,
+                                         TxMulti::Request& request) {
+    request.set_transaction_id(tx->get_tx_id());
+    if (tx->get_tx_id() == 0) {
+        request.set_stats_version(table_stats_version_);
+    }
+    const std::string* table_name = nullptr;
+    for (const auto& op : ops) {
+        auto* m = request.add_ops();
+        m->set_kind(static_cast<TxMulti::Kind>(op.kind));
+        // Ops on the previous op's table leave it out
+        if (!table_name || *table_name != op.table_name) {
+            if (uint32_t table_id = table_handle(op.handles, op.table_name)) {
+                m->set_table_id(table_id);
+            } else {
+                m->set_table_name(op.table_name);
+            }
+            table_name = &op.table_name;
+        }
+        if (!op.index_name.empty()) {
+            if (uint32_t index_id = index_handle(op.handles, op.table_name, op.index_name)) {
+                m->set_index_id(index_id);
+            } else {
+                m->set_index_name(op.index_name);
+            }
+        }
+        m->set_key(op.key);
+        m->set_value(op.value);
+        m->set_secondary_key(op.secondary_key);
+        m->set_new_secondary_key(op.new_secondary_key);
+    }
+}
+
+void LineairDBProxy::note_implicit_begin(LineairDBTransaction* tx,
+                                         const TxMulti::Response& response) {
+    if (response.transaction_id() != 0) {
+        tx->set_tx_id(response.transaction_id());
+        update_table_stats(response);
+    }
+}
+
+bool LineairDBProxy::finish_multi(LineairDBTransaction* tx, uint64_t request_id,
+                                  size_t op_count, std::vector<MultiResult>* results) {
+    if (results) results->clear();
+    TxMulti::Response response;
+    if (!finish_protobuf_request(request_id, response)) {
+        return false;
+    }
+    note_implicit_begin(tx, response);
+    tx->set_aborted(response.is_aborted());
+    if (results) {
+        results->resize(response.results_size());
+        for (int i = 0; i < response.results_size(); i++) {
+            auto* r = response.mutable_results(i);
+            (*results)[i].found = r->found();
+            (*results)[i].value.swap(*r->mutable_value());
+            (*results)[i].values.assign(r->values().begin(), r->values().end());
+        }
+    }
+    LOG_DEBUG("CLIENT: tx_multi ran %d of %zu ops", response.results_size(), op_count);
+    return static_cast<size_t>(response.results_size()) == op_count && !response.is_aborted();
+}
+
+bool LineairDBProxy::run_multi_ops(LineairDBTransaction* tx, const std::vector<MultiOp>& ops,
+                                   std::vector<MultiResult>* results) {
+    // The single-op RPCs name tx's selected table; put it back afterwards
+    const std::string selected_table = tx->get_selected_table_name();
+    TableHandleCache* selected_handles = tx->selected_table_handles();
+    bool ok = true;
+    for (size_t i = 0; ok && i < ops.size() && !tx->is_aborted();) {
+        const MultiOp& op = ops[i];
+        size_t end = batch_write_run(ops, i);
+        if (end > i) {
+            std::vector<BatchWriteOp> writes;
+            std::vector<BatchSecondaryIndexOp> si_writes;
+            for (size_t j = i; j < end; j++) {
+                if (ops[j].kind == MultiOp::Kind::WRITE) {
+                    writes.push_back({ops[j].key, ops[j].value});
+                } else {
+                    si_writes.push_back({ops[j].index_name, ops[j].secondary_key, ops[j].key});
+                }
+            }
+            ok = tx_batch_write(tx, op.table_name, writes, si_writes, op.handles);
+            if (results) results->resize(results->size() + (end - i));
+            i = end;
+            continue;
+        }
+        end = secondary_delete_run(ops, i);
+        if (end > i + 1) {
+            std::vector<BatchSecondaryIndexOp> si_deletes;
+            for (size_t j = i; j < end; j++) {
+                si_deletes.push_back({ops[j].index_name, ops[j].secondary_key, ops[j].key});
+            }
+            tx->choose_table(op.table_name, op.handles);
+            ok = tx_delete_secondary_indexes(tx, si_deletes);
+            if (results) results->resize(results->size() + (end - i));
+            i = end;
+            continue;
+        }
+
+        tx->choose_table(op.table_name, op.handles);
+        MultiResult result;
+        switch (op.kind) {
+            case MultiOp::Kind::READ:
+                result.value = tx_read(tx, op.key);
+                result.found = !result.value.empty();
+                break;
+            case MultiOp::Kind::DELETE:
+                ok = tx_delete(tx, op.key);
+                break;
+            case MultiOp::Kind::READ_SECONDARY_INDEX:
+                result.values = tx_read_secondary_index(tx, op.index_name, op.secondary_key);
+                break;
+            case MultiOp::Kind::DELETE_SECONDARY_INDEX:
+                ok = tx_delete_secondary_index(tx, op.index_name, op.secondary_key, op.key);
+                break;
+            case MultiOp::Kind::UPDATE_SECONDARY_INDEX:
+                ok = tx_update_secondary_index(tx, op.index_name, op.secondary_key,
+                                               op.new_secondary_key, op.key);
+                break;
+            default:  // the writes went as a batch above
+                break;
+        }
+        if (results) results->push_back(std::move(result));
+        i++;
+    }
+    tx->choose_table(selected_table, selected_handles);
+    return ok && !tx->is_aborted() && (!results || results->size() == ops.size());
+}
+
 std::vector<std::string> LineairDBProxy::tx_read_secondary_index(LineairDBTransaction* tx,
                                                                   const std::string& index_name,
                                                                   const std::string& secondary_key) {
@@ -295,12 +681,36 @@ std::vector<std::string> LineairDBProxy::tx_read_secondary_index(LineairDBTransa
         return {};
     }
 
+    if (binary_point_ops()) {
+        uint8_t flags;
+        if (!call_point(MessageType::TX_READ_SECONDARY_INDEX, tx, {index_name, secondary_key}, flags)) {
+            LOG_ERROR("RPC failed: Failed to send message to server");
+            return {};
+        }
+        tx->set_aborted((flags & Rpc::kAborted) != 0);
+        Rpc::PointReader reader(std::string_view(response_.data() + 1, response_.size() - 1));
+        uint32_t count = reader.read<uint32_t>();
+        std::vector<std::string> values;
+        for (uint32_t i = 0; i < count && reader.ok(); i++) {
+            std::string_view value = reader.read_bytes();
+            if (reader.ok()) values.emplace_back(value);
+        }
+        if (!reader.done()) {
+            // A short list must not read as the index's complete entries
+            LOG_WARNING("tx_read_secondary_index: malformed response (%zu bytes)",
+                        response_.size());
+            tx->set_aborted(true);
+            return {};
+        }
+        return values;
+    }
+
     LineairDB::Protocol::TxReadSecondaryIndex::Request request;
     LineairDB::Protocol::TxReadSecondaryIndex::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
-    request.set_index_name(index_name);
+    set_table(request, tx);
+    set_index(request, tx, index_name);
     request.set_secondary_key(secondary_key);
 
     if (!send_protobuf_message(request, response, MessageType::TX_READ_SECONDARY_INDEX)) {
@@ -331,12 +741,22 @@ bool LineairDBProxy::tx_write_secondary_index(LineairDBTransaction* tx,
         return false;
     }
 
+    if (binary_point_ops()) {
+        uint8_t flags;
+        if (!call_point(MessageType::TX_WRITE_SECONDARY_INDEX, tx, {index_name, secondary_key, primary_key}, flags)) {
+            LOG_ERROR("RPC failed: Failed to send message to server");
+            return false;
+        }
+        tx->set_aborted((flags & Rpc::kAborted) != 0);
+        return (flags & Rpc::kFound) != 0;
+    }
+
     LineairDB::Protocol::TxWriteSecondaryIndex::Request request;
     LineairDB::Protocol::TxWriteSecondaryIndex::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
-    request.set_index_name(index_name);
+    set_table(request, tx);
+    set_index(request, tx, index_name);
     request.set_secondary_key(secondary_key);
     request.set_primary_key(primary_key);
 
@@ -363,12 +783,22 @@ bool LineairDBProxy::tx_delete_secondary_index(LineairDBTransaction* tx,
         return false;
     }
 
+    if (binary_point_ops()) {
+        uint8_t flags;
+        if (!call_point(MessageType::TX_DELETE_SECONDARY_INDEX, tx, {index_name, secondary_key, primary_key}, flags)) {
+            LOG_ERROR("RPC failed: Failed to send message to server");
+            return false;
+        }
+        tx->set_aborted((flags & Rpc::kAborted) != 0);
+        return (flags & Rpc::kFound) != 0;
+    }
+
     LineairDB::Protocol::TxDeleteSecondaryIndex::Request request;
     LineairDB::Protocol::TxDeleteSecondaryIndex::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
-    request.set_index_name(index_name);
+    set_table(request, tx);
+    set_index(request, tx, index_name);
     request.set_secondary_key(secondary_key);
     request.set_primary_key(primary_key);
 
@@ -383,6 +813,75 @@ bool LineairDBProxy::tx_delete_secondary_index(LineairDBTransaction* tx,
     return response.success();
 }
 
+bool LineairDBProxy::tx_delete_secondary_indexes(LineairDBTransaction* tx,
+                                                  const std::vector<BatchSecondaryIndexOp>& ops) {
+    int64_t tx_id = tx->get_tx_id();
+    LOG_DEBUG("CLIENT: tx_delete_secondary_indexes called with tx_id=%ld, ops=%zu", tx_id, ops.size());
+    if (!connected_) {
+        LOG_ERROR("RPC failed: Not connected to server");
+        return false;
+    }
+
+    // Put every delete on the wire before reading any response, so the N
+    // round trips overlap instead of running back to back.
+    std::vector<uint64_t> request_ids;
+    request_ids.reserve(ops.size());
+    bool ok = true;
+    for (const auto& op : ops) {
+        uint64_t request_id;
+        if (binary_point_ops()) {
+            if (!start_point_request(MessageType::TX_DELETE_SECONDARY_INDEX, tx,
+                                     {op.index_name, op.secondary_key, op.primary_key}, request_id)) {
+                LOG_ERROR("RPC failed: Failed to send message to server");
+                ok = false;
+                break;
+            }
+            request_ids.push_back(request_id);
+            continue;
+        }
+
+        LineairDB::Protocol::TxDeleteSecondaryIndex::Request request;
+        request.set_transaction_id(tx_id);
+        set_table(request, tx);
+        set_index(request, tx, op.index_name);
+        request.set_secondary_key(op.secondary_key);
+        request.set_primary_key(op.primary_key);
+
+        if (!start_protobuf_request(request, MessageType::TX_DELETE_SECONDARY_INDEX, request_id)) {
+            LOG_ERROR("RPC failed: Failed to send message to server");
+            ok = false;
+            break;
+        }
+        request_ids.push_back(request_id);
+    }
+
+    // Collect every response that was sent, even after a failure, so none
+    // are left behind on the connection.
+    for (uint64_t request_id : request_ids) {
+        if (binary_point_ops()) {
+            uint8_t flags;
+            if (!finish_point_request(request_id, flags)) {
+                ok = false;
+                continue;
+            }
+            tx->set_aborted((flags & Rpc::kAborted) != 0);
+            ok = ok && (flags & Rpc::kFound) != 0;
+            continue;
+        }
+
+        LineairDB::Protocol::TxDeleteSecondaryIndex::Response response;
+        if (!finish_protobuf_request(request_id, response)) {
+            ok = false;
+            continue;
+        }
+        tx->set_aborted(response.is_aborted());
+        ok = ok && response.success();
+    }
+
+    LOG_DEBUG("CLIENT: tx_delete_secondary_indexes completed, success: %s", ok ? "true" : "false");
+    return ok;
+}
+
 bool LineairDBProxy::tx_update_secondary_index(LineairDBTransaction* tx,
                                                 const std::string& index_name,
                                                 const std::string& old_secondary_key,
@@ -396,12 +895,22 @@ bool LineairDBProxy::tx_update_secondary_index(LineairDBTransaction* tx,
         return false;
     }
 
+    if (binary_point_ops()) {
+        uint8_t flags;
+        if (!call_point(MessageType::TX_UPDATE_SECONDARY_INDEX, tx, {index_name, old_secondary_key, new_secondary_key, primary_key}, flags)) {
+            LOG_ERROR("RPC failed: Failed to send message to server");
+            return false;
+        }
+        tx->set_aborted((flags & Rpc::kAborted) != 0);
+        return (flags & Rpc::kFound) != 0;
+    }
+
     LineairDB::Protocol::TxUpdateSecondaryIndex::Request request;
     LineairDB::Protocol::TxUpdateSecondaryIndex::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
-    request.set_index_name(index_name);
+    set_table(request, tx);
+    set_index(request, tx, index_name);
     request.set_old_secondary_key(old_secondary_key);
     request.set_new_secondary_key(new_secondary_key);
     request.set_primary_key(primary_key);
@@ -433,7 +942,7 @@ std::vector<std::string> LineairDBProxy::tx_get_matching_keys_in_range(LineairDB
     LineairDB::Protocol::TxGetMatchingKeysInRange::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     request.set_start_key(start_key);
     request.set_end_key(end_key);
 
@@ -465,7 +974,7 @@ std::vector<KeyValue> LineairDBProxy::tx_get_matching_keys_and_values_in_range(L
 
     LineairDB::Protocol::TxGetMatchingKeysAndValuesInRange::Request request;
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     request.set_start_key(start_key);
     request.set_end_key(end_key);
 
@@ -475,14 +984,14 @@ std::vector<KeyValue> LineairDBProxy::tx_get_matching_keys_and_values_in_range(L
         request.mutable_filter()->ParseFromString(filter);
     }
 
-    std::string raw_response;
-    if (!send_protobuf_recv_binary(request, raw_response, MessageType::TX_GET_MATCHING_KEYS_AND_VALUES_IN_RANGE)) {
+    if (!send_protobuf_recv_binary(request, MessageType::TX_GET_MATCHING_KEYS_AND_VALUES_IN_RANGE)) {
         LOG_ERROR("RPC failed: Failed to send message to server");
         return {};
     }
 
     bool is_aborted = false;
-    auto results = parse_binary_kv_response(raw_response, is_aborted);
+    auto results = parse_binary_kv_response(response_.data(), response_.size(), front_coded_keys(),
+                                            is_aborted);
     tx->set_aborted(is_aborted);
 
     LOG_DEBUG("CLIENT: tx_get_matching_keys_and_values_in_range completed, found %zu results", results.size());
@@ -500,7 +1009,7 @@ std::vector<KeyValue> LineairDBProxy::tx_get_matching_keys_and_values_from_prefi
 
     LineairDB::Protocol::TxGetMatchingKeysAndValuesFromPrefix::Request request;
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     request.set_prefix(prefix);
 
     // Attach pushed predicate filter if available
@@ -509,14 +1018,14 @@ std::vector<KeyValue> LineairDBProxy::tx_get_matching_keys_and_values_from_prefi
         request.mutable_filter()->ParseFromString(filter);
     }
 
-    std::string raw_response;
-    if (!send_protobuf_recv_binary(request, raw_response, MessageType::TX_GET_MATCHING_KEYS_AND_VALUES_FROM_PREFIX)) {
+    if (!send_protobuf_recv_binary(request, MessageType::TX_GET_MATCHING_KEYS_AND_VALUES_FROM_PREFIX)) {
         LOG_ERROR("RPC failed: Failed to send message to server");
         return {};
     }
 
     bool is_aborted = false;
-    auto results = parse_binary_kv_response(raw_response, is_aborted);
+    auto results = parse_binary_kv_response(response_.data(), response_.size(), front_coded_keys(),
+                                            is_aborted);
     tx->set_aborted(is_aborted);
 
     LOG_DEBUG("CLIENT: tx_get_matching_keys_and_values_from_prefix completed, found %zu results", results.size());
@@ -525,7 +1034,6 @@ std::vector<KeyValue> LineairDBProxy::tx_get_matching_keys_and_values_from_prefi
 
 // Zero-copy scan variant: parse binary response directly into caller-provided buffers.
 // Same wire format as parse_binary_kv_response(), but avoids intermediate KeyValue copies.
-// TODO: unify parse logic with parse_binary_kv_response() via callback-based parser
 int LineairDBProxy::tx_scan_into_buffers(LineairDBTransaction* tx,
                                           const std::string& prefix,
                                           std::vector<std::string>& out_keys,
@@ -539,7 +1047,7 @@ int LineairDBProxy::tx_scan_into_buffers(LineairDBTransaction* tx,
 
     LineairDB::Protocol::TxGetMatchingKeysAndValuesFromPrefix::Request request;
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     request.set_prefix(prefix);
 
     // Attach pushed predicate filter if available
@@ -548,68 +1056,32 @@ int LineairDBProxy::tx_scan_into_buffers(LineairDBTransaction* tx,
         request.mutable_filter()->ParseFromString(filter);
     }
 
-    std::string raw_response;
-    if (!send_protobuf_recv_binary(request, raw_response, MessageType::TX_GET_MATCHING_KEYS_AND_VALUES_FROM_PREFIX)) {
+    if (!send_protobuf_recv_binary(request, MessageType::TX_GET_MATCHING_KEYS_AND_VALUES_FROM_PREFIX)) {
         LOG_ERROR("RPC failed: Failed to send message to server");
         return -1;
     }
 
-    if (raw_response.size() < 5) {  // 1B is_aborted + 4B sentinel minimum
-        tx->set_aborted(true);
-        return -1;
-    }
-
-    // Walk the raw buffer with a pointer; same format as parse_binary_kv_response
-    const char* p = raw_response.data();
-    const char* end = p + raw_response.size();
-
-    // First byte: is_aborted flag from server
-    bool is_aborted = (static_cast<uint8_t>(*p) != 0);
-    p++;
-    tx->set_aborted(is_aborted);
-
-    if (is_aborted) return 0;
-
+    // Walk the response in place; tombstones (deleted rows) are skipped
+    bool is_aborted = false;
     int count = 0;
-    while (p + 4 <= end) {
-        // Read key length
-        uint32_t klen;
-        std::memcpy(&klen, p, 4);
-        p += 4;
-        if (klen == 0) break;  // sentinel: no more entries
-
-        if (p + klen + 4 > end) {
-            LOG_WARNING("tx_scan_into_buffers: truncated at key (klen=%u, remaining=%ld)", klen, end - p);
-            break;
-        }
-        std::string key(p, klen);
-        p += klen;
-
-        // Read value length
-        uint32_t vlen;
-        std::memcpy(&vlen, p, 4);
-        p += 4;
-        if (p + vlen > end) {
-            LOG_WARNING("tx_scan_into_buffers: truncated at value (vlen=%u, remaining=%ld)", vlen, end - p);
-            break;
-        }
-
-        // Skip tombstones (deleted rows still appear in scan)
-        if (vlen == 0) { p += vlen; continue; }
-
-        // Store directly into caller-provided buffers
-        size_t idx = out_keys.size();
-        out_keys.emplace_back(std::move(key));
-        // Copy value bytes from raw_response into a new vector<std::byte>
-        out_values.emplace_back(
-            reinterpret_cast<const std::byte*>(p),
-            reinterpret_cast<const std::byte*>(p) + vlen);
-        out_cache[out_keys.back()] = idx;
-        p += vlen;
-        count++;
+    bool complete = Rpc::for_each_scan_entry(
+        std::string_view(response_.data(), response_.size()), front_coded_keys(), true, is_aborted,
+        [&](std::string_view key, std::string_view value) {
+            if (is_aborted || value.empty()) return;
+            // Store directly into caller-provided buffers
+            size_t idx = out_keys.size();
+            out_keys.emplace_back(key);
+            out_values.emplace_back(reinterpret_cast<const std::byte*>(value.data()),
+                                    reinterpret_cast<const std::byte*>(value.data()) + value.size());
+            out_cache[out_keys.back()] = idx;
+            count++;
+        });
+    tx->set_aborted(is_aborted);
+    if (!complete) {
+        LOG_WARNING("tx_scan_into_buffers: truncated scan response (%zu bytes)", response_.size());
+        if (response_.size() == 0) return -1;
     }
-
-    return count;
+    return is_aborted ? 0 : count;
 }
 
 std::optional<std::string> LineairDBProxy::tx_fetch_last_key_in_range(LineairDBTransaction* tx,
@@ -626,7 +1098,7 @@ std::optional<std::string> LineairDBProxy::tx_fetch_last_key_in_range(LineairDBT
     LineairDB::Protocol::TxFetchLastKeyInRange::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     request.set_start_key(start_key);
     request.set_end_key(end_key);
 
@@ -657,7 +1129,7 @@ std::optional<std::string> LineairDBProxy::tx_fetch_first_key_with_prefix(Lineai
     LineairDB::Protocol::TxFetchFirstKeyWithPrefix::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     request.set_prefix(prefix);
     request.set_prefix_end(prefix_end);
 
@@ -688,7 +1160,7 @@ std::optional<std::string> LineairDBProxy::tx_fetch_next_key_with_prefix(Lineair
     LineairDB::Protocol::TxFetchNextKeyWithPrefix::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
+    set_table(request, tx);
     request.set_last_key(last_key);
     request.set_prefix_end(prefix_end);
 
@@ -722,11 +1194,31 @@ std::vector<std::string> LineairDBProxy::tx_get_matching_primary_keys_in_range(L
     LineairDB::Protocol::TxGetMatchingPrimaryKeysInRange::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
-    request.set_index_name(index_name);
+    set_table(request, tx);
+    set_index(request, tx, index_name);
     request.set_start_key(start_key);
     request.set_end_key(end_key);
 
+    std::vector<std::string> primary_keys;
+    if (front_coded_keys()) {
+        // Flat key list instead of the protobuf Response (common/scan_codec.h)
+        if (!send_protobuf_recv_binary(request, MessageType::TX_GET_MATCHING_PRIMARY_KEYS_IN_RANGE)) {
+            LOG_ERROR("RPC failed: Failed to send message to server");
+            return {};
+        }
+        bool is_aborted = false;
+        if (!Rpc::for_each_scan_entry(std::string_view(response_.data(), response_.size()), true, false,
+                                      is_aborted, [&primary_keys](std::string_view pk, std::string_view) {
+                                          primary_keys.emplace_back(pk);
+                                      })) {
+            LOG_WARNING("tx_get_matching_primary_keys_in_range: truncated response (%zu bytes)",
+                        response_.size());
+        }
+        tx->set_aborted(is_aborted);
+        LOG_DEBUG("CLIENT: tx_get_matching_primary_keys_in_range completed, found %zu keys", primary_keys.size());
+        return primary_keys;
+    }
+
     if (!send_protobuf_message(request, response, MessageType::TX_GET_MATCHING_PRIMARY_KEYS_IN_RANGE)) {
         LOG_ERROR("RPC failed: Failed to send message to server");
         return {};
@@ -734,7 +1226,6 @@ std::vector<std::string> LineairDBProxy::tx_get_matching_primary_keys_in_range(L
 
     tx->set_aborted(response.is_aborted());
 
-    std::vector<std::string> primary_keys;
     for (const auto& pk : response.primary_keys()) {
         primary_keys.emplace_back(pk);
     }
@@ -758,8 +1249,8 @@ std::vector<std::string> LineairDBProxy::tx_get_matching_primary_keys_from_prefi
     LineairDB::Protocol::TxGetMatchingPrimaryKeysFromPrefix::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
-    request.set_index_name(index_name);
+    set_table(request, tx);
+    set_index(request, tx, index_name);
     request.set_prefix(prefix);
 
     if (!send_protobuf_message(request, response, MessageType::TX_GET_MATCHING_PRIMARY_KEYS_FROM_PREFIX)) {
@@ -793,8 +1284,8 @@ std::optional<std::string> LineairDBProxy::tx_fetch_last_primary_key_in_secondar
     LineairDB::Protocol::TxFetchLastPrimaryKeyInSecondaryRange::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
-    request.set_index_name(index_name);
+    set_table(request, tx);
+    set_index(request, tx, index_name);
     request.set_start_key(start_key);
     request.set_end_key(end_key);
 
@@ -826,8 +1317,8 @@ std::optional<SecondaryIndexEntry> LineairDBProxy::tx_fetch_last_secondary_entry
     LineairDB::Protocol::TxFetchLastSecondaryEntryInRange::Response response;
 
     request.set_transaction_id(tx_id);
-    request.set_table_name(tx->get_selected_table_name());
-    request.set_index_name(index_name);
+    set_table(request, tx);
+    set_index(request, tx, index_name);
     request.set_start_key(start_key);
     request.set_end_key(end_key);
 
@@ -932,6 +1423,7 @@ bool LineairDBProxy::db_end_transaction(int64_t tx_id, bool isFence,
 
     request.set_transaction_id(tx_id);
     request.set_fence(isFence);
+    request.set_stats_version(table_stats_version_);
     for (const auto& [table, delta] : row_deltas) {
         auto* rd = request.add_row_deltas();
         rd->set_table_name(table);
@@ -944,15 +1436,25 @@ bool LineairDBProxy::db_end_transaction(int64_t tx_id, bool isFence,
     }
 
     // Cache updated table row counts for next transaction.
-    table_stats_cache_.clear();
-    for (const auto& ts : response.table_stats()) {
-        table_stats_cache_[ts.table_name()] = ts.row_count();
-    }
+    update_table_stats(response);
 
     LOG_DEBUG("CLIENT: db_end_transaction (with row_deltas) completed");
     return !response.is_aborted();
 }
 
+// Merge the row counts piggybacked on a BEGIN/END response. A server that
+// predates versioned stats (stats_version 0) always sends every table.
+template <typename Response>
+void LineairDBProxy::update_table_stats(const Response& response) {
+    if (response.stats_full() || response.stats_version() == 0) {
+        table_stats_cache_.clear();
+    }
+    for (const auto& ts : response.table_stats()) {
+        table_stats_cache_[ts.table_name()] = ts.row_count();
+    }
+    table_stats_version_ = response.stats_version();
+}
+
 void LineairDBProxy::db_fence() {
     LOG_DEBUG("CLIENT: db_fence called");
     if (!connected_) {
@@ -1026,18 +1528,14 @@ bool LineairDBProxy::send_message(const std::string& serialized_request, std::st
 
 template<typename RequestType, typename ResponseType>
 bool LineairDBProxy::send_protobuf_message(const RequestType& request, ResponseType& response, MessageType message_type) {
-    // serialize request
-    std::string serialized_request = request.SerializeAsString();
-
-    // send message with header
-    std::string serialized_response;
-    if (!send_message_with_header(serialized_request, serialized_response, message_type)) {
+    uint64_t request_id;
+    if (!start_protobuf_request(request, message_type, request_id) || !receive_response(request_id)) {
         LOG_ERROR("PROTOBUF_MESSAGE: Failed to send message with header");
         return false;
     }
 
-    // deserialize response
-    if (!response.ParseFromString(serialized_response)) {
+    // deserialize straight from the reusable response buffer
+    if (!response_.parse(response)) {
         LOG_ERROR("PROTOBUF_MESSAGE: Failed to parse response");
         return false;
     }
@@ -1045,137 +1543,342 @@ bool LineairDBProxy::send_protobuf_message(const RequestType& request, ResponseT
     return true;
 }
 
-// Send protobuf-encoded request, receive raw binary response (no protobuf decode).
-// Used for Scan RPCs where the server returns flat binary instead of protobuf.
+// Send protobuf-encoded request, receive raw binary response (no protobuf decode)
+// into response_. Used for Scan RPCs where the server returns flat binary instead
+// of protobuf.
 template<typename RequestType>
-bool LineairDBProxy::send_protobuf_recv_binary(const RequestType& request,
-                                                std::string& raw_response,
-                                                MessageType message_type) {
-    std::string serialized_request = request.SerializeAsString();
-    return send_message_with_header(serialized_request, raw_response, message_type);
+bool LineairDBProxy::send_protobuf_recv_binary(const RequestType& request, MessageType message_type) {
+    uint64_t request_id;
+    return start_protobuf_request(request, message_type, request_id) && receive_response(request_id);
 }
 
-// Parse flat binary scan response into vector<KeyValue>.
-// Wire format: [is_aborted:1B] [key_len:4B LE][key][val_len:4B LE][val]... [sentinel:key_len=0]
-// TODO: unify parse logic with tx_scan_into_buffers() via callback-based parser
-std::vector<KeyValue> LineairDBProxy::parse_binary_kv_response(const std::string& raw, bool& is_aborted) {
-    std::vector<KeyValue> results;
-    if (raw.size() < 5) {  // 1B is_aborted + 4B sentinel minimum
-        is_aborted = true;
-        return results;
+// Pipelined RPC, first half: send the request and return without waiting.
+template<typename RequestType>
+bool LineairDBProxy::start_protobuf_request(const RequestType& request, MessageType message_type,
+                                            uint64_t& request_id) {
+    // Serialize in place behind the header: no temporary string, no copy
+    request_frame_.trim();
+    request_frame_.build(static_cast<uint32_t>(message_type), request);
+    return send_request(request_id);
+}
+
+// Pipelined RPC, second half: wait for the response tagged with request_id.
+template<typename ResponseType>
+bool LineairDBProxy::finish_protobuf_request(uint64_t request_id, ResponseType& response) {
+    if (!receive_response(request_id)) {
+        LOG_ERROR("PROTOBUF_MESSAGE: Failed to receive pipelined response %lu", request_id);
+        return false;
+    }
+    if (!response_.parse(response)) {
+        LOG_ERROR("PROTOBUF_MESSAGE: Failed to parse response");
+        return false;
     }
+    return true;
+}
 
-    // Walk the raw buffer with a pointer; each field is read via memcpy
-    const char* p = raw.data();
-    const char* end = p + raw.size();
+bool LineairDBProxy::binary_point_ops() const {
+    return mux_ ? mux_->binary_point_ops() : binary_point_ops_;
+}
 
-    // First byte: is_aborted flag from server
-    is_aborted = (static_cast<uint8_t>(*p) != 0);
-    p++;
+bool LineairDBProxy::front_coded_keys() const {
+    return mux_ ? mux_->front_coded_keys() : front_coded_keys_;
+}
 
-    while (p + 4 <= end) {
-        // Read key length
-        uint32_t klen;
-        std::memcpy(&klen, p, 4);
-        p += 4;
-        if (klen == 0) break;  // sentinel: no more entries
+bool LineairDBProxy::multi_ops() const {
+    return mux_ ? mux_->multi_ops() : multi_ops_;
+}
 
-        if (p + klen + 4 > end) {
-            LOG_WARNING("parse_binary_kv_response: truncated at key (klen=%u, remaining=%ld)", klen, end - p);
-            break;
-        }
-        std::string key(p, klen);
-        p += klen;
+bool LineairDBProxy::implicit_begin() const {
+    return mux_ ? mux_->implicit_begin() : implicit_begin_;
+}
 
-        // Read value length
-        uint32_t vlen;
-        std::memcpy(&vlen, p, 4);
-        p += 4;
+bool LineairDBProxy::durable_fence() const {
+    return mux_ ? mux_->durable_fence() : durable_fence_;
+}
 
-        if (p + vlen > end) {
-            LOG_WARNING("parse_binary_kv_response: truncated at value (vlen=%u, remaining=%ld)", vlen, end - p);
-            break;
+uint64_t LineairDBProxy::handle_epoch() const {
+    return mux_ ? mux_->handle_epoch() : handle_epoch_;
+}
+
+uint32_t LineairDBProxy::table_handle(TableHandleCache* cache, const std::string& table_name) {
+    uint64_t epoch = handle_epoch();
+    if (epoch == 0 || cache == nullptr || table_name.empty()) {
+        return 0;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(cache->mutex);
+        if (cache->epoch == epoch) {
+            return cache->table_id;
         }
-        std::string val(p, vlen);
-        p += vlen;
+    }
+    if (!resolve_handles(*cache, table_name, nullptr, epoch)) {
+        return 0;
+    }
+    std::shared_lock<std::shared_mutex> lock(cache->mutex);
+    return cache->epoch == epoch ? cache->table_id : 0;
+}
 
-        results.emplace_back(KeyValue{std::move(key), std::move(val)});
+uint32_t LineairDBProxy::index_handle(TableHandleCache* cache, const std::string& table_name,
+                                      const std::string& index_name) {
+    uint64_t epoch = handle_epoch();
+    if (epoch == 0 || cache == nullptr || table_name.empty()) {
+        return 0;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(cache->mutex);
+        if (cache->epoch == epoch) {
+            auto it = cache->index_ids.find(index_name);
+            if (it != cache->index_ids.end()) {
+                return it->second;
+            }
+        }
     }
+    if (!resolve_handles(*cache, table_name, &index_name, epoch)) {
+        return 0;
+    }
+    std::shared_lock<std::shared_mutex> lock(cache->mutex);
+    auto it = cache->index_ids.find(index_name);
+    return cache->epoch == epoch && it != cache->index_ids.end() ? it->second : 0;
+}
+
+bool LineairDBProxy::resolve_handles(TableHandleCache& cache, const std::string& table_name,
+                                     const std::string* index_name, uint64_t epoch) {
+    LineairDB::Protocol::DbResolveHandles::Request request;
+    LineairDB::Protocol::DbResolveHandles::Response response;
+    request.set_table_name(table_name);
+    if (index_name) {
+        request.add_index_names(*index_name);
+    }
+    if (!send_protobuf_message(request, response, MessageType::DB_RESOLVE_HANDLES) ||
+        response.table_id() == 0 || response.handle_epoch() != epoch ||
+        response.index_ids_size() != request.index_names_size()) {
+        LOG_WARNING("LineairDBProxy(%p): could not resolve handles for %s, sending names",
+                    static_cast<const void*>(this), table_name.c_str());
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(cache.mutex);
+    if (cache.epoch != epoch) {
+        cache.epoch = epoch;
+        cache.index_ids.clear();
+    }
+    cache.table_id = response.table_id();
+    if (index_name) {
+        cache.index_ids[*index_name] = response.index_ids(0);
+    }
+    LOG_DEBUG("CLIENT: resolved %s to table handle %u", table_name.c_str(), cache.table_id);
+    return true;
+}
 
+template <typename Request>
+void LineairDBProxy::set_table(Request& request, LineairDBTransaction* tx) {
+    const std::string& table_name = tx->get_selected_table_name();
+    if (uint32_t table_id = table_handle(tx->selected_table_handles(), table_name)) {
+        request.set_table_id(table_id);
+    } else {
+        request.set_table_name(table_name);
+    }
+}
+
+template <typename Request>
+void LineairDBProxy::set_index(Request& request, LineairDBTransaction* tx,
+                               const std::string& index_name) {
+    if (uint32_t index_id = index_handle(tx->selected_table_handles(),
+                                         tx->get_selected_table_name(), index_name)) {
+        request.set_index_id(index_id);
+    } else {
+        request.set_index_name(index_name);
+    }
+}
+
+// Binary point RPC, first half: encode straight into the request frame.
+bool LineairDBProxy::start_point_request(MessageType message_type, LineairDBTransaction* tx,
+                                         std::initializer_list<std::string_view> fields,
+                                         uint64_t& request_id) {
+    // Resolve handles first: a DB_RESOLVE_HANDLES round trip reuses request_frame_
+    const std::string table_name = tx->get_selected_table_name();
+    uint32_t table_id = table_handle(tx->selected_table_handles(), table_name);
+    uint32_t index_id = 0;
+    if (Rpc::point_has_index(static_cast<uint32_t>(message_type)) && fields.size() > 0) {
+        index_id = index_handle(tx->selected_table_handles(), table_name,
+                                std::string(*fields.begin()));
+    }
+    request_frame_.trim();
+    char* payload = request_frame_.build_in_place(
+        static_cast<uint32_t>(message_type) | Rpc::kBinaryPayload,
+        Rpc::point_request_size(table_name, table_id, index_id, fields));
+    Rpc::encode_point_request(payload, tx->get_tx_id(), table_name, table_id, index_id, fields);
+    return send_request(request_id);
+}
+
+// Flat TX_BATCH_READ; answered like a point request, flags byte first.
+bool LineairDBProxy::start_batch_read_request(LineairDBTransaction* tx,
+                                              const std::vector<std::string>& keys,
+                                              uint64_t& request_id) {
+    const std::string table_name = tx->get_selected_table_name();
+    uint32_t table_id = table_handle(tx->selected_table_handles(), table_name);
+    request_frame_.trim();
+    char* payload = request_frame_.build_in_place(
+        static_cast<uint32_t>(MessageType::TX_BATCH_READ) | Rpc::kBinaryPayload,
+        Rpc::batch_read_request_size(table_name, table_id, keys));
+    Rpc::encode_batch_read_request(payload, tx->get_tx_id(), table_name, table_id, keys);
+    return send_request(request_id);
+}
+
+// Binary point RPC, second half: the leading flags byte of the response.
+bool LineairDBProxy::finish_point_request(uint64_t request_id, uint8_t& flags) {
+    if (!receive_response(request_id)) {
+        LOG_ERROR("POINT_MESSAGE: Failed to receive response %lu", request_id);
+        return false;
+    }
+    if (response_.size() == 0) {
+        LOG_ERROR("POINT_MESSAGE: Empty response %lu", request_id);
+        return false;
+    }
+    flags = static_cast<uint8_t>(response_.data()[0]);
+    return true;
+}
+
+bool LineairDBProxy::call_point(MessageType message_type, LineairDBTransaction* tx,
+                                std::initializer_list<std::string_view> fields, uint8_t& flags) {
+    uint64_t request_id;
+    return start_point_request(message_type, tx, fields, request_id) &&
+           finish_point_request(request_id, flags);
+}
+
+// Parse flat binary scan response into vector<KeyValue>.
+// Wire format: common/scan_codec.h
+std::vector<KeyValue> LineairDBProxy::parse_binary_kv_response(const char* raw, size_t raw_size,
+                                                               bool front_coded, bool& is_aborted) {
+    std::vector<KeyValue> results;
+    bool complete = Rpc::for_each_scan_entry(
+        std::string_view(raw, raw_size), front_coded, true, is_aborted,
+        [&results](std::string_view key, std::string_view value) {
+            results.emplace_back(KeyValue{std::string(key), std::string(value)});
+        });
+    if (!complete) {
+        LOG_WARNING("parse_binary_kv_response: truncated scan response (%zu bytes)", raw_size);
+    }
     return results;
 }
 
-bool LineairDBProxy::send_message_with_header(const std::string& serialized_request,
-                                              std::string& serialized_response,
-                                              MessageType message_type) {
+bool LineairDBProxy::send_request(uint64_t& request_id) {
     if (!connected_) {
         LOG_ERROR("SEND_MESSAGE: Not connected!");
         return false;
     }
 
-    LOG_DEBUG("SEND_MESSAGE: Sending message of size %zu bytes with message_type %u", 
-              serialized_request.size(), static_cast<uint32_t>(message_type));
+    if (mux_) {
+        return mux_->send(*mux_waiter_, request_frame_, request_id);
+    }
 
-    // prepare message header
-    MessageHeader header;
-    header.sender_id = htobe64(1);  // TODO: replace with actual sender ID
-    header.message_type = htonl(static_cast<uint32_t>(message_type));
-    header.payload_size = htonl(static_cast<uint32_t>(serialized_request.size()));
+    request_id = next_request_id_++;
+    request_frame_.set_request_id(request_id);
+    LOG_DEBUG("SEND_MESSAGE: Sending request_id=%lu, message_type=%u, frame_size=%zu",
+              request_id, request_frame_.message_type(), request_frame_.size());
 
-    LOG_DEBUG("SEND_MESSAGE: Prepared header: sender_id=1, message_type=%u, payload_size=%zu", 
-              static_cast<uint32_t>(message_type), serialized_request.size());
+    // Header and payload are contiguous, so this is a single send()
+    if (!write_all(request_frame_.data(), request_frame_.size())) {
+        LOG_ERROR("SEND_MESSAGE: Failed to send message of %zu bytes", request_frame_.size());
+        return false;
+    }
 
-    // combine header and payload
-    size_t total_size = sizeof(header) + serialized_request.size();
-    std::vector<char> buffer(total_size);
-    std::memcpy(buffer.data(), &header, sizeof(header));
-    std::memcpy(buffer.data() + sizeof(header), serialized_request.c_str(), serialized_request.size());
+    LOG_DEBUG("SEND_MESSAGE: Successfully sent %zu bytes", request_frame_.size());
+    return true;
+}
 
-    // send (handle partial writes for large messages)
+bool LineairDBProxy::write_all(const void* data, size_t len) {
+    if (shm_) {
+        return shm_->send(data, len);
+    }
+    // handle partial writes for large messages
+    const char* p = static_cast<const char*>(data);
     size_t total_sent = 0;
-    while (total_sent < total_size) {
-        ssize_t bytes_sent = send(socket_fd_, buffer.data() + total_sent,
-                                  total_size - total_sent, 0);
+    while (total_sent < len) {
+        ssize_t bytes_sent = send(socket_fd_, p + total_sent, len - total_sent, 0);
         if (bytes_sent <= 0) {
-            LOG_ERROR("SEND_MESSAGE: Failed to send message, sent %zu/%zu bytes", total_sent, total_size);
             return false;
         }
         total_sent += bytes_sent;
     }
+    return true;
+}
 
-    LOG_DEBUG("SEND_MESSAGE: Successfully sent %zd bytes", bytes_sent);
+bool LineairDBProxy::read_all(void* data, size_t len) {
+    if (shm_) {
+        return shm_->recv(data, len);
+    }
+    return recv(socket_fd_, data, len, MSG_WAITALL) == static_cast<ssize_t>(len);
+}
 
-    // receive response header
-    MessageHeader response_header;
-    ssize_t header_received = recv(socket_fd_, &response_header, sizeof(response_header), MSG_WAITALL);
-    if (header_received != sizeof(response_header)) {
-        LOG_ERROR("SEND_MESSAGE: Failed to receive response header, received %zd bytes", header_received);
-        return false;
+bool LineairDBProxy::receive_response(uint64_t request_id) {
+    response_.trim();
+    compressed_.trim();
+    if (mux_) {
+        if (!mux_->wait(*mux_waiter_, request_id, response_)) {
+            LOG_ERROR("SEND_MESSAGE: Shared connection lost while waiting for response %lu", request_id);
+            return false;
+        }
+        return true;
+    }
+
+    // A response for this ID may already have been read while waiting for another one
+    auto early = early_responses_.find(request_id);
+    if (early != early_responses_.end()) {
+        const std::string& payload = early->second;
+        std::memcpy(response_.prepare(payload.size()), payload.data(), payload.size());
+        early_responses_.erase(early);
+        return true;
     }
 
-    // convert from network byte order to host byte order
-    uint64_t response_sender_id = be64toh(response_header.sender_id);
-    uint32_t response_message_type = ntohl(response_header.message_type);
-    uint32_t response_payload_size = ntohl(response_header.payload_size);
+    while (true) {
+        // receive response header
+        char header[Rpc::kHeaderSize];
+        if (!read_all(header, sizeof(header))) {
+            LOG_ERROR("SEND_MESSAGE: Failed to receive response header");
+            return false;
+        }
 
-    LOG_DEBUG("SEND_MESSAGE: Received response header: sender_id=%lu, message_type=%u, payload_size=%u", 
-              response_sender_id, response_message_type, response_payload_size);
+        uint64_t response_id;
+        uint32_t response_message_type;
+        uint32_t response_payload_size;
+        Rpc::decode_header(header, response_id, response_message_type, response_payload_size);
 
-    // receive response payload
-    if (response_payload_size > 0) {
-        serialized_response.resize(response_payload_size);
-        ssize_t payload_received = recv(socket_fd_, &serialized_response[0], response_payload_size, MSG_WAITALL);
-        if (payload_received != static_cast<ssize_t>(response_payload_size)) {
-            LOG_ERROR("SEND_MESSAGE: Failed to receive response payload, received %zd bytes instead of %u", 
-                      payload_received, response_payload_size);
+        LOG_DEBUG("SEND_MESSAGE: Received response header: request_id=%lu, message_type=%u, payload_size=%u",
+                  response_id, response_message_type, response_payload_size);
+
+        // receive response payload into the reusable buffer
+        if (!read_payload(response_message_type, response_payload_size)) {
+            LOG_ERROR("SEND_MESSAGE: Failed to receive response payload of %u bytes",
+                      response_payload_size);
             return false;
         }
-        LOG_DEBUG("SEND_MESSAGE: Successfully received response payload (%zd bytes)", payload_received);
-    } else {
-        LOG_DEBUG("SEND_MESSAGE: No response payload (empty response)");
-        serialized_response.clear();
+        if (response_id == request_id) {
+            break;
+        }
+
+        // Someone else's pipelined response: park a copy until it is asked for
+        early_responses_.emplace(response_id, std::string(response_.data(), response_.size()));
     }
 
     LOG_DEBUG("SEND_MESSAGE: Message exchange completed successfully");
     return true;
 }
+
+// Read one payload into response_, inflating it if the server compressed it.
+bool LineairDBProxy::read_payload(uint32_t message_type, uint32_t payload_size) {
+    if ((message_type & Rpc::kCompressedPayload) == 0) {
+        char* payload = response_.prepare(payload_size);
+        return payload_size == 0 || read_all(payload, payload_size);
+    }
+    char* raw = compressed_.prepare(payload_size);
+    if (payload_size > 0 && !read_all(raw, payload_size)) {
+        return false;
+    }
+    size_t size = Rpc::decompressed_size(raw, payload_size);
+    if (!Rpc::decompress_payload(raw, payload_size, response_.prepare(size), size)) {
+        LOG_ERROR("SEND_MESSAGE: Failed to decompress a %u-byte response payload", payload_size);
+        return false;
+    }
+    return true;
+}
@@ -2,30 +2,67 @@
 #define LINEAIRDB_PROXY_H
 
 #include <cstdint>
+#include <initializer_list>
 #include <optional>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 #include <memory>
 
 #include "lineairdb.pb.h"
+#include "../common/compression.h"
+#include "../common/point_codec.h"
+#include "../common/rpc_buffer.h"
 
 class LineairDBTransaction;
+class MuxConnection;
+struct MuxWaiter;
+namespace Shm {
+class Channel;
+}
 
 struct KeyValue {
     std::string key;
     std::string value;
 };
 
+// Server handles (DB_RESOLVE_HANDLES) for one table and the indexes used on
+// it. Lives in the table's LineairDB_share, so the table is resolved once per
+// server instance rather than once per handler or connection; requests on a
+// connection with a different handle epoch resolve again.
+struct TableHandleCache {
+    std::shared_mutex mutex;
+    uint64_t epoch = 0;  // server instance the handles belong to, 0 = none yet
+    uint32_t table_id = 0;
+    std::unordered_map<std::string, uint32_t> index_ids;
+};
+
 struct SecondaryIndexEntry {
     std::string secondary_key;
     std::vector<std::string> primary_keys;
 };
 
+// What a new server connection asks for in its SESSION_HELLO. With no
+// compression and protocol version 1 there is nothing to ask, and no hello is
+// sent at all.
+struct SessionOptions {
+    Rpc::Codec compression = Rpc::Codec::NONE;
+    uint32_t compression_threshold = 0;  // compress responses of at least this size
+    uint32_t protocol_version = Rpc::kProtocolVersion;  // highest version to offer
+
+    bool operator==(const SessionOptions& other) const {
+        return compression == other.compression &&
+               compression_threshold == other.compression_threshold &&
+               protocol_version == other.protocol_version;
+    }
+};
+
 // Message header for RPC communication (matching server implementation)
 struct MessageHeader {
-    uint64_t sender_id;      // sender ID
+    uint64_t sender_id;      // request ID, echoed back in the matching response
     uint32_t message_type;   // OpCode from protobuf
     uint32_t payload_size;   // size of the protobuf payload
 };
@@ -72,7 +109,13 @@ enum class MessageType : uint32_t {
 
     // Batch operations
     TX_BATCH_READ = 25,
-    TX_BATCH_WRITE = 26
+    TX_BATCH_WRITE = 26,
+
+    SESSION_HELLO = 27,
+    DB_RESOLVE_HANDLES = 28,
+
+    // Heterogeneous batch
+    TX_MULTI = 29
 };
 
 /**
@@ -82,20 +125,41 @@ enum class MessageType : uint32_t {
  * In this disaggregated architecture, MySQL instances do not embed LineairDB
  * directly; instead, each THD holds a LineairDBProxy that maintains a
  * TCP connection to the remote LineairDB server. Managed via LineairDBThdCtx.
+ *
+ * When shm_socket is given (server on the same host), frames travel over a
+ * shared-memory ring pair negotiated on that Unix socket instead of TCP.
+ *
+ * Alternatively a proxy can ride on a MuxConnection shared with other THDs
+ * (see lineairdb_mux.hh); it then owns no socket of its own.
+ *
+ * Over TCP the proxy can ask the server to compress large responses
+ * (SessionOptions); compressed payloads are inflated on receipt, so callers
+ * always see plain responses. Point reads and writes use the binary layout of
+ * common/point_codec.h when the server negotiates it, protobuf otherwise.
  */
 class LineairDBProxy {
 public:
-    LineairDBProxy(const std::string& host, int port);
+    LineairDBProxy(const std::string& host, int port, const std::string& shm_socket = "",
+                   const SessionOptions& options = SessionOptions());
+    explicit LineairDBProxy(std::shared_ptr<MuxConnection> connection);
     ~LineairDBProxy();
 
     // connection management
     bool connect(const std::string& host, int port);
     void disconnect();
     bool is_connected() const;
+    // Connected, idle and with nothing in flight: safe to hand to another THD.
+    bool is_reusable() const;
 
     // transaction management
     int64_t tx_begin_transaction();
     void tx_abort(int64_t tx_id);
+    // The server begins a transaction for a TX_MULTI with transaction ID 0
+    // and can commit one at the end of a TX_MULTI (tx_multi_commit())
+    bool implicit_begin() const;
+    // A commit with fence set returns once it is durable, so it needs no
+    // db_fence() after it
+    bool durable_fence() const;
 
     // primary key operations
     std::string tx_read(LineairDBTransaction* tx, const std::string& key);
@@ -103,12 +167,30 @@ public:
     bool tx_delete(LineairDBTransaction* tx, const std::string& key);
 
     // batch operations
-    struct BatchReadResult {
-        bool found;
-        std::string value;
+    // Rows of a batch read. A binary response frame changes hands whole into
+    // frame and values are views into it, so no value is copied after it
+    // comes off the socket; values that arrive as strings (TX_MULTI,
+    // protobuf) are moved into owned instead. The views stay valid until the
+    // next read into the same object, or its destruction.
+    struct BatchReadValues {
+        std::vector<std::string_view> values;  // empty = not found
+        Rpc::PayloadBuffer frame;
+        std::vector<std::string> owned;
+
+        void clear() {
+            values.clear();
+            owned.clear();
+        }
+        // Point values at owned, one per string
+        void view_owned() {
+            values.assign(owned.begin(), owned.end());
+        }
     };
-    std::vector<BatchReadResult> tx_batch_read(LineairDBTransaction* tx,
-                                                const std::vector<std::string>& keys);
+    // Reads keys[i] into out.values[i]; a key that is not found leaves its
+    // value empty, as tx_read() does. False (and out cleared) if the RPC
+    // failed.
+    bool tx_batch_read(LineairDBTransaction* tx, const std::vector<std::string>& keys,
+                       BatchReadValues& out);
     struct BatchWriteOp {
         std::string key;
         std::string value;
@@ -121,7 +203,55 @@ public:
     bool tx_batch_write(LineairDBTransaction* tx,
                         const std::string& table_name,
                         const std::vector<BatchWriteOp>& writes,
-                        const std::vector<BatchSecondaryIndexOp>& si_writes);
+                        const std::vector<BatchSecondaryIndexOp>& si_writes,
+                        TableHandleCache* handles = nullptr);
+    // One operation of tx_multi(), on its own table. The secondary index ops
+    // take key as the primary key; UPDATE_SECONDARY_INDEX moves it from
+    // secondary_key to new_secondary_key.
+    struct MultiOp {
+        // Same order as LineairDB::Protocol::TxMulti::Kind
+        enum class Kind {
+            READ,
+            WRITE,
+            DELETE,
+            READ_SECONDARY_INDEX,
+            WRITE_SECONDARY_INDEX,
+            DELETE_SECONDARY_INDEX,
+            UPDATE_SECONDARY_INDEX
+        };
+        Kind kind;
+        std::string table_name;
+        TableHandleCache* handles = nullptr;
+        std::string index_name;
+        std::string key;
+        std::string value;
+        std::string secondary_key;
+        std::string new_secondary_key;
+    };
+    struct MultiResult {
+        bool found = false;               // READ
+        std::string value;                // READ
+        std::vector<std::string> values;  // READ_SECONDARY_INDEX
+    };
+    // Runs ops in order in one TX_MULTI round trip, stopping after the first
+    // op that aborts tx; results (if given) gets one entry per op that ran.
+    // Ops that are all WRITE / WRITE_SECONDARY_INDEX on one table go as
+    // TX_BATCH_WRITE instead, and a server without TX_MULTI gets such runs
+    // batched, runs of DELETE_SECONDARY_INDEX pipelined and the other ops one
+    // RPC each. True if every op ran and tx is not aborted.
+    bool tx_multi(LineairDBTransaction* tx, const std::vector<MultiOp>& ops,
+                  std::vector<MultiResult>* results = nullptr);
+    // tx_multi() in two halves, so that tx's next request can follow in the
+    // same round trip and run after ops on the server. start_multi() sends
+    // nothing and is false if the server does not run TX_MULTI.
+    bool start_multi(LineairDBTransaction* tx, const std::vector<MultiOp>& ops,
+                     uint64_t& request_id);
+    bool finish_multi(LineairDBTransaction* tx, uint64_t request_id, size_t op_count,
+                      std::vector<MultiResult>* results = nullptr);
+    // Runs ops and then ends tx as db_end_transaction() does, in one TX_MULTI
+    // (needs implicit_begin()). True if tx committed.
+    bool tx_multi_commit(LineairDBTransaction* tx, const std::vector<MultiOp>& ops, bool isFence,
+                         const std::vector<std::pair<std::string, int64_t>>& row_deltas);
 
     // secondary index operations
     std::vector<std::string> tx_read_secondary_index(LineairDBTransaction* tx,
@@ -135,6 +265,9 @@ public:
                                    const std::string& index_name,
                                    const std::string& secondary_key,
                                    const std::string& primary_key);
+    // Pipelined: all deletes are sent before any response is awaited.
+    bool tx_delete_secondary_indexes(LineairDBTransaction* tx,
+                                     const std::vector<BatchSecondaryIndexOp>& ops);
     bool tx_update_secondary_index(LineairDBTransaction* tx,
                                    const std::string& index_name,
                                    const std::string& old_secondary_key,
@@ -203,20 +336,94 @@ public:
 
 private:
     std::unordered_map<std::string, int64_t> table_stats_cache_;
+    // Server stats version table_stats_cache_ is current with; BEGIN/END
+    // send it so the server returns only the tables changed since
+    uint64_t table_stats_version_ = 0;
+    template<typename ResponseType>
+    void update_table_stats(const ResponseType& response);
     template<typename RequestType, typename ResponseType>
     bool send_protobuf_message(const RequestType& request, ResponseType& response, MessageType message_type);
-    // Send protobuf request, receive raw binary response
+    // Send protobuf request, receive raw binary response into response_
+    template<typename RequestType>
+    bool send_protobuf_recv_binary(const RequestType& request, MessageType message_type);
+    // Parse a flat binary scan response (common/scan_codec.h) into KeyValues
+    static std::vector<KeyValue> parse_binary_kv_response(const char* raw, size_t raw_size,
+                                                          bool front_coded, bool& is_aborted);
+    // Pipelined RPC: start_* sends and returns the request ID, finish_* waits
+    // for the response carrying that ID. Several may be outstanding at once.
     template<typename RequestType>
-    bool send_protobuf_recv_binary(const RequestType& request, std::string& raw_response, MessageType message_type);
-    // Parse flat binary scan response: [is_aborted:1B] [entries...] [sentinel: key_len=0]
-    static std::vector<KeyValue> parse_binary_kv_response(const std::string& raw, bool& is_aborted);
+    bool start_protobuf_request(const RequestType& request, MessageType message_type, uint64_t& request_id);
+    template<typename ResponseType>
+    bool finish_protobuf_request(uint64_t request_id, ResponseType& response);
     bool send_message(const std::string& serialized_request, std::string& serialized_response);
-    bool send_message_with_header(const std::string& serialized_request, std::string& serialized_response, MessageType message_type);
+    // Send the frame in request_frame_ / read the matching payload into response_
+    bool send_request(uint64_t& request_id);
+    bool receive_response(uint64_t request_id);
+    bool read_payload(uint32_t message_type, uint32_t payload_size);
+    bool say_hello();
+    // Binary point RPCs: the response flags byte is returned, the rest of the
+    // response stays in response_ after it
+    bool binary_point_ops() const;
+    // Scan responses carry front-coded keys (common/scan_codec.h)
+    bool front_coded_keys() const;
+    // Server runs TX_MULTI
+    bool multi_ops() const;
+    void build_multi_request(LineairDBTransaction* tx, const std::vector<MultiOp>& ops,
+                             LineairDB::Protocol::TxMulti::Request& request);
+    // Take the ID and row counts sent back by a TX_MULTI that began tx
+    void note_implicit_begin(LineairDBTransaction* tx,
+                             const LineairDB::Protocol::TxMulti::Response& response);
+    // tx_multi() without TX_MULTI: batched write runs, pipelined secondary
+    // deletes, other ops one by one
+    bool run_multi_ops(LineairDBTransaction* tx, const std::vector<MultiOp>& ops,
+                       std::vector<MultiResult>* results);
+    bool start_point_request(MessageType message_type, LineairDBTransaction* tx,
+                             std::initializer_list<std::string_view> fields, uint64_t& request_id);
+    bool finish_point_request(uint64_t request_id, uint8_t& flags);
+    bool start_batch_read_request(LineairDBTransaction* tx, const std::vector<std::string>& keys,
+                                  uint64_t& request_id);
+    bool call_point(MessageType message_type, LineairDBTransaction* tx,
+                    std::initializer_list<std::string_view> fields, uint8_t& flags);
+    // Table handles: 0 means the connection did not negotiate them (or the
+    // lookup failed) and the name goes on the wire instead.
+    uint64_t handle_epoch() const;
+    uint32_t table_handle(TableHandleCache* cache, const std::string& table_name);
+    uint32_t index_handle(TableHandleCache* cache, const std::string& table_name,
+                          const std::string& index_name);
+    bool resolve_handles(TableHandleCache& cache, const std::string& table_name,
+                         const std::string* index_name, uint64_t epoch);
+    // Name tx's selected table (and index) in request by handle or by name
+    template <typename Request>
+    void set_table(Request& request, LineairDBTransaction* tx);
+    template <typename Request>
+    void set_index(Request& request, LineairDBTransaction* tx, const std::string& index_name);
+    // Transport-level I/O: TCP socket or shared-memory channel
+    bool write_all(const void* data, size_t len);
+    bool read_all(void* data, size_t len);
 
     int socket_fd_;
     bool connected_;
+    uint64_t next_request_id_ = 1;
+    // Responses read off the socket while waiting for a different request ID
+    std::unordered_map<uint64_t, std::string> early_responses_;
+    // Reused by every RPC so the steady-state path does not allocate
+    Rpc::FrameBuffer request_frame_;
+    Rpc::PayloadBuffer response_;
+    Rpc::PayloadBuffer compressed_;
+    SessionOptions options_;
+    bool binary_point_ops_ = false;  // negotiated by say_hello()
+    bool front_coded_keys_ = false;  // likewise
+    bool multi_ops_ = false;         // likewise
+    bool implicit_begin_ = false;    // likewise
+    bool durable_fence_ = false;     // likewise
+    uint64_t handle_epoch_ = 0;      // likewise; 0 = no table handles
     std::string host_;
     int port_;
+    std::string shm_socket_;
+    std::unique_ptr<Shm::Channel> shm_;
+    // Set when multiplexed over a shared connection
+    std::shared_ptr<MuxConnection> mux_;
+    std::unique_ptr<MuxWaiter> mux_waiter_;
 };
 
 #endif // LINEAIRDB_PROXY_H
@@ -0,0 +1,96 @@
+#include <chrono>
+
+#include "lineairdb_proxy_pool.hh"
+#include "../common/log.h"
+
+ProxyPool::ProxyPool(std::string host, int port, std::string shm_socket, SessionOptions options,
+                     size_t capacity, ProxyPoolStats& stats)
+    : host_(std::move(host)), port_(port), shm_socket_(std::move(shm_socket)),
+      options_(options), stats_(stats), capacity_(capacity) {}
+
+ProxyPool::~ProxyPool() {
+    LOG_INFO("ProxyPool(%p): closing %zu idle proxies", static_cast<const void*>(this), idle_.size());
+}
+
+std::shared_ptr<LineairDBProxy> ProxyPool::checkout() {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<LineairDBProxy> proxy;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Skip proxies whose connection died while they sat idle
+        while (!idle_.empty() && !proxy) {
+            proxy = std::move(idle_.back());
+            idle_.pop_back();
+            if (!proxy->is_reusable()) {
+                stats_.discarded.fetch_add(1, std::memory_order_relaxed);
+                proxy.reset();
+            }
+        }
+    }
+    if (proxy) {
+        stats_.hits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        stats_.misses.fetch_add(1, std::memory_order_relaxed);
+        proxy = std::make_unique<LineairDBProxy>(host_, port_, shm_socket_, options_);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    stats_.wait_us.fetch_add(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(),
+        std::memory_order_relaxed);
+
+    std::shared_ptr<ProxyPool> self = shared_from_this();
+    return std::shared_ptr<LineairDBProxy>(proxy.release(),
+                                           [self](LineairDBProxy* p) { self->checkin(p); });
+}
+
+void ProxyPool::checkin(LineairDBProxy* proxy) {
+    std::unique_ptr<LineairDBProxy> owned(proxy);
+    if (owned->is_reusable()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < capacity_) {
+            idle_.push_back(std::move(owned));
+            stats_.returned.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    stats_.discarded.fetch_add(1, std::memory_order_relaxed);
+    // owned closes the connection outside the lock
+}
+
+size_t ProxyPool::warm_up(size_t count) {
+    size_t opened = 0;
+    while (opened < count) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (idle_.size() >= capacity_) break;
+        }
+        auto proxy = std::make_unique<LineairDBProxy>(host_, port_, shm_socket_, options_);
+        if (!proxy->is_connected()) {
+            LOG_WARNING("ProxyPool: warm-up stopped after %zu connections, server %s:%d unreachable",
+                        opened, host_.c_str(), port_);
+            break;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(std::move(proxy));
+        opened++;
+    }
+    return opened;
+}
+
+void ProxyPool::set_capacity(size_t capacity) {
+    std::vector<std::unique_ptr<LineairDBProxy>> surplus;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        while (idle_.size() > capacity_) {
+            surplus.push_back(std::move(idle_.back()));
+            idle_.pop_back();
+        }
+    }
+    // surplus proxies disconnect here, outside the lock
+}
+
+size_t ProxyPool::idle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
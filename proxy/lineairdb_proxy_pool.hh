@@ -0,0 +1,61 @@
+#ifndef LINEAIRDB_PROXY_POOL_H
+#define LINEAIRDB_PROXY_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "lineairdb_proxy.hh"
+
+// Counters surfaced through SHOW STATUS; shared by successive pools.
+struct ProxyPoolStats {
+    std::atomic<uint64_t> hits{0};       // checkouts served by an idle proxy
+    std::atomic<uint64_t> misses{0};     // checkouts that had to connect
+    std::atomic<uint64_t> returned{0};   // proxies put back for reuse
+    std::atomic<uint64_t> discarded{0};  // proxies closed on return (broken or pool full)
+    std::atomic<uint64_t> wait_us{0};    // total time spent in checkout()
+};
+
+/**
+ * Process-wide set of connected LineairDBProxy instances kept across client
+ * sessions, so a new THD skips the TCP connect and the server-side session
+ * setup. checkout() hands out a proxy whose shared_ptr deleter returns it
+ * here; only proxies that are still connected with nothing in flight are
+ * kept, up to capacity.
+ */
+class ProxyPool : public std::enable_shared_from_this<ProxyPool> {
+public:
+    ProxyPool(std::string host, int port, std::string shm_socket, SessionOptions options,
+              size_t capacity, ProxyPoolStats& stats);
+    ~ProxyPool();
+
+    std::shared_ptr<LineairDBProxy> checkout();
+    // Open up to count connections ahead of time. Returns how many were opened.
+    size_t warm_up(size_t count);
+
+    void set_capacity(size_t capacity);
+    size_t idle() const;
+
+    bool matches(const std::string& host, int port, const std::string& shm_socket,
+                 const SessionOptions& options) const {
+        return host == host_ && port == port_ && shm_socket == shm_socket_ &&
+               options == options_;
+    }
+
+private:
+    void checkin(LineairDBProxy* proxy);
+
+    const std::string host_;
+    const int port_;
+    const std::string shm_socket_;
+    const SessionOptions options_;
+    ProxyPoolStats& stats_;
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    std::vector<std::unique_ptr<LineairDBProxy>> idle_;
+};
+
+#endif // LINEAIRDB_PROXY_POOL_H
@@ -17,8 +17,10 @@ LineairDBTransaction::LineairDBTransaction(THD* thd,
 
 std::string LineairDBTransaction::get_selected_table_name() { return db_table_key; }
 
-void LineairDBTransaction::choose_table(std::string db_table_name) {
+void LineairDBTransaction::choose_table(std::string db_table_name,
+                                        TableHandleCache *handles) {
   db_table_key = db_table_name;
+  table_handles_ = handles;
 }
 
 bool LineairDBTransaction::table_is_not_chosen() {
@@ -33,41 +35,63 @@ const std::pair<const std::byte *const, const size_t>
 LineairDBTransaction::read(std::string key) {
   if (table_is_not_chosen()) return std::pair<const std::byte *const, const size_t>{nullptr, 0};
 
-  flush_write_buffer();
-
-  last_read_value_ = lineairdb_proxy->tx_read(this, key);
+  if ((!write_buffer_ops_.empty() || tx_id == 0) && !is_aborted_) {
+    LineairDBProxy::MultiOp op{LineairDBProxy::MultiOp::Kind::READ, db_table_key, table_handles_};
+    op.key = std::move(key);
+    std::vector<LineairDBProxy::MultiResult> results;
+    flush_write_buffer_with_reads({std::move(op)}, results);
+    last_read_value_ = results.empty() ? std::string() : std::move(results[0].value);
+  } else {
+    flush_write_buffer();
+    last_read_value_ = lineairdb_proxy->tx_read(this, key);
+  }
   if (last_read_value_.empty()) return std::pair<const std::byte *const, const size_t>{nullptr, 0};
 
   return {reinterpret_cast<const std::byte*>(last_read_value_.data()), last_read_value_.size()};
 }
 
-std::vector<std::pair<bool, std::string>>
-LineairDBTransaction::batch_read(const std::vector<std::string>& keys) {
-  if (table_is_not_chosen()) return {};
+void LineairDBTransaction::batch_read(const std::vector<std::string>& keys,
+                                      LineairDBProxy::BatchReadValues& out) {
+  out.clear();
+  if (table_is_not_chosen()) {
+    return;
+  }
+  if ((!write_buffer_ops_.empty() || tx_id == 0) && !is_aborted_) {
+    std::vector<LineairDBProxy::MultiOp> reads;
+    reads.reserve(keys.size());
+    for (const auto& key : keys) {
+      reads.push_back({LineairDBProxy::MultiOp::Kind::READ, db_table_key, table_handles_});
+      reads.back().key = key;
+    }
+    std::vector<LineairDBProxy::MultiResult> results;
+    flush_write_buffer_with_reads(std::move(reads), results);
+    out.owned.resize(keys.size());
+    for (size_t i = 0; i < keys.size() && i < results.size(); i++) {
+      out.owned[i].swap(results[i].value);
+    }
+    out.view_owned();
+    return;
+  }
   flush_write_buffer();
 
-  auto results = lineairdb_proxy->tx_batch_read(this, keys);
-  std::vector<std::pair<bool, std::string>> pairs;
-  pairs.reserve(results.size());
-  for (auto& r : results) {
-    pairs.emplace_back(r.found, std::move(r.value));
-  }
-  return pairs;
+  lineairdb_proxy->tx_batch_read(this, keys, out);
 }
 
 bool LineairDBTransaction::batch_write(
     const std::string& table_name,
     const std::vector<LineairDBProxy::BatchWriteOp>& writes,
     const std::vector<LineairDBProxy::BatchSecondaryIndexOp>& si_writes) {
+  ensure_begun();
   return lineairdb_proxy->tx_batch_write(this, table_name, writes, si_writes);
 }
 
 std::vector<std::string>
 LineairDBTransaction::get_all_keys() {
   if (table_is_not_chosen()) return {};
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
   auto key_value_pairs = lineairdb_proxy->tx_get_matching_keys_and_values_from_prefix(this, "");
+  finish_flush_write_buffer(flush);
 
   std::vector<std::string> keyList;
   for (const auto& kv : key_value_pairs) {
@@ -80,9 +104,10 @@ LineairDBTransaction::get_all_keys() {
 std::vector<std::string>
 LineairDBTransaction::get_matching_keys(std::string first_key_part) {
   if (table_is_not_chosen()) return {};
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
   auto key_value_pairs = lineairdb_proxy->tx_get_matching_keys_and_values_from_prefix(this, first_key_part);
+  finish_flush_write_buffer(flush);
 
   std::vector<std::string> keyList;
   for (const auto& kv : key_value_pairs) {
@@ -94,12 +119,14 @@ LineairDBTransaction::get_matching_keys(std::string first_key_part) {
 
 bool LineairDBTransaction::write(std::string key, const std::string value) {
   if (table_is_not_chosen()) return false;
+  ensure_begun();
 
   return lineairdb_proxy->tx_write(this, key, value);
 }
 
 bool LineairDBTransaction::delete_value(std::string key) {
   if (table_is_not_chosen()) return false;
+  ensure_begun();
 
   return lineairdb_proxy->tx_delete(this, key);
 }
@@ -110,6 +137,14 @@ std::vector<std::string>
 LineairDBTransaction::read_secondary_index(std::string index_name,
                                            std::string secondary_key) {
   if (table_is_not_chosen()) return {};
+  if ((!write_buffer_ops_.empty() || tx_id == 0) && !is_aborted_) {
+    LineairDBProxy::MultiOp op{LineairDBProxy::MultiOp::Kind::READ_SECONDARY_INDEX,
+                               db_table_key, table_handles_, std::move(index_name)};
+    op.secondary_key = std::move(secondary_key);
+    std::vector<LineairDBProxy::MultiResult> results;
+    flush_write_buffer_with_reads({std::move(op)}, results);
+    return results.empty() ? std::vector<std::string>() : std::move(results[0].values);
+  }
   flush_write_buffer();
 
   return lineairdb_proxy->tx_read_secondary_index(this, index_name, secondary_key);
@@ -119,6 +154,7 @@ bool LineairDBTransaction::write_secondary_index(std::string index_name,
                                                  std::string secondary_key,
                                                  const std::string primary_key) {
   if (table_is_not_chosen()) return false;
+  ensure_begun();
 
   return lineairdb_proxy->tx_write_secondary_index(this, index_name, secondary_key, primary_key);
 }
@@ -127,6 +163,7 @@ bool LineairDBTransaction::delete_secondary_index(std::string index_name,
                                                   std::string secondary_key,
                                                   const std::string primary_key) {
   if (table_is_not_chosen()) return false;
+  ensure_begun();
 
   return lineairdb_proxy->tx_delete_secondary_index(this, index_name, secondary_key, primary_key);
 }
@@ -136,6 +173,7 @@ bool LineairDBTransaction::update_secondary_index(std::string index_name,
                                                   std::string new_secondary_key,
                                                   const std::string primary_key) {
   if (table_is_not_chosen()) return false;
+  ensure_begun();
 
   return lineairdb_proxy->tx_update_secondary_index(this, index_name, old_secondary_key, new_secondary_key, primary_key);
 }
@@ -146,18 +184,21 @@ std::vector<std::string>
 LineairDBTransaction::get_matching_keys_in_range(std::string start_key,
                                                  std::string end_key) {
   if (table_is_not_chosen()) return {};
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
-  return lineairdb_proxy->tx_get_matching_keys_in_range(this, start_key, end_key);
+  auto result = lineairdb_proxy->tx_get_matching_keys_in_range(this, start_key, end_key);
+  finish_flush_write_buffer(flush);
+  return result;
 }
 
 std::vector<std::pair<std::string, std::string>>
 LineairDBTransaction::get_matching_keys_and_values_in_range(std::string start_key,
                                                             std::string end_key) {
   if (table_is_not_chosen()) return {};
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
   auto results = lineairdb_proxy->tx_get_matching_keys_and_values_in_range(this, start_key, end_key);
+  finish_flush_write_buffer(flush);
 
   std::vector<std::pair<std::string, std::string>> pairs;
   for (const auto& kv : results) {
@@ -169,9 +210,10 @@ LineairDBTransaction::get_matching_keys_and_values_in_range(std::string start_ke
 std::vector<std::pair<std::string, std::string>>
 LineairDBTransaction::get_matching_keys_and_values_from_prefix(std::string prefix) {
   if (table_is_not_chosen()) return {};
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
   auto results = lineairdb_proxy->tx_get_matching_keys_and_values_from_prefix(this, prefix);
+  finish_flush_write_buffer(flush);
 
   std::vector<std::pair<std::string, std::string>> pairs;
   for (const auto& kv : results) {
@@ -184,27 +226,33 @@ std::optional<std::string>
 LineairDBTransaction::fetch_last_key_in_range(const std::string &start_key,
                                               const std::string &end_key) {
   if (table_is_not_chosen()) return std::nullopt;
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
-  return lineairdb_proxy->tx_fetch_last_key_in_range(this, start_key, end_key);
+  auto result = lineairdb_proxy->tx_fetch_last_key_in_range(this, start_key, end_key);
+  finish_flush_write_buffer(flush);
+  return result;
 }
 
 std::optional<std::string>
 LineairDBTransaction::fetch_first_key_with_prefix(const std::string &prefix,
                                                   const std::string &prefix_end) {
   if (table_is_not_chosen()) return std::nullopt;
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
-  return lineairdb_proxy->tx_fetch_first_key_with_prefix(this, prefix, prefix_end);
+  auto result = lineairdb_proxy->tx_fetch_first_key_with_prefix(this, prefix, prefix_end);
+  finish_flush_write_buffer(flush);
+  return result;
 }
 
 std::optional<std::string>
 LineairDBTransaction::fetch_next_key_with_prefix(const std::string &last_key,
                                                  const std::string &prefix_end) {
   if (table_is_not_chosen()) return std::nullopt;
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
-  return lineairdb_proxy->tx_fetch_next_key_with_prefix(this, last_key, prefix_end);
+  auto result = lineairdb_proxy->tx_fetch_next_key_with_prefix(this, last_key, prefix_end);
+  finish_flush_write_buffer(flush);
+  return result;
 }
 
 // Secondary index scan operations
@@ -214,18 +262,22 @@ LineairDBTransaction::get_matching_primary_keys_in_range(std::string index_name,
                                                          std::string start_key,
                                                          std::string end_key) {
   if (table_is_not_chosen()) return {};
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
-  return lineairdb_proxy->tx_get_matching_primary_keys_in_range(this, index_name, start_key, end_key);
+  auto result = lineairdb_proxy->tx_get_matching_primary_keys_in_range(this, index_name, start_key, end_key);
+  finish_flush_write_buffer(flush);
+  return result;
 }
 
 std::vector<std::string>
 LineairDBTransaction::get_matching_primary_keys_from_prefix(std::string index_name,
                                                             std::string prefix) {
   if (table_is_not_chosen()) return {};
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
-  return lineairdb_proxy->tx_get_matching_primary_keys_from_prefix(this, index_name, prefix);
+  auto result = lineairdb_proxy->tx_get_matching_primary_keys_from_prefix(this, index_name, prefix);
+  finish_flush_write_buffer(flush);
+  return result;
 }
 
 std::optional<std::string>
@@ -233,9 +285,11 @@ LineairDBTransaction::fetch_last_primary_key_in_secondary_range(const std::strin
                                                                 const std::string &start_key,
                                                                 const std::string &end_key) {
   if (table_is_not_chosen()) return std::nullopt;
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
-  return lineairdb_proxy->tx_fetch_last_primary_key_in_secondary_range(this, index_name, start_key, end_key);
+  auto result = lineairdb_proxy->tx_fetch_last_primary_key_in_secondary_range(this, index_name, start_key, end_key);
+  finish_flush_write_buffer(flush);
+  return result;
 }
 
 std::optional<SecondaryIndexEntry>
@@ -243,9 +297,11 @@ LineairDBTransaction::fetch_last_secondary_entry_in_range(const std::string &ind
                                                           const std::string &start_key,
                                                           const std::string &end_key) {
   if (table_is_not_chosen()) return std::nullopt;
-  flush_write_buffer();
+  uint64_t flush = start_flush_write_buffer();
 
-  return lineairdb_proxy->tx_fetch_last_secondary_entry_in_range(this, index_name, start_key, end_key);
+  auto result = lineairdb_proxy->tx_fetch_last_secondary_entry_in_range(this, index_name, start_key, end_key);
+  finish_flush_write_buffer(flush);
+  return result;
 }
 
 // Row count delta tracking
@@ -277,46 +333,131 @@ LineairDBTransaction::peek_rowcount_delta(const LineairDB_share *share) const {
   return 0;
 }
 
-void LineairDBTransaction::buffer_write(const std::string& table_name,
-                                        const std::string& key,
-                                        const std::string& value) {
-  // If table changed, flush the current buffer first
-  if (!write_buffer_ops_.empty() && write_buffer_table_ != table_name) {
+void LineairDBTransaction::buffer_op(LineairDBProxy::MultiOp op) {
+  using Kind = LineairDBProxy::MultiOp::Kind;
+  bool is_row = op.kind == Kind::WRITE || op.kind == Kind::DELETE;
+  write_buffer_ops_.push_back(std::move(op));
+  if (is_row && ++write_buffer_rows_ >= WRITE_BATCH_SIZE) {
     flush_write_buffer();
   }
-  write_buffer_table_ = table_name;
-  write_buffer_ops_.push_back({key, value});
+}
 
-  if (write_buffer_ops_.size() >= WRITE_BATCH_SIZE) {
-    flush_write_buffer();
-  }
+void LineairDBTransaction::buffer_write(const std::string& table_name,
+                                        const std::string& key,
+                                        const std::string& value,
+                                        TableHandleCache *handles) {
+  LineairDBProxy::MultiOp op{LineairDBProxy::MultiOp::Kind::WRITE, table_name, handles};
+  op.key = key;
+  op.value = value;
+  buffer_op(std::move(op));
+}
+
+void LineairDBTransaction::buffer_delete(const std::string& table_name,
+                                         const std::string& key,
+                                         TableHandleCache *handles) {
+  LineairDBProxy::MultiOp op{LineairDBProxy::MultiOp::Kind::DELETE, table_name, handles};
+  op.key = key;
+  buffer_op(std::move(op));
 }
 
 void LineairDBTransaction::buffer_write_secondary_index(const std::string& table_name,
                                                         const std::string& index_name,
                                                         const std::string& secondary_key,
-                                                        const std::string& primary_key) {
-  write_buffer_si_ops_.push_back({index_name, secondary_key, primary_key});
+                                                        const std::string& primary_key,
+                                                        TableHandleCache *handles) {
+  LineairDBProxy::MultiOp op{LineairDBProxy::MultiOp::Kind::WRITE_SECONDARY_INDEX,
+                             table_name, handles, index_name, primary_key};
+  op.secondary_key = secondary_key;
+  buffer_op(std::move(op));
+}
+
+void LineairDBTransaction::buffer_delete_secondary_index(const std::string& table_name,
+                                                         const std::string& index_name,
+                                                         const std::string& secondary_key,
+                                                         const std::string& primary_key,
+                                                         TableHandleCache *handles) {
+  LineairDBProxy::MultiOp op{LineairDBProxy::MultiOp::Kind::DELETE_SECONDARY_INDEX,
+                             table_name, handles, index_name, primary_key};
+  op.secondary_key = secondary_key;
+  buffer_op(std::move(op));
+}
+
+void LineairDBTransaction::buffer_update_secondary_index(const std::string& table_name,
+                                                         const std::string& index_name,
+                                                         const std::string& old_secondary_key,
+                                                         const std::string& new_secondary_key,
+                                                         const std::string& primary_key,
+                                                         TableHandleCache *handles) {
+  LineairDBProxy::MultiOp op{LineairDBProxy::MultiOp::Kind::UPDATE_SECONDARY_INDEX,
+                             table_name, handles, index_name, primary_key};
+  op.secondary_key = old_secondary_key;
+  op.new_secondary_key = new_secondary_key;
+  buffer_op(std::move(op));
+}
+
+void LineairDBTransaction::flush_write_buffer_with_reads(
+    std::vector<LineairDBProxy::MultiOp> reads,
+    std::vector<LineairDBProxy::MultiResult>& results) {
+  size_t first_read = write_buffer_ops_.size();
+  for (auto& op : reads) {
+    write_buffer_ops_.push_back(std::move(op));
+  }
+  write_buffer_rows_ = 0;
+  lineairdb_proxy->tx_multi(this, write_buffer_ops_, &results);
+  write_buffer_ops_.clear();
+  if (results.size() > first_read) {
+    results.erase(results.begin(), results.begin() + first_read);
+  } else {
+    results.clear();
+  }
+}
+
+uint64_t LineairDBTransaction::start_flush_write_buffer() {
+  uint64_t request_id = 0;
+  // The request that follows needs the ID of a transaction this flush would
+  // begin, so that flush has to finish first
+  if (write_buffer_ops_.empty() || is_aborted_ || tx_id == 0 ||
+      !lineairdb_proxy->start_multi(this, write_buffer_ops_, request_id)) {
+    flush_write_buffer();
+    ensure_begun();
+    return 0;
+  }
+  flush_in_flight_ops_ = write_buffer_ops_.size();
+  write_buffer_ops_.clear();
+  write_buffer_rows_ = 0;
+  return request_id;
+}
+
+void LineairDBTransaction::finish_flush_write_buffer(uint64_t request_id) {
+  if (request_id != 0) {
+    lineairdb_proxy->finish_multi(this, request_id, flush_in_flight_ops_);
+  }
+}
+
+void LineairDBTransaction::ensure_begun() {
+  if (tx_id == 0) {
+    tx_id = lineairdb_proxy->tx_begin_transaction();
+  }
 }
 
 bool LineairDBTransaction::flush_write_buffer() {
-  if (write_buffer_ops_.empty() && write_buffer_si_ops_.empty()) return true;
+  if (write_buffer_ops_.empty()) return true;
+  write_buffer_rows_ = 0;
   if (is_aborted_) {
     write_buffer_ops_.clear();
-    write_buffer_si_ops_.clear();
     return false;
   }
 
-  bool ok = lineairdb_proxy->tx_batch_write(
-      this, write_buffer_table_, write_buffer_ops_, write_buffer_si_ops_);
+  bool ok = lineairdb_proxy->tx_multi(this, write_buffer_ops_);
   write_buffer_ops_.clear();
-  write_buffer_si_ops_.clear();
   return ok;
 }
 
 void LineairDBTransaction::begin_transaction() {
   assert(is_not_started());
-  tx_id = lineairdb_proxy->tx_begin_transaction();
+  // With implicit begin the first TX_MULTI (a read, a flush or the commit)
+  // begins the transaction on the server; tx_id stays 0 until then
+  tx_id = lineairdb_proxy->implicit_begin() ? 0 : lineairdb_proxy->tx_begin_transaction();
   // TODO: maybe need error handling when tx_id == -1
   assert(tx_id != -1);
   is_aborted_ = false;
@@ -332,7 +473,7 @@ void LineairDBTransaction::begin_transaction() {
 
 void LineairDBTransaction::set_status_to_abort() {
   // Skip TX_ABORT RPC if the server already knows (is_aborted_ was set from an RPC response).
-  if (!is_aborted_) {
+  if (!is_aborted_ && tx_id != 0) {
     lineairdb_proxy->tx_abort(tx_id);
   }
   is_aborted_ = true;
@@ -340,7 +481,12 @@ void LineairDBTransaction::set_status_to_abort() {
 
 bool LineairDBTransaction::end_transaction() {
   assert(tx_id != -1);
-  flush_write_buffer();
+  // The last write batch carries the commit when the server can do both
+  bool commit_with_writes =
+      !write_buffer_ops_.empty() && !is_aborted_ && lineairdb_proxy->implicit_begin();
+  if (!commit_with_writes) {
+    flush_write_buffer();
+  }
   bool was_aborted = is_aborted_;
 
   // Build row-delta pairs for the server (table_name, delta).
@@ -353,7 +499,17 @@ bool LineairDBTransaction::end_transaction() {
     }
   }
 
-  bool committed = lineairdb_proxy->db_end_transaction(tx_id, isFence, server_deltas);
+  bool committed;
+  if (commit_with_writes) {
+    committed = lineairdb_proxy->tx_multi_commit(this, write_buffer_ops_, isFence, server_deltas);
+    write_buffer_ops_.clear();
+    write_buffer_rows_ = 0;
+  } else if (tx_id == 0) {
+    // Never begun on the server: nothing to end there
+    committed = !was_aborted;
+  } else {
+    committed = lineairdb_proxy->db_end_transaction(tx_id, isFence, server_deltas);
+  }
   if (!committed) {
     thd_mark_transaction_to_rollback(thread, 1);
   }
@@ -373,7 +529,8 @@ bool LineairDBTransaction::end_transaction() {
     }
   }
 
-  if (isFence && !was_aborted && committed) {
+  // Older servers ignore the fence flag of the commit itself
+  if (isFence && !was_aborted && committed && !lineairdb_proxy->durable_fence()) {
     lineairdb_proxy->db_fence();
   }
   delete this;
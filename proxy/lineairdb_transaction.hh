@@ -24,11 +24,16 @@ class LineairDBTransaction
 {
 public:
   std::string get_selected_table_name();
-  void choose_table(std::string db_table_name);
+  // handles: the table's LineairDB_share cache, so RPCs can name it by handle
+  void choose_table(std::string db_table_name, TableHandleCache *handles = nullptr);
+  TableHandleCache *selected_table_handles() const { return table_handles_; }
   bool table_is_not_chosen();
 
   const std::pair<const std::byte *const, const size_t> read(std::string key);
-  std::vector<std::pair<bool, std::string>> batch_read(const std::vector<std::string>& keys);
+  // out.values[i] is the row for keys[i], or empty if it does not exist;
+  // see LineairDBProxy::BatchReadValues for how long the values live
+  void batch_read(const std::vector<std::string>& keys,
+                  LineairDBProxy::BatchReadValues& out);
   bool batch_write(const std::string& table_name,
                    const std::vector<LineairDBProxy::BatchWriteOp>& writes,
                    const std::vector<LineairDBProxy::BatchSecondaryIndexOp>& si_writes);
@@ -66,15 +71,34 @@ public:
   bool delete_value(std::string key);
   bool delete_secondary_index(std::string index_name, std::string secondary_key, const std::string primary_key);
 
-  // Write buffering for batch operations
+  // Write buffering: writes, deletes and secondary index changes that need
+  // no answer are queued, on any mix of tables, and sent together in order
+  // (LineairDBProxy::tx_multi) at the next flush
   void buffer_write(const std::string& table_name,
-                    const std::string& key, const std::string& value);
+                    const std::string& key, const std::string& value,
+                    TableHandleCache *handles = nullptr);
+  void buffer_delete(const std::string& table_name, const std::string& key,
+                     TableHandleCache *handles = nullptr);
   void buffer_write_secondary_index(const std::string& table_name,
                                      const std::string& index_name,
                                      const std::string& secondary_key,
-                                     const std::string& primary_key);
+                                     const std::string& primary_key,
+                                     TableHandleCache *handles = nullptr);
+  void buffer_delete_secondary_index(const std::string& table_name,
+                                     const std::string& index_name,
+                                     const std::string& secondary_key,
+                                     const std::string& primary_key,
+                                     TableHandleCache *handles = nullptr);
+  void buffer_update_secondary_index(const std::string& table_name,
+                                     const std::string& index_name,
+                                     const std::string& old_secondary_key,
+                                     const std::string& new_secondary_key,
+                                     const std::string& primary_key,
+                                     TableHandleCache *handles = nullptr);
   // Flush buffered writes to LineairDB so that subsequent reads can see them.
-  // Must be called before any read/scan RPC to ensure read-your-own-writes.
+  // Must be called before any read/scan RPC to ensure read-your-own-writes;
+  // the read and scan methods here do it themselves, without an extra round
+  // trip when the server runs TX_MULTI.
   bool flush_write_buffer();
 
   void begin_transaction();
@@ -88,10 +112,14 @@ public:
     return false;
   }
 
+  // 0 until the first TX_MULTI begins the transaction on the server, when
+  // the proxy negotiated implicit begin
   inline int64_t get_tx_id() const {
     return tx_id;
   }
 
+  inline void set_tx_id(int64_t id) { tx_id = id; }
+
   inline bool is_aborted() const { 
     return is_aborted_;
   }
@@ -123,6 +151,7 @@ private:
   int64_t tx_id;  // transaction id (instead of tx pointer), -1 means tx is not started
   LineairDBProxy* lineairdb_proxy;
   std::string db_table_key;
+  TableHandleCache *table_handles_ = nullptr;
   THD* thread;
   bool isTransaction;
   handlerton* hton;
@@ -144,11 +173,24 @@ private:
   // Predicate pushdown: serialized PushedPredicate for scan filtering
   std::string pushed_filter_;
 
-  // Write buffer for batch write operations
+  // Write buffer, flushed once it holds WRITE_BATCH_SIZE row writes/deletes
   static constexpr size_t WRITE_BATCH_SIZE = 100;
-  std::string write_buffer_table_;
-  std::vector<LineairDBProxy::BatchWriteOp> write_buffer_ops_;
-  std::vector<LineairDBProxy::BatchSecondaryIndexOp> write_buffer_si_ops_;
+  std::vector<LineairDBProxy::MultiOp> write_buffer_ops_;
+  size_t write_buffer_rows_ = 0;
+  size_t flush_in_flight_ops_ = 0;  // ops of the flush start_flush_write_buffer() sent
+
+  void buffer_op(LineairDBProxy::MultiOp op);
+  // Flush with reads appended to the same TX_MULTI; results gets one entry
+  // per read that ran
+  void flush_write_buffer_with_reads(std::vector<LineairDBProxy::MultiOp> reads,
+                                     std::vector<LineairDBProxy::MultiResult>& results);
+  // Send the buffer ahead of the caller's next RPC without waiting for it;
+  // returns the request to finish afterwards, or 0 if it was flushed already
+  uint64_t start_flush_write_buffer();
+  void finish_flush_write_buffer(uint64_t request_id);
+  // Begin the transaction on the server now if that was left to the first
+  // TX_MULTI, for RPCs that cannot begin it
+  void ensure_begun();
 
   bool thd_is_transaction() const;
   void register_transaction_to_mysql();
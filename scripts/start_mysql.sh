@@ -2,14 +2,33 @@
 
 set -euo pipefail
 
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
 SERVER_HOST="127.0.0.1"
 SERVER_PORT=9999
 MYSQLD_PORT=3307
+SHM_SOCKET=""
+MUX_CONNECTIONS=0
+POOL_WARMUP=0
+COMPRESSION="off"
+COMPRESSION_THRESHOLD=65536
+# Newest wire protocol version the plugin speaks (Rpc::kProtocolVersion)
+PROTOCOL_VERSION=$(sed -n 's/^constexpr uint32_t kProtocolVersion = \([0-9]*\);.*/\1/p' \
+  "$ROOT_DIR/common/point_codec.h")
 
 usage() {
   cat <<USAGE
-Usage: $0 [--mysqld-port N] [--server-host HOST] [--server-port PORT]
+Usage: $0 [--mysqld-port N] [--server-host HOST] [--server-port PORT] [--shm-socket PATH] [--mux-connections N] [--pool-warmup N]
+          [--compression off|lz4|zstd] [--compression-threshold BYTES] [--protocol-version 1|2|3|4|5|6|7]
 Defaults: mysqld-port=3307, server=127.0.0.1:9999
+--shm-socket uses the shared-memory transport of a co-located lineairdb-server (started with the same --shm-socket)
+--mux-connections N shares N server connections among all client sessions (0 = one connection per session)
+--pool-warmup N pre-connects N pooled server connections when the plugin loads
+--compression asks the server to compress TCP responses of at least --compression-threshold bytes (default 65536)
+--protocol-version 1 keeps point reads/writes on protobuf instead of the binary encoding, 2 also sends table/index
+    names instead of numeric handles, 3 also sends scan keys in full instead of front-coded, 4 sends deferred
+    writes/deletes as one batch per table instead of one TX_MULTI across tables, 5 also begins transactions and
+    commits them with separate round trips instead of on the first and last TX_MULTI, 6 also follows a fenced
+    commit with DB_FENCE instead of the server answering it once durable (default $PROTOCOL_VERSION)
 Data dir / socket are derived from mysqld-port (3307 -> data,/tmp/mysql.sock; others -> data_PORT,/tmp/mysql_PORT.sock)
 USAGE
 }
@@ -19,6 +38,12 @@ while [[ $# -gt 0 ]]; do
     --mysqld-port) MYSQLD_PORT="$2"; shift 2;;
     --server-host) SERVER_HOST="$2"; shift 2;;
     --server-port) SERVER_PORT="$2"; shift 2;;
+    --shm-socket) SHM_SOCKET="$2"; shift 2;;
+    --mux-connections) MUX_CONNECTIONS="$2"; shift 2;;
+    --pool-warmup) POOL_WARMUP="$2"; shift 2;;
+    --compression) COMPRESSION="$2"; shift 2;;
+    --compression-threshold) COMPRESSION_THRESHOLD="$2"; shift 2;;
+    --protocol-version) PROTOCOL_VERSION="$2"; shift 2;;
     --help|-h) usage; exit 0;;
     --) shift; break;;
     -*) echo "Unknown option: $1" >&2; usage; exit 2;;
@@ -26,7 +51,6 @@ while [[ $# -gt 0 ]]; do
   esac
 done
 
-ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
 cd "$ROOT_DIR/build"
 
 # jemalloc: use LD_PRELOAD to replace glibc malloc
@@ -82,11 +106,25 @@ kill "$BOOT_PID" 2>/dev/null || true
 wait "$BOOT_PID" 2>/dev/null || true
 sleep 3
 
+# The warm-up runs at plugin init, before the SET GLOBALs below, so the
+# connection target has to be known on the command line.
+PLUGIN_ARGS=()
+if [ "$POOL_WARMUP" != "0" ]; then
+  PLUGIN_ARGS+=(--loose-lineairdb-server-host="$SERVER_HOST"
+                --loose-lineairdb-server-port="$SERVER_PORT"
+                --loose-lineairdb-shm-socket="$SHM_SOCKET"
+                --loose-lineairdb-compression="$COMPRESSION"
+                --loose-lineairdb-compression-threshold="$COMPRESSION_THRESHOLD"
+                --loose-lineairdb-protocol-version="$PROTOCOL_VERSION"
+                --loose-lineairdb-proxy-pool-warmup="$POOL_WARMUP")
+fi
+
 nohup ./runtime_output_directory/mysqld --datadir="$DATA_DIR" --socket="$SOCKET" --port="$MYSQLD_PORT" \
   --pid-file="$PID_FILE" --default-storage-engine=lineairdb \
   --max-connections=16384 \
   --open-files-limit=65535 \
   --table-open-cache=8192 \
+  "${PLUGIN_ARGS[@]}" \
   --disable-log-bin >> "$MYSQL_LOG_FILE" 2>&1 &
 MYSQL_PID=$!
 disown "$MYSQL_PID" 2>/dev/null || true
@@ -96,7 +134,7 @@ until ./runtime_output_directory/mysqladmin ping -u root --socket="$SOCKET" --po
 done
 
 ./runtime_output_directory/mysql -u root --socket="$SOCKET" --port="$MYSQLD_PORT" \
-  -e "SET GLOBAL lineairdb_server_host='${SERVER_HOST}'; SET GLOBAL lineairdb_server_port=${SERVER_PORT};" >/dev/null
+  -e "SET GLOBAL lineairdb_server_host='${SERVER_HOST}'; SET GLOBAL lineairdb_server_port=${SERVER_PORT}; SET GLOBAL lineairdb_shm_socket='${SHM_SOCKET}'; SET GLOBAL lineairdb_mux_connections=${MUX_CONNECTIONS}; SET GLOBAL lineairdb_compression='${COMPRESSION}'; SET GLOBAL lineairdb_compression_threshold=${COMPRESSION_THRESHOLD}; SET GLOBAL lineairdb_protocol_version=${PROTOCOL_VERSION};" >/dev/null
 
 echo "MySQL running with LineairDB"
 echo "PID       : $MYSQL_PID"
@@ -104,4 +142,13 @@ echo "Port      : $MYSQLD_PORT"
 echo "Data dir  : $DATA_DIR"
 echo "Socket    : $SOCKET"
 echo "Server    : ${SERVER_HOST}:${SERVER_PORT}"
+if [ -n "$SHM_SOCKET" ]; then
+  echo "Shm socket: $SHM_SOCKET"
+fi
+if [ "$MUX_CONNECTIONS" != "0" ]; then
+  echo "Mux conns : $MUX_CONNECTIONS"
+fi
+if [ "$COMPRESSION" != "off" ]; then
+  echo "Compress  : $COMPRESSION (>= $COMPRESSION_THRESHOLD bytes)"
+fi
 echo "Log       : $MYSQL_LOG_FILE"
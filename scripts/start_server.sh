@@ -30,9 +30,16 @@ if pgrep -f "/build/server/lineairdb-server" >/dev/null 2>&1; then
   exit 0
 fi
 
-echo "Starting lineairdb-server (port 9999) ..."
+# LINEAIRDB_SERVER_CPUS confines the server to a CPU list (taskset -c syntax);
+# with the default --engine-threads it then runs one engine slot per CPU
+LAUNCH=()
+if [ -n "${LINEAIRDB_SERVER_CPUS:-}" ]; then
+  LAUNCH=(taskset -c "$LINEAIRDB_SERVER_CPUS")
+fi
+
+echo "Starting lineairdb-server (port 9999) $* ${LINEAIRDB_SERVER_CPUS:+on cpus $LINEAIRDB_SERVER_CPUS }..."
 ulimit -n 1048576 2>/dev/null || ulimit -n 65535 2>/dev/null || true
-nohup "$BIN" > "$LOG_FILE" 2>&1 &
+nohup ${LAUNCH[@]+"${LAUNCH[@]}"} "$BIN" "$@" > "$LOG_FILE" 2>&1 &
 PID=$!
 echo $PID > "$PID_FILE"
 
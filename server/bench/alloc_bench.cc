@@ -0,0 +1,303 @@
+// lineairdb-alloc-bench: heap allocations per RPC on the client send/receive path.
+//
+// Runs TX_READ and TX_WRITE round trips against lineairdb-server over one
+// TCP connection and counts operator new calls per RPC for two framings:
+//
+//   legacy  SerializeAsString() -> copy header+payload into a fresh vector
+//           -> recv into a resized std::string -> ParseFromString()
+//           (what LineairDBProxy did before the reusable buffers)
+//   reuse   Rpc::FrameBuffer / Rpc::PayloadBuffer from common/rpc_buffer.h,
+//           serialize in place and ParseFromArray() (the current proxy path)
+//
+// Request/response messages are built fresh per RPC in both modes, exactly
+// like the proxy, so the difference is the framing alone.
+//
+//   lineairdb-alloc-bench --rpcs 100000 --value-size 100
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../../common/rpc_buffer.h"
+#include "lineairdb.pb.h"
+#include "protocol/message.hh"
+
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_allocated_bytes{0};
+}  // namespace
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t port = 9999;
+    size_t rpcs = 100000;
+    size_t keys = 1000;
+    size_t value_size = 100;
+    std::string table = "allocbench";
+};
+
+int connect_to(const Options& opt) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opt.port);
+    if (fd < 0 || inet_pton(AF_INET, opt.host.c_str(), &addr.sin_addr) <= 0 ||
+        connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    return fd;
+}
+
+bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool read_all(int fd, char* data, size_t len) {
+    return len == 0 || recv(fd, data, len, MSG_WAITALL) == static_cast<ssize_t>(len);
+}
+
+// The pre-buffer proxy path, kept verbatim in spirit for comparison.
+class LegacyClient {
+public:
+    explicit LegacyClient(int fd) : fd_(fd) {}
+
+    template <typename Request, typename Response>
+    bool call(MessageType type, const Request& request, Response& response) {
+        std::string serialized_request = request.SerializeAsString();
+
+        MessageHeader header;
+        header.sender_id = htobe64(next_id_++);
+        header.message_type = htonl(static_cast<uint32_t>(type));
+        header.payload_size = htonl(static_cast<uint32_t>(serialized_request.size()));
+        std::vector<char> buffer(sizeof(header) + serialized_request.size());
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        std::memcpy(buffer.data() + sizeof(header), serialized_request.data(), serialized_request.size());
+        if (!write_all(fd_, buffer.data(), buffer.size())) return false;
+
+        MessageHeader response_header;
+        if (!read_all(fd_, reinterpret_cast<char*>(&response_header), sizeof(response_header))) return false;
+        std::string serialized_response;
+        serialized_response.resize(ntohl(response_header.payload_size));
+        if (!read_all(fd_, &serialized_response[0], serialized_response.size())) return false;
+        return response.ParseFromString(serialized_response);
+    }
+
+private:
+    int fd_;
+    uint64_t next_id_ = 1;
+};
+
+class ReuseClient {
+public:
+    explicit ReuseClient(int fd) : fd_(fd) {}
+
+    template <typename Request, typename Response>
+    bool call(MessageType type, const Request& request, Response& response) {
+        frame_.build(static_cast<uint32_t>(type), request);
+        frame_.set_request_id(next_id_++);
+        if (!write_all(fd_, frame_.data(), frame_.size())) return false;
+
+        char header[Rpc::kHeaderSize];
+        if (!read_all(fd_, header, sizeof(header))) return false;
+        uint64_t id;
+        uint32_t response_type;
+        uint32_t payload_size;
+        Rpc::decode_header(header, id, response_type, payload_size);
+        if (!read_all(fd_, payload_.prepare(payload_size), payload_size)) return false;
+        return payload_.parse(response);
+    }
+
+private:
+    int fd_;
+    uint64_t next_id_ = 1;
+    Rpc::FrameBuffer frame_;
+    Rpc::PayloadBuffer payload_;
+};
+
+std::string make_key(size_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "key%012zu", i);
+    return buf;
+}
+
+template <typename Client>
+int64_t begin(Client& client) {
+    LineairDB::Protocol::TxBeginTransaction::Request request;
+    LineairDB::Protocol::TxBeginTransaction::Response response;
+    return client.call(MessageType::TX_BEGIN_TRANSACTION, request, response) ? response.transaction_id() : -1;
+}
+
+template <typename Client>
+bool end(Client& client, int64_t tx_id) {
+    LineairDB::Protocol::DbEndTransaction::Request request;
+    LineairDB::Protocol::DbEndTransaction::Response response;
+    request.set_transaction_id(tx_id);
+    request.set_fence(false);
+    return client.call(MessageType::DB_END_TRANSACTION, request, response);
+}
+
+struct Result {
+    double allocs_per_rpc;
+    double bytes_per_rpc;
+    double ns_per_rpc;
+};
+
+// Issue opt.rpcs TX_READ or TX_WRITE RPCs inside one transaction; only those
+// RPCs are inside the counting window.
+template <typename Client>
+bool measure(const Options& opt, Client& client, bool write, Result& result) {
+    const std::string value(opt.value_size, 'v');
+    int64_t tx_id = begin(client);
+    if (tx_id < 0) return false;
+
+    // Warm up buffers and protobuf internals before counting
+    std::string key = make_key(0);
+    for (int i = 0; i < 100; i++) {
+        LineairDB::Protocol::TxRead::Request request;
+        LineairDB::Protocol::TxRead::Response response;
+        request.set_transaction_id(tx_id);
+        request.set_table_name(opt.table);
+        request.set_key(key);
+        if (!client.call(MessageType::TX_READ, request, response)) return false;
+    }
+
+    uint64_t allocs_before = g_allocations.load();
+    uint64_t bytes_before = g_allocated_bytes.load();
+    auto start = Clock::now();
+    for (size_t i = 0; i < opt.rpcs; i++) {
+        // key stays within the SSO buffer, so building it does not allocate
+        std::snprintf(&key[0], key.size() + 1, "key%012zu", i % opt.keys);
+        bool ok;
+        if (write) {
+            LineairDB::Protocol::TxWrite::Request request;
+            LineairDB::Protocol::TxWrite::Response response;
+            request.set_transaction_id(tx_id);
+            request.set_table_name(opt.table);
+            request.set_key(key);
+            request.set_value(value);
+            ok = client.call(MessageType::TX_WRITE, request, response);
+        } else {
+            LineairDB::Protocol::TxRead::Request request;
+            LineairDB::Protocol::TxRead::Response response;
+            request.set_transaction_id(tx_id);
+            request.set_table_name(opt.table);
+            request.set_key(key);
+            ok = client.call(MessageType::TX_READ, request, response);
+        }
+        if (!ok) return false;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    result.allocs_per_rpc = static_cast<double>(g_allocations.load() - allocs_before) / opt.rpcs;
+    result.bytes_per_rpc = static_cast<double>(g_allocated_bytes.load() - bytes_before) / opt.rpcs;
+    result.ns_per_rpc = static_cast<double>(elapsed) / opt.rpcs;
+    return end(client, tx_id);
+}
+
+bool prepare(const Options& opt, int fd) {
+    LegacyClient client(fd);
+    LineairDB::Protocol::DbCreateTable::Request create;
+    LineairDB::Protocol::DbCreateTable::Response created;
+    create.set_table_name(opt.table);
+    if (!client.call(MessageType::DB_CREATE_TABLE, create, created)) return false;
+
+    int64_t tx_id = begin(client);
+    LineairDB::Protocol::TxBatchWrite::Request batch;
+    LineairDB::Protocol::TxBatchWrite::Response written;
+    batch.set_transaction_id(tx_id);
+    batch.set_table_name(opt.table);
+    const std::string value(opt.value_size, 'v');
+    for (size_t i = 0; i < opt.keys; i++) {
+        auto* w = batch.add_writes();
+        w->set_key(make_key(i));
+        w->set_value(value);
+    }
+    return tx_id >= 0 && client.call(MessageType::TX_BATCH_WRITE, batch, written) && end(client, tx_id);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return 1;
+        }
+        if (arg == "--host") opt.host = value;
+        else if (arg == "--port") opt.port = static_cast<uint16_t>(std::atoi(value));
+        else if (arg == "--rpcs") opt.rpcs = std::strtoul(value, nullptr, 10);
+        else if (arg == "--keys") opt.keys = std::strtoul(value, nullptr, 10);
+        else if (arg == "--value-size") opt.value_size = std::strtoul(value, nullptr, 10);
+        else {
+            std::fprintf(stderr,
+                         "Usage: %s [--host H] [--port P] [--rpcs N] [--keys N] [--value-size N]\n",
+                         argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (opt.rpcs == 0 || opt.keys == 0) {
+        std::fprintf(stderr, "--rpcs and --keys must be positive\n");
+        return 1;
+    }
+
+    int fd = connect_to(opt);
+    if (fd < 0 || !prepare(opt, fd)) {
+        std::fprintf(stderr, "cannot reach lineairdb-server at %s:%u\n", opt.host.c_str(), opt.port);
+        return 1;
+    }
+
+    LegacyClient legacy(fd);
+    ReuseClient reuse(fd);
+    std::printf("%-9s %-7s %12s %12s %10s\n", "op", "path", "allocs/rpc", "bytes/rpc", "ns/rpc");
+    for (bool write : {false, true}) {
+        Result r;
+        if (!measure(opt, legacy, write, r)) return 1;
+        std::printf("%-9s %-7s %12.2f %12.1f %10.0f\n", write ? "TX_WRITE" : "TX_READ", "legacy",
+                    r.allocs_per_rpc, r.bytes_per_rpc, r.ns_per_rpc);
+        if (!measure(opt, reuse, write, r)) return 1;
+        std::printf("%-9s %-7s %12.2f %12.1f %10.0f\n", write ? "TX_WRITE" : "TX_READ", "reuse",
+                    r.allocs_per_rpc, r.bytes_per_rpc, r.ns_per_rpc);
+    }
+    close(fd);
+    return 0;
+}
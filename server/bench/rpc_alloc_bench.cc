@@ -0,0 +1,260 @@
+// lineairdb-rpc-alloc-bench: heap allocations per RPC inside the server.
+//
+// Drives LineairDBRpc in-process (no sockets) with the same protobuf payloads
+// a proxy sends and counts operator new calls made while handle_rpc() runs:
+//
+//   TX_BATCH_WRITE                          --batch rows, each with one
+//                                           secondary index entry
+//   TX_GET_MATCHING_PRIMARY_KEYS_IN_RANGE   a secondary range matching --scan
+//                                           primary keys
+//
+// The counts include LineairDB's own work (write set entries, scan results),
+// so compare runs of the same options across builds rather than reading them
+// as protobuf cost alone.
+//
+//   lineairdb-rpc-alloc-bench --rpcs 20000 --batch 100 --scan 100
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "lineairdb.pb.h"
+#include "rpc/lineairdb_rpc.hh"
+
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_allocated_bytes{0};
+}  // namespace
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t rpcs = 20000;
+    size_t batch = 100;
+    size_t scan = 100;
+    size_t value_size = 100;
+    std::string table = "rpcallocbench";
+    std::string index = "by_secondary";
+};
+
+struct Result {
+    double allocs_per_rpc = 0;
+    double bytes_per_rpc = 0;
+    double ns_per_rpc = 0;
+};
+
+std::string make_key(const char* prefix, size_t i) {
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "%s%016zu", prefix, i);
+    return buf;
+}
+
+// The driver calls into LineairDB from this thread only
+LineairDB::Config single_thread_config() {
+    LineairDB::Config conf = DatabaseManager::default_config();
+    conf.max_thread = 1;
+    return conf;
+}
+
+class Driver {
+public:
+    Driver()
+        : db_manager_(std::make_shared<DatabaseManager>(single_thread_config())),
+          rpc_(db_manager_, std::make_shared<TransactionManager>(),
+               std::make_shared<TableRowCounts>(), std::make_shared<TableHandles>()) {}
+
+    template <typename Request, typename Response>
+    bool call(MessageType type, const Request& request, Response& response) {
+        request.SerializeToString(&payload_);
+        rpc_.handle_rpc(0, type, payload_, result_);
+        return response.ParseFromString(result_);
+    }
+
+    // handle_rpc() alone, on a payload serialized beforehand
+    void call_raw(MessageType type, const std::string& payload) {
+        rpc_.handle_rpc(0, type, payload, result_);
+    }
+
+    int64_t begin() {
+        LineairDB::Protocol::TxBeginTransaction::Request request;
+        LineairDB::Protocol::TxBeginTransaction::Response response;
+        return call(MessageType::TX_BEGIN_TRANSACTION, request, response) ? response.transaction_id() : -1;
+    }
+
+    bool end(int64_t tx_id, bool commit) {
+        if (!commit) {
+            LineairDB::Protocol::TxAbort::Request abort;
+            LineairDB::Protocol::TxAbort::Response aborted;
+            abort.set_transaction_id(tx_id);
+            call(MessageType::TX_ABORT, abort, aborted);
+        }
+        LineairDB::Protocol::DbEndTransaction::Request request;
+        LineairDB::Protocol::DbEndTransaction::Response response;
+        request.set_transaction_id(tx_id);
+        return call(MessageType::DB_END_TRANSACTION, request, response) &&
+               (!commit || !response.is_aborted());
+    }
+
+private:
+    std::shared_ptr<DatabaseManager> db_manager_;
+    LineairDBRpc rpc_;
+    std::string payload_;
+    std::string result_;
+};
+
+std::string batch_write_payload(const Options& opt, int64_t tx_id, size_t first) {
+    LineairDB::Protocol::TxBatchWrite::Request request;
+    request.set_transaction_id(tx_id);
+    request.set_table_name(opt.table);
+    const std::string value(opt.value_size, 'v');
+    for (size_t i = first; i < first + opt.batch; i++) {
+        auto* write = request.add_writes();
+        write->set_key(make_key("pk", i));
+        write->set_value(value);
+        auto* index_write = request.add_secondary_index_writes();
+        index_write->set_index_name(opt.index);
+        index_write->set_secondary_key(make_key("sk", i));
+        index_write->set_primary_key(make_key("pk", i));
+    }
+    return request.SerializeAsString();
+}
+
+bool prepare(const Options& opt, Driver& driver) {
+    LineairDB::Protocol::DbCreateTable::Request create;
+    LineairDB::Protocol::DbCreateTable::Response created;
+    create.set_table_name(opt.table);
+    LineairDB::Protocol::DbCreateSecondaryIndex::Request create_index;
+    LineairDB::Protocol::DbCreateSecondaryIndex::Response index_created;
+    create_index.set_table_name(opt.table);
+    create_index.set_index_name(opt.index);
+    if (!driver.call(MessageType::DB_CREATE_TABLE, create, created) ||
+        !driver.call(MessageType::DB_CREATE_SECONDARY_INDEX, create_index, index_created)) {
+        return false;
+    }
+
+    // Committed rows for the scans to find
+    for (size_t first = 0; first < opt.scan; first += opt.batch) {
+        int64_t tx_id = driver.begin();
+        driver.call_raw(MessageType::TX_BATCH_WRITE, batch_write_payload(opt, tx_id, first));
+        if (!driver.end(tx_id, true)) return false;
+    }
+    return true;
+}
+
+// Each TX_BATCH_WRITE runs in its own transaction, which is then aborted so
+// the table does not grow; only the TX_BATCH_WRITE itself is counted.
+bool measure_batch_write(const Options& opt, Driver& driver, Result& result) {
+    uint64_t allocs = 0, bytes = 0;
+    Clock::duration elapsed{};
+    for (size_t i = 0; i < opt.rpcs; i++) {
+        int64_t tx_id = driver.begin();
+        if (tx_id < 0) return false;
+        std::string payload = batch_write_payload(opt, tx_id, opt.scan + (i % 100) * opt.batch);
+
+        uint64_t allocs_before = g_allocations.load();
+        uint64_t bytes_before = g_allocated_bytes.load();
+        auto start = Clock::now();
+        driver.call_raw(MessageType::TX_BATCH_WRITE, payload);
+        elapsed += Clock::now() - start;
+        allocs += g_allocations.load() - allocs_before;
+        bytes += g_allocated_bytes.load() - bytes_before;
+
+        driver.end(tx_id, false);
+    }
+    result.allocs_per_rpc = static_cast<double>(allocs) / opt.rpcs;
+    result.bytes_per_rpc = static_cast<double>(bytes) / opt.rpcs;
+    result.ns_per_rpc =
+        static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / opt.rpcs;
+    return true;
+}
+
+// opt.rpcs scans in one read-only transaction
+bool measure_scan(const Options& opt, Driver& driver, Result& result) {
+    int64_t tx_id = driver.begin();
+    if (tx_id < 0) return false;
+    LineairDB::Protocol::TxGetMatchingPrimaryKeysInRange::Request request;
+    request.set_transaction_id(tx_id);
+    request.set_table_name(opt.table);
+    request.set_index_name(opt.index);
+    request.set_start_key(make_key("sk", 0));
+    request.set_end_key(make_key("sk", opt.scan - 1));
+    std::string payload = request.SerializeAsString();
+
+    for (int i = 0; i < 100; i++) {
+        driver.call_raw(MessageType::TX_GET_MATCHING_PRIMARY_KEYS_IN_RANGE, payload);
+    }
+    uint64_t allocs_before = g_allocations.load();
+    uint64_t bytes_before = g_allocated_bytes.load();
+    auto start = Clock::now();
+    for (size_t i = 0; i < opt.rpcs; i++) {
+        driver.call_raw(MessageType::TX_GET_MATCHING_PRIMARY_KEYS_IN_RANGE, payload);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    result.allocs_per_rpc = static_cast<double>(g_allocations.load() - allocs_before) / opt.rpcs;
+    result.bytes_per_rpc = static_cast<double>(g_allocated_bytes.load() - bytes_before) / opt.rpcs;
+    result.ns_per_rpc = static_cast<double>(elapsed) / opt.rpcs;
+    return driver.end(tx_id, true);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return 1;
+        }
+        if (arg == "--rpcs") opt.rpcs = std::strtoul(value, nullptr, 10);
+        else if (arg == "--batch") opt.batch = std::strtoul(value, nullptr, 10);
+        else if (arg == "--scan") opt.scan = std::strtoul(value, nullptr, 10);
+        else if (arg == "--value-size") opt.value_size = std::strtoul(value, nullptr, 10);
+        else {
+            std::fprintf(stderr, "Usage: %s [--rpcs N] [--batch N] [--scan N] [--value-size N]\n",
+                         argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (opt.rpcs == 0 || opt.batch == 0 || opt.scan == 0) {
+        std::fprintf(stderr, "--rpcs, --batch and --scan must be positive\n");
+        return 1;
+    }
+
+    Driver driver;
+    if (!prepare(opt, driver)) {
+        std::fprintf(stderr, "failed to prepare table %s\n", opt.table.c_str());
+        return 1;
+    }
+
+    std::printf("%-38s %12s %12s %10s\n", "op", "allocs/rpc", "bytes/rpc", "ns/rpc");
+    Result r;
+    if (!measure_batch_write(opt, driver, r)) return 1;
+    std::printf("%-38s %12.2f %12.1f %10.0f\n", "TX_BATCH_WRITE", r.allocs_per_rpc, r.bytes_per_rpc,
+                r.ns_per_rpc);
+    if (!measure_scan(opt, driver, r)) return 1;
+    std::printf("%-38s %12.2f %12.1f %10.0f\n", "TX_GET_MATCHING_PRIMARY_KEYS_IN_RANGE",
+                r.allocs_per_rpc, r.bytes_per_rpc, r.ns_per_rpc);
+    return 0;
+}
@@ -0,0 +1,903 @@
+// lineairdb-rpc-bench: closed-loop RPC load generator for lineairdb-server.
+//
+// Opens N proxy-style connections and keeps exactly one request outstanding
+// on each, measuring per-RPC round-trip latency. Talks the wire protocol
+// directly so the server I/O path can be measured without MySQL in front.
+//
+//   lineairdb-rpc-bench --connections 256 --duration 10 --op begin_end
+//                       --server-pid $(cat /tmp/lineairdb_server.pid)
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../../common/point_codec.h"
+#include "../../common/scan_codec.h"
+#include "../../common/shm_ring.h"
+#include "lineairdb.pb.h"
+#include "protocol/message.hh"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t port = 9999;
+    size_t connections = 64;
+    size_t threads = 0;  // 0 = min(connections, hardware threads)
+    double duration_sec = 10.0;
+    std::string op = "begin_end";
+    std::string transport = "tcp";
+    std::string encoding = "protobuf";
+    std::string shm_socket = "/tmp/lineairdb.sock";
+    size_t batch_size = 10;
+    uint32_t protocol_version = 0;  // 0 = no SESSION_HELLO
+    std::string table = "rpcbench";
+    std::string index = "by_row";
+    bool table_handles = false;
+    uint32_t table_id = 0;  // resolved by prepare() with --table-handles
+    size_t keys = 1000;
+    size_t value_size = 100;
+    double zipf_theta = 0.0;  // 0 = uniform key choice
+    double zipf_zetan = 0.0;  // derived by init_zipf()
+    double zipf_eta = 0.0;
+    std::string key_shape = "plain";
+    std::vector<std::string> key_space;  // primary keys in order, unless plain
+    size_t scan_rows = 100;
+    size_t ops_per_tx = 10;
+    size_t stats_tables = 0;  // tables with row counts; each END updates one
+    bool full_stats = false;  // ask for every table's count, not just changes
+    bool autocommit = false;  // multi: one TX_MULTI begins and commits each tx
+    bool fence = false;       // commits wait until their epoch is durable
+    int server_pid = 0;
+};
+
+void usage(const char* prog) {
+    std::fprintf(stderr,
+                 "Usage: %s [options]\n"
+                 "  --host H            server host (default 127.0.0.1)\n"
+                 "  --port P            server port (default 9999)\n"
+                 "  --connections N     concurrent connections (default 64)\n"
+                 "  --threads N         client threads (default min(N, cores))\n"
+                 "  --duration S        measurement time in seconds (default 10)\n"
+                 "  --op OP             begin_end | read | batch_read | write | batch_write |\n"
+                 "                      scan | index_scan | multi | ycsb_a (default begin_end;\n"
+                 "                      ycsb_a = read or write, 50/50, per op)\n"
+                 "  --transport T       tcp | shm (default tcp)\n"
+                 "  --encoding E        protobuf | binary: wire format of read/write/batch_read\n"
+                 "                      (default protobuf; binary = common/point_codec.h)\n"
+                 "  --protocol-version N  open every connection with a SESSION_HELLO offering\n"
+                 "                      version N (default: no hello, version 1)\n"
+                 "  --table-handles     name the table by its DB_RESOLVE_HANDLES handle\n"
+                 "  --table NAME        benchmark table (default rpcbench)\n"
+                 "  --shm-socket PATH   server --shm-socket path (default /tmp/lineairdb.sock)\n"
+                 "  --batch-size N      keys per TX_BATCH_READ / TX_BATCH_WRITE, alternating\n"
+                 "                      reads and writes per TX_MULTI (default 10)\n"
+                 "  --keys N            key space for read/write (default 1000)\n"
+                 "  --zipf THETA        pick each op's key from a scrambled Zipfian\n"
+                 "                      distribution (YCSB uses 0.99; default uniform)\n"
+                 "  --value-size N      value bytes for write/preload (default 100)\n"
+                 "  --key-shape S       plain | order_line | lineitem: primary keys as\n"
+                 "                      ha_lineairdb encodes the TPC-C ORDER_LINE or TPC-H\n"
+                 "                      LINEITEM primary key (default plain)\n"
+                 "  --scan-rows N       rows per scan / index_scan (default 100)\n"
+                 "  --ops-per-tx N      read/write RPCs between BEGIN and END (default 10)\n"
+                 "  --stats-tables N    give N tables row counts; every END updates one\n"
+                 "                      (default 0)\n"
+                 "  --full-stats        request every table's row count on BEGIN/END\n"
+                 "                      instead of only the changed ones\n"
+                 "  --autocommit        with --op multi, run each transaction as one TX_MULTI\n"
+                 "                      that begins and commits it (protocol version 6)\n"
+                 "  --fence             set fence on every commit: the server answers once\n"
+                 "                      the transaction's epoch is durable\n"
+                 "  --server-pid PID    report server thread count from /proc\n",
+                 prog);
+}
+
+bool parse_options(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+        if (arg == "--host") opt.host = next();
+        else if (arg == "--port") opt.port = static_cast<uint16_t>(std::atoi(next()));
+        else if (arg == "--connections") opt.connections = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--threads") opt.threads = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--duration") opt.duration_sec = std::atof(next());
+        else if (arg == "--op") opt.op = next();
+        else if (arg == "--transport") opt.transport = next();
+        else if (arg == "--encoding") opt.encoding = next();
+        else if (arg == "--protocol-version") opt.protocol_version = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--table-handles") opt.table_handles = true;
+        else if (arg == "--table") opt.table = next();
+        else if (arg == "--shm-socket") opt.shm_socket = next();
+        else if (arg == "--batch-size") opt.batch_size = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--keys") opt.keys = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--zipf") opt.zipf_theta = std::atof(next());
+        else if (arg == "--value-size") opt.value_size = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--key-shape") opt.key_shape = next();
+        else if (arg == "--scan-rows") opt.scan_rows = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--ops-per-tx") opt.ops_per_tx = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--stats-tables") opt.stats_tables = std::strtoul(next(), nullptr, 10);
+        else if (arg == "--full-stats") opt.full_stats = true;
+        else if (arg == "--autocommit") opt.autocommit = true;
+        else if (arg == "--fence") opt.fence = true;
+        else if (arg == "--server-pid") opt.server_pid = std::atoi(next());
+        else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (opt.op != "begin_end" && opt.op != "read" && opt.op != "batch_read" && opt.op != "write" &&
+        opt.op != "batch_write" && opt.op != "scan" && opt.op != "index_scan" && opt.op != "multi" &&
+        opt.op != "ycsb_a") {
+        std::fprintf(stderr, "unknown --op %s\n", opt.op.c_str());
+        return false;
+    }
+    if (opt.autocommit && opt.op != "multi") {
+        std::fprintf(stderr, "--autocommit needs --op multi\n");
+        return false;
+    }
+    if (opt.transport != "tcp" && opt.transport != "shm") {
+        std::fprintf(stderr, "unknown --transport %s\n", opt.transport.c_str());
+        return false;
+    }
+    if (opt.encoding != "protobuf" && opt.encoding != "binary") {
+        std::fprintf(stderr, "unknown --encoding %s\n", opt.encoding.c_str());
+        return false;
+    }
+    if (opt.key_shape != "plain" && opt.key_shape != "order_line" && opt.key_shape != "lineitem") {
+        std::fprintf(stderr, "unknown --key-shape %s\n", opt.key_shape.c_str());
+        return false;
+    }
+    if (opt.zipf_theta < 0.0 || opt.zipf_theta >= 1.0) {
+        std::fprintf(stderr, "--zipf must be in [0, 1)\n");
+        return false;
+    }
+    if (opt.connections == 0 || opt.keys == 0 || opt.scan_rows == 0) {
+        std::fprintf(stderr, "--connections, --keys and --scan-rows must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+int connect_tcp(const Options& opt) {
+    struct addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res = nullptr;
+    std::string port = std::to_string(opt.port);
+    if (getaddrinfo(opt.host.c_str(), port.c_str(), &hints, &res) != 0 || res == nullptr) {
+        return -1;
+    }
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) < 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd >= 0) {
+        int flag = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+    return fd;
+}
+
+// One proxy-style connection over TCP or the shared-memory ring.
+struct Conn {
+    int fd = -1;
+    std::unique_ptr<Shm::Channel> shm;
+    bool front_coded_keys = false;  // agreed in SESSION_HELLO
+
+    bool open(const Options& opt) {
+        if (opt.transport == "shm") {
+            shm = Shm::Channel::connect(opt.shm_socket);
+            if (shm == nullptr) return false;
+        } else {
+            fd = connect_tcp(opt);
+            if (fd < 0) return false;
+        }
+        return opt.protocol_version == 0 || say_hello(opt.protocol_version);
+    }
+
+    bool say_hello(uint32_t protocol_version);
+
+    void close_conn() {
+        shm.reset();
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+
+    bool write_all(const char* data, size_t len) {
+        if (shm) return shm->send(data, len);
+        size_t sent = 0;
+        while (sent < len) {
+            ssize_t n = send(fd, data + sent, len - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool read_all(char* data, size_t len) {
+        if (shm) return shm->recv(data, len);
+        return recv(fd, data, len, MSG_WAITALL) == static_cast<ssize_t>(len);
+    }
+
+    bool send_frame(MessageType type, const std::string& payload) {
+        MessageHeader header;
+        header.sender_id = htobe64(1);
+        header.message_type = htonl(static_cast<uint32_t>(type));
+        header.payload_size = htonl(static_cast<uint32_t>(payload.size()));
+
+        std::string frame(reinterpret_cast<const char*>(&header), sizeof(header));
+        frame += payload;
+        return write_all(frame.data(), frame.size());
+    }
+
+    bool recv_frame(std::string& payload) {
+        MessageHeader header;
+        if (!read_all(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+        uint32_t size = ntohl(header.payload_size);
+        payload.resize(size);
+        return size == 0 || read_all(&payload[0], size);
+    }
+};
+
+template <typename Request>
+bool call(Conn& conn, MessageType type, const Request& request, std::string& response) {
+    std::string payload;
+    request.SerializeToString(&payload);
+    return conn.send_frame(type, payload) && conn.recv_frame(response);
+}
+
+bool Conn::say_hello(uint32_t protocol_version) {
+    LineairDB::Protocol::SessionHello::Request request;
+    LineairDB::Protocol::SessionHello::Response response;
+    request.set_protocol_version(protocol_version);
+    std::string payload;
+    if (!call(*this, MessageType::SESSION_HELLO, request, payload) || !response.ParseFromString(payload)) {
+        return false;
+    }
+    front_coded_keys = response.protocol_version() >= Rpc::kFrontCodedKeysVersion;
+    return true;
+}
+
+std::string make_key(size_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "key%012zu", i);
+    return buf;
+}
+
+// One INT primary key part as ha_lineairdb encodes it: not-null marker,
+// type tag, big-endian length, then the big-endian value with its sign bit
+// flipped
+void append_int_key_part(std::string& key, uint32_t value) {
+    value ^= 0x80000000u;
+    const char part[8] = {0x00, 0x10, 0x00, 0x04,
+                          static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+                          static_cast<char>(value >> 8), static_cast<char>(value)};
+    key.append(part, sizeof(part));
+}
+
+// --keys primary keys in key order for --key-shape
+//   order_line  (w_id, d_id, o_id, ol_number): 10 districts of 3000 orders,
+//               10 lines each (the TPC-C average)
+//   lineitem    (l_orderkey, l_linenumber): 1-7 lines per order, as in TPC-H
+std::vector<std::string> build_key_space(const Options& opt) {
+    std::vector<std::string> keys;
+    if (opt.key_shape == "plain") return keys;
+    keys.reserve(opt.keys);
+    uint64_t rng = 1;
+    for (uint32_t i = 0; keys.size() < opt.keys; i++) {
+        std::string key;
+        if (opt.key_shape == "order_line") {
+            append_int_key_part(key, i / 300000 + 1);
+            append_int_key_part(key, i / 30000 % 10 + 1);
+            append_int_key_part(key, i / 10 % 3000 + 1);
+            append_int_key_part(key, i % 10 + 1);
+            keys.push_back(std::move(key));
+            continue;
+        }
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint32_t lines = static_cast<uint32_t>((rng >> 33) % 7) + 1;
+        for (uint32_t line = 1; line <= lines && keys.size() < opt.keys; line++) {
+            key.clear();
+            append_int_key_part(key, i + 1);
+            append_int_key_part(key, line);
+            keys.push_back(key);
+        }
+    }
+    return keys;
+}
+
+std::string key_at(const Options& opt, size_t i) {
+    return opt.key_space.empty() ? make_key(i) : opt.key_space[i];
+}
+
+std::string secondary_key(size_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "sk%012zu", i);
+    return buf;
+}
+
+std::string stats_table(size_t i) {
+    char buf[40];
+    std::snprintf(buf, sizeof(buf), "./rpcbench/stats_%04zu", i);
+    return buf;
+}
+
+// Give --stats-tables tables a row count, so BEGIN/END carry their stats.
+bool prepare_stats(const Options& opt) {
+    Conn conn;
+    if (!conn.open(opt)) return false;
+
+    std::string response;
+    LineairDB::Protocol::TxBeginTransaction::Request begin;
+    LineairDB::Protocol::TxBeginTransaction::Response begin_resp;
+    bool ok = call(conn, MessageType::TX_BEGIN_TRANSACTION, begin, response) &&
+              begin_resp.ParseFromString(response);
+
+    LineairDB::Protocol::DbEndTransaction::Request end;
+    end.set_transaction_id(begin_resp.transaction_id());
+    for (size_t i = 0; i < opt.stats_tables; i++) {
+        auto* delta = end.add_row_deltas();
+        delta->set_table_name(stats_table(i));
+        delta->set_delta(1000);
+    }
+    ok = ok && call(conn, MessageType::DB_END_TRANSACTION, end, response);
+    conn.close_conn();
+    return ok;
+}
+
+// Create the benchmark table and load --keys rows so reads hit. index_scan
+// also indexes row i under secondary_key(i).
+bool prepare(Options& opt) {
+    Conn conn;
+    if (!conn.open(opt)) return false;
+
+    std::string response;
+    LineairDB::Protocol::DbCreateTable::Request create;
+    create.set_table_name(opt.table);
+    bool ok = call(conn, MessageType::DB_CREATE_TABLE, create, response);
+    if (ok && opt.op == "index_scan") {
+        LineairDB::Protocol::DbCreateSecondaryIndex::Request create_index;
+        create_index.set_table_name(opt.table);
+        create_index.set_index_name(opt.index);
+        ok = call(conn, MessageType::DB_CREATE_SECONDARY_INDEX, create_index, response);
+    }
+
+    if (ok && opt.table_handles) {
+        LineairDB::Protocol::DbResolveHandles::Request resolve;
+        LineairDB::Protocol::DbResolveHandles::Response resolved;
+        resolve.set_table_name(opt.table);
+        ok = call(conn, MessageType::DB_RESOLVE_HANDLES, resolve, response) &&
+             resolved.ParseFromString(response) && resolved.table_id() != 0;
+        opt.table_id = resolved.table_id();
+    }
+
+    const std::string value(opt.value_size, 'v');
+    for (size_t base = 0; ok && base < opt.keys; base += 1000) {
+        LineairDB::Protocol::TxBeginTransaction::Request begin;
+        ok = call(conn, MessageType::TX_BEGIN_TRANSACTION, begin, response);
+        LineairDB::Protocol::TxBeginTransaction::Response begin_resp;
+        ok = ok && begin_resp.ParseFromString(response);
+
+        LineairDB::Protocol::TxBatchWrite::Request batch;
+        batch.set_transaction_id(begin_resp.transaction_id());
+        batch.set_table_name(opt.table);
+        for (size_t i = base; i < std::min(opt.keys, base + 1000); i++) {
+            auto* w = batch.add_writes();
+            w->set_key(key_at(opt, i));
+            w->set_value(value);
+            if (opt.op == "index_scan") {
+                auto* index_write = batch.add_secondary_index_writes();
+                index_write->set_index_name(opt.index);
+                index_write->set_secondary_key(secondary_key(i));
+                index_write->set_primary_key(key_at(opt, i));
+            }
+        }
+        ok = ok && call(conn, MessageType::TX_BATCH_WRITE, batch, response);
+
+        LineairDB::Protocol::DbEndTransaction::Request end;
+        end.set_transaction_id(begin_resp.transaction_id());
+        end.set_fence(true);
+        ok = ok && call(conn, MessageType::DB_END_TRANSACTION, end, response);
+    }
+    conn.close_conn();
+    return ok;
+}
+
+// One benchmark connection: cycles BEGIN, ops_per_tx x OP, END.
+struct Client {
+    Conn conn;
+    int64_t tx_id = 0;
+    size_t step = 0;  // 0 = BEGIN, 1..ops_per_tx = op, ops_per_tx+1 = END;
+                      // always 0 with --autocommit
+    uint64_t rng = 0;
+    uint64_t stats_version = 0;
+    Clock::time_point sent_at;
+};
+
+struct ThreadResult {
+    std::vector<uint32_t> latencies_us;
+    std::vector<uint32_t> commit_latencies_us;  // END, or TX_MULTI with --autocommit
+    uint64_t errors = 0;
+    uint64_t op_responses = 0;
+    uint64_t op_bytes = 0;
+    uint64_t scanned_rows = 0;
+    uint64_t begin_end_responses = 0;
+    uint64_t begin_end_bytes = 0;
+    uint64_t transactions = 0;  // END responses, or TX_MULTIs with --autocommit
+};
+
+// Fixed-layout point request (common/point_codec.h), flagged as binary
+void build_point_request(MessageType op, int64_t tx_id, const Options& opt,
+                         std::initializer_list<std::string_view> fields, MessageType& type,
+                         std::string& payload) {
+    type = static_cast<MessageType>(static_cast<uint32_t>(op) | Rpc::kBinaryPayload);
+    payload.resize(Rpc::point_request_size(opt.table, opt.table_id, 0, fields));
+    Rpc::encode_point_request(&payload[0], tx_id, opt.table, opt.table_id, 0, fields);
+}
+
+template <typename Request>
+void set_table(const Options& opt, Request& req) {
+    if (opt.table_id != 0) {
+        req.set_table_id(opt.table_id);
+    } else {
+        req.set_table_name(opt.table);
+    }
+}
+
+// Gray et al.'s Zipfian generator as YCSB implements it; ranks are scrambled
+// so the hot keys are spread over the key space
+void init_zipf(Options& opt) {
+    if (opt.zipf_theta == 0.0) return;
+    double zetan = 0.0;
+    for (size_t i = 1; i <= opt.keys; i++) {
+        zetan += 1.0 / std::pow(static_cast<double>(i), opt.zipf_theta);
+    }
+    double zeta2 = 1.0 + 1.0 / std::pow(2.0, opt.zipf_theta);
+    opt.zipf_zetan = zetan;
+    opt.zipf_eta = (1.0 - std::pow(2.0 / opt.keys, 1.0 - opt.zipf_theta)) / (1.0 - zeta2 / zetan);
+}
+
+size_t next_key(const Options& opt, Client& c) {
+    c.rng = c.rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    if (opt.zipf_theta == 0.0) {
+        return (c.rng >> 33) % opt.keys;
+    }
+    double u = static_cast<double>(c.rng >> 11) / static_cast<double>(1ULL << 53);
+    double uz = u * opt.zipf_zetan;
+    size_t rank;
+    if (uz < 1.0) {
+        rank = 0;
+    } else if (uz < 1.0 + std::pow(0.5, opt.zipf_theta)) {
+        rank = 1;
+    } else {
+        rank = static_cast<size_t>(opt.keys * std::pow(opt.zipf_eta * u - opt.zipf_eta + 1.0,
+                                                       1.0 / (1.0 - opt.zipf_theta)));
+    }
+    return (std::min(rank, opt.keys - 1) * 0x9E3779B97F4A7C15ULL) % opt.keys;
+}
+
+size_t ops_per_tx(const Options& opt) {
+    return opt.op == "begin_end" ? 0 : opt.ops_per_tx;
+}
+
+void build_request(const Options& opt, Client& c, MessageType& type, std::string& payload) {
+    size_t ops = ops_per_tx(opt);
+    if (c.step == 0 && !opt.autocommit) {
+        type = MessageType::TX_BEGIN_TRANSACTION;
+        LineairDB::Protocol::TxBeginTransaction::Request req;
+        req.set_stats_version(opt.full_stats ? 0 : c.stats_version);
+        req.SerializeToString(&payload);
+    } else if (opt.autocommit || c.step <= ops) {
+        size_t position = next_key(opt, c);
+        size_t last = std::min(position + opt.scan_rows, opt.keys) - 1;
+        std::string key = key_at(opt, position);
+        std::string_view op = opt.op;
+        if (op == "ycsb_a") {
+            op = (c.rng >> 32) & 1 ? "read" : "write";
+        }
+        if (op == "scan") {
+            type = MessageType::TX_GET_MATCHING_KEYS_AND_VALUES_IN_RANGE;
+            LineairDB::Protocol::TxGetMatchingKeysAndValuesInRange::Request req;
+            req.set_transaction_id(c.tx_id);
+            req.set_start_key(key);
+            req.set_end_key(key_at(opt, last));
+            set_table(opt, req);
+            req.SerializeToString(&payload);
+        } else if (op == "index_scan") {
+            type = MessageType::TX_GET_MATCHING_PRIMARY_KEYS_IN_RANGE;
+            LineairDB::Protocol::TxGetMatchingPrimaryKeysInRange::Request req;
+            req.set_transaction_id(c.tx_id);
+            req.set_index_name(opt.index);
+            req.set_start_key(secondary_key(position));
+            req.set_end_key(secondary_key(last));
+            set_table(opt, req);
+            req.SerializeToString(&payload);
+        } else if (opt.encoding == "binary" && op == "read") {
+            build_point_request(MessageType::TX_READ, c.tx_id, opt, {key}, type, payload);
+        } else if (opt.encoding == "binary" && op == "write") {
+            const std::string value(opt.value_size, 'w');
+            build_point_request(MessageType::TX_WRITE, c.tx_id, opt, {key, value}, type, payload);
+        } else if (op == "read") {
+            type = MessageType::TX_READ;
+            LineairDB::Protocol::TxRead::Request req;
+            req.set_transaction_id(c.tx_id);
+            req.set_key(key);
+            set_table(opt, req);
+            req.SerializeToString(&payload);
+        } else if (opt.encoding == "binary" && op == "batch_read") {
+            std::vector<std::string> keys{key};
+            for (size_t i = 1; i < opt.batch_size; i++) {
+                c.rng = c.rng * 6364136223846793005ULL + 1442695040888963407ULL;
+                keys.push_back(key_at(opt, (c.rng >> 33) % opt.keys));
+            }
+            type = static_cast<MessageType>(static_cast<uint32_t>(MessageType::TX_BATCH_READ) |
+                                            Rpc::kBinaryPayload);
+            payload.resize(Rpc::batch_read_request_size(opt.table, opt.table_id, keys));
+            Rpc::encode_batch_read_request(&payload[0], c.tx_id, opt.table, opt.table_id, keys);
+        } else if (op == "batch_read") {
+            type = MessageType::TX_BATCH_READ;
+            LineairDB::Protocol::TxBatchRead::Request req;
+            req.set_transaction_id(c.tx_id);
+            set_table(opt, req);
+            req.add_keys(key);
+            for (size_t i = 1; i < opt.batch_size; i++) {
+                c.rng = c.rng * 6364136223846793005ULL + 1442695040888963407ULL;
+                req.add_keys(key_at(opt, (c.rng >> 33) % opt.keys));
+            }
+            req.SerializeToString(&payload);
+        } else if (op == "batch_write") {
+            type = MessageType::TX_BATCH_WRITE;
+            LineairDB::Protocol::TxBatchWrite::Request req;
+            req.set_transaction_id(c.tx_id);
+            set_table(opt, req);
+            const std::string value(opt.value_size, 'w');
+            auto* w = req.add_writes();
+            w->set_key(key);
+            w->set_value(value);
+            for (size_t i = 1; i < opt.batch_size; i++) {
+                c.rng = c.rng * 6364136223846793005ULL + 1442695040888963407ULL;
+                w = req.add_writes();
+                w->set_key(key_at(opt, (c.rng >> 33) % opt.keys));
+                w->set_value(value);
+            }
+            req.SerializeToString(&payload);
+        } else if (op == "multi") {
+            type = MessageType::TX_MULTI;
+            LineairDB::Protocol::TxMulti::Request req;
+            req.set_transaction_id(opt.autocommit ? 0 : c.tx_id);
+            if (opt.autocommit) {
+                req.set_commit(true);
+                req.set_fence(opt.fence);
+                req.set_stats_version(opt.full_stats ? 0 : c.stats_version);
+                if (opt.stats_tables > 0) {
+                    c.rng = c.rng * 6364136223846793005ULL + 1442695040888963407ULL;
+                    auto* delta = req.add_row_deltas();
+                    delta->set_table_name(stats_table((c.rng >> 33) % opt.stats_tables));
+                    delta->set_delta(1);
+                }
+            }
+            const std::string value(opt.value_size, 'w');
+            for (size_t i = 0; i < opt.batch_size; i++) {
+                if (i > 0) {
+                    c.rng = c.rng * 6364136223846793005ULL + 1442695040888963407ULL;
+                    key = key_at(opt, (c.rng >> 33) % opt.keys);
+                }
+                auto* op = req.add_ops();
+                if (i == 0) set_table(opt, *op);
+                op->set_key(key);
+                if (i % 2 == 0) {
+                    op->set_kind(LineairDB::Protocol::TxMulti::OP_READ);
+                } else {
+                    op->set_kind(LineairDB::Protocol::TxMulti::OP_WRITE);
+                    op->set_value(value);
+                }
+            }
+            req.SerializeToString(&payload);
+        } else {
+            type = MessageType::TX_WRITE;
+            LineairDB::Protocol::TxWrite::Request req;
+            req.set_transaction_id(c.tx_id);
+            req.set_key(key);
+            req.set_value(std::string(opt.value_size, 'w'));
+            set_table(opt, req);
+            req.SerializeToString(&payload);
+        }
+    } else {
+        type = MessageType::DB_END_TRANSACTION;
+        LineairDB::Protocol::DbEndTransaction::Request req;
+        req.set_transaction_id(c.tx_id);
+        req.set_fence(opt.fence);
+        req.set_stats_version(opt.full_stats ? 0 : c.stats_version);
+        if (opt.stats_tables > 0) {
+            c.rng = c.rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            auto* delta = req.add_row_deltas();
+            delta->set_table_name(stats_table((c.rng >> 33) % opt.stats_tables));
+            delta->set_delta(1);
+        }
+        req.SerializeToString(&payload);
+    }
+}
+
+void handle_response(const Options& opt, Client& c, const std::string& payload) {
+    size_t ops = ops_per_tx(opt);
+    if (opt.autocommit) {
+        LineairDB::Protocol::TxMulti::Response resp;
+        resp.ParseFromString(payload);
+        c.stats_version = resp.stats_version();
+        return;
+    }
+    if (c.step == 0) {
+        LineairDB::Protocol::TxBeginTransaction::Response resp;
+        resp.ParseFromString(payload);
+        c.tx_id = resp.transaction_id();
+        c.stats_version = resp.stats_version();
+    } else if (c.step > ops) {
+        LineairDB::Protocol::DbEndTransaction::Response resp;
+        resp.ParseFromString(payload);
+        c.stats_version = resp.stats_version();
+    }
+    c.step = c.step > ops ? 0 : c.step + 1;
+}
+
+// Rows in a scan / index_scan response, in whichever layout the connection
+// agreed on
+size_t scan_response_rows(const Options& opt, const Conn& conn, const std::string& response) {
+    size_t rows = 0;
+    bool is_aborted;
+    if (opt.op == "index_scan" && !conn.front_coded_keys) {
+        LineairDB::Protocol::TxGetMatchingPrimaryKeysInRange::Response resp;
+        return resp.ParseFromString(response) ? resp.primary_keys_size() : 0;
+    }
+    Rpc::for_each_scan_entry(response, conn.front_coded_keys, opt.op == "scan", is_aborted,
+                             [&](std::string_view, std::string_view) { rows++; });
+    return rows;
+}
+
+// Each thread keeps one request in flight on every connection it owns and
+// services whichever connection answers first. Shared-memory connections
+// cannot be polled, so a thread that owns exactly one connection simply
+// blocks on it.
+void run_thread(const Options& opt, std::vector<Client>& clients, const std::atomic<bool>& measuring,
+                const std::atomic<bool>& stop, ThreadResult& result) {
+    std::string payload;
+    std::string response;
+    MessageType type;
+
+    auto complete = [&](Client& c) -> bool {
+        if (!c.conn.recv_frame(response)) {
+            result.errors++;
+            return false;
+        }
+        auto now = Clock::now();
+        if (measuring.load(std::memory_order_relaxed)) {
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(now - c.sent_at).count();
+            result.latencies_us.push_back(static_cast<uint32_t>(us));
+            if (opt.autocommit || c.step > ops_per_tx(opt)) {
+                result.transactions++;
+                result.commit_latencies_us.push_back(static_cast<uint32_t>(us));
+            }
+            if (!opt.autocommit && (c.step == 0 || c.step > ops_per_tx(opt))) {
+                result.begin_end_responses++;
+                result.begin_end_bytes += response.size();
+            } else {
+                result.op_responses++;
+                result.op_bytes += response.size();
+                if (opt.op == "scan" || opt.op == "index_scan") {
+                    result.scanned_rows += scan_response_rows(opt, c.conn, response);
+                }
+            }
+        }
+        handle_response(opt, c, response);
+        build_request(opt, c, type, payload);
+        c.sent_at = Clock::now();
+        if (!c.conn.send_frame(type, payload)) {
+            result.errors++;
+            return false;
+        }
+        return true;
+    };
+
+    for (auto& c : clients) {
+        build_request(opt, c, type, payload);
+        c.sent_at = Clock::now();
+        if (!c.conn.send_frame(type, payload)) result.errors++;
+    }
+
+    if (clients.size() == 1) {
+        while (!stop.load(std::memory_order_relaxed) && complete(clients[0])) {}
+        return;
+    }
+
+    std::vector<struct pollfd> pfds(clients.size());
+    for (size_t i = 0; i < clients.size(); i++) {
+        pfds[i].fd = clients[i].conn.fd;
+        pfds[i].events = POLLIN;
+    }
+    while (!stop.load(std::memory_order_relaxed)) {
+        int n = poll(pfds.data(), pfds.size(), 100);
+        if (n <= 0) continue;
+        for (size_t i = 0; i < pfds.size(); i++) {
+            if (!(pfds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            if (!complete(clients[i])) {
+                pfds[i].fd = -1;  // stop polling a dead connection
+            }
+        }
+    }
+}
+
+int read_thread_count(int pid) {
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("Threads:", 0) == 0) {
+            return std::atoi(line.c_str() + 8);
+        }
+    }
+    return -1;
+}
+
+double percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1));
+    return sorted[idx];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) return 1;
+    opt.key_space = build_key_space(opt);
+    init_zipf(opt);
+
+    if (opt.stats_tables > 0 && !prepare_stats(opt)) {
+        std::fprintf(stderr, "failed to prepare %zu stats tables on %s:%u\n",
+                     opt.stats_tables, opt.host.c_str(), opt.port);
+        return 1;
+    }
+    if (opt.op != "begin_end" && !prepare(opt)) {
+        std::fprintf(stderr, "failed to prepare table %s on %s:%u\n",
+                     opt.table.c_str(), opt.host.c_str(), opt.port);
+        return 1;
+    }
+
+    size_t num_threads = opt.threads;
+    if (num_threads == 0) {
+        num_threads = std::min<size_t>(opt.connections, std::max(1u, std::thread::hardware_concurrency()));
+    }
+    num_threads = std::min(num_threads, opt.connections);
+    if (opt.transport == "shm") {
+        num_threads = opt.connections;  // one blocking thread per ring
+    }
+
+    std::vector<std::vector<Client>> per_thread(num_threads);
+    for (size_t i = 0; i < opt.connections; i++) {
+        Client c;
+        if (!c.conn.open(opt)) {
+            std::fprintf(stderr, "connect #%zu (%s) failed: %s\n",
+                         i, opt.transport.c_str(), std::strerror(errno));
+            return 1;
+        }
+        c.rng = i + 1;
+        per_thread[i % num_threads].push_back(std::move(c));
+    }
+
+    std::atomic<bool> measuring{false};
+    std::atomic<bool> stop{false};
+    std::vector<ThreadResult> results(num_threads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back(run_thread, std::cref(opt), std::ref(per_thread[t]),
+                             std::cref(measuring), std::cref(stop), std::ref(results[t]));
+    }
+
+    // Short warm-up so connection setup does not skew the tail
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    int server_threads = opt.server_pid > 0 ? read_thread_count(opt.server_pid) : -1;
+    measuring = true;
+    auto start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.duration_sec));
+    measuring = false;
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    stop = true;
+    for (auto& th : threads) th.join();
+
+    std::vector<uint32_t> all;
+    std::vector<uint32_t> commits;
+    uint64_t errors = 0;
+    uint64_t begin_end_responses = 0;
+    uint64_t begin_end_bytes = 0;
+    uint64_t op_responses = 0;
+    uint64_t op_bytes = 0;
+    uint64_t scanned_rows = 0;
+    uint64_t transactions = 0;
+    for (auto& r : results) {
+        all.insert(all.end(), r.latencies_us.begin(), r.latencies_us.end());
+        commits.insert(commits.end(), r.commit_latencies_us.begin(), r.commit_latencies_us.end());
+        errors += r.errors;
+        begin_end_responses += r.begin_end_responses;
+        begin_end_bytes += r.begin_end_bytes;
+        op_responses += r.op_responses;
+        op_bytes += r.op_bytes;
+        scanned_rows += r.scanned_rows;
+        transactions += r.transactions;
+    }
+    std::sort(all.begin(), all.end());
+    std::sort(commits.begin(), commits.end());
+
+    std::printf("op=%s transport=%s encoding=%s connections=%zu client_threads=%zu duration=%.1fs\n",
+                opt.op.c_str(), opt.transport.c_str(), opt.encoding.c_str(), opt.connections,
+                num_threads, elapsed);
+    std::printf("rpcs=%zu throughput=%.0f rpc/s errors=%lu\n",
+                all.size(), all.size() / elapsed, errors);
+    std::printf("transactions=%lu tx_throughput=%.0f tx/s\n", transactions, transactions / elapsed);
+    {
+        // Wire size of one op request (the first after BEGIN), header included
+        Client sample;
+        sample.step = 1;
+        MessageType sample_type;
+        std::string sample_payload;
+        build_request(opt, sample, sample_type, sample_payload);
+        std::printf("request_bytes=%zu table=%s%s\n", sizeof(MessageHeader) + sample_payload.size(),
+                    opt.table.c_str(), opt.table_id != 0 ? " (handle)" : "");
+    }
+    if (op_responses > 0 && (opt.op == "scan" || opt.op == "index_scan")) {
+        bool front_coded = per_thread[0][0].conn.front_coded_keys;
+        std::printf("response_bytes=%.0f rows=%.1f key_shape=%s keys=%s\n",
+                    static_cast<double>(op_bytes) / op_responses,
+                    static_cast<double>(scanned_rows) / op_responses, opt.key_shape.c_str(),
+                    front_coded ? "front-coded" : "plain");
+    }
+    if (begin_end_responses > 0) {
+        std::printf("begin_end_response_bytes=%.0f stats_tables=%zu stats=%s\n",
+                    static_cast<double>(begin_end_bytes) / begin_end_responses, opt.stats_tables,
+                    opt.full_stats ? "full" : "incremental");
+    }
+    std::printf("latency_us p50=%.0f p99=%.0f p999=%.0f max=%.0f\n",
+                percentile(all, 0.50), percentile(all, 0.99), percentile(all, 0.999),
+                all.empty() ? 0.0 : static_cast<double>(all.back()));
+    if (!commits.empty()) {
+        std::printf("commit_latency_us p50=%.0f p99=%.0f p999=%.0f max=%.0f fence=%s\n",
+                    percentile(commits, 0.50), percentile(commits, 0.99),
+                    percentile(commits, 0.999), static_cast<double>(commits.back()),
+                    opt.fence ? "true" : "false");
+    }
+    if (server_threads >= 0) {
+        std::printf("server_threads=%d\n", server_threads);
+    }
+
+    for (auto& list : per_thread) {
+        for (auto& c : list) c.conn.close_conn();
+    }
+    return errors == 0 ? 0 : 2;
+}
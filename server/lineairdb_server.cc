@@ -1,41 +1,304 @@
 #include "lineairdb_server.hh"
 #include "../common/log.h"
 #include "lineairdb.pb.h"
+#include "network/response_sink.hh"
 #include "rpc/lineairdb_rpc.hh"
 
+#include <algorithm>
+#include <chrono>
+#include <csignal>
 #include <iostream>
 
-LineairDBServer::LineairDBServer() : TcpServer(9999) {}
+namespace {
+// Streams a multiplexed session may accumulate before idle ones are dropped
+constexpr size_t kMinStreamSweep = 64;
+
+// Run one request on rpc and compress its response if that was negotiated.
+// Returns the flags for the response type.
+uint32_t execute(LineairDBRpc& rpc, uint64_t sender_id, MessageType message_type,
+                 std::string_view payload, std::string& result, Rpc::Codec compression,
+                 size_t compression_threshold, std::string& compressed) {
+    uint32_t raw_type = static_cast<uint32_t>(message_type);
+    if (raw_type & Rpc::kBinaryPayload) {
+        // Response type echoes the request's, so it carries kBinaryPayload too
+        rpc.handle_binary_rpc(static_cast<MessageType>(raw_type & ~Rpc::kBinaryPayload),
+                              payload, result);
+    } else {
+        rpc.handle_rpc(sender_id, message_type, payload, result);
+    }
+
+    if (compression == Rpc::Codec::NONE || result.size() < compression_threshold ||
+        !Rpc::compress_payload(compression, result.data(), result.size(), compressed)) {
+        return 0;
+    }
+    result.swap(compressed);
+    if (compressed.capacity() > Rpc::kRetainLimit) {
+        std::string().swap(compressed);  // don't pin the raw copy of a huge scan
+    }
+    return Rpc::kCompressedPayload;
+}
+}  // namespace
+
+LineairDBSession::LineairDBSession(std::shared_ptr<DatabaseManager> db_manager,
+                                   std::shared_ptr<TableRowCounts> row_counts,
+                                   std::shared_ptr<TableHandles> handles,
+                                   std::shared_ptr<StreamExecutor> executor)
+    : db_manager_(db_manager),
+      row_counts_(row_counts),
+      tx_manager_(std::make_shared<TransactionManager>()),
+      rpc_handler_(std::make_shared<LineairDBRpc>(db_manager, tx_manager_, row_counts, handles)),
+      handles_(handles),
+      executor_(std::move(executor)),
+      sweep_at_(kMinStreamSweep) {}
+
+LineairDBSession::~LineairDBSession() {
+    // Requests already queued still run; their responses go nowhere
+    for (auto& entry : streams_) {
+        executor_->close(entry.second->queue);
+    }
+    if (own_stream_) {
+        executor_->close(own_stream_->queue);
+    }
+}
+
+uint32_t LineairDBSession::handle_message(uint64_t sender_id, MessageType message_type,
+                                          std::string_view payload, std::string& result) {
+    if (message_type == MessageType::SESSION_HELLO) {
+        handle_hello(payload, result);
+        return 0;
+    }
+    if (multiplexed_) {
+        return defer(stream(Rpc::request_stream(sender_id)), sender_id, message_type, payload);
+    }
+    if (own_stream_) {
+        return defer(own_stream_, sender_id, message_type, payload);
+    }
+    uint32_t flags = execute(*rpc_handler_, sender_id, message_type, payload, result,
+                             compression_, compression_threshold_, compressed_);
+
+    // A fenced commit on an event loop: the response is complete, but it may
+    // only leave once the commit is durable
+    if (std::shared_ptr<CommitSignal> durable = rpc_handler_->take_durable_wait()) {
+        durable->on_done([sink = sink_, sender_id,
+                          response_type = static_cast<uint32_t>(message_type) | flags,
+                          response = std::move(result)]() {
+            sink->send(sender_id, response_type, response);
+        });
+        return kDeferred;
+    }
+    return flags;
+}
+
+void LineairDBSession::set_response_sink(std::shared_ptr<ResponseSink> sink) {
+    sink_ = std::move(sink);
+    bool event_loop = sink_ && sink_->queues();
+    if (event_loop && executor_) {
+        // Keep the worker to I/O: an open transaction holds an executor
+        // thread of its own until it ends
+        own_stream_ = std::make_shared<Stream>();
+        own_stream_->tx_manager = tx_manager_;
+        own_stream_->rpc_handler = rpc_handler_;
+        own_stream_->queue = std::make_shared<StreamExecutor::Stream>(
+            [tx_manager = tx_manager_]() { return tx_manager->open_transactions() > 0; });
+        event_loop = false;
+    }
+    // Stream threads and per-connection threads may block on a fenced commit;
+    // a reactor worker serving many connections must not
+    rpc_handler_->set_async_fence(event_loop);
+}
+
+uint32_t LineairDBSession::defer(const std::shared_ptr<Stream>& target, uint64_t sender_id,
+                                 MessageType message_type, std::string_view payload) {
+    // payload lives in the transport's receive buffer, so the task keeps a copy
+    executor_->submit(target->queue,
+                      [target, sink = sink_, sender_id, message_type,
+                       request = std::string(payload), compression = compression_,
+                       threshold = compression_threshold_]() {
+                          std::string result;
+                          uint32_t flags = execute(*target->rpc_handler, sender_id, message_type,
+                                                   request, result, compression, threshold,
+                                                   target->compressed);
+                          sink->send(sender_id, static_cast<uint32_t>(message_type) | flags, result);
+                      });
+    return kDeferred;
+}
+
+std::shared_ptr<LineairDBSession::Stream> LineairDBSession::stream(uint32_t stream_id) {
+    auto it = streams_.find(stream_id);
+    if (it != streams_.end()) {
+        return it->second;
+    }
+
+    // Proxy sessions come and go while the connection stays: forget the ones
+    // with no queued request and no open transaction
+    if (streams_.size() >= sweep_at_) {
+        for (auto entry = streams_.begin(); entry != streams_.end();) {
+            if (executor_->idle(entry->second->queue) &&
+                entry->second->tx_manager->open_transactions() == 0) {
+                entry = streams_.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+        sweep_at_ = std::max(kMinStreamSweep, 2 * streams_.size());
+    }
+
+    auto created = std::make_shared<Stream>();
+    created->tx_manager = std::make_shared<TransactionManager>();
+    created->rpc_handler = std::make_shared<LineairDBRpc>(db_manager_, created->tx_manager,
+                                                          row_counts_, handles_);
+    created->rpc_handler->set_protocol_version(protocol_version_);
+    created->queue = std::make_shared<StreamExecutor::Stream>(
+        [tx_manager = created->tx_manager]() { return tx_manager->open_transactions() > 0; });
+    streams_.emplace(stream_id, created);
+    return created;
+}
+
+void LineairDBSession::handle_hello(std::string_view payload, std::string& result) {
+    LineairDB::Protocol::SessionHello::Request request;
+    LineairDB::Protocol::SessionHello::Response response;
+    request.ParseFromArray(payload.data(), static_cast<int>(payload.size()));
+
+    // First codec in the proxy's preference order that this build has
+    compression_ = Rpc::Codec::NONE;
+    for (uint32_t codec : request.compression_codecs()) {
+        if (Rpc::codec_available(static_cast<Rpc::Codec>(codec))) {
+            compression_ = static_cast<Rpc::Codec>(codec);
+            break;
+        }
+    }
+    compression_threshold_ = request.compression_threshold();
+    protocol_version_ = std::min(request.protocol_version(), Rpc::kProtocolVersion);
+    response.set_compression_codec(static_cast<uint32_t>(compression_));
+    response.set_protocol_version(protocol_version_);
+    if (protocol_version_ >= Rpc::kTableHandlesVersion) {
+        response.set_handle_epoch(handles_->epoch());
+    }
+    rpc_handler_->set_protocol_version(protocol_version_);
+    if (request.multiplexed() && sink_ && executor_) {
+        multiplexed_ = true;
+        response.set_multiplexed(true);
+    }
+    result = response.SerializeAsString();
+
+    LOG_INFO("Session hello: compression=%s threshold=%zu protocol_version=%u%s",
+             Rpc::codec_name(compression_), compression_threshold_, protocol_version_,
+             multiplexed_ ? " multiplexed" : "");
+}
+
+LineairDBServer::LineairDBServer(const ServerConfig& config)
+    : TcpServer(config.network.port), config_(config) {
+    set_io_model(config.scheduler.io_model, config.network.io_workers);
+    set_listen_address(config.network.listen_address, config.network.backlog);
+    set_socket_buffers(config.network.socket_send_buffer, config.network.socket_receive_buffer);
+    set_shm_socket(config.network.shm_socket);
+    if (config.scheduler.listener_groups) {
+        set_listener_groups(config.scheduler.listeners);
+    }
+}
 
 void LineairDBServer::init() {
+    using Clock = std::chrono::steady_clock;
+    auto ms_since = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+    auto started = Clock::now();
+
     // Initialize components in dependency order
+    if (!engine_slots_) {
+        engine_slots_ = std::make_shared<EngineSlots>(allowed_cpus(), config_.engine.max_thread);
+        LOG_INFO("LineairDB engine: %s%s", engine_slots_->describe().c_str(),
+                 config_.scheduler.engine_affinity ? "" : " (serving threads not bound)");
+    }
+    // With checkpoints the server keeps its own redo log, and durability=wal
+    // makes it log every commit instead of LineairDB: the engine replays its
+    // log while it starts, so a checkpoint loaded after that would overwrite
+    // the newer rows.
+    bool durable_checkpoints = !config_.checkpoint.dir.empty() && config_.engine.enable_logging;
     if (!db_manager_) {
-        db_manager_ = std::make_shared<DatabaseManager>();
+        LineairDB::Config engine = config_.engine;
+        engine.max_thread = engine_slots_->size();
+        if (!config_.checkpoint.dir.empty()) {
+            engine.enable_logging = engine.enable_recovery = false;
+        }
+        db_manager_ = std::make_shared<DatabaseManager>(engine);
+    }
+    double engine_ms = ms_since(started);  // includes LineairDB's own recovery
+    if (!stream_executor_) {
+        stream_executor_ = std::make_shared<StreamExecutor>([this]() { init_serving_thread(); });
+    }
+
+    double load_ms = 0;
+    if (!config_.checkpoint.dir.empty() && !checkpointer_) {
+        auto load_started = Clock::now();
+        Checkpointer::Options options = config_.checkpoint;
+        if (options.load_threads == 0) {
+            options.load_threads = engine_slots_->size();
+        }
+        options.durable = durable_checkpoints;
+        if (durable_checkpoints) {
+            LOG_INFO("Durable checkpoints: every commit is logged in %s", options.dir.c_str());
+        }
+        checkpointer_ = std::make_unique<Checkpointer>(options, db_manager_, row_counts_);
+        if (!checkpointer_->load()) {
+            LOG_FATAL("Cannot load the checkpoint in %s", options.dir.c_str());
+        }
+        checkpointer_->start();
+        std::signal(SIGUSR1, [](int) { Checkpointer::request(); });
+        load_ms = ms_since(load_started);
     }
 
     LOG_INFO("LineairDB server initialized successfully");
+    LOG_INFO("Time to ready: %.1f ms (engine start%s %.1f ms, checkpoint load %.1f ms)",
+             ms_since(started),
+             config_.engine.enable_recovery && config_.checkpoint.dir.empty() ? " and recovery" : "",
+             engine_ms, load_ms);
 }
 
 void LineairDBServer::handle_client(int client_socket) {
     LOG_INFO("Handling client connection fd=%d", client_socket);
     // Per-connection managers
-    auto tx_manager = std::make_shared<TransactionManager>();
-    auto rpc_handler = std::make_shared<LineairDBRpc>(db_manager_, tx_manager, row_counts_);
+    auto session = create_session();
+    auto sink = std::make_shared<BlockingResponseSink>(
+        [client_socket](uint64_t sender_id, uint32_t message_type, const std::string& result) {
+            return MessageHandler::send_response_writev(
+                client_socket, sender_id, static_cast<MessageType>(message_type), result);
+        });
+    session->set_response_sink(sink);
+    // Reused for every request on this connection; handlers parse in place
+    Rpc::PayloadBuffer payload;
 
     while (true) {
         uint64_t sender_id;
         MessageType message_type;
-        std::string payload;
 
         if (!MessageHandler::receive_message(client_socket, sender_id, message_type, payload)) {
             break;  // Client disconnected or error
         }
 
         std::string result;
-        rpc_handler->handle_rpc(sender_id, message_type, payload, result);
+        uint32_t flags = session->handle_message(
+            sender_id, message_type, std::string_view(payload.data(), payload.size()), result);
+        payload.trim();
+        if (flags == ConnectionSession::kDeferred) {
+            continue;  // a stream executor thread sends it
+        }
 
-        if (!MessageHandler::send_response_writev(client_socket, 0, message_type, result)) {
+        // Echo the request ID so a pipelining proxy can match the response
+        if (!sink->send(sender_id, static_cast<uint32_t>(message_type) | flags, result)) {
             break;  // Failed to send response
         }
     }
+    // The caller closes the socket next; late deferred responses are dropped
+    sink->close();
+}
+
+void LineairDBServer::init_serving_thread() {
+    if (config_.scheduler.engine_affinity) {
+        engine_slots_->bind_current_thread();
+    }
+}
+
+std::unique_ptr<ConnectionSession> LineairDBServer::create_session() {
+    return std::make_unique<LineairDBSession>(db_manager_, row_counts_, handles_, stream_executor_);
 }
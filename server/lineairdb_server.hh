@@ -1,25 +1,97 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
 
+#include "../common/compression.h"
+#include "../common/point_codec.h"
 #include "network/tcp_server.hh"
 #include "network/message_handler.hh"
+#include "network/stream_executor.hh"
 #include "rpc/lineairdb_rpc.hh"
+#include "server_config.hh"
+#include "storage/checkpointer.hh"
 #include "storage/database_manager.hh"
+#include "storage/engine_slots.hh"
+#include "storage/table_handles.hh"
 #include "storage/transaction_manager.hh"
 
+// RPC state owned by one proxy connection: its open transactions and handler.
+// A multiplexed connection (SessionHello.multiplexed) gets one such state per
+// request stream instead, run on the server's StreamExecutor. A connection on
+// an event loop (reactor, io_uring) runs its requests there too, as a single
+// stream: a worker serves many connections, and LineairDB's per-thread epoch
+// and log state allow only one open transaction per thread.
+class LineairDBSession : public ConnectionSession {
+public:
+    LineairDBSession(std::shared_ptr<DatabaseManager> db_manager,
+                     std::shared_ptr<TableRowCounts> row_counts,
+                     std::shared_ptr<TableHandles> handles,
+                     std::shared_ptr<StreamExecutor> executor);
+    ~LineairDBSession() override;
+
+    uint32_t handle_message(uint64_t sender_id, MessageType message_type,
+                            std::string_view payload, std::string& result) override;
+    void set_response_sink(std::shared_ptr<ResponseSink> sink) override;
+
+private:
+    // One proxy session's share of a multiplexed connection
+    struct Stream {
+        std::shared_ptr<TransactionManager> tx_manager;
+        std::shared_ptr<LineairDBRpc> rpc_handler;
+        std::shared_ptr<StreamExecutor::Stream> queue;
+        std::string compressed;
+    };
+
+    void handle_hello(std::string_view payload, std::string& result);
+    // Queue the request on target; the stream's thread sends the response
+    uint32_t defer(const std::shared_ptr<Stream>& target, uint64_t sender_id,
+                   MessageType message_type, std::string_view payload);
+    std::shared_ptr<Stream> stream(uint32_t stream_id);
+
+    std::shared_ptr<DatabaseManager> db_manager_;
+    std::shared_ptr<TableRowCounts> row_counts_;
+    std::shared_ptr<TransactionManager> tx_manager_;
+    std::shared_ptr<LineairDBRpc> rpc_handler_;
+    std::shared_ptr<TableHandles> handles_;
+    std::shared_ptr<StreamExecutor> executor_;
+    std::shared_ptr<ResponseSink> sink_;
+    // The connection's own state as a stream, when it runs on the executor
+    std::shared_ptr<Stream> own_stream_;
+
+    // Negotiated by SESSION_HELLO; NONE until the proxy asks for it
+    Rpc::Codec compression_ = Rpc::Codec::NONE;
+    size_t compression_threshold_ = 0;
+    std::string compressed_;
+    uint32_t protocol_version_ = 1;
+    bool multiplexed_ = false;
+
+    // Touched only by the connection's thread. Idle streams are dropped once
+    // the map reaches sweep_at_ entries.
+    std::unordered_map<uint32_t, std::shared_ptr<Stream>> streams_;
+    size_t sweep_at_;
+};
+
 class LineairDBServer : public TcpServer {
 public:
-    LineairDBServer();
+    explicit LineairDBServer(const ServerConfig& config = ServerConfig());
     ~LineairDBServer() = default;
 
     void init();
 
 protected:
     void handle_client(int client_socket) override;
+    std::unique_ptr<ConnectionSession> create_session() override;
+    void init_serving_thread() override;
 
 private:
+    ServerConfig config_;
+
     // Core components
+    std::shared_ptr<EngineSlots> engine_slots_;
     std::shared_ptr<DatabaseManager> db_manager_;
     std::shared_ptr<TableRowCounts> row_counts_ = std::make_shared<TableRowCounts>();
+    std::shared_ptr<TableHandles> handles_ = std::make_shared<TableHandles>();
+    std::unique_ptr<Checkpointer> checkpointer_;  // with checkpoint.dir
+    std::shared_ptr<StreamExecutor> stream_executor_;  // multiplexed connections
 };
@@ -1,14 +1,23 @@
-#include <iostream>
-
 #include "lineairdb_server.hh"
+#include "server_config.hh"
 #include "../common/log.h"
 
 int main(int argc, char** argv) {
+    ServerConfig config;
+    if (!load_server_config(argc, argv, config)) {
+        return 1;
+    }
+
     LOG_INFO("Starting LineairDB server...");
-    
-    LineairDBServer server;
+    // Echo every setting, defaults included, so a run can be reproduced
+    // from its log alone
+    for (const auto& line : config.describe()) {
+        LOG_INFO("config %s", line.c_str());
+    }
+
+    LineairDBServer server(config);
     server.init();
     server.run();  // Start listening
     
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "../protocol/message.hh"
+
+// Writes responses back to a proxy connection from any thread. Responses from
+// concurrent callers are framed whole and never interleave.
+class ResponseSink {
+public:
+    virtual ~ResponseSink() = default;
+
+    // Queue or write one framed response. False once the connection is gone.
+    virtual bool send(uint64_t sender_id, uint32_t message_type, const std::string& payload) = 0;
+    // True if send() only queues and never waits for the peer, so it may be
+    // called from threads that must not block (LineairDB's commit callbacks)
+    virtual bool queues() const { return false; }
+};
+
+// Request handler bound to one proxy connection for its whole lifetime.
+// The transport calls handle_message() once per complete frame, always from
+// the thread that owns the connection. payload points into the connection's
+// receive buffer and is only valid for the duration of the call.
+// The return value is OR'ed into the response's message type (e.g.
+// Rpc::kCompressedPayload); 0 for a plain response. kDeferred means there is
+// no response now: the session sends it later through its ResponseSink.
+// On an event loop (the sink queues()) that thread serves other connections
+// between calls, so a session must not leave thread-bound state such as an
+// open LineairDB transaction on it; it runs such requests elsewhere and
+// defers their responses.
+class ConnectionSession {
+public:
+    static constexpr uint32_t kDeferred = 0xffffffffu;
+
+    virtual ~ConnectionSession() = default;
+
+    virtual uint32_t handle_message(uint64_t sender_id, MessageType message_type,
+                                std::string_view payload, std::string& result) = 0;
+
+    // Called by the transport before the first message. A session that never
+    // defers responses can ignore it.
+    virtual void set_response_sink(std::shared_ptr<ResponseSink> sink) {}
+};
@@ -0,0 +1,128 @@
+#include "cpu_groups.hh"
+#include "../../common/log.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+
+#ifdef LINEAIRDB_WITH_NUMA
+#include <numa.h>
+#endif
+
+namespace {
+
+// CPUs in this process's affinity mask, grouped by NUMA node.
+std::map<int, std::vector<int>> allowed_cpus_by_node() {
+    std::map<int, std::vector<int>> nodes;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+        return nodes;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        int node = 0;
+#ifdef LINEAIRDB_WITH_NUMA
+        if (numa_available() >= 0) {
+            node = std::max(0, numa_node_of_cpu(cpu));
+        }
+#endif
+        nodes[node].push_back(cpu);
+    }
+    return nodes;
+}
+
+}  // namespace
+
+std::vector<CpuGroup> make_cpu_groups(size_t count) {
+    auto nodes = allowed_cpus_by_node();
+    std::vector<CpuGroup> groups;
+    if (nodes.empty()) {
+        return groups;
+    }
+    if (count == 0) {
+        count = nodes.size();
+    }
+
+    if (count <= nodes.size()) {
+        // Deal whole nodes out round-robin
+        groups.resize(count);
+        size_t i = 0;
+        for (auto& [node, cpus] : nodes) {
+            CpuGroup& group = groups[i++ % count];
+            group.node = group.cpus.empty() ? node : -1;
+            group.cpus.insert(group.cpus.end(), cpus.begin(), cpus.end());
+        }
+        for (auto& group : groups) {
+            std::sort(group.cpus.begin(), group.cpus.end());
+        }
+        return groups;
+    }
+
+    // More groups than nodes: give each node its share and split its CPUs.
+    // A node with fewer CPUs than groups lets its groups share CPUs.
+    size_t node_index = 0;
+    for (auto& [node, cpus] : nodes) {
+        size_t share = count / nodes.size() + (node_index++ < count % nodes.size() ? 1 : 0);
+        for (size_t i = 0; i < share; i++) {
+            CpuGroup group;
+            group.node = node;
+            size_t begin = i * cpus.size() / share;
+            size_t end = (i + 1) * cpus.size() / share;
+            if (begin == end) {
+                group.cpus.push_back(cpus[begin % cpus.size()]);
+            } else {
+                group.cpus.assign(cpus.begin() + begin, cpus.begin() + end);
+            }
+            groups.push_back(std::move(group));
+        }
+    }
+    return groups;
+}
+
+std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    for (auto& [node, node_cpus] : allowed_cpus_by_node()) {
+        cpus.insert(cpus.end(), node_cpus.begin(), node_cpus.end());
+    }
+    std::sort(cpus.begin(), cpus.end());
+    return cpus;
+}
+
+bool pin_to_group(const CpuGroup& group) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : group.cpus) {
+        CPU_SET(cpu, &set);
+    }
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        LOG_WARNING("Failed to pin thread to %s: %s (errno=%d)",
+                    describe(group).c_str(), std::strerror(err), err);
+        return false;
+    }
+#ifdef LINEAIRDB_WITH_NUMA
+    if (group.node >= 0 && numa_available() >= 0) {
+        numa_set_preferred(group.node);
+    }
+#endif
+    return true;
+}
+
+std::string describe(const CpuGroup& group) {
+    std::string out = group.node >= 0 ? "node" + std::to_string(group.node) : "multi-node";
+    out += " cpus ";
+    for (size_t i = 0; i < group.cpus.size();) {
+        size_t j = i;
+        while (j + 1 < group.cpus.size() && group.cpus[j + 1] == group.cpus[j] + 1) j++;
+        if (i > 0) out += ",";
+        out += std::to_string(group.cpus[i]);
+        if (j > i) out += "-" + std::to_string(group.cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A set of CPUs that one listener group's acceptor and workers are confined to.
+struct CpuGroup {
+    int node = -1;          // NUMA node of the CPUs, -1 if they span nodes or it is unknown
+    std::vector<int> cpus;  // sorted, all within this process's affinity mask
+};
+
+// Partition the CPUs this process may run on into listener groups.
+//
+// count == 0 gives one group per NUMA node. Otherwise whole nodes are dealt
+// out to the groups when count <= nodes, and each node's CPUs are split into
+// contiguous ranges when count > nodes, so a group never straddles a node
+// boundary unless it has to. Node layout comes from libnuma when built with
+// LINEAIRDB_WITH_NUMA; without it every CPU is treated as node 0.
+std::vector<CpuGroup> make_cpu_groups(size_t count);
+
+// CPUs in this process's affinity mask, sorted.
+std::vector<int> allowed_cpus();
+
+// Restrict the calling thread to group's CPUs and, with libnuma, prefer its
+// node for new allocations. Returns false if the affinity could not be set.
+bool pin_to_group(const CpuGroup& group);
+
+// "node0 cpus 0-3,8" style description for logs.
+std::string describe(const CpuGroup& group);
@@ -0,0 +1,282 @@
+#include "epoll_reactor.hh"
+#include "../../common/log.h"
+#include "message_handler.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+constexpr int kMaxEvents = 256;
+constexpr size_t kReadChunk = 64 * 1024;
+// A drained receive buffer larger than this is given back, so one large
+// frame does not pin its memory for the rest of the connection
+constexpr size_t kMaxIdleReadBuffer = 4 * kReadChunk;
+}  // namespace
+
+EpollReactor::EpollReactor(size_t num_workers, SessionFactory session_factory)
+    : session_factory_(std::move(session_factory)) {
+    if (num_workers == 0) num_workers = 1;
+    for (size_t i = 0; i < num_workers; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+EpollReactor::~EpollReactor() {
+    // Workers run for the lifetime of the process (the accept loop never returns).
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.detach();
+    }
+}
+
+bool EpollReactor::start() {
+    for (size_t i = 0; i < workers_.size(); i++) {
+        Worker& worker = *workers_[i];
+        worker.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        worker.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (worker.epoll_fd < 0 || worker.wake_fd < 0) {
+            int err = errno;
+            LOG_ERROR("Failed to create epoll worker %zu: %s (errno=%d)", i, std::strerror(err), err);
+            return false;
+        }
+
+        struct epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = worker.wake_fd;
+        if (epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, worker.wake_fd, &ev) < 0) {
+            int err = errno;
+            LOG_ERROR("Failed to register wake fd for worker %zu: %s (errno=%d)", i, std::strerror(err), err);
+            return false;
+        }
+
+        worker.thread = std::thread([this, &worker]() {
+            if (thread_init_) thread_init_();
+            worker_loop(worker);
+        });
+    }
+    LOG_INFO("Reactor started with %zu epoll workers", workers_.size());
+    return true;
+}
+
+void EpollReactor::add_connection(int client_socket, const std::string& peer) {
+    auto conn = std::make_unique<Connection>();
+    conn->fd = client_socket;
+    conn->peer = peer;
+    conn->session = session_factory_();
+
+    size_t index = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    Worker& worker = *workers_[index];
+    conn->outbox = std::make_shared<ReactorOutbox>(
+        client_socket,
+        [this, &worker](std::shared_ptr<ReactorOutbox> outbox) { post_outbox(worker, std::move(outbox)); });
+    conn->session->set_response_sink(conn->outbox);
+    {
+        std::lock_guard<std::mutex> lock(worker.pending_mutex);
+        worker.pending.push_back(std::move(conn));
+    }
+    uint64_t one = 1;
+    if (write(worker.wake_fd, &one, sizeof(one)) < 0) {
+        LOG_WARNING("Failed to wake reactor worker %zu", index);
+    }
+
+    int now_active = ++active_connections_;
+    LOG_INFO("Accepted connection fd=%d from %s -> worker %zu (active=%d)",
+             client_socket, peer.c_str(), index, now_active);
+}
+
+void EpollReactor::adopt_pending(Worker& worker) {
+    uint64_t counter;
+    while (read(worker.wake_fd, &counter, sizeof(counter)) > 0) {}
+
+    std::vector<std::unique_ptr<Connection>> pending;
+    std::vector<std::shared_ptr<ReactorOutbox>> outboxes;
+    {
+        std::lock_guard<std::mutex> lock(worker.pending_mutex);
+        pending.swap(worker.pending);
+        outboxes.swap(worker.outboxes);
+    }
+
+    for (auto& conn : pending) {
+        int fd = conn->fd;
+        struct epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            int err = errno;
+            LOG_ERROR("Failed to register fd=%d with epoll: %s (errno=%d)", fd, std::strerror(err), err);
+            conn->outbox->close();
+            close(fd);
+            --active_connections_;
+            continue;
+        }
+        worker.connections.emplace(fd, std::move(conn));
+    }
+    drain_outboxes(worker, outboxes);
+}
+
+void EpollReactor::post_outbox(Worker& worker, std::shared_ptr<ReactorOutbox> outbox) {
+    {
+        std::lock_guard<std::mutex> lock(worker.pending_mutex);
+        worker.outboxes.push_back(std::move(outbox));
+    }
+    uint64_t one = 1;
+    if (write(worker.wake_fd, &one, sizeof(one)) < 0) {
+        LOG_WARNING("Failed to wake reactor worker for deferred responses");
+    }
+}
+
+void EpollReactor::drain_outboxes(Worker& worker,
+                                  std::vector<std::shared_ptr<ReactorOutbox>>& outboxes) {
+    for (auto& outbox : outboxes) {
+        auto it = worker.connections.find(outbox->fd());
+        // The fd may already belong to a newer connection
+        if (it == worker.connections.end() || it->second->outbox != outbox) continue;
+        Connection& conn = *it->second;
+        if (outbox->drain(conn.out) && !flush_output(worker, conn)) {
+            close_connection(worker, conn.fd);
+        }
+    }
+}
+
+void EpollReactor::worker_loop(Worker& worker) {
+    struct epoll_event events[kMaxEvents];
+
+    while (true) {
+        int n = epoll_wait(worker.epoll_fd, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int err = errno;
+            LOG_ERROR("epoll_wait failed: %s (errno=%d)", std::strerror(err), err);
+            continue;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == worker.wake_fd) {
+                adopt_pending(worker);
+                continue;
+            }
+
+            auto it = worker.connections.find(fd);
+            if (it == worker.connections.end()) continue;
+            Connection& conn = *it->second;
+
+            bool alive = true;
+            if (events[i].events & EPOLLOUT) {
+                alive = flush_output(worker, conn);
+            }
+            if (alive && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                alive = on_readable(worker, conn);
+            }
+            if (!alive) {
+                close_connection(worker, fd);
+            }
+        }
+    }
+}
+
+bool EpollReactor::on_readable(Worker& worker, Connection& conn) {
+    // Drain the socket: a pipelining peer may have several frames queued.
+    while (true) {
+        if (conn.in.size() - conn.in_len < kReadChunk) {
+            conn.in.resize(conn.in_len + kReadChunk);
+        }
+        ssize_t n = recv(conn.fd, conn.in.data() + conn.in_len, conn.in.size() - conn.in_len, 0);
+        if (n > 0) {
+            conn.in_len += static_cast<size_t>(n);
+            continue;
+        }
+        if (n == 0) {
+            LOG_DEBUG("Client disconnected fd=%d", conn.fd);
+            // Still answer the frames that arrived before the FIN: the peer
+            // may only have shut down its sending side
+            if (conn.in_len > 0 && dispatch_frames(conn)) {
+                flush_output(worker, conn);
+            }
+            return false;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        int err = errno;
+        if (err == ECONNRESET) {
+            LOG_DEBUG("Client reset connection fd=%d", conn.fd);
+            return false;
+        }
+        LOG_ERROR("recv failed on fd=%d: %s (errno=%d)", conn.fd, std::strerror(err), err);
+        return false;
+    }
+
+    if (!dispatch_frames(conn)) return false;
+    return flush_output(worker, conn);
+}
+
+bool EpollReactor::dispatch_frames(Connection& conn) {
+    size_t frames;
+    size_t consumed = MessageHandler::dispatch_frames(conn.in.data(), conn.in_len, *conn.session,
+                                                      conn.out, frames);
+
+    // Keep any partial frame at the front of the buffer
+    if (consumed > 0) {
+        std::memmove(conn.in.data(), conn.in.data() + consumed, conn.in_len - consumed);
+        conn.in_len -= consumed;
+    }
+    if (conn.in_len == 0 && conn.in.size() > kMaxIdleReadBuffer) {
+        std::vector<char>(kReadChunk).swap(conn.in);
+    }
+    return true;
+}
+
+bool EpollReactor::flush_output(Worker& worker, Connection& conn) {
+    while (conn.out_pos < conn.out.size()) {
+        ssize_t n = send(conn.fd, conn.out.data() + conn.out_pos,
+                         conn.out.size() - conn.out_pos, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.out_pos += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        int err = errno;
+        LOG_ERROR("send failed on fd=%d: %s (errno=%d)", conn.fd, std::strerror(err), err);
+        return false;
+    }
+
+    bool drained = conn.out_pos == conn.out.size();
+    if (drained) {
+        conn.out.clear();
+        conn.out_pos = 0;
+    }
+
+    // While output is pending, wait for EPOLLOUT instead of reading more
+    // requests from a peer that is not consuming its responses.
+    bool want_write = !drained;
+    if (want_write != conn.want_write) {
+        struct epoll_event ev{};
+        ev.events = EPOLLRDHUP | (want_write ? EPOLLOUT : EPOLLIN);
+        ev.data.fd = conn.fd;
+        if (epoll_ctl(worker.epoll_fd, EPOLL_CTL_MOD, conn.fd, &ev) < 0) {
+            int err = errno;
+            LOG_ERROR("epoll_ctl(MOD) failed on fd=%d: %s (errno=%d)", conn.fd, std::strerror(err), err);
+            return false;
+        }
+        conn.want_write = want_write;
+    }
+    return true;
+}
+
+void EpollReactor::close_connection(Worker& worker, int fd) {
+    auto it = worker.connections.find(fd);
+    if (it == worker.connections.end()) return;
+
+    std::string peer = it->second->peer;
+    it->second->outbox->close();
+    epoll_ctl(worker.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    worker.connections.erase(it);  // destroys the session before the fd is reused
+    close(fd);
+
+    int left = --active_connections_;
+    LOG_INFO("Closed connection fd=%d (%s) (active=%d)", fd, peer.c_str(), left);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "connection_session.hh"
+#include "response_sink.hh"
+
+/**
+ * Event-driven connection server: a fixed pool of worker threads, each running
+ * its own epoll loop over the non-blocking sockets it owns.
+ *
+ * The acceptor hands every new connection to one worker (round-robin); from
+ * then on only that worker reads, dispatches and writes for the connection,
+ * so a session never migrates between threads. Frames use the same
+ * MessageHeader framing as the blocking path; requests on a connection are
+ * dispatched in arrival order and responses are written back in that order,
+ * except that responses a session defers are written when it hands them to
+ * the connection's ReactorOutbox.
+ */
+class EpollReactor {
+public:
+    using SessionFactory = std::function<std::unique_ptr<ConnectionSession>()>;
+    using ThreadInit = std::function<void()>;
+
+    EpollReactor(size_t num_workers, SessionFactory session_factory);
+    ~EpollReactor();
+
+    // Run init on each worker thread before its loop starts (e.g. CPU
+    // pinning). Must be called before start().
+    void set_thread_init(ThreadInit init) { thread_init_ = std::move(init); }
+    bool start();
+    // Called from the accept thread. Takes ownership of client_socket.
+    void add_connection(int client_socket, const std::string& peer);
+
+    size_t num_workers() const { return workers_.size(); }
+
+private:
+    struct Connection {
+        int fd;
+        std::string peer;
+        std::unique_ptr<ConnectionSession> session;
+        std::shared_ptr<ReactorOutbox> outbox;
+        std::vector<char> in;  // received bytes not yet dispatched
+        size_t in_len = 0;
+        std::string out;       // encoded responses not yet written
+        size_t out_pos = 0;
+        bool want_write = false;
+    };
+
+    struct Worker {
+        int epoll_fd = -1;
+        int wake_fd = -1;  // eventfd: new connections or outboxes are pending
+        std::thread thread;
+        std::mutex pending_mutex;
+        std::vector<std::unique_ptr<Connection>> pending;
+        std::vector<std::shared_ptr<ReactorOutbox>> outboxes;  // with deferred responses
+        std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    };
+
+    void worker_loop(Worker& worker);
+    void adopt_pending(Worker& worker);
+    void post_outbox(Worker& worker, std::shared_ptr<ReactorOutbox> outbox);
+    void drain_outboxes(Worker& worker, std::vector<std::shared_ptr<ReactorOutbox>>& outboxes);
+    bool on_readable(Worker& worker, Connection& conn);
+    bool dispatch_frames(Connection& conn);
+    bool flush_output(Worker& worker, Connection& conn);
+    void close_connection(Worker& worker, int fd);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    SessionFactory session_factory_;
+    ThreadInit thread_init_;
+    std::atomic<size_t> next_worker_{0};
+    std::atomic<int> active_connections_{0};
+};
@@ -0,0 +1,208 @@
+#include "io_uring.hh"
+#include "../../common/log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+void IoUring::prep_read_fixed(struct io_uring_sqe* sqe, int fd, void* buf, unsigned len,
+                              uint16_t buf_index, uint64_t user_data) {
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->buf_index = buf_index;
+    sqe->user_data = user_data;
+}
+
+void IoUring::prep_recv(struct io_uring_sqe* sqe, int fd, void* buf, unsigned len,
+                        uint64_t user_data) {
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->user_data = user_data;
+}
+
+void IoUring::prep_send(struct io_uring_sqe* sqe, int fd, const void* buf, unsigned len,
+                        uint64_t user_data) {
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = user_data;
+}
+
+void IoUring::prep_read(struct io_uring_sqe* sqe, int fd, void* buf, unsigned len,
+                        uint64_t user_data) {
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->user_data = user_data;
+}
+
+#ifdef LINEAIRDB_WITH_LIBURING
+
+IoUring::~IoUring() {
+    if (initialized_) io_uring_queue_exit(&ring_);
+}
+
+bool IoUring::init(unsigned sq_entries, unsigned cq_entries) {
+    struct io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = cq_entries;
+    int ret = io_uring_queue_init_params(sq_entries, &ring_, &params);
+    if (ret < 0) {
+        LOG_ERROR("io_uring_queue_init failed: %s", std::strerror(-ret));
+        return false;
+    }
+    initialized_ = true;
+    return true;
+}
+
+struct io_uring_sqe* IoUring::get_sqe() {
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+    if (sqe) std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int IoUring::submit_and_wait(unsigned wait_nr) {
+    enter_calls_++;
+    return io_uring_submit_and_wait(&ring_, wait_nr);
+}
+
+bool IoUring::register_buffers(const struct iovec* iovecs, unsigned count) {
+    int ret = io_uring_register_buffers(&ring_, iovecs, count);
+    if (ret < 0) {
+        LOG_WARNING("io_uring_register_buffers failed: %s", std::strerror(-ret));
+        return false;
+    }
+    return true;
+}
+
+#else  // raw syscalls
+
+namespace {
+int sys_io_uring_setup(unsigned entries, struct io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                                    nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+}  // namespace
+
+IoUring::~IoUring() {
+    if (sqes_) munmap(sqes_, sqes_map_size_);
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_map_size_);
+    if (sq_ptr_) munmap(sq_ptr_, sq_map_size_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+}
+
+bool IoUring::init(unsigned sq_entries, unsigned cq_entries) {
+    struct io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = cq_entries;
+    ring_fd_ = sys_io_uring_setup(sq_entries, &params);
+    if (ring_fd_ < 0) {
+        int err = errno;
+        LOG_ERROR("io_uring_setup failed: %s (errno=%d)", std::strerror(err), err);
+        return false;
+    }
+
+    sq_map_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        if (cq_map_size_ > sq_map_size_) sq_map_size_ = cq_map_size_;
+        cq_map_size_ = sq_map_size_;
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        sq_ptr_ = nullptr;
+        LOG_ERROR("io_uring: mmap of SQ ring failed: %s", std::strerror(errno));
+        return false;
+    }
+    if (single_mmap) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr, cq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) {
+            cq_ptr_ = nullptr;
+            LOG_ERROR("io_uring: mmap of CQ ring failed: %s", std::strerror(errno));
+            return false;
+        }
+    }
+
+    sqes_map_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        LOG_ERROR("io_uring: mmap of SQEs failed: %s", std::strerror(errno));
+        return false;
+    }
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    // SQE slots map 1:1 onto the submission array, so it is filled once here
+    unsigned* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < sq_entries_; i++) array[i] = i;
+    sqe_tail_ = *sq_tail_;
+
+    char* cq = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+struct io_uring_sqe* IoUring::get_sqe() {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sqe_tail_ - head >= sq_entries_) {
+        return nullptr;
+    }
+    struct io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe_tail_++;
+    return sqe;
+}
+
+int IoUring::submit_and_wait(unsigned wait_nr) {
+    // Publish new SQEs; anything the kernel has not consumed yet (e.g. after
+    // -EBUSY) is simply submitted again.
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+    unsigned to_submit = sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    enter_calls_++;
+    int ret = sys_io_uring_enter(ring_fd_, to_submit, wait_nr, flags);
+    return ret < 0 ? -errno : ret;
+}
+
+bool IoUring::register_buffers(const struct iovec* iovecs, unsigned count) {
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_BUFFERS, iovecs, count) < 0) {
+        int err = errno;
+        LOG_WARNING("io_uring buffer registration failed: %s (errno=%d)", std::strerror(err), err);
+        return false;
+    }
+    return true;
+}
+
+#endif  // LINEAIRDB_WITH_LIBURING
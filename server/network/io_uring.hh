@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <sys/uio.h>
+
+#include <linux/io_uring.h>
+
+#ifdef LINEAIRDB_WITH_LIBURING
+#include <liburing.h>
+#endif
+
+/**
+ * Minimal io_uring ring used by the server transport.
+ *
+ * Built either on liburing (LINEAIRDB_IO_URING=LIBURING) or directly on the
+ * io_uring_setup/io_uring_enter syscalls (LINEAIRDB_IO_URING=RAW). Only what
+ * the transport needs is exposed: SQE allocation, one combined
+ * submit-and-wait call, completion draining and buffer registration.
+ * Not thread-safe; each worker owns its ring.
+ */
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring();
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool init(unsigned sq_entries, unsigned cq_entries);
+
+    // Next free SQE (zeroed), or nullptr when the submission queue is full.
+    struct io_uring_sqe* get_sqe();
+
+    // Submit all queued SQEs and wait for at least wait_nr completions, in a
+    // single io_uring_enter. Returns the number submitted or -errno.
+    int submit_and_wait(unsigned wait_nr);
+
+    // Invoke fn(user_data, res) for every available completion and retire them.
+    template <typename Fn>
+    unsigned drain_completions(Fn&& fn);
+
+    bool register_buffers(const struct iovec* iovecs, unsigned count);
+
+    uint64_t enter_calls() const { return enter_calls_; }
+
+    static void prep_read_fixed(struct io_uring_sqe* sqe, int fd, void* buf, unsigned len,
+                                uint16_t buf_index, uint64_t user_data);
+    static void prep_recv(struct io_uring_sqe* sqe, int fd, void* buf, unsigned len,
+                          uint64_t user_data);
+    static void prep_send(struct io_uring_sqe* sqe, int fd, const void* buf, unsigned len,
+                          uint64_t user_data);
+    static void prep_read(struct io_uring_sqe* sqe, int fd, void* buf, unsigned len,
+                          uint64_t user_data);
+
+private:
+    uint64_t enter_calls_ = 0;
+
+#ifdef LINEAIRDB_WITH_LIBURING
+    struct io_uring ring_{};
+    bool initialized_ = false;
+#else
+    int ring_fd_ = -1;
+
+    void* sq_ptr_ = nullptr;
+    size_t sq_map_size_ = 0;
+    void* cq_ptr_ = nullptr;
+    size_t cq_map_size_ = 0;
+    struct io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_map_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned sqe_tail_ = 0;  // next SQE handed out by get_sqe()
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    struct io_uring_cqe* cqes_ = nullptr;
+#endif
+};
+
+template <typename Fn>
+unsigned IoUring::drain_completions(Fn&& fn) {
+    unsigned count = 0;
+#ifdef LINEAIRDB_WITH_LIBURING
+    struct io_uring_cqe* cqe;
+    unsigned head;
+    io_uring_for_each_cqe(&ring_, head, cqe) {
+        fn(cqe->user_data, cqe->res);
+        count++;
+    }
+    io_uring_cq_advance(&ring_, count);
+#else
+    unsigned head = *cq_head_;
+    while (true) {
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        if (head == tail) break;
+        const struct io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        uint64_t user_data = cqe.user_data;
+        int32_t res = cqe.res;
+        head++;
+        // Retire before the callback so it may queue new work freely
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        fn(user_data, res);
+        count++;
+    }
+#endif
+    return count;
+}
@@ -0,0 +1,360 @@
+#include "io_uring_reactor.hh"
+#include "../../common/log.h"
+#include "message_handler.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+constexpr unsigned kSqEntries = 1024;
+constexpr unsigned kCqEntries = 8192;
+constexpr size_t kRecvSlotSize = 16 * 1024;
+constexpr size_t kRecvSlotsPerWorker = 512;
+constexpr size_t kHeapChunk = 64 * 1024;
+
+// user_data = Connection* | op tag (connections are at least 8-byte aligned)
+constexpr uint64_t kOpRecv = 1;
+constexpr uint64_t kOpSend = 2;
+constexpr uint64_t kOpWake = 3;
+constexpr uint64_t kOpMask = 3;
+}  // namespace
+
+IoUringReactor::IoUringReactor(size_t num_workers, SessionFactory session_factory)
+    : session_factory_(std::move(session_factory)) {
+    if (num_workers == 0) num_workers = 1;
+    for (size_t i = 0; i < num_workers; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+        workers_.back()->index = i;
+    }
+}
+
+IoUringReactor::~IoUringReactor() {
+    // Workers run for the lifetime of the process (the accept loop never returns).
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.detach();
+    }
+}
+
+bool IoUringReactor::start() {
+    for (auto& worker_ptr : workers_) {
+        Worker& worker = *worker_ptr;
+        if (!worker.ring.init(kSqEntries, kCqEntries)) {
+            return false;
+        }
+        worker.wake_fd = eventfd(0, EFD_CLOEXEC);
+        if (worker.wake_fd < 0) {
+            int err = errno;
+            LOG_ERROR("Failed to create eventfd for io_uring worker %zu: %s (errno=%d)",
+                      worker.index, std::strerror(err), err);
+            return false;
+        }
+
+        // One registered region, carved into fixed-size per-connection slots
+        worker.slots.resize(kRecvSlotSize * kRecvSlotsPerWorker);
+        struct iovec region;
+        region.iov_base = worker.slots.data();
+        region.iov_len = worker.slots.size();
+        worker.fixed_buffers = worker.ring.register_buffers(&region, 1);
+        if (worker.fixed_buffers) {
+            for (size_t s = kRecvSlotsPerWorker; s > 0; s--) {
+                worker.free_slots.push_back(static_cast<int>(s - 1));
+            }
+        } else {
+            std::vector<char>().swap(worker.slots);
+            LOG_WARNING("io_uring worker %zu: receiving without registered buffers", worker.index);
+        }
+
+        post_wake_read(worker);
+        worker.thread = std::thread([this, &worker]() {
+            if (thread_init_) thread_init_();
+            worker_loop(worker);
+        });
+    }
+    LOG_INFO("io_uring reactor started with %zu workers (%s, %zu x %zu KB receive slots)",
+             workers_.size(),
+#ifdef LINEAIRDB_WITH_LIBURING
+             "liburing",
+#else
+             "raw syscalls",
+#endif
+             workers_[0]->fixed_buffers ? kRecvSlotsPerWorker : 0, kRecvSlotSize / 1024);
+    return true;
+}
+
+void IoUringReactor::add_connection(int client_socket, const std::string& peer) {
+    auto conn = std::make_unique<Connection>();
+    conn->fd = client_socket;
+    conn->peer = peer;
+    conn->session = session_factory_();
+
+    size_t index = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    Worker& worker = *workers_[index];
+    conn->outbox = std::make_shared<ReactorOutbox>(
+        client_socket,
+        [this, &worker](std::shared_ptr<ReactorOutbox> outbox) { post_outbox(worker, std::move(outbox)); });
+    conn->session->set_response_sink(conn->outbox);
+    {
+        std::lock_guard<std::mutex> lock(worker.pending_mutex);
+        worker.pending.push_back(std::move(conn));
+    }
+    uint64_t one = 1;
+    if (write(worker.wake_fd, &one, sizeof(one)) < 0) {
+        LOG_WARNING("Failed to wake io_uring worker %zu", index);
+    }
+
+    int now_active = ++active_connections_;
+    LOG_INFO("Accepted connection fd=%d from %s -> worker %zu (active=%d)",
+             client_socket, peer.c_str(), index, now_active);
+}
+
+struct io_uring_sqe* IoUringReactor::next_sqe(Worker& worker) {
+    struct io_uring_sqe* sqe = worker.ring.get_sqe();
+    while (sqe == nullptr) {
+        // Submission queue full: flush it without waiting and retry
+        worker.ring.submit_and_wait(0);
+        sqe = worker.ring.get_sqe();
+    }
+    return sqe;
+}
+
+void IoUringReactor::post_wake_read(Worker& worker) {
+    IoUring::prep_read(next_sqe(worker), worker.wake_fd, &worker.wake_value,
+                       sizeof(worker.wake_value), kOpWake);
+}
+
+char* IoUringReactor::in_buffer(Worker& worker, Connection& conn) {
+    if (conn.use_heap) return conn.heap.data();
+    return worker.slots.data() + static_cast<size_t>(conn.slot) * kRecvSlotSize;
+}
+
+size_t IoUringReactor::in_capacity(const Connection& conn) const {
+    return conn.use_heap ? conn.heap.size() : kRecvSlotSize;
+}
+
+void IoUringReactor::post_recv(Worker& worker, Connection& conn) {
+    if (conn.use_heap && conn.heap.size() - conn.in_len < kHeapChunk / 4) {
+        conn.heap.resize(conn.in_len + kHeapChunk);
+    }
+    char* buf = in_buffer(worker, conn) + conn.in_len;
+    unsigned len = static_cast<unsigned>(in_capacity(conn) - conn.in_len);
+    uint64_t user_data = reinterpret_cast<uint64_t>(&conn) | kOpRecv;
+
+    struct io_uring_sqe* sqe = next_sqe(worker);
+    if (conn.use_heap) {
+        IoUring::prep_recv(sqe, conn.fd, buf, len, user_data);
+    } else {
+        IoUring::prep_read_fixed(sqe, conn.fd, buf, len, 0, user_data);
+    }
+    conn.recv_inflight = true;
+}
+
+void IoUringReactor::post_send(Worker& worker, Connection& conn) {
+    IoUring::prep_send(next_sqe(worker), conn.fd, conn.out.data() + conn.out_pos,
+                       static_cast<unsigned>(conn.out.size() - conn.out_pos),
+                       reinterpret_cast<uint64_t>(&conn) | kOpSend);
+    conn.send_inflight = true;
+}
+
+void IoUringReactor::adopt_pending(Worker& worker) {
+    std::vector<std::unique_ptr<Connection>> pending;
+    std::vector<std::shared_ptr<ReactorOutbox>> outboxes;
+    {
+        std::lock_guard<std::mutex> lock(worker.pending_mutex);
+        pending.swap(worker.pending);
+        outboxes.swap(worker.outboxes);
+    }
+
+    for (auto& conn : pending) {
+        if (!worker.free_slots.empty()) {
+            conn->slot = worker.free_slots.back();
+            worker.free_slots.pop_back();
+        } else {
+            conn->use_heap = true;
+        }
+        Connection& ref = *conn;
+        if (worker.connections.size() <= static_cast<size_t>(ref.fd)) {
+            worker.connections.resize(ref.fd + 1);
+        }
+        worker.connections[ref.fd] = std::move(conn);
+        worker.live_connections++;
+        post_recv(worker, ref);
+    }
+    drain_outboxes(worker, outboxes);
+}
+
+void IoUringReactor::post_outbox(Worker& worker, std::shared_ptr<ReactorOutbox> outbox) {
+    {
+        std::lock_guard<std::mutex> lock(worker.pending_mutex);
+        worker.outboxes.push_back(std::move(outbox));
+    }
+    uint64_t one = 1;
+    if (write(worker.wake_fd, &one, sizeof(one)) < 0) {
+        LOG_WARNING("Failed to wake io_uring worker %zu for deferred responses", worker.index);
+    }
+}
+
+void IoUringReactor::drain_outboxes(Worker& worker,
+                                    std::vector<std::shared_ptr<ReactorOutbox>>& outboxes) {
+    for (auto& outbox : outboxes) {
+        size_t fd = static_cast<size_t>(outbox->fd());
+        // The fd may already belong to a newer connection
+        if (fd >= worker.connections.size() || !worker.connections[fd] ||
+            worker.connections[fd]->outbox != outbox) {
+            continue;
+        }
+        Connection& conn = *worker.connections[fd];
+        if (conn.closing || !outbox->drain(conn.out_pending)) continue;
+        if (!conn.send_inflight && !conn.out_pending.empty()) {
+            conn.out.swap(conn.out_pending);
+            conn.out_pos = 0;
+            post_send(worker, conn);
+        }
+    }
+}
+
+void IoUringReactor::worker_loop(Worker& worker) {
+    while (true) {
+        // One syscall submits everything queued by the previous batch of
+        // completions and waits for the next one.
+        int ret = worker.ring.submit_and_wait(1);
+        if (ret < 0 && ret != -EINTR && ret != -EBUSY && ret != -EAGAIN) {
+            LOG_ERROR("io_uring_enter failed: %s (errno=%d)", std::strerror(-ret), -ret);
+            continue;
+        }
+
+        worker.ring.drain_completions([&](uint64_t user_data, int32_t res) {
+            uint64_t op = user_data & kOpMask;
+            if (op == kOpWake) {
+                adopt_pending(worker);
+                post_wake_read(worker);
+                return;
+            }
+            Connection& conn = *reinterpret_cast<Connection*>(user_data & ~kOpMask);
+            if (op == kOpRecv) {
+                on_recv(worker, conn, res);
+            } else {
+                on_send(worker, conn, res);
+            }
+            maybe_release(worker, conn);
+        });
+    }
+}
+
+void IoUringReactor::on_recv(Worker& worker, Connection& conn, int res) {
+    conn.recv_inflight = false;
+    if (conn.closing) return;
+
+    if (res <= 0) {
+        if (res == -EINTR || res == -EAGAIN) {
+            post_recv(worker, conn);
+            return;
+        }
+        if (res == 0 || res == -ECONNRESET) {
+            LOG_DEBUG("Client disconnected fd=%d", conn.fd);
+        } else {
+            LOG_ERROR("recv failed on fd=%d: %s (errno=%d)", conn.fd, std::strerror(-res), -res);
+        }
+        start_close(conn);
+        return;
+    }
+
+    conn.in_len += static_cast<size_t>(res);
+    char* data = in_buffer(worker, conn);
+    size_t frames;
+    size_t consumed = MessageHandler::dispatch_frames(data, conn.in_len, *conn.session,
+                                                      conn.out_pending, frames);
+    worker.rpcs += frames;
+    if (consumed > 0) {
+        std::memmove(data, data + consumed, conn.in_len - consumed);
+        conn.in_len -= consumed;
+    }
+
+    // A frame that does not fit the registered slot continues on the heap;
+    // once the buffer is empty again the connection goes back to its slot.
+    size_t need = MessageHandler::frame_size(data, conn.in_len);
+    if (!conn.use_heap && need > kRecvSlotSize) {
+        conn.heap.assign(data, data + conn.in_len);
+        conn.heap.resize(need);
+        conn.use_heap = true;
+    } else if (conn.use_heap && conn.slot >= 0 && conn.in_len == 0) {
+        std::vector<char>().swap(conn.heap);
+        conn.use_heap = false;
+    } else if (conn.use_heap && need > conn.heap.size()) {
+        conn.heap.resize(need);
+    }
+
+    if (!conn.send_inflight && !conn.out_pending.empty()) {
+        conn.out.swap(conn.out_pending);
+        conn.out_pos = 0;
+        post_send(worker, conn);
+    }
+    // Stop reading while responses queue up behind a send the peer is not
+    // draining; on_send re-arms the receive.
+    if (conn.out_pending.empty()) {
+        post_recv(worker, conn);
+    }
+}
+
+void IoUringReactor::on_send(Worker& worker, Connection& conn, int res) {
+    conn.send_inflight = false;
+    if (conn.closing) return;
+
+    if (res < 0) {
+        if (res == -EINTR || res == -EAGAIN) {
+            post_send(worker, conn);
+            return;
+        }
+        if (res != -EPIPE && res != -ECONNRESET) {
+            LOG_ERROR("send failed on fd=%d: %s (errno=%d)", conn.fd, std::strerror(-res), -res);
+        }
+        start_close(conn);
+        return;
+    }
+
+    conn.out_pos += static_cast<size_t>(res);
+    if (conn.out_pos < conn.out.size()) {
+        post_send(worker, conn);
+        return;
+    }
+
+    conn.out.clear();
+    conn.out_pos = 0;
+    if (!conn.out_pending.empty()) {
+        conn.out.swap(conn.out_pending);
+        post_send(worker, conn);
+    }
+    if (!conn.recv_inflight) {
+        post_recv(worker, conn);
+    }
+}
+
+void IoUringReactor::start_close(Connection& conn) {
+    conn.closing = true;
+    // Completes whichever operation is still in flight on this socket
+    shutdown(conn.fd, SHUT_RDWR);
+}
+
+void IoUringReactor::maybe_release(Worker& worker, Connection& conn) {
+    if (!conn.closing || conn.recv_inflight || conn.send_inflight) return;
+
+    int fd = conn.fd;
+    std::string peer = conn.peer;
+    conn.outbox->close();
+    if (conn.slot >= 0) {
+        worker.free_slots.push_back(conn.slot);
+    }
+    worker.connections[fd].reset();  // destroys the session before the fd is reused
+    close(fd);
+    worker.live_connections--;
+
+    int left = --active_connections_;
+    LOG_INFO("Closed connection fd=%d (%s) (active=%d)", fd, peer.c_str(), left);
+    if (worker.live_connections == 0 && worker.rpcs > 0) {
+        LOG_INFO("io_uring worker %zu: %lu rpcs, %lu io_uring_enter calls (%.3f per rpc)",
+                 worker.index, worker.rpcs, worker.ring.enter_calls(),
+                 static_cast<double>(worker.ring.enter_calls()) / worker.rpcs);
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "connection_session.hh"
+#include "response_sink.hh"
+#include "io_uring.hh"
+
+/**
+ * io_uring connection server: a fixed pool of worker threads, each owning one
+ * ring and the connections handed to it.
+ *
+ * A worker keeps one receive and at most one send in flight per connection
+ * and submits/reaps them for all of its connections with a single
+ * io_uring_enter per loop iteration, so syscalls are amortized across
+ * connections instead of paid per request. Receives go into per-connection
+ * slots of a buffer registered with the ring (IORING_OP_READ_FIXED); frames
+ * larger than a slot, or connections beyond the slot count, fall back to a
+ * heap buffer and IORING_OP_RECV. Framing, ordering and deferred responses
+ * match EpollReactor.
+ */
+class IoUringReactor {
+public:
+    using SessionFactory = std::function<std::unique_ptr<ConnectionSession>()>;
+    using ThreadInit = std::function<void()>;
+
+    IoUringReactor(size_t num_workers, SessionFactory session_factory);
+    ~IoUringReactor();
+
+    // Run init on each worker thread before its loop starts (e.g. CPU
+    // pinning). Must be called before start().
+    void set_thread_init(ThreadInit init) { thread_init_ = std::move(init); }
+    bool start();
+    // Called from the accept thread. Takes ownership of client_socket.
+    void add_connection(int client_socket, const std::string& peer);
+
+    size_t num_workers() const { return workers_.size(); }
+
+private:
+    struct Connection {
+        int fd;
+        std::string peer;
+        std::unique_ptr<ConnectionSession> session;
+        std::shared_ptr<ReactorOutbox> outbox;
+        int slot = -1;            // registered receive slot, -1 = none
+        bool use_heap = false;    // receiving into heap instead of slot
+        std::vector<char> heap;
+        size_t in_len = 0;
+        std::string out;          // bytes owned by the in-flight send
+        size_t out_pos = 0;
+        std::string out_pending;  // responses produced while a send is in flight
+        bool recv_inflight = false;
+        bool send_inflight = false;
+        bool closing = false;
+    };
+
+    struct Worker {
+        size_t index = 0;
+        IoUring ring;
+        int wake_fd = -1;  // eventfd: new connections or outboxes are pending
+        uint64_t wake_value = 0;
+        std::thread thread;
+        std::mutex pending_mutex;
+        std::vector<std::unique_ptr<Connection>> pending;
+        std::vector<std::shared_ptr<ReactorOutbox>> outboxes;  // with deferred responses
+        std::vector<std::unique_ptr<Connection>> connections;  // indexed by fd
+        size_t live_connections = 0;
+
+        std::vector<char> slots;  // registered receive arena
+        std::vector<int> free_slots;
+        bool fixed_buffers = false;
+
+        uint64_t rpcs = 0;
+    };
+
+    void worker_loop(Worker& worker);
+    void adopt_pending(Worker& worker);
+    void post_outbox(Worker& worker, std::shared_ptr<ReactorOutbox> outbox);
+    void drain_outboxes(Worker& worker, std::vector<std::shared_ptr<ReactorOutbox>>& outboxes);
+    struct io_uring_sqe* next_sqe(Worker& worker);
+    void post_wake_read(Worker& worker);
+    void post_recv(Worker& worker, Connection& conn);
+    void post_send(Worker& worker, Connection& conn);
+    void on_recv(Worker& worker, Connection& conn, int res);
+    void on_send(Worker& worker, Connection& conn, int res);
+    void start_close(Connection& conn);
+    void maybe_release(Worker& worker, Connection& conn);
+
+    char* in_buffer(Worker& worker, Connection& conn);
+    size_t in_capacity(const Connection& conn) const;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    SessionFactory session_factory_;
+    ThreadInit thread_init_;
+    std::atomic<size_t> next_worker_{0};
+    std::atomic<int> active_connections_{0};
+};
@@ -10,7 +10,7 @@
 #include <arpa/inet.h>
 
 bool MessageHandler::receive_message(int socket, uint64_t& sender_id, 
-                                    MessageType& message_type, std::string& payload) {
+                                    MessageType& message_type, Rpc::PayloadBuffer& payload) {
     // Read fixed-size header
     MessageHeader net_header{};
     ssize_t header_read = recv(socket, &net_header, sizeof(net_header), MSG_WAITALL);
@@ -32,10 +32,10 @@ bool MessageHandler::receive_message(int socket, uint64_t& sender_id,
               sender_id, static_cast<uint32_t>(message_type), payload_size);
 
     // Read payload (if exists)
-    payload.clear();
+    // prepare() reuses the buffer's capacity and does not zero-fill it
+    char* body = payload.prepare(payload_size);
     if (payload_size > 0) {
-        payload.resize(payload_size);
-        ssize_t body_read = recv(socket, &payload[0], payload_size, MSG_WAITALL);
+        ssize_t body_read = recv(socket, body, payload_size, MSG_WAITALL);
         if (body_read != static_cast<ssize_t>(payload_size)) {
             if (body_read < 0) {
                 LOG_ERROR("Failed to receive message payload");
@@ -125,3 +125,55 @@ bool MessageHandler::send_response_writev(int socket, uint64_t sender_id,
     LOG_DEBUG("writev response sent successfully");
     return true;
 }
+
+size_t MessageHandler::dispatch_frames(const char* data, size_t len, ConnectionSession& session,
+                                       std::string& out, size_t& frames) {
+    size_t pos = 0;
+    std::string result;
+    frames = 0;
+
+    while (len - pos >= sizeof(MessageHeader)) {
+        MessageHeader net_header;
+        std::memcpy(&net_header, data + pos, sizeof(net_header));
+        uint32_t payload_size = ntohl(net_header.payload_size);
+        if (len - pos - sizeof(MessageHeader) < payload_size) {
+            break;  // frame not complete yet
+        }
+
+        uint64_t sender_id = be64toh(net_header.sender_id);
+        MessageType message_type = static_cast<MessageType>(ntohl(net_header.message_type));
+        // The session parses the payload in place in the reactor's input buffer
+        std::string_view payload(data + pos + sizeof(MessageHeader), payload_size);
+        pos += sizeof(MessageHeader) + payload_size;
+
+        result.clear();
+        uint32_t flags = session.handle_message(sender_id, message_type, payload, result);
+        frames++;
+        if (flags == ConnectionSession::kDeferred) {
+            continue;  // the session answers through its ResponseSink
+        }
+
+        // Echo the request ID so a pipelining proxy can match the response
+        append_frame(out, sender_id, static_cast<uint32_t>(message_type) | flags, result);
+    }
+    return pos;
+}
+
+void MessageHandler::append_frame(std::string& out, uint64_t sender_id, uint32_t message_type,
+                                  const std::string& payload) {
+    MessageHeader response_header;
+    response_header.sender_id = htobe64(sender_id);
+    response_header.message_type = htonl(message_type);
+    response_header.payload_size = htonl(static_cast<uint32_t>(payload.size()));
+    out.append(reinterpret_cast<const char*>(&response_header), sizeof(response_header));
+    out.append(payload);
+}
+
+size_t MessageHandler::frame_size(const char* data, size_t len) {
+    if (len < sizeof(MessageHeader)) {
+        return 0;
+    }
+    MessageHeader net_header;
+    std::memcpy(&net_header, data, sizeof(net_header));
+    return sizeof(MessageHeader) + ntohl(net_header.payload_size);
+}
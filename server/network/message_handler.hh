@@ -2,15 +2,32 @@
 
 #include <string>
 
+#include "../../common/rpc_buffer.h"
 #include "../protocol/message.hh"
+#include "connection_session.hh"
 
 class MessageHandler {
 public:
+    // Reads one frame; the payload lands in the caller's reusable buffer.
     static bool receive_message(int socket, uint64_t& sender_id,
-                               MessageType& message_type, std::string& payload);
+                               MessageType& message_type, Rpc::PayloadBuffer& payload);
     static bool send_response(int socket, uint64_t sender_id,
                              MessageType message_type, const std::string& payload);
     // writev-based send: avoids copying header+payload into one buffer
     static bool send_response_writev(int socket, uint64_t sender_id,
                                      MessageType message_type, const std::string& payload);
+
+    // Append header + payload to out as one response frame.
+    static void append_frame(std::string& out, uint64_t sender_id, uint32_t message_type,
+                             const std::string& payload);
+
+    // Event-driven servers: decode every complete frame in [data, data + len),
+    // run it through session and append the framed response to out (nothing
+    // for a deferred one). Returns the bytes consumed; frames is set to the
+    // number of requests handled.
+    static size_t dispatch_frames(const char* data, size_t len, ConnectionSession& session,
+                                  std::string& out, size_t& frames);
+    // Total size (header + payload) of the frame starting at data, or 0 if its
+    // header has not been received yet.
+    static size_t frame_size(const char* data, size_t len);
 };
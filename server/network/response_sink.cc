@@ -0,0 +1,56 @@
+#include "response_sink.hh"
+#include "message_handler.hh"
+
+bool BlockingResponseSink::send(uint64_t sender_id, uint32_t message_type,
+                                const std::string& payload) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+        return false;
+    }
+    if (!writer_(sender_id, message_type, payload)) {
+        closed_ = true;  // a partial frame leaves the stream unusable
+    }
+    return !closed_;
+}
+
+void BlockingResponseSink::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+}
+
+bool ReactorOutbox::send(uint64_t sender_id, uint32_t message_type, const std::string& payload) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return false;
+        }
+        MessageHandler::append_frame(frames_, sender_id, message_type, payload);
+        if (posted_) {
+            return true;  // the worker has not drained the previous ones yet
+        }
+        posted_ = true;
+    }
+    post_(shared_from_this());
+    return true;
+}
+
+bool ReactorOutbox::drain(std::string& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    posted_ = false;
+    if (closed_) {
+        return false;
+    }
+    if (out.empty()) {
+        out.swap(frames_);
+    } else {
+        out.append(frames_);
+    }
+    frames_.clear();
+    return true;
+}
+
+void ReactorOutbox::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    std::string().swap(frames_);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "connection_session.hh"
+
+/**
+ * ResponseSink for transports that write with blocking calls from the
+ * connection's own thread (thread-per-connection TCP, shared memory). The
+ * connection thread sends its inline responses through the sink too, so a
+ * response finished on another thread never interleaves with one in progress.
+ */
+class BlockingResponseSink : public ResponseSink {
+public:
+    using Writer = std::function<bool(uint64_t sender_id, uint32_t message_type,
+                                      const std::string& payload)>;
+
+    explicit BlockingResponseSink(Writer writer) : writer_(std::move(writer)) {}
+
+    bool send(uint64_t sender_id, uint32_t message_type, const std::string& payload) override;
+    // Fail every later send; waits for a send in progress. Call before the
+    // connection's socket or channel goes away.
+    void close();
+
+private:
+    std::mutex mutex_;
+    Writer writer_;
+    bool closed_ = false;
+};
+
+/**
+ * ResponseSink of a reactor connection. Responses finished off the worker
+ * thread are framed into the outbox, and the first one since the worker last
+ * drained it hands the outbox to post, which queues it on the owning worker
+ * and wakes it. The worker moves the frames into the connection's output
+ * from its own loop, so only the worker ever touches the socket.
+ */
+class ReactorOutbox : public ResponseSink, public std::enable_shared_from_this<ReactorOutbox> {
+public:
+    using Post = std::function<void(std::shared_ptr<ReactorOutbox>)>;
+
+    ReactorOutbox(int fd, Post post) : fd_(fd), post_(std::move(post)) {}
+
+    bool send(uint64_t sender_id, uint32_t message_type, const std::string& payload) override;
+    bool queues() const override { return true; }
+
+    // Worker thread: append the queued frames to out. False once closed.
+    bool drain(std::string& out);
+    // Worker thread, when it closes the connection.
+    void close();
+    int fd() const { return fd_; }
+
+private:
+    const int fd_;
+    const Post post_;
+    std::mutex mutex_;
+    std::string frames_;
+    bool posted_ = false;
+    bool closed_ = false;
+};
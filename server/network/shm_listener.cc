@@ -0,0 +1,126 @@
+#include "shm_listener.hh"
+#include "../../common/log.h"
+#include "../../common/rpc_buffer.h"
+#include "../../common/shm_ring.h"
+#include "../protocol/message.hh"
+#include "response_sink.hh"
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+ShmListener::ShmListener(std::string socket_path, SessionFactory session_factory)
+    : socket_path_(std::move(socket_path)), session_factory_(std::move(session_factory)) {}
+
+bool ShmListener::start() {
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        int err = errno;
+        LOG_ERROR("Failed to create shm listener socket: %s (errno=%d)", std::strerror(err), err);
+        return false;
+    }
+
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path_.size() >= sizeof(addr.sun_path)) {
+        LOG_ERROR("Shm socket path too long: %s", socket_path_.c_str());
+        return false;
+    }
+    std::strncpy(addr.sun_path, socket_path_.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(socket_path_.c_str());  // stale socket from a previous run
+
+    if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listen_fd_, 128) < 0) {
+        int err = errno;
+        LOG_ERROR("Failed to listen on %s: %s (errno=%d)", socket_path_.c_str(), std::strerror(err), err);
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    std::thread([this]() { accept_loop(); }).detach();
+    LOG_INFO("Shared-memory transport listening on %s", socket_path_.c_str());
+    return true;
+}
+
+void ShmListener::accept_loop() {
+    while (true) {
+        int client_socket = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_socket < 0) {
+            int err = errno;
+            if (err == EINTR) continue;
+            LOG_ERROR("Failed to accept shm connection: %s (errno=%d)", std::strerror(err), err);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        std::thread([this, client_socket]() {
+            if (thread_init_) thread_init_();
+            serve(client_socket);
+        }).detach();
+    }
+}
+
+void ShmListener::serve(int client_socket) {
+    std::unique_ptr<Shm::Channel> channel = Shm::Channel::accept(client_socket);
+    if (!channel) {
+        LOG_ERROR("Shm handshake failed on fd=%d", client_socket);
+        close(client_socket);
+        return;
+    }
+    // The channel now owns client_socket
+
+    int now_active = ++active_connections_;
+    LOG_INFO("Accepted shm connection fd=%d (active=%d)", client_socket, now_active);
+
+    auto session = session_factory_();
+    auto sink = std::make_shared<BlockingResponseSink>(
+        [&channel](uint64_t sender_id, uint32_t message_type, const std::string& result) {
+            MessageHeader response_header;
+            response_header.sender_id = htobe64(sender_id);
+            response_header.message_type = htonl(message_type);
+            response_header.payload_size = htonl(static_cast<uint32_t>(result.size()));
+            return channel->send(&response_header, sizeof(response_header)) &&
+                   channel->send(result.data(), result.size());
+        });
+    session->set_response_sink(sink);
+    Rpc::PayloadBuffer payload;
+    std::string result;
+    while (true) {
+        MessageHeader header;
+        if (!channel->recv(&header, sizeof(header))) {
+            break;  // proxy closed or died
+        }
+        uint64_t sender_id = be64toh(header.sender_id);
+        MessageType message_type = static_cast<MessageType>(ntohl(header.message_type));
+        uint32_t payload_size = ntohl(header.payload_size);
+        char* body = payload.prepare(payload_size);
+        if (payload_size > 0 && !channel->recv(body, payload_size)) {
+            break;
+        }
+
+        result.clear();
+        uint32_t flags = session->handle_message(sender_id, message_type,
+                                                 std::string_view(body, payload_size), result);
+        payload.trim();
+        if (flags == ConnectionSession::kDeferred) {
+            continue;
+        }
+
+        // Echo the request ID so a pipelining proxy can match the response
+        if (!sink->send(sender_id, static_cast<uint32_t>(message_type) | flags, result)) {
+            break;
+        }
+    }
+
+    sink->close();  // deferred responses still in flight must not touch the channel
+    session.reset();
+    channel.reset();
+    int left = --active_connections_;
+    LOG_INFO("Closed shm connection fd=%d (active=%d)", client_socket, left);
+}
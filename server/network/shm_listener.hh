@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "connection_session.hh"
+
+/**
+ * Accepts shared-memory connections from co-located proxies.
+ *
+ * Listens on a Unix domain socket; each proxy that connects hands over a
+ * memfd holding a Shm::Channel (see common/shm_ring.h). Every channel is then
+ * served by its own thread with the same framing and session handling as the
+ * TCP thread-per-connection path. Runs alongside whatever TCP I/O model is
+ * configured.
+ */
+class ShmListener {
+public:
+    using SessionFactory = std::function<std::unique_ptr<ConnectionSession>()>;
+    using ThreadInit = std::function<void()>;
+
+    ShmListener(std::string socket_path, SessionFactory session_factory);
+
+    // Run on each connection's thread before it serves. Must be called
+    // before start().
+    void set_thread_init(ThreadInit init) { thread_init_ = std::move(init); }
+
+    // Bind the socket and start the accept thread.
+    bool start();
+
+private:
+    void accept_loop();
+    void serve(int client_socket);
+
+    std::string socket_path_;
+    SessionFactory session_factory_;
+    ThreadInit thread_init_;
+    int listen_fd_ = -1;
+    std::atomic<int> active_connections_{0};
+};
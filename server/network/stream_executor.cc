@@ -0,0 +1,92 @@
+#include "stream_executor.hh"
+
+#include <thread>
+
+StreamExecutor::StreamExecutor(ThreadInit thread_init, std::chrono::milliseconds idle_timeout)
+    : thread_init_(std::move(thread_init)), idle_timeout_(idle_timeout) {}
+
+void StreamExecutor::submit(const std::shared_ptr<Stream>& stream, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex_);
+        if (stream->closed_) {
+            return;
+        }
+        stream->tasks_.push_back(std::move(task));
+        if (stream->scheduled_) {
+            stream->cv_.notify_one();  // its thread may be holding it
+            return;
+        }
+        stream->scheduled_ = true;
+    }
+
+    bool spawn;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.push_back(stream);
+        spawn = ready_.size() > idle_threads_;
+    }
+    if (spawn) {
+        spawn_thread();
+    } else {
+        cv_.notify_one();
+    }
+}
+
+void StreamExecutor::close(const std::shared_ptr<Stream>& stream) {
+    std::lock_guard<std::mutex> lock(stream->mutex_);
+    stream->closed_ = true;
+    stream->cv_.notify_one();
+}
+
+bool StreamExecutor::idle(const std::shared_ptr<Stream>& stream) {
+    std::lock_guard<std::mutex> lock(stream->mutex_);
+    return !stream->scheduled_;
+}
+
+void StreamExecutor::spawn_thread() {
+    std::thread([self = shared_from_this()]() { self->worker(); }).detach();
+}
+
+void StreamExecutor::worker() {
+    if (thread_init_) {
+        thread_init_();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (ready_.empty()) {
+            idle_threads_++;
+            bool woken = cv_.wait_for(lock, idle_timeout_, [this]() { return !ready_.empty(); });
+            idle_threads_--;
+            if (!woken) {
+                return;
+            }
+        }
+        std::shared_ptr<Stream> stream = std::move(ready_.front());
+        ready_.pop_front();
+        lock.unlock();
+        serve(*stream);
+        stream.reset();
+        lock.lock();
+    }
+}
+
+void StreamExecutor::serve(Stream& stream) {
+    std::unique_lock<std::mutex> lock(stream.mutex_);
+    while (true) {
+        if (!stream.tasks_.empty()) {
+            Task task = std::move(stream.tasks_.front());
+            stream.tasks_.pop_front();
+            lock.unlock();
+            task();
+            task = nullptr;  // drop what it captured outside the lock
+            lock.lock();
+            continue;
+        }
+        if (stream.closed_ || !stream.hold_ || !stream.hold_()) {
+            stream.scheduled_ = false;
+            return;
+        }
+        // Mid-transaction: keep this thread for the stream's next request
+        stream.cv_.wait(lock);
+    }
+}
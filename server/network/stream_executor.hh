@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+/**
+ * Runs the request streams of multiplexed connections on their own threads.
+ *
+ * A shared proxy connection carries one stream per MySQL session. Each
+ * stream's tasks run in submission order on one thread at a time, and
+ * different streams run concurrently, so a slow request only delays later
+ * requests of its own session. While a stream's hold() is true (it has an
+ * open transaction) its thread stays with it between requests: LineairDB
+ * keeps epoch and log state per thread, so a transaction must begin and end
+ * on one thread, and no other transaction may run on that thread meanwhile.
+ * An idle stream gives its thread back to the pool.
+ *
+ * The pool grows whenever a stream is ready and no thread is free, and a
+ * thread that stays idle for idle_timeout exits, so the thread count follows
+ * the number of concurrently open transactions, as with one connection per
+ * session: sharing connections saves sockets, not threads. The pool is
+ * unbounded on purpose. A held thread waits for its client, which may be
+ * waiting for another session's request to run, so a fixed pool that
+ * transactions have filled could deadlock. Each thread runs thread_init
+ * before its first task.
+ */
+class StreamExecutor : public std::enable_shared_from_this<StreamExecutor> {
+public:
+    using Task = std::function<void()>;
+    using ThreadInit = std::function<void()>;
+
+    class Stream {
+    public:
+        explicit Stream(std::function<bool()> hold) : hold_(std::move(hold)) {}
+
+    private:
+        friend class StreamExecutor;
+
+        std::function<bool()> hold_;  // called on the stream's thread only
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<Task> tasks_;
+        bool scheduled_ = false;  // queued for or owned by a thread
+        bool closed_ = false;
+    };
+
+    explicit StreamExecutor(ThreadInit thread_init,
+                            std::chrono::milliseconds idle_timeout = std::chrono::seconds(10));
+
+    // Queue task behind stream's earlier tasks. Ignored once stream is closed.
+    void submit(const std::shared_ptr<Stream>& stream, Task task);
+    // Run the tasks already queued, then release the stream's thread even if
+    // it still holds (its connection is gone).
+    void close(const std::shared_ptr<Stream>& stream);
+    // True if no thread owns stream and none of its tasks are queued; its
+    // state may then be touched or discarded by the submitting thread.
+    bool idle(const std::shared_ptr<Stream>& stream);
+
+private:
+    void spawn_thread();
+    void worker();
+    void serve(Stream& stream);
+
+    const ThreadInit thread_init_;
+    const std::chrono::milliseconds idle_timeout_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Stream>> ready_;
+    size_t idle_threads_ = 0;
+};
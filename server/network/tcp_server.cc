@@ -1,4 +1,9 @@
 #include "tcp_server.hh"
+#include "epoll_reactor.hh"
+#include "shm_listener.hh"
+#ifdef LINEAIRDB_WITH_IO_URING
+#include "io_uring_reactor.hh"
+#endif
 #include "../../common/log.h"
 
 #include <iostream>
@@ -7,28 +12,133 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <linux/filter.h>
 #include <thread>
 #include <chrono>
 #include <cerrno>
 #include <cstring>
 #include <atomic>
+#include <algorithm>
+#include <string>
 
 TcpServer::TcpServer(uint16_t port) : port_(port) {}
 
+TcpServer::~TcpServer() = default;
+
+void TcpServer::set_io_model(IoModel io_model, size_t num_workers) {
+    io_model_ = io_model;
+    num_workers_ = num_workers;
+}
+
 void TcpServer::run() {
-    LOG_INFO("Starting server on port %d", port_);
-    
+    LOG_INFO("Starting server on %s:%d", listen_address_.c_str(), port_);
+
+    if (!shm_socket_path_.empty()) {
+        shm_listener_ = std::make_unique<ShmListener>(shm_socket_path_,
+                                                      [this]() { return create_session(); });
+        shm_listener_->set_thread_init([this]() { init_serving_thread(); });
+    }
+    if (reuseport_) {
+        run_listener_groups();
+        return;
+    }
+
     int server_socket;
-    if (!setup_and_listen(server_socket)) {
+    if (!setup_and_listen(server_socket, false)) {
         return;
     }
     
     LOG_INFO("Server listening on port %d", port_);
-    accept_clients(server_socket);
+    if (shm_listener_ && !shm_listener_->start()) {
+        shm_listener_.reset();
+    }
+    serve(server_socket, nullptr);
     close(server_socket);
 }
 
-bool TcpServer::setup_and_listen(int& server_socket) {
+void TcpServer::run_listener_groups() {
+    cpu_groups_ = make_cpu_groups(listener_groups_);
+    if (cpu_groups_.empty()) {
+        LOG_ERROR("Failed to determine CPU groups for listeners");
+        return;
+    }
+
+    // Bind in group order: the steering program returns indexes into the
+    // reuseport group, which follow the order the sockets started listening
+    std::vector<int> sockets;
+    for (size_t i = 0; i < cpu_groups_.size(); i++) {
+        int server_socket;
+        if (!setup_and_listen(server_socket, true)) {
+            for (int fd : sockets) close(fd);
+            return;
+        }
+        sockets.push_back(server_socket);
+    }
+    if (!attach_group_steering(sockets[0])) {
+        LOG_WARNING("Reuseport steering unavailable, the kernel will hash connections across listeners");
+    }
+
+    LOG_INFO("Server listening on port %d with %zu reuseport listeners", port_, sockets.size());
+    if (shm_listener_ && !shm_listener_->start()) {
+        shm_listener_.reset();
+    }
+
+    std::vector<std::thread> acceptors;
+    for (size_t i = 0; i < sockets.size(); i++) {
+        const CpuGroup* group = &cpu_groups_[i];
+        LOG_INFO("Listener %zu: %s", i, describe(*group).c_str());
+        acceptors.emplace_back([this, server_socket = sockets[i], group]() {
+            pin_to_group(*group);
+            serve(server_socket, group);
+        });
+    }
+    for (size_t i = 0; i < acceptors.size(); i++) {
+        acceptors[i].join();
+        close(sockets[i]);
+    }
+}
+
+// Classic BPF for SO_ATTACH_REUSEPORT_CBPF: map the CPU that processed the
+// SYN to the listener of the group owning that CPU. CPUs outside every group
+// fall through to an out-of-range index, which makes the kernel use its
+// default hash.
+bool TcpServer::attach_group_steering(int server_socket) {
+    std::vector<struct sock_filter> code;
+    code.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)));
+    for (size_t i = 0; i < cpu_groups_.size(); i++) {
+        for (int cpu : cpu_groups_[i].cpus) {
+            code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(cpu), 0, 1));
+            code.push_back(BPF_STMT(BPF_RET | BPF_K, static_cast<uint32_t>(i)));
+        }
+    }
+    code.push_back(BPF_STMT(BPF_RET | BPF_K, 0xffffffffu));
+    if (code.size() > BPF_MAXINSNS) {
+        return false;
+    }
+
+    struct sock_fprog program;
+    program.len = static_cast<unsigned short>(code.size());
+    program.filter = code.data();
+    if (setsockopt(server_socket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) < 0) {
+        int err = errno;
+        LOG_WARNING("Failed to attach reuseport program: %s (errno=%d)", std::strerror(err), err);
+        return false;
+    }
+    return true;
+}
+
+void TcpServer::serve(int server_socket, const CpuGroup* group) {
+    if (io_model_ == IoModel::Reactor) {
+        run_reactor(server_socket, group);
+    } else if (io_model_ == IoModel::IoUring) {
+        run_io_uring(server_socket, group);
+    } else {
+        accept_clients(server_socket, group);
+    }
+}
+
+bool TcpServer::setup_and_listen(int& server_socket, bool reuseport) {
     // Create socket
     server_socket = socket(AF_INET, SOCK_STREAM, 0);
     if (server_socket < 0) {
@@ -44,11 +154,33 @@ bool TcpServer::setup_and_listen(int& server_socket) {
         close(server_socket);
         return false;
     }
+    if (reuseport && setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0) {
+        int err = errno;
+        LOG_ERROR("Failed to set SO_REUSEPORT: %s (errno=%d)", std::strerror(err), err);
+        close(server_socket);
+        return false;
+    }
+
+    // Set before listen() so the window scale offered to clients matches
+    if (send_buffer_ > 0 &&
+        setsockopt(server_socket, SOL_SOCKET, SO_SNDBUF, &send_buffer_, sizeof(send_buffer_)) < 0) {
+        int err = errno;
+        LOG_WARNING("Failed to set SO_SNDBUF=%d: %s (errno=%d)", send_buffer_, std::strerror(err), err);
+    }
+    if (receive_buffer_ > 0 &&
+        setsockopt(server_socket, SOL_SOCKET, SO_RCVBUF, &receive_buffer_, sizeof(receive_buffer_)) < 0) {
+        int err = errno;
+        LOG_WARNING("Failed to set SO_RCVBUF=%d: %s (errno=%d)", receive_buffer_, std::strerror(err), err);
+    }
 
     struct sockaddr_in server_addr;
     server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(port_);
+    if (inet_pton(AF_INET, listen_address_.c_str(), &server_addr.sin_addr) != 1) {
+        LOG_ERROR("Invalid listen address %s", listen_address_.c_str());
+        close(server_socket);
+        return false;
+    }
 
     // Bind socket
     if (bind(server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
@@ -58,7 +190,7 @@ bool TcpServer::setup_and_listen(int& server_socket) {
     }
 
     // Listen for connections
-    if (listen(server_socket, 128) < 0) {
+    if (listen(server_socket, backlog_) < 0) {
         std::cerr << "Failed to listen on socket" << std::endl;
         close(server_socket);
         return false;
@@ -67,8 +199,9 @@ bool TcpServer::setup_and_listen(int& server_socket) {
     return true;
 }
 
-void TcpServer::accept_clients(int server_socket) {
-    static std::atomic<int> active_connections{0};
+namespace {
+// Accept one client, retrying on transient errors. Returns the connected socket.
+int accept_one(int server_socket, std::string& client_ip) {
     while (true) {
         struct sockaddr_in client_addr;
         socklen_t client_addr_len = sizeof(client_addr);
@@ -90,12 +223,27 @@ void TcpServer::accept_clients(int server_socket) {
         int flag = 1;
         setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
 
+        client_ip = std::string(inet_ntoa(client_addr.sin_addr));
+        return client_socket;
+    }
+}
+}  // namespace
+
+void TcpServer::accept_clients(int server_socket, const CpuGroup* group) {
+    static std::atomic<int> active_connections{0};
+    while (true) {
+        std::string client_ip;
+        int client_socket = accept_one(server_socket, client_ip);
+
         // Hand off each client to a dedicated thread
-        auto client_ip = std::string(inet_ntoa(client_addr.sin_addr));
         int now_active = ++active_connections;
         LOG_INFO("Accepted connection fd=%d from %s (active=%d)", client_socket, client_ip.c_str(), now_active);
 
-        std::thread([this, client_socket, client_ip]() {
+        std::thread([this, client_socket, client_ip, group]() {
+            if (group) {
+                pin_to_group(*group);
+            }
+            init_serving_thread();
             // Process the client in this thread
             handle_client(client_socket);
             // Ensure socket is closed when done
@@ -106,3 +254,64 @@ void TcpServer::accept_clients(int server_socket) {
         }).detach();
     }
 }
+
+size_t TcpServer::worker_count(const CpuGroup* group) const {
+    if (group == nullptr) {
+        return num_workers_ > 0 ? num_workers_ : std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (num_workers_ > 0) {
+        return std::max<size_t>(1, num_workers_ / cpu_groups_.size());
+    }
+    return group->cpus.size();
+}
+
+void TcpServer::run_reactor(int server_socket, const CpuGroup* group) {
+    EpollReactor reactor(worker_count(group), [this]() { return create_session(); });
+    reactor.set_thread_init([this, group]() {
+        if (group) {
+            pin_to_group(*group);
+        }
+        init_serving_thread();
+    });
+    if (!reactor.start()) {
+        return;
+    }
+
+    while (true) {
+        std::string client_ip;
+        int client_socket = accept_one(server_socket, client_ip);
+
+        int flags = fcntl(client_socket, F_GETFL, 0);
+        if (flags < 0 || fcntl(client_socket, F_SETFL, flags | O_NONBLOCK) < 0) {
+            int err = errno;
+            LOG_ERROR("Failed to make fd=%d non-blocking: %s (errno=%d)", client_socket, std::strerror(err), err);
+            close(client_socket);
+            continue;
+        }
+        reactor.add_connection(client_socket, client_ip);
+    }
+}
+
+void TcpServer::run_io_uring(int server_socket, const CpuGroup* group) {
+#ifdef LINEAIRDB_WITH_IO_URING
+    IoUringReactor reactor(worker_count(group), [this]() { return create_session(); });
+    reactor.set_thread_init([this, group]() {
+        if (group) {
+            pin_to_group(*group);
+        }
+        init_serving_thread();
+    });
+    if (!reactor.start()) {
+        return;
+    }
+
+    while (true) {
+        std::string client_ip;
+        int client_socket = accept_one(server_socket, client_ip);
+        // Sockets stay blocking: io_uring arms its own readiness polling
+        reactor.add_connection(client_socket, client_ip);
+    }
+#else
+    LOG_ERROR("io_uring transport not compiled in (configure with -DLINEAIRDB_IO_URING=RAW or LIBURING)");
+#endif
+}
@@ -1,20 +1,89 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "connection_session.hh"
+#include "cpu_groups.hh"
+
+class ShmListener;
+
+// How accepted proxy connections are served.
+enum class IoModel {
+    ThreadPerConnection,  // one detached thread per connection, blocking recv
+    Reactor,              // fixed pool of epoll workers, each owning many connections
+    IoUring,              // fixed pool of io_uring workers (LINEAIRDB_IO_URING builds only)
+};
 
 class TcpServer {
 public:
     TcpServer(uint16_t port = 9999);
-    virtual ~TcpServer() = default;
-    
+    virtual ~TcpServer();
+
+    // Must be called before run(). num_workers is only used by the worker-pool
+    // models (0 = one worker per hardware thread).
+    void set_io_model(IoModel io_model, size_t num_workers = 0);
+    // IPv4 address to bind ("0.0.0.0" = all) and listen() backlog. Must be
+    // called before run().
+    void set_listen_address(const std::string& address, int backlog) {
+        listen_address_ = address;
+        backlog_ = backlog;
+    }
+    // SO_SNDBUF / SO_RCVBUF for the listening sockets, which accepted
+    // connections inherit (0 = kernel default). Must be called before run().
+    void set_socket_buffers(int send_bytes, int receive_bytes) {
+        send_buffer_ = send_bytes;
+        receive_buffer_ = receive_bytes;
+    }
+    // Also accept shared-memory connections on this Unix socket path
+    // (empty = TCP only). Must be called before run().
+    void set_shm_socket(const std::string& path) { shm_socket_path_ = path; }
+    // Open one SO_REUSEPORT listener per CPU group instead of a single
+    // listener. Each group gets its own acceptor and workers pinned to its
+    // CPUs, and a reuseport BPF program steers a connection to the group of
+    // the CPU that received its SYN. groups == 0 means one group per NUMA
+    // node. With num_workers set, the workers are divided among the groups.
+    // Must be called before run().
+    void set_listener_groups(size_t groups) {
+        reuseport_ = true;
+        listener_groups_ = groups;
+    }
+
     void run();
-    
+
 protected:
     virtual void handle_client(int client_socket) = 0;
-    
+    // Per-connection RPC state, used by the reactor workers.
+    virtual std::unique_ptr<ConnectionSession> create_session() = 0;
+    // Called on every thread that serves connections (per-connection TCP and
+    // shared-memory threads, reactor workers) before its first request,
+    // after any listener-group pinning.
+    virtual void init_serving_thread() {}
+
 private:
     uint16_t port_;
-    
-    bool setup_and_listen(int& server_socket);
-    void accept_clients(int server_socket);
+    std::string listen_address_ = "0.0.0.0";
+    int backlog_ = 128;
+    int send_buffer_ = 0;
+    int receive_buffer_ = 0;
+    IoModel io_model_ = IoModel::ThreadPerConnection;
+    size_t num_workers_ = 0;
+    std::string shm_socket_path_;
+    std::unique_ptr<ShmListener> shm_listener_;
+    bool reuseport_ = false;
+    size_t listener_groups_ = 0;
+    std::vector<CpuGroup> cpu_groups_;
+
+    bool setup_and_listen(int& server_socket, bool reuseport);
+    bool attach_group_steering(int server_socket);
+    void run_listener_groups();
+    // group == nullptr: the single unpinned listener
+    void serve(int server_socket, const CpuGroup* group);
+    void accept_clients(int server_socket, const CpuGroup* group);
+    void run_reactor(int server_socket, const CpuGroup* group);
+    void run_io_uring(int server_socket, const CpuGroup* group);
+    size_t worker_count(const CpuGroup* group) const;
 };
@@ -4,7 +4,7 @@
 
 // Message header for RPC communication
 struct MessageHeader {
-    uint64_t sender_id;      // sender ID (not used in LineairDB but keeping for consistency)
+    uint64_t sender_id;      // request ID chosen by the proxy; echoed back in the response
     uint32_t message_type;   // OpCode from protobuf
     uint32_t payload_size;   // size of the protobuf payload
 };
@@ -51,5 +51,12 @@ enum class MessageType : uint32_t {
 
     // Batch operations
     TX_BATCH_READ = 25,
-    TX_BATCH_WRITE = 26
+    TX_BATCH_WRITE = 26,
+
+    // Connection setup
+    SESSION_HELLO = 27,
+    DB_RESOLVE_HANDLES = 28,
+
+    // Heterogeneous batch
+    TX_MULTI = 29
 };
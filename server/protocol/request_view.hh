@@ -0,0 +1,272 @@
+#pragma once
+
+// Zero-copy decoders for the hot request messages.
+//
+// Generated protobuf classes copy every bytes/string field into its own
+// std::string on parse. For the per-row RPCs the handler only needs the key
+// and value long enough to hand them to LineairDB::Transaction, so these
+// views decode the protobuf wire format in place and return string_views into
+// the connection's receive buffer. Field numbers must match lineairdb.proto;
+// unknown fields are skipped like the generated parser does.
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Wire {
+
+enum WireType : uint32_t { VARINT = 0, FIXED64 = 1, LENGTH_DELIMITED = 2, FIXED32 = 5 };
+
+class Reader {
+public:
+    explicit Reader(std::string_view data)
+        : p_(reinterpret_cast<const uint8_t*>(data.data())), end_(p_ + data.size()) {}
+
+    bool done() const { return p_ == end_; }
+
+    // Read the next field tag. Returns false at end of input or on a bad tag.
+    bool next(uint32_t& field, uint32_t& wire_type) {
+        uint64_t tag;
+        if (done() || !read_varint(tag) || (tag >> 3) == 0) return false;
+        field = static_cast<uint32_t>(tag >> 3);
+        wire_type = static_cast<uint32_t>(tag & 7);
+        return true;
+    }
+
+    bool read_varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && p_ < end_; shift += 7) {
+            uint8_t byte = *p_++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    // uint32 fields: protobuf keeps the low 32 bits of a longer varint
+    bool read_uint32(uint32_t& value) {
+        uint64_t v;
+        if (!read_varint(v)) return false;
+        value = static_cast<uint32_t>(v);
+        return true;
+    }
+
+    bool read_bytes(std::string_view& value) {
+        uint64_t len;
+        if (!read_varint(len) || len > static_cast<uint64_t>(end_ - p_)) return false;
+        value = std::string_view(reinterpret_cast<const char*>(p_), static_cast<size_t>(len));
+        p_ += len;
+        return true;
+    }
+
+    bool skip(uint32_t wire_type) {
+        uint64_t ignored;
+        std::string_view ignored_bytes;
+        switch (wire_type) {
+            case VARINT: return read_varint(ignored);
+            case LENGTH_DELIMITED: return read_bytes(ignored_bytes);
+            case FIXED64: return advance(8);
+            case FIXED32: return advance(4);
+            default: return false;  // groups are not used by lineairdb.proto
+        }
+    }
+
+private:
+    bool advance(size_t n) {
+        if (static_cast<size_t>(end_ - p_) < n) return false;
+        p_ += n;
+        return true;
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+};
+
+}  // namespace Wire
+
+// TxRead::Request and TxDelete::Request share their layout:
+// transaction_id = 1, key = 2, table_name = 4, table_id = 14
+struct KeyRequestView {
+    int64_t transaction_id = 0;
+    std::string_view key;
+    std::string_view table_name;
+    uint32_t table_id = 0;
+
+    bool parse(std::string_view data) {
+        Wire::Reader reader(data);
+        uint32_t field, wire_type;
+        while (reader.next(field, wire_type)) {
+            bool ok;
+            if (field == 1 && wire_type == Wire::VARINT) {
+                uint64_t v;
+                ok = reader.read_varint(v);
+                transaction_id = static_cast<int64_t>(v);
+            } else if (field == 2 && wire_type == Wire::LENGTH_DELIMITED) {
+                ok = reader.read_bytes(key);
+            } else if (field == 4 && wire_type == Wire::LENGTH_DELIMITED) {
+                ok = reader.read_bytes(table_name);
+            } else if (field == 14 && wire_type == Wire::VARINT) {
+                ok = reader.read_uint32(table_id);
+            } else {
+                ok = reader.skip(wire_type);
+            }
+            if (!ok) return false;
+        }
+        return reader.done();
+    }
+};
+
+// TxWrite::Request: transaction_id = 1, key = 2, value = 3, table_name = 5,
+// table_id = 14
+struct WriteRequestView {
+    int64_t transaction_id = 0;
+    std::string_view key;
+    std::string_view value;
+    std::string_view table_name;
+    uint32_t table_id = 0;
+
+    bool parse(std::string_view data) {
+        Wire::Reader reader(data);
+        uint32_t field, wire_type;
+        while (reader.next(field, wire_type)) {
+            bool ok;
+            if (field == 1 && wire_type == Wire::VARINT) {
+                uint64_t v;
+                ok = reader.read_varint(v);
+                transaction_id = static_cast<int64_t>(v);
+            } else if (field == 2 && wire_type == Wire::LENGTH_DELIMITED) {
+                ok = reader.read_bytes(key);
+            } else if (field == 3 && wire_type == Wire::LENGTH_DELIMITED) {
+                ok = reader.read_bytes(value);
+            } else if (field == 5 && wire_type == Wire::LENGTH_DELIMITED) {
+                ok = reader.read_bytes(table_name);
+            } else if (field == 14 && wire_type == Wire::VARINT) {
+                ok = reader.read_uint32(table_id);
+            } else {
+                ok = reader.skip(wire_type);
+            }
+            if (!ok) return false;
+        }
+        return reader.done();
+    }
+};
+
+// TxBatchWrite::Request: transaction_id = 1, table_name = 2,
+// repeated WriteOp writes = 3 {key = 1, value = 2},
+// repeated SecondaryIndexOp secondary_index_writes = 4
+//     {index_name = 1, secondary_key = 2, primary_key = 3, index_id = 4},
+// table_id = 14
+//
+// parse() validates the whole message and picks up the scalar fields; the
+// repeated ops are then walked in place with for_each_write() and
+// for_each_secondary_index_write(), so a batch of N rows costs no allocation.
+struct BatchWriteRequestView {
+    int64_t transaction_id = 0;
+    std::string_view table_name;
+    uint32_t table_id = 0;
+
+    bool parse(std::string_view data) {
+        data_ = data;
+        Wire::Reader reader(data);
+        uint32_t field, wire_type;
+        while (reader.next(field, wire_type)) {
+            bool ok;
+            std::string_view op;
+            if (field == 1 && wire_type == Wire::VARINT) {
+                uint64_t v;
+                ok = reader.read_varint(v);
+                transaction_id = static_cast<int64_t>(v);
+            } else if (field == 2 && wire_type == Wire::LENGTH_DELIMITED) {
+                ok = reader.read_bytes(table_name);
+            } else if (field == 3 && wire_type == Wire::LENGTH_DELIMITED) {
+                std::string_view key, value;
+                ok = reader.read_bytes(op) && parse_op(op, key, value);
+            } else if (field == 4 && wire_type == Wire::LENGTH_DELIMITED) {
+                uint32_t index_id;
+                std::string_view index_name, secondary_key, primary_key;
+                ok = reader.read_bytes(op) &&
+                     parse_index_op(op, index_id, index_name, secondary_key, primary_key);
+            } else if (field == 14 && wire_type == Wire::VARINT) {
+                ok = reader.read_uint32(table_id);
+            } else {
+                ok = reader.skip(wire_type);
+            }
+            if (!ok) return false;
+        }
+        return reader.done();
+    }
+
+    // fn(key, value) -> bool; returning false stops the walk.
+    template <typename Fn>
+    void for_each_write(Fn&& fn) const {
+        for_each_op(3, [&fn](std::string_view op) {
+            std::string_view key, value;
+            parse_op(op, key, value);
+            return fn(key, value);
+        });
+    }
+
+    // fn(index_id, index_name, secondary_key, primary_key) -> bool
+    template <typename Fn>
+    void for_each_secondary_index_write(Fn&& fn) const {
+        for_each_op(4, [&fn](std::string_view op) {
+            uint32_t index_id;
+            std::string_view index_name, secondary_key, primary_key;
+            parse_index_op(op, index_id, index_name, secondary_key, primary_key);
+            return fn(index_id, index_name, secondary_key, primary_key);
+        });
+    }
+
+private:
+    template <typename Fn>
+    void for_each_op(uint32_t op_field, Fn&& fn) const {
+        Wire::Reader reader(data_);
+        uint32_t field, wire_type;
+        while (reader.next(field, wire_type)) {
+            if (field == op_field && wire_type == Wire::LENGTH_DELIMITED) {
+                std::string_view op;
+                if (!reader.read_bytes(op) || !fn(op)) return;
+            } else if (!reader.skip(wire_type)) {
+                return;
+            }
+        }
+    }
+
+    // Decode the length-delimited fields 1..N of a nested op into out[0..N).
+    template <typename... Out>
+    static bool parse_op(std::string_view op, Out&... out) {
+        std::string_view* fields[] = {&out...};
+        Wire::Reader reader(op);
+        uint32_t field, wire_type;
+        while (reader.next(field, wire_type)) {
+            bool ok = field <= sizeof...(Out) && wire_type == Wire::LENGTH_DELIMITED
+                          ? reader.read_bytes(*fields[field - 1])
+                          : reader.skip(wire_type);
+            if (!ok) return false;
+        }
+        return reader.done();
+    }
+
+    // SecondaryIndexOp: the length-delimited fields plus index_id = 4
+    static bool parse_index_op(std::string_view op, uint32_t& index_id, std::string_view& index_name,
+                               std::string_view& secondary_key, std::string_view& primary_key) {
+        std::string_view* fields[] = {&index_name, &secondary_key, &primary_key};
+        index_id = 0;
+        Wire::Reader reader(op);
+        uint32_t field, wire_type;
+        while (reader.next(field, wire_type)) {
+            bool ok;
+            if (field <= 3 && wire_type == Wire::LENGTH_DELIMITED) {
+                ok = reader.read_bytes(*fields[field - 1]);
+            } else if (field == 4 && wire_type == Wire::VARINT) {
+                ok = reader.read_uint32(index_id);
+            } else {
+                ok = reader.skip(wire_type);
+            }
+            if (!ok) return false;
+        }
+        return reader.done();
+    }
+
+    std::string_view data_;
+};
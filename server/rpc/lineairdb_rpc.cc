@@ -1,118 +1,372 @@
 #include "lineairdb_rpc.hh"
 #include "predicate_evaluator.hh"
 #include "../../common/log.h"
+#include "../../common/point_codec.h"
+#include "../../common/scan_codec.h"
 
+#include <condition_variable>
 #include <iostream>
 #include <vector>
 #include <cstring>
 
 #include "lineairdb.pb.h"
+#include "../protocol/request_view.hh"
+
+namespace {
+// The connection's own block backs the arena, so an RPC whose messages fit in
+// it never reaches malloc; larger ones spill into blocks freed on Reset()
+google::protobuf::ArenaOptions arena_options(char* initial_block) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = initial_block;
+    options.initial_block_size = LineairDBRpc::kArenaBlockSize;
+    options.max_block_size = LineairDBRpc::kArenaBlockSize;
+    return options;
+}
+
+// Parse straight from the connection's receive buffer without an extra copy
+template <typename Request>
+bool parse_request(std::string_view message, Request& request) {
+    return request.ParseFromArray(message.data(), static_cast<int>(message.size()));
+}
+}  // namespace
+
+void CommitSignal::complete() {
+    std::function<void()> then;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+        then.swap(then_);
+    }
+    cv_.notify_all();
+    if (then) {
+        then();
+    }
+}
+
+void CommitSignal::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return done_; });
+}
+
+void CommitSignal::on_done(std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!done_) {
+            then_ = std::move(fn);
+            return;
+        }
+    }
+    fn();
+}
 
 LineairDBRpc::LineairDBRpc(std::shared_ptr<DatabaseManager> db_manager,
                            std::shared_ptr<TransactionManager> tx_manager,
-                           std::shared_ptr<TableRowCounts> row_counts)
-    : db_manager_(db_manager), tx_manager_(tx_manager), row_counts_(row_counts) {
+                           std::shared_ptr<TableRowCounts> row_counts,
+                           std::shared_ptr<TableHandles> handles)
+    : db_manager_(db_manager), tx_manager_(tx_manager), row_counts_(row_counts),
+      handles_(handles), arena_block_(new char[kArenaBlockSize]),
+      arena_(arena_options(arena_block_.get())) {
+}
+
+void LineairDBRpc::set_protocol_version(uint32_t protocol_version) {
+    front_coded_keys_ = protocol_version >= Rpc::kFrontCodedKeysVersion;
 }
 
 void LineairDBRpc::handle_rpc(uint64_t sender_id, MessageType message_type,
-                             const std::string& message, std::string& result) {
+                             std::string_view message, std::string& result) {
     LOG_DEBUG("Handling RPC: message_type=%u", static_cast<uint32_t>(message_type));
 
     switch(message_type) {
         // Transaction lifecycle
         case MessageType::TX_BEGIN_TRANSACTION:
             handleTxBeginTransaction(message, result);
-            return;
+            break;
         case MessageType::TX_ABORT:
             handleTxAbort(message, result);
-            return;
+            break;
 
         // Primary key operations
         case MessageType::TX_READ:
             handleTxRead(message, result);
-            return;
+            break;
         case MessageType::TX_BATCH_READ:
             handleTxBatchRead(message, result);
-            return;
+            break;
         case MessageType::TX_BATCH_WRITE:
             handleTxBatchWrite(message, result);
-            return;
+            break;
         case MessageType::TX_WRITE:
             handleTxWrite(message, result);
-            return;
+            break;
         case MessageType::TX_DELETE:
             handleTxDelete(message, result);
-            return;
+            break;
 
         // Secondary index operations
         case MessageType::TX_READ_SECONDARY_INDEX:
             handleTxReadSecondaryIndex(message, result);
-            return;
+            break;
         case MessageType::TX_WRITE_SECONDARY_INDEX:
             handleTxWriteSecondaryIndex(message, result);
-            return;
+            break;
         case MessageType::TX_DELETE_SECONDARY_INDEX:
             handleTxDeleteSecondaryIndex(message, result);
-            return;
+            break;
         case MessageType::TX_UPDATE_SECONDARY_INDEX:
             handleTxUpdateSecondaryIndex(message, result);
-            return;
+            break;
 
         // Primary key scan operations
         case MessageType::TX_GET_MATCHING_KEYS_IN_RANGE:
             handleTxGetMatchingKeysInRange(message, result);
-            return;
+            break;
         case MessageType::TX_GET_MATCHING_KEYS_AND_VALUES_IN_RANGE:
             handleTxGetMatchingKeysAndValuesInRange(message, result);
-            return;
+            break;
         case MessageType::TX_GET_MATCHING_KEYS_AND_VALUES_FROM_PREFIX:
             handleTxGetMatchingKeysAndValuesFromPrefix(message, result);
-            return;
+            break;
         case MessageType::TX_FETCH_LAST_KEY_IN_RANGE:
             handleTxFetchLastKeyInRange(message, result);
-            return;
+            break;
         case MessageType::TX_FETCH_FIRST_KEY_WITH_PREFIX:
             handleTxFetchFirstKeyWithPrefix(message, result);
-            return;
+            break;
         case MessageType::TX_FETCH_NEXT_KEY_WITH_PREFIX:
             handleTxFetchNextKeyWithPrefix(message, result);
-            return;
+            break;
 
         // Secondary index scan operations
         case MessageType::TX_GET_MATCHING_PRIMARY_KEYS_IN_RANGE:
             handleTxGetMatchingPrimaryKeysInRange(message, result);
-            return;
+            break;
         case MessageType::TX_GET_MATCHING_PRIMARY_KEYS_FROM_PREFIX:
             handleTxGetMatchingPrimaryKeysFromPrefix(message, result);
-            return;
+            break;
         case MessageType::TX_FETCH_LAST_PRIMARY_KEY_IN_SECONDARY_RANGE:
             handleTxFetchLastPrimaryKeyInSecondaryRange(message, result);
-            return;
+            break;
         case MessageType::TX_FETCH_LAST_SECONDARY_ENTRY_IN_RANGE:
             handleTxFetchLastSecondaryEntryInRange(message, result);
-            return;
+            break;
 
         // Database operations
         case MessageType::DB_FENCE:
             handleDbFence(message, result);
-            return;
+            break;
         case MessageType::DB_END_TRANSACTION:
             handleDbEndTransaction(message, result);
-            return;
+            break;
         case MessageType::DB_CREATE_TABLE:
             handleDbCreateTable(message, result);
-            return;
+            break;
         case MessageType::DB_SET_TABLE:
             handleDbSetTable(message, result);
-            return;
+            break;
         case MessageType::DB_CREATE_SECONDARY_INDEX:
             handleDbCreateSecondaryIndex(message, result);
-            return;
+            break;
+        case MessageType::DB_RESOLVE_HANDLES:
+            handleDbResolveHandles(message, result);
+            break;
+
+        // Heterogeneous batch
+        case MessageType::TX_MULTI:
+            handleTxMulti(message, result);
+            break;
 
         default:
             LOG_ERROR("Unknown message type: %u", static_cast<uint32_t>(message_type));
+            break;
+    }
+
+    // The messages are serialized into result by now; drop them all at once
+    arena_.Reset();
+}
+
+// Same semantics as the protobuf handlers of these opcodes; only the
+// encoding differs. Keys and values stay string_views into the receive buffer.
+void LineairDBRpc::handle_binary_rpc(MessageType message_type, std::string_view message,
+                                     std::string& result) {
+    result.clear();
+    if (message_type == MessageType::TX_BATCH_READ) {
+        handleBinaryBatchRead(message, result);
+        return;
+    }
+
+    Rpc::PointRequestView request;
+    if (!request.parse(message, static_cast<uint32_t>(message_type))) {
+        LOG_WARNING("Malformed binary request: message_type=%u (%zu bytes)",
+                    static_cast<uint32_t>(message_type), message.size());
+        result.push_back(static_cast<char>(Rpc::kAborted));
+        return;
+    }
+
+    int64_t tx_id = request.transaction_id;
+    auto* tx = tx_manager_->get_transaction(tx_id);
+    if (!tx) {
+        LOG_WARNING("Transaction not found for binary message_type=%u: %ld",
+                    static_cast<uint32_t>(message_type), tx_id);
+        result.push_back(static_cast<char>(Rpc::kAborted));
+        if (message_type == MessageType::TX_READ_SECONDARY_INDEX) {
+            Rpc::append_u32(result, 0);
+        }
+        return;
+    }
+    select_table(tx, tx_id, request.table_id, request.table_name);
+
+    auto& f = request.fields;
+    if (Rpc::point_has_index(static_cast<uint32_t>(message_type))) {
+        f[0] = select_index(tx, request.index_id, f[0]);
+    }
+    auto as_bytes = [](std::string_view s) { return reinterpret_cast<const std::byte*>(s.data()); };
+    RedoLog::WriteSet* writes = write_set(tx_id);
+    uint8_t flags = 0;
+    switch (message_type) {
+        case MessageType::TX_READ: {
+            auto read_result = tx->Read(f[0]);
+            if (read_result.first != nullptr) flags |= Rpc::kFound;
+            if (tx->IsAborted()) flags |= Rpc::kAborted;
+            result.push_back(static_cast<char>(flags));
+            if (read_result.first != nullptr) {
+                Rpc::append_bytes(result, std::string_view(reinterpret_cast<const char*>(read_result.first),
+                                                           read_result.second));
+            }
             return;
+        }
+        case MessageType::TX_READ_SECONDARY_INDEX: {
+            auto values = tx->ReadSecondaryIndex(f[0], f[1]);
+            result.push_back(static_cast<char>(tx->IsAborted() ? Rpc::kAborted : 0));
+            Rpc::append_u32(result, static_cast<uint32_t>(values.size()));
+            for (const auto& [ptr, size] : values) {
+                Rpc::append_bytes(result, std::string_view(reinterpret_cast<const char*>(ptr), size));
+            }
+            return;
+        }
+        case MessageType::TX_WRITE:
+            tx->Write(f[0], as_bytes(f[1]), f[1].size());
+            if (writes) writes->put(f[0], f[1]);
+            break;
+        case MessageType::TX_DELETE:
+            tx->Delete(f[0]);
+            if (writes) writes->erase(f[0]);
+            break;
+        case MessageType::TX_WRITE_SECONDARY_INDEX:
+            tx->WriteSecondaryIndex(f[0], f[1], as_bytes(f[2]), f[2].size());
+            if (writes) writes->add_entry(f[0], f[1], f[2]);
+            break;
+        case MessageType::TX_DELETE_SECONDARY_INDEX:
+            tx->DeleteSecondaryIndex(f[0], f[1], as_bytes(f[2]), f[2].size());
+            if (writes) writes->remove_entry(f[0], f[1], f[2]);
+            break;
+        case MessageType::TX_UPDATE_SECONDARY_INDEX:
+            tx->UpdateSecondaryIndex(f[0], f[1], f[2], as_bytes(f[3]), f[3].size());
+            if (writes) {
+                writes->remove_entry(f[0], f[1], f[3]);
+                writes->add_entry(f[0], f[2], f[3]);
+            }
+            break;
+        default:
+            break;  // unreachable: parse() rejected it
+    }
+    result.push_back(static_cast<char>(tx->IsAborted() ? Rpc::kAborted : Rpc::kFound));
+}
+
+// Flat TX_BATCH_READ: one [found][len][value] entry per key, in key order
+void LineairDBRpc::handleBinaryBatchRead(std::string_view message, std::string& result) {
+    Rpc::BatchReadRequestView request;
+    if (!request.parse(message)) {
+        LOG_WARNING("Malformed binary batch_read request (%zu bytes)", message.size());
+        result.push_back(static_cast<char>(Rpc::kAborted));
+        Rpc::append_u32(result, 0);
+        return;
+    }
+
+    int64_t tx_id = request.transaction_id;
+    auto* tx = tx_manager_->get_transaction(tx_id);
+    if (!tx) {
+        LOG_WARNING("Transaction not found for batch_read: %ld", tx_id);
+        result.push_back(static_cast<char>(Rpc::kAborted));
+        Rpc::append_u32(result, 0);
+        return;
+    }
+    select_table(tx, tx_id, request.table_id, request.table_name);
+
+    result.push_back(0);  // flags placeholder, set once every key is read
+    Rpc::append_u32(result, request.count);
+    request.for_each_key([&](std::string_view key) {
+        auto read_result = tx->Read(key);
+        result.push_back(read_result.first != nullptr ? 1 : 0);
+        Rpc::append_bytes(result, read_result.first != nullptr
+                                      ? std::string_view(reinterpret_cast<const char*>(read_result.first),
+                                                         read_result.second)
+                                      : std::string_view());
+    });
+    result[0] = static_cast<char>(tx->IsAborted() ? Rpc::kAborted : 0);
+}
+
+void LineairDBRpc::select_table(LineairDB::Transaction* tx, int64_t tx_id, uint32_t table_id,
+                                std::string_view table_name) {
+    if (table_id == 0) {
+        if (!table_name.empty()) {
+            tx->SetTable(table_name);
+            selected_tx_id_ = -1;
+            if (auto* writes = write_set(tx_id)) writes->set_table(table_name);
+        }
+        return;
+    }
+    if (tx_id == selected_tx_id_ && table_id == selected_table_id_) {
+        return;
+    }
+
+    if (table_id >= table_names_.size()) {
+        table_names_.resize(table_id + 1, nullptr);
+    }
+    const std::string*& name = table_names_[table_id];
+    if (!name) {
+        name = handles_->table_name(table_id);
     }
+    if (!name) {
+        LOG_WARNING("Unknown table handle %u, aborting tx=%ld", table_id, tx_id);
+        tx->Abort();
+        return;
+    }
+    if (tx->SetTable(*name)) {
+        selected_tx_id_ = tx_id;
+        selected_table_id_ = table_id;
+    }
+    if (auto* writes = write_set(tx_id)) writes->set_table(*name);
+}
+
+RedoLog::WriteSet* LineairDBRpc::write_set(int64_t tx_id) {
+    if (!db_manager_->redo_log()) {
+        return nullptr;
+    }
+    if (tx_id != write_set_tx_id_) {
+        write_set_ = &write_sets_[tx_id];
+        write_set_tx_id_ = tx_id;
+    }
+    return write_set_;
+}
+
+std::string_view LineairDBRpc::select_index(LineairDB::Transaction* tx, uint32_t index_id,
+                                            std::string_view index_name) {
+    if (index_id == 0) {
+        return index_name;
+    }
+    if (index_id >= indexes_.size()) {
+        indexes_.resize(index_id + 1, nullptr);
+    }
+    const TableHandles::Index*& index = indexes_[index_id];
+    if (!index) {
+        index = handles_->index_entry(index_id);
+    }
+    if (!index) {
+        LOG_WARNING("Unknown index handle %u, aborting transaction", index_id);
+        tx->Abort();
+        return {};
+    }
+    return index->name;
 }
 
 bool LineairDBRpc::key_prefix_is_matching(const std::string& key_prefix, const std::string& key) {
@@ -120,39 +374,99 @@ bool LineairDBRpc::key_prefix_is_matching(const std::string& key_prefix, const s
     return true;
 }
 
-void LineairDBRpc::handleTxBeginTransaction(const std::string& message, std::string& result) {
-    LOG_DEBUG("Handling TxBeginTransaction");
+template <typename Response>
+void LineairDBRpc::add_table_stats(uint64_t since_version, Response& response) {
+    bool full = false;
+    uint64_t version = row_counts_->changes_since(
+        since_version, full, [&response](const std::string& name, int64_t count) {
+            auto* ts = response.add_table_stats();
+            ts->set_table_name(name);
+            ts->set_row_count(count);
+        });
+    response.set_stats_version(version);
+    response.set_stats_full(full);
+}
 
-    LineairDB::Protocol::TxBeginTransaction::Request request;
-    LineairDB::Protocol::TxBeginTransaction::Response response;
+int64_t LineairDBRpc::begin_transaction(LineairDB::Transaction*& tx) {
+    tx = &db_manager_->get_database()->BeginTransaction();
+    int64_t tx_id = tx_manager_->generate_tx_id();
+    tx_manager_->store_transaction(tx_id, tx);
+    return tx_id;
+}
 
-    request.ParseFromString(message);
+template <typename RowDeltas>
+bool LineairDBRpc::end_transaction(LineairDB::Transaction* tx, int64_t tx_id, bool fence,
+                                   const RowDeltas& row_deltas) {
+    auto& db = *db_manager_->get_database();
+    RedoLog* redo_log = db_manager_->redo_log();
+    // Wait for this transaction's own group commit: LineairDB's, or with a
+    // durable redo log the flush of its record. Database::Fence() would also
+    // wait for every other connection's transactions.
+    bool log_fence = fence && redo_log && redo_log->durable();
+    std::shared_ptr<CommitSignal> signal;
+    if (fence) {
+        signal = std::make_shared<CommitSignal>();
+    }
+    auto callback = [signal = log_fence ? nullptr : signal, tx_id](LineairDB::TxStatus status) {
+        LOG_DEBUG("Transaction %ld ended with status: %d", tx_id, static_cast<int>(status));
+        if (signal) signal->complete();
+    };
+    bool committed;
+    if (redo_log) {
+        RedoLog::Commit commit(*redo_log, *write_set(tx_id));
+        committed = db.EndTransaction(*tx, callback);
+        uint64_t lsn = commit.log(committed);
+        if (log_fence && committed) {
+            redo_log->when_durable(lsn, [signal] { signal->complete(); });
+        }
+        write_sets_.erase(tx_id);
+        write_set_tx_id_ = -1;
+    } else {
+        committed = db.EndTransaction(*tx, callback);
+    }
+    if (fence && committed && async_fence_) {
+        durable_wait_ = std::move(signal);
+    } else if (fence && committed) {
+        signal->wait();
+    }
+    tx_manager_->remove_transaction(tx_id);
 
-    auto& tx = db_manager_->get_database()->BeginTransaction();
-    int64_t tx_id = tx_manager_->generate_tx_id();
-    tx_manager_->store_transaction(tx_id, &tx);
+    // Apply row-count deltas on successful commit
+    if (committed && row_deltas.size() > 0) {
+        row_counts_->apply_deltas(row_deltas);
+    }
 
+    LOG_DEBUG("Ended transaction %ld with fence=%s (committed=%s)", tx_id, fence ? "true" : "false", committed ? "true" : "false");
+    return committed;
+}
+
+void LineairDBRpc::handleTxBeginTransaction(std::string_view message, std::string& result) {
+    LOG_DEBUG("Handling TxBeginTransaction");
+
+    auto& request = arena_message<LineairDB::Protocol::TxBeginTransaction::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxBeginTransaction::Response>();
+
+    parse_request(message, request);
+
+    LineairDB::Transaction* tx;
+    int64_t tx_id = begin_transaction(tx);
     response.set_transaction_id(tx_id);
 
-    // Piggyback current table row counts so proxy has fresh stats.
-    for (const auto& [name, count] : row_counts_->snapshot()) {
-        auto* ts = response.add_table_stats();
-        ts->set_table_name(name);
-        ts->set_row_count(count);
-    }
+    // Piggyback the row counts the proxy has not seen yet.
+    add_table_stats(request.stats_version(), response);
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 
     LOG_DEBUG("Created transaction: %ld", tx_id);
 }
 
-void LineairDBRpc::handleTxAbort(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxAbort(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxAbort");
 
-    LineairDB::Protocol::TxAbort::Request request;
-    LineairDB::Protocol::TxAbort::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxAbort::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxAbort::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
@@ -162,56 +476,55 @@ void LineairDBRpc::handleTxAbort(const std::string& message, std::string& result
         LOG_WARNING("Transaction not found for abort: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxRead(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxRead(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxRead");
 
-    LineairDB::Protocol::TxRead::Request request;
-    LineairDB::Protocol::TxRead::Response response;
+    KeyRequestView request;
+    auto& response = arena_message<LineairDB::Protocol::TxRead::Response>();
 
-    request.ParseFromString(message);
+    if (!request.parse(message)) {
+        LOG_WARNING("Malformed TxRead request (%zu bytes)", message.size());
+        request = KeyRequestView{};  // transaction 0 never exists, so this fails cleanly
+    }
 
-    int64_t tx_id = request.transaction_id();
+    int64_t tx_id = request.transaction_id;
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        auto read_result = tx->Read(request.key());
+        select_table(tx, tx_id, request.table_id, request.table_name);
+        auto read_result = tx->Read(request.key);
         response.set_is_aborted(tx->IsAborted());
 
         if (read_result.first != nullptr) {
             response.set_found(true);
-            std::string value(reinterpret_cast<const char*>(read_result.first), read_result.second);
-            response.set_value(value);
+            response.set_value(reinterpret_cast<const char*>(read_result.first), read_result.second);
         } else {
             response.set_found(false);
         }
 
-        LOG_DEBUG("Read key '%s' from transaction %ld: %s", request.key().c_str(), tx_id, (read_result.first != nullptr ? "found" : "not found"));
+        LOG_DEBUG("Read key '%.*s' from transaction %ld: %s", static_cast<int>(request.key.size()),
+                  request.key.data(), tx_id, (read_result.first != nullptr ? "found" : "not found"));
     } else {
         response.set_found(false);
         response.set_is_aborted(true);
         LOG_WARNING("Transaction not found for read: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxBatchRead(const std::string& message, std::string& result) {
-    LineairDB::Protocol::TxBatchRead::Request request;
-    LineairDB::Protocol::TxBatchRead::Response response;
+void LineairDBRpc::handleTxBatchRead(std::string_view message, std::string& result) {
+    auto& request = arena_message<LineairDB::Protocol::TxBatchRead::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxBatchRead::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
+        select_table(tx, tx_id, request.table_id(), request.table_name());
         for (int i = 0; i < request.keys_size(); i++) {
             auto* read_result = response.add_results();
             auto pair = tx->Read(request.keys(i));
@@ -229,37 +542,46 @@ void LineairDBRpc::handleTxBatchRead(const std::string& message, std::string& re
         LOG_WARNING("Transaction not found for batch_read: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxBatchWrite(const std::string& message, std::string& result) {
-    LineairDB::Protocol::TxBatchWrite::Request request;
-    LineairDB::Protocol::TxBatchWrite::Response response;
+void LineairDBRpc::handleTxBatchWrite(std::string_view message, std::string& result) {
+    BatchWriteRequestView request;
+    auto& response = arena_message<LineairDB::Protocol::TxBatchWrite::Response>();
 
-    request.ParseFromString(message);
+    if (!request.parse(message)) {
+        // Apply nothing from a torn batch; tx_id may be unset anyway
+        LOG_WARNING("Malformed TxBatchWrite request (%zu bytes)", message.size());
+        response.set_success(false);
+        response.set_is_aborted(true);
+        response.SerializeToString(&result);
+        return;
+    }
 
-    int64_t tx_id = request.transaction_id();
+    int64_t tx_id = request.transaction_id;
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
+        select_table(tx, tx_id, request.table_id, request.table_name);
 
-        for (int i = 0; i < request.writes_size(); i++) {
-            const auto& op = request.writes(i);
-            const std::string& value_str = op.value();
-            tx->Write(op.key(), reinterpret_cast<const std::byte*>(value_str.c_str()), value_str.size());
-            if (tx->IsAborted()) break;
-        }
+        // Keys and values go to LineairDB straight out of the receive buffer
+        RedoLog::WriteSet* writes = write_set(tx_id);
+        request.for_each_write([tx, writes](std::string_view key, std::string_view value) {
+            tx->Write(key, reinterpret_cast<const std::byte*>(value.data()), value.size());
+            if (writes) writes->put(key, value);
+            return !tx->IsAborted();
+        });
 
         if (!tx->IsAborted()) {
-            for (int i = 0; i < request.secondary_index_writes_size(); i++) {
-                const auto& si = request.secondary_index_writes(i);
-                const std::string& pk = si.primary_key();
-                tx->WriteSecondaryIndex(si.index_name(), si.secondary_key(),
-                                        reinterpret_cast<const std::byte*>(pk.c_str()), pk.size());
-                if (tx->IsAborted()) break;
-            }
+            request.for_each_secondary_index_write(
+                [this, tx, writes](uint32_t index_id, std::string_view index_name,
+                                   std::string_view secondary_key, std::string_view primary_key) {
+                    std::string_view index = select_index(tx, index_id, index_name);
+                    tx->WriteSecondaryIndex(index, secondary_key,
+                                            reinterpret_cast<const std::byte*>(primary_key.data()),
+                                            primary_key.size());
+                    if (writes) writes->add_entry(index, secondary_key, primary_key);
+                    return !tx->IsAborted();
+                });
         }
 
         response.set_success(!tx->IsAborted());
@@ -270,112 +592,219 @@ void LineairDBRpc::handleTxBatchWrite(const std::string& message, std::string& r
         LOG_WARNING("Transaction not found for batch_write: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxWrite(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxWrite(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxWrite");
 
-    LineairDB::Protocol::TxWrite::Request request;
-    LineairDB::Protocol::TxWrite::Response response;
+    WriteRequestView request;
+    auto& response = arena_message<LineairDB::Protocol::TxWrite::Response>();
 
-    request.ParseFromString(message);
+    if (!request.parse(message)) {
+        LOG_WARNING("Malformed TxWrite request (%zu bytes)", message.size());
+        request = WriteRequestView{};  // transaction 0 never exists, so this fails cleanly
+    }
 
-    int64_t tx_id = request.transaction_id();
+    int64_t tx_id = request.transaction_id;
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        const std::string& value_str = request.value();
-        tx->Write(request.key(), reinterpret_cast<const std::byte*>(value_str.c_str()), value_str.size());
+        select_table(tx, tx_id, request.table_id, request.table_name);
+        tx->Write(request.key, reinterpret_cast<const std::byte*>(request.value.data()),
+                  request.value.size());
+        if (auto* writes = write_set(tx_id)) writes->put(request.key, request.value);
         response.set_is_aborted(tx->IsAborted());
         response.set_success(!tx->IsAborted());
-        LOG_DEBUG("Wrote key '%s' to transaction %ld", request.key().c_str(), tx_id);
+        LOG_DEBUG("Wrote key '%.*s' to transaction %ld", static_cast<int>(request.key.size()),
+                  request.key.data(), tx_id);
     } else {
         response.set_success(false);
         response.set_is_aborted(true);
         LOG_WARNING("Transaction not found for write: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxDelete(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxDelete(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxDelete");
 
-    LineairDB::Protocol::TxDelete::Request request;
-    LineairDB::Protocol::TxDelete::Response response;
+    KeyRequestView request;
+    auto& response = arena_message<LineairDB::Protocol::TxDelete::Response>();
 
-    request.ParseFromString(message);
+    if (!request.parse(message)) {
+        LOG_WARNING("Malformed TxDelete request (%zu bytes)", message.size());
+        request = KeyRequestView{};  // transaction 0 never exists, so this fails cleanly
+    }
 
-    int64_t tx_id = request.transaction_id();
+    int64_t tx_id = request.transaction_id;
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        tx->Delete(request.key());
+        select_table(tx, tx_id, request.table_id, request.table_name);
+        tx->Delete(request.key);
+        if (auto* writes = write_set(tx_id)) writes->erase(request.key);
         response.set_is_aborted(tx->IsAborted());
         response.set_success(!tx->IsAborted());
-        LOG_DEBUG("Deleted key '%s' from transaction %ld", request.key().c_str(), tx_id);
+        LOG_DEBUG("Deleted key '%.*s' from transaction %ld", static_cast<int>(request.key.size()),
+                  request.key.data(), tx_id);
     } else {
         response.set_success(false);
         response.set_is_aborted(true);
         LOG_WARNING("Transaction not found for delete: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
+}
+
+void LineairDBRpc::handleTxMulti(std::string_view message, std::string& result) {
+    using Multi = LineairDB::Protocol::TxMulti;
+    auto& request = arena_message<Multi::Request>();
+    auto& response = arena_message<Multi::Response>();
+
+    parse_request(message, request);
+
+    int64_t tx_id = request.transaction_id();
+    LineairDB::Transaction* tx;
+    if (tx_id == 0) {
+        tx_id = begin_transaction(tx);
+        response.set_transaction_id(tx_id);
+    } else {
+        tx = tx_manager_->get_transaction(tx_id);
+    }
+    if (!tx) {
+        response.set_is_aborted(true);
+        LOG_WARNING("Transaction not found for multi: %ld", tx_id);
+        if (request.commit()) {
+            add_table_stats(request.stats_version(), response);
+        }
+        response.SerializeToString(&result);
+        return;
+    }
+
+    RedoLog::WriteSet* writes = write_set(tx_id);
+    for (const auto& op : request.ops()) {
+        auto* op_result = response.add_results();
+        select_table(tx, tx_id, op.table_id(), op.table_name());
+        if (tx->IsAborted()) break;
+        const std::string& key = op.key();
+        const auto* primary_key = reinterpret_cast<const std::byte*>(key.data());
+
+        switch (op.kind()) {
+            case Multi::OP_READ: {
+                auto read_result = tx->Read(key);
+                if (read_result.first != nullptr) {
+                    op_result->set_found(true);
+                    op_result->set_value(reinterpret_cast<const char*>(read_result.first),
+                                         read_result.second);
+                }
+                break;
+            }
+            case Multi::OP_WRITE:
+                tx->Write(key, reinterpret_cast<const std::byte*>(op.value().data()), op.value().size());
+                if (writes) writes->put(key, op.value());
+                break;
+            case Multi::OP_DELETE:
+                tx->Delete(key);
+                if (writes) writes->erase(key);
+                break;
+            case Multi::OP_READ_SECONDARY_INDEX:
+                for (const auto& [ptr, size] : tx->ReadSecondaryIndex(
+                         select_index(tx, op.index_id(), op.index_name()), op.secondary_key())) {
+                    op_result->add_values(reinterpret_cast<const char*>(ptr), size);
+                }
+                break;
+            case Multi::OP_WRITE_SECONDARY_INDEX: {
+                std::string_view index = select_index(tx, op.index_id(), op.index_name());
+                tx->WriteSecondaryIndex(index, op.secondary_key(), primary_key, key.size());
+                if (writes) writes->add_entry(index, op.secondary_key(), key);
+                break;
+            }
+            case Multi::OP_DELETE_SECONDARY_INDEX: {
+                std::string_view index = select_index(tx, op.index_id(), op.index_name());
+                tx->DeleteSecondaryIndex(index, op.secondary_key(), primary_key, key.size());
+                if (writes) writes->remove_entry(index, op.secondary_key(), key);
+                break;
+            }
+            case Multi::OP_UPDATE_SECONDARY_INDEX: {
+                std::string_view index = select_index(tx, op.index_id(), op.index_name());
+                tx->UpdateSecondaryIndex(index, op.secondary_key(), op.new_secondary_key(), primary_key,
+                                         key.size());
+                if (writes) {
+                    writes->remove_entry(index, op.secondary_key(), key);
+                    writes->add_entry(index, op.new_secondary_key(), key);
+                }
+                break;
+            }
+            default:
+                LOG_WARNING("Unknown TxMulti op kind %d, aborting tx=%ld", op.kind(), tx_id);
+                tx->Abort();
+                break;
+        }
+        if (tx->IsAborted()) break;
+    }
+    if (request.commit()) {
+        response.set_is_aborted(!end_transaction(tx, tx_id, request.fence(), request.row_deltas()));
+    } else {
+        response.set_is_aborted(tx->IsAborted());
+    }
+    if (request.commit() || response.transaction_id() != 0) {
+        add_table_stats(request.stats_version(), response);
+    }
+    LOG_DEBUG("Multi tx=%ld: %d of %d ops", tx_id, response.results_size(), request.ops_size());
+
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxReadSecondaryIndex(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxReadSecondaryIndex(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxReadSecondaryIndex");
 
-    LineairDB::Protocol::TxReadSecondaryIndex::Request request;
-    LineairDB::Protocol::TxReadSecondaryIndex::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxReadSecondaryIndex::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxReadSecondaryIndex::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        auto results = tx->ReadSecondaryIndex(request.index_name(), request.secondary_key());
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        std::string_view index_name = select_index(tx, request.index_id(), request.index_name());
+        auto results = tx->ReadSecondaryIndex(index_name, request.secondary_key());
         response.set_is_aborted(tx->IsAborted());
 
         for (const auto& [ptr, size] : results) {
             std::string value(reinterpret_cast<const char*>(ptr), size);
             response.add_values(value);
         }
-        LOG_DEBUG("ReadSecondaryIndex index='%s' key='%s' tx=%ld: %d values",
-                  request.index_name().c_str(), request.secondary_key().c_str(), tx_id, response.values_size());
+        LOG_DEBUG("ReadSecondaryIndex index='%.*s' key='%s' tx=%ld: %d values",
+                  static_cast<int>(index_name.size()), index_name.data(),
+                  request.secondary_key().c_str(), tx_id, response.values_size());
     } else {
         response.set_is_aborted(true);
         LOG_WARNING("Transaction not found for read_secondary_index: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxWriteSecondaryIndex(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxWriteSecondaryIndex(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxWriteSecondaryIndex");
 
-    LineairDB::Protocol::TxWriteSecondaryIndex::Request request;
-    LineairDB::Protocol::TxWriteSecondaryIndex::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxWriteSecondaryIndex::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxWriteSecondaryIndex::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        std::string_view index_name = select_index(tx, request.index_id(), request.index_name());
         const std::string& pk = request.primary_key();
-        tx->WriteSecondaryIndex(request.index_name(), request.secondary_key(),
+        tx->WriteSecondaryIndex(index_name, request.secondary_key(),
                                 reinterpret_cast<const std::byte*>(pk.c_str()), pk.size());
+        if (auto* writes = write_set(tx_id)) {
+            writes->add_entry(index_name, request.secondary_key(), pk);
+        }
         response.set_is_aborted(tx->IsAborted());
         response.set_success(!tx->IsAborted());
     } else {
@@ -384,61 +813,68 @@ void LineairDBRpc::handleTxWriteSecondaryIndex(const std::string& message, std::
         LOG_WARNING("Transaction not found for write_secondary_index: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxDeleteSecondaryIndex(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxDeleteSecondaryIndex(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxDeleteSecondaryIndex");
 
-    LineairDB::Protocol::TxDeleteSecondaryIndex::Request request;
-    LineairDB::Protocol::TxDeleteSecondaryIndex::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxDeleteSecondaryIndex::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxDeleteSecondaryIndex::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        std::string_view index_name = select_index(tx, request.index_id(), request.index_name());
         const std::string& pk = request.primary_key();
-        tx->DeleteSecondaryIndex(request.index_name(), request.secondary_key(),
+        tx->DeleteSecondaryIndex(index_name, request.secondary_key(),
                                  reinterpret_cast<const std::byte*>(pk.c_str()), pk.size());
+        if (auto* writes = write_set(tx_id)) {
+            writes->remove_entry(index_name, request.secondary_key(), pk);
+        }
         response.set_is_aborted(tx->IsAborted());
         response.set_success(!tx->IsAborted());
-        LOG_DEBUG("DeleteSecondaryIndex index='%s' key='%s' tx=%ld",
-                  request.index_name().c_str(), request.secondary_key().c_str(), tx_id);
+        LOG_DEBUG("DeleteSecondaryIndex index='%.*s' key='%s' tx=%ld",
+                  static_cast<int>(index_name.size()), index_name.data(),
+                  request.secondary_key().c_str(), tx_id);
     } else {
         response.set_success(false);
         response.set_is_aborted(true);
         LOG_WARNING("Transaction not found for delete_secondary_index: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxUpdateSecondaryIndex(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxUpdateSecondaryIndex(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxUpdateSecondaryIndex");
 
-    LineairDB::Protocol::TxUpdateSecondaryIndex::Request request;
-    LineairDB::Protocol::TxUpdateSecondaryIndex::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxUpdateSecondaryIndex::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxUpdateSecondaryIndex::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        std::string_view index_name = select_index(tx, request.index_id(), request.index_name());
         const std::string& pk = request.primary_key();
-        tx->UpdateSecondaryIndex(request.index_name(),
+        tx->UpdateSecondaryIndex(index_name,
                                  request.old_secondary_key(), request.new_secondary_key(),
                                  reinterpret_cast<const std::byte*>(pk.c_str()), pk.size());
+        if (auto* writes = write_set(tx_id)) {
+            writes->remove_entry(index_name, request.old_secondary_key(), pk);
+            writes->add_entry(index_name, request.new_secondary_key(), pk);
+        }
         response.set_is_aborted(tx->IsAborted());
         response.set_success(!tx->IsAborted());
-        LOG_DEBUG("UpdateSecondaryIndex index='%s' old='%s' new='%s' tx=%ld",
-                  request.index_name().c_str(), request.old_secondary_key().c_str(),
+        LOG_DEBUG("UpdateSecondaryIndex index='%.*s' old='%s' new='%s' tx=%ld",
+                  static_cast<int>(index_name.size()), index_name.data(),
+                  request.old_secondary_key().c_str(),
                   request.new_secondary_key().c_str(), tx_id);
     } else {
         response.set_success(false);
@@ -446,25 +882,23 @@ void LineairDBRpc::handleTxUpdateSecondaryIndex(const std::string& message, std:
         LOG_WARNING("Transaction not found for update_secondary_index: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxGetMatchingKeysInRange(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxGetMatchingKeysInRange(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxGetMatchingKeysInRange");
 
-    LineairDB::Protocol::TxGetMatchingKeysInRange::Request request;
-    LineairDB::Protocol::TxGetMatchingKeysInRange::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxGetMatchingKeysInRange::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxGetMatchingKeysInRange::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        std::string start_key = request.start_key();
-        std::string end_key = request.end_key();
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        const std::string& start_key = request.start_key();
+        const std::string& end_key = request.end_key();
 
         std::optional<std::string_view> end_opt;
         if (!end_key.empty()) { end_opt = end_key; }
@@ -488,30 +922,29 @@ void LineairDBRpc::handleTxGetMatchingKeysInRange(const std::string& message, st
         LOG_WARNING("Transaction not found for get_matching_keys_in_range: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxGetMatchingKeysAndValuesInRange(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxGetMatchingKeysAndValuesInRange(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxGetMatchingKeysAndValuesInRange");
 
-    LineairDB::Protocol::TxGetMatchingKeysAndValuesInRange::Request request;
-    request.ParseFromString(message);
+    auto& request = arena_message<LineairDB::Protocol::TxGetMatchingKeysAndValuesInRange::Request>();
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
 
-    // Respond with flat binary instead of protobuf to avoid per-entry overhead.
-    // Format: [is_aborted:1B] [key_len:4B][key][val_len:4B][val]... [sentinel:key_len=0]
-    result.clear();
+    // Respond with flat binary instead of protobuf to avoid per-entry overhead
+    // (layout in common/scan_codec.h)
     result.reserve(4096);
-    result.push_back(0);   // is_aborted placeholder (updated after Scan completes)
+    Rpc::ScanResponseWriter writer(result, front_coded_keys_);
+    writer.begin();
+    bool aborted = false;
 
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        std::string start_key = request.start_key();
-        std::string end_key = request.end_key();
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        const std::string& start_key = request.start_key();
+        const std::string& end_key = request.end_key();
 
         std::optional<std::string_view> end_opt;
         if (!end_key.empty()) { end_opt = end_key; }
@@ -524,7 +957,7 @@ void LineairDBRpc::handleTxGetMatchingKeysAndValuesInRange(const std::string& me
 
         // Scan callback: value is pair<const void*, size_t> from LineairDB
         auto scan_result = tx->Scan(
-            start_key, end_opt, [&result,
+            start_key, end_opt, [&writer,
                                   filter_expr, filter_num_cols, &evaluator](auto key, auto value) {
                 // Skip tombstones (deleted rows)
                 if (value.first == nullptr || value.second == 0) { return false; }
@@ -538,51 +971,43 @@ void LineairDBRpc::handleTxGetMatchingKeysAndValuesInRange(const std::string& me
                     }
                     // parse_row failure → include row (safe fallback)
                 }
-                // Append key-value entry in flat binary format
-                uint32_t klen = static_cast<uint32_t>(key.size());
-                uint32_t vlen = static_cast<uint32_t>(value.second);
-                result.append(reinterpret_cast<const char*>(&klen), 4);
-                result.append(key.data(), key.size());
-                result.append(reinterpret_cast<const char*>(&vlen), 4);
-                result.append(static_cast<const char*>(value.first), value.second);
+                writer.add(key, std::string_view(static_cast<const char*>(value.first), value.second));
                 return false;  // continue scanning
             });
 
         // Phantom detection: if Scan returns nullopt, the transaction is in an abort state
         if (!scan_result.has_value()) {
             tx->Abort();
-            result[0] = 1;  // update is_aborted placeholder
+            aborted = true;
         } else if (tx->IsAborted()) {
-            result[0] = 1;
+            aborted = true;
         }
     } else {
-        result[0] = 1;
+        aborted = true;
         LOG_WARNING("Transaction not found for get_matching_keys_and_values_in_range: %ld", tx_id);
     }
 
-    uint32_t sentinel = 0;
-    result.append(reinterpret_cast<const char*>(&sentinel), 4);  // sentinel: key_len=0 marks end of entries
+    writer.finish(aborted);
 }
 
-void LineairDBRpc::handleTxGetMatchingKeysAndValuesFromPrefix(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxGetMatchingKeysAndValuesFromPrefix(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxGetMatchingKeysAndValuesFromPrefix");
 
-    LineairDB::Protocol::TxGetMatchingKeysAndValuesFromPrefix::Request request;
-    request.ParseFromString(message);
+    auto& request = arena_message<LineairDB::Protocol::TxGetMatchingKeysAndValuesFromPrefix::Request>();
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
 
     // Same flat binary format as handleTxGetMatchingKeysAndValuesInRange
-    result.clear();
     result.reserve(4096);
-    result.push_back(0);   // is_aborted placeholder
+    Rpc::ScanResponseWriter writer(result, front_coded_keys_);
+    writer.begin();
+    bool aborted = false;
 
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        std::string prefix = request.prefix();
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        const std::string& prefix = request.prefix();
         bool first_key_checked = false;
         bool prefix_miss = false;
 
@@ -595,7 +1020,7 @@ void LineairDBRpc::handleTxGetMatchingKeysAndValuesFromPrefix(const std::string&
         // Scan callback: value is pair<const void*, size_t> from LineairDB
         auto scan_result = tx->Scan(
             prefix, std::nullopt,
-            [&result, &first_key_checked, &prefix_miss, &prefix,
+            [&writer, &first_key_checked, &prefix_miss, &prefix,
              filter_expr, filter_num_cols, &evaluator, this](auto key, auto value) {
                 // Check if first key matches the prefix; if not, abort scan early
                 if (!first_key_checked) {
@@ -615,52 +1040,43 @@ void LineairDBRpc::handleTxGetMatchingKeysAndValuesFromPrefix(const std::string&
                     }
                     // parse_row failure → include row (safe fallback)
                 }
-                // Append key-value entry in flat binary format
-                uint32_t klen = static_cast<uint32_t>(key.size());
-                uint32_t vlen = static_cast<uint32_t>(value.second);
-                result.append(reinterpret_cast<const char*>(&klen), 4);
-                result.append(key.data(), key.size());
-                result.append(reinterpret_cast<const char*>(&vlen), 4);
-                result.append(static_cast<const char*>(value.first), value.second);
+                writer.add(key, std::string_view(static_cast<const char*>(value.first), value.second));
                 return false;  // continue scanning
             });
 
         // Phantom detection: if Scan returns nullopt, the transaction is in an abort state
         if (!scan_result.has_value()) {
             tx->Abort();
-            result[0] = 1;
+            aborted = true;
         } else if (tx->IsAborted()) {
-            result[0] = 1;
+            aborted = true;
         }
         if (prefix_miss) {
             // No matching keys found; discard entries, keep just header + sentinel
-            result.resize(1);
+            writer.discard();
         }
     } else {
-        result[0] = 1;
+        aborted = true;
         LOG_WARNING("Transaction not found for get_matching_keys_and_values_from_prefix: %ld", tx_id);
     }
 
-    uint32_t sentinel = 0;
-    result.append(reinterpret_cast<const char*>(&sentinel), 4);  // sentinel
+    writer.finish(aborted);
 }
 
-void LineairDBRpc::handleTxFetchLastKeyInRange(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxFetchLastKeyInRange(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxFetchLastKeyInRange");
 
-    LineairDB::Protocol::TxFetchLastKeyInRange::Request request;
-    LineairDB::Protocol::TxFetchLastKeyInRange::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxFetchLastKeyInRange::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxFetchLastKeyInRange::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        std::string start_key = request.start_key();
-        std::string end_key = request.end_key();
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        const std::string& start_key = request.start_key();
+        const std::string& end_key = request.end_key();
 
         std::optional<std::string_view> end_opt;
         if (!end_key.empty()) { end_opt = end_key; }
@@ -693,25 +1109,23 @@ void LineairDBRpc::handleTxFetchLastKeyInRange(const std::string& message, std::
         LOG_WARNING("Transaction not found for fetch_last_key_in_range: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxFetchFirstKeyWithPrefix(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxFetchFirstKeyWithPrefix(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxFetchFirstKeyWithPrefix");
 
-    LineairDB::Protocol::TxFetchFirstKeyWithPrefix::Request request;
-    LineairDB::Protocol::TxFetchFirstKeyWithPrefix::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxFetchFirstKeyWithPrefix::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxFetchFirstKeyWithPrefix::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        std::string prefix = request.prefix();
-        std::string prefix_end = request.prefix_end();
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        const std::string& prefix = request.prefix();
+        const std::string& prefix_end = request.prefix_end();
 
         std::optional<std::string_view> end_opt;
         if (!prefix_end.empty()) { end_opt = prefix_end; }
@@ -752,25 +1166,23 @@ void LineairDBRpc::handleTxFetchFirstKeyWithPrefix(const std::string& message, s
         LOG_WARNING("Transaction not found for fetch_first_key_with_prefix: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxFetchNextKeyWithPrefix(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxFetchNextKeyWithPrefix(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxFetchNextKeyWithPrefix");
 
-    LineairDB::Protocol::TxFetchNextKeyWithPrefix::Request request;
-    LineairDB::Protocol::TxFetchNextKeyWithPrefix::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxFetchNextKeyWithPrefix::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxFetchNextKeyWithPrefix::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        std::string last_key = request.last_key();
-        std::string prefix_end = request.prefix_end();
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        const std::string& last_key = request.last_key();
+        const std::string& prefix_end = request.prefix_end();
         bool skip_first = true;
 
         std::optional<std::string_view> end_opt;
@@ -818,35 +1230,45 @@ void LineairDBRpc::handleTxFetchNextKeyWithPrefix(const std::string& message, st
         LOG_WARNING("Transaction not found for fetch_next_key_with_prefix: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxGetMatchingPrimaryKeysInRange(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxGetMatchingPrimaryKeysInRange(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxGetMatchingPrimaryKeysInRange");
 
-    LineairDB::Protocol::TxGetMatchingPrimaryKeysInRange::Request request;
-    LineairDB::Protocol::TxGetMatchingPrimaryKeysInRange::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxGetMatchingPrimaryKeysInRange::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxGetMatchingPrimaryKeysInRange::Response>();
+
+    parse_request(message, request);
 
-    request.ParseFromString(message);
+    // Front-coded sessions get the flat key list of common/scan_codec.h
+    Rpc::ScanResponseWriter writer(result, true);
+    if (front_coded_keys_) writer.begin();
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        std::string index_name = request.index_name();
-        std::string start_key = request.start_key();
-        std::string end_key = request.end_key();
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        std::string_view index_name = select_index(tx, request.index_id(), request.index_name());
+        const std::string& start_key = request.start_key();
+        const std::string& end_key = request.end_key();
 
         std::optional<std::string_view> end_opt;
         if (!end_key.empty()) { end_opt = end_key; }
 
+        size_t num_keys = 0;
         auto scan_result = tx->ScanSecondaryIndex(
             index_name, start_key, end_opt,
-            [&response]([[maybe_unused]] std::string_view secondary_key,
-                        const std::vector<std::string>& primary_keys) {
-                for (const auto& pk : primary_keys) { response.add_primary_keys(pk); }
+            [this, &response, &writer, &num_keys]([[maybe_unused]] std::string_view secondary_key,
+                                                  const std::vector<std::string>& primary_keys) {
+                num_keys += primary_keys.size();
+                for (const auto& pk : primary_keys) {
+                    if (front_coded_keys_) {
+                        writer.add_key(pk);
+                    } else {
+                        response.add_primary_keys(pk);
+                    }
+                }
                 return false;
             });
 
@@ -857,32 +1279,34 @@ void LineairDBRpc::handleTxGetMatchingPrimaryKeysInRange(const std::string& mess
         } else {
             response.set_is_aborted(tx->IsAborted());
         }
-        LOG_DEBUG("GetMatchingPrimaryKeysInRange tx=%ld index='%s': %d keys",
-                  tx_id, index_name.c_str(), response.primary_keys_size());
+        LOG_DEBUG("GetMatchingPrimaryKeysInRange tx=%ld index='%.*s': %zu keys",
+                  tx_id, static_cast<int>(index_name.size()), index_name.data(), num_keys);
     } else {
         response.set_is_aborted(true);
         LOG_WARNING("Transaction not found for get_matching_primary_keys_in_range: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    if (front_coded_keys_) {
+        writer.finish(response.is_aborted());
+    } else {
+        response.SerializeToString(&result);
+    }
 }
 
-void LineairDBRpc::handleTxGetMatchingPrimaryKeysFromPrefix(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxGetMatchingPrimaryKeysFromPrefix(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxGetMatchingPrimaryKeysFromPrefix");
 
-    LineairDB::Protocol::TxGetMatchingPrimaryKeysFromPrefix::Request request;
-    LineairDB::Protocol::TxGetMatchingPrimaryKeysFromPrefix::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxGetMatchingPrimaryKeysFromPrefix::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxGetMatchingPrimaryKeysFromPrefix::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        std::string index_name = request.index_name();
-        std::string prefix = request.prefix();
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        std::string_view index_name = select_index(tx, request.index_id(), request.index_name());
+        const std::string& prefix = request.prefix();
         bool first_key_checked = false;
         bool prefix_miss = false;
 
@@ -907,33 +1331,31 @@ void LineairDBRpc::handleTxGetMatchingPrimaryKeysFromPrefix(const std::string& m
             response.set_is_aborted(tx->IsAborted());
             if (prefix_miss) { response.clear_primary_keys(); }
         }
-        LOG_DEBUG("GetMatchingPrimaryKeysFromPrefix tx=%ld index='%s' prefix='%s': %d keys",
-                  tx_id, index_name.c_str(), prefix.c_str(), response.primary_keys_size());
+        LOG_DEBUG("GetMatchingPrimaryKeysFromPrefix tx=%ld index='%.*s' prefix='%s': %d keys",
+                  tx_id, static_cast<int>(index_name.size()), index_name.data(), prefix.c_str(), response.primary_keys_size());
     } else {
         response.set_is_aborted(true);
         LOG_WARNING("Transaction not found for get_matching_primary_keys_from_prefix: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxFetchLastPrimaryKeyInSecondaryRange(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxFetchLastPrimaryKeyInSecondaryRange(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxFetchLastPrimaryKeyInSecondaryRange");
 
-    LineairDB::Protocol::TxFetchLastPrimaryKeyInSecondaryRange::Request request;
-    LineairDB::Protocol::TxFetchLastPrimaryKeyInSecondaryRange::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxFetchLastPrimaryKeyInSecondaryRange::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxFetchLastPrimaryKeyInSecondaryRange::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        std::string index_name = request.index_name();
-        std::string start_key = request.start_key();
-        std::string end_key = request.end_key();
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        std::string_view index_name = select_index(tx, request.index_id(), request.index_name());
+        const std::string& start_key = request.start_key();
+        const std::string& end_key = request.end_key();
 
         std::optional<std::string_view> end_opt;
         if (!end_key.empty()) { end_opt = end_key; }
@@ -962,34 +1384,32 @@ void LineairDBRpc::handleTxFetchLastPrimaryKeyInSecondaryRange(const std::string
                 response.set_found(false);
             }
         }
-        LOG_DEBUG("FetchLastPrimaryKeyInSecondaryRange tx=%ld index='%s': found=%s",
-                  tx_id, index_name.c_str(), result.has_value() ? "true" : "false");
+        LOG_DEBUG("FetchLastPrimaryKeyInSecondaryRange tx=%ld index='%.*s': found=%s",
+                  tx_id, static_cast<int>(index_name.size()), index_name.data(), result.has_value() ? "true" : "false");
     } else {
         response.set_is_aborted(true);
         response.set_found(false);
         LOG_WARNING("Transaction not found for fetch_last_primary_key_in_secondary_range: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleTxFetchLastSecondaryEntryInRange(const std::string& message, std::string& result) {
+void LineairDBRpc::handleTxFetchLastSecondaryEntryInRange(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling TxFetchLastSecondaryEntryInRange");
 
-    LineairDB::Protocol::TxFetchLastSecondaryEntryInRange::Request request;
-    LineairDB::Protocol::TxFetchLastSecondaryEntryInRange::Response response;
+    auto& request = arena_message<LineairDB::Protocol::TxFetchLastSecondaryEntryInRange::Request>();
+    auto& response = arena_message<LineairDB::Protocol::TxFetchLastSecondaryEntryInRange::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        if (!request.table_name().empty()) {
-            tx->SetTable(request.table_name());
-        }
-        std::string index_name = request.index_name();
-        std::string start_key = request.start_key();
-        std::string end_key = request.end_key();
+        select_table(tx, tx_id, request.table_id(), request.table_name());
+        std::string_view index_name = select_index(tx, request.index_id(), request.index_name());
+        const std::string& start_key = request.start_key();
+        const std::string& end_key = request.end_key();
 
         std::optional<std::string_view> end_opt;
         if (!end_key.empty()) { end_opt = end_key; }
@@ -1016,97 +1436,85 @@ void LineairDBRpc::handleTxFetchLastSecondaryEntryInRange(const std::string& mes
             response.set_is_aborted(tx->IsAborted());
             response.set_found(found);
         }
-        LOG_DEBUG("FetchLastSecondaryEntryInRange tx=%ld index='%s': found=%s",
-                  tx_id, index_name.c_str(), found ? "true" : "false");
+        LOG_DEBUG("FetchLastSecondaryEntryInRange tx=%ld index='%.*s': found=%s",
+                  tx_id, static_cast<int>(index_name.size()), index_name.data(), found ? "true" : "false");
     } else {
         response.set_is_aborted(true);
         response.set_found(false);
         LOG_WARNING("Transaction not found for fetch_last_secondary_entry_in_range: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
-void LineairDBRpc::handleDbFence(const std::string& message, std::string& result) {
+void LineairDBRpc::handleDbFence(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling DbFence");
 
-    LineairDB::Protocol::DbFence::Request request;
-    LineairDB::Protocol::DbFence::Response response;
+    auto& request = arena_message<LineairDB::Protocol::DbFence::Request>();
+    auto& response = arena_message<LineairDB::Protocol::DbFence::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     db_manager_->get_database()->Fence();
+    RedoLog* redo_log = db_manager_->redo_log();
+    if (redo_log && redo_log->durable()) {
+        redo_log->sync();
+    }
     LOG_DEBUG("Database fence completed");
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleDbEndTransaction(const std::string& message, std::string& result) {
+void LineairDBRpc::handleDbEndTransaction(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling DbEndTransaction");
 
-    LineairDB::Protocol::DbEndTransaction::Request request;
-    LineairDB::Protocol::DbEndTransaction::Response response;
+    auto& request = arena_message<LineairDB::Protocol::DbEndTransaction::Request>();
+    auto& response = arena_message<LineairDB::Protocol::DbEndTransaction::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
-        bool fence = request.fence();
-        bool committed = db_manager_->get_database()->EndTransaction(
-            *tx, [fence, tx_id](LineairDB::TxStatus status) {
-                LOG_DEBUG("Transaction %ld ended with status: %d, fence=%s", tx_id, static_cast<int>(status), fence ? "true" : "false");
-            });
-        bool aborted = !committed;
-        response.set_is_aborted(aborted);
-        tx_manager_->remove_transaction(tx_id);
-
-        // Apply row-count deltas on successful commit
-        if (committed && request.row_deltas_size() > 0) {
-            row_counts_->apply_deltas(request.row_deltas());
-        }
-
-        LOG_DEBUG("Ended transaction %ld with fence=%s (committed=%s)", tx_id, fence ? "true" : "false", committed ? "true" : "false");
-        // Piggyback updated table row counts for the proxy's next transaction.
-        for (const auto& [name, count] : row_counts_->snapshot()) {
-            auto* ts = response.add_table_stats();
-            ts->set_table_name(name);
-            ts->set_row_count(count);
-        }
+        response.set_is_aborted(!end_transaction(tx, tx_id, request.fence(), request.row_deltas()));
     } else {
         response.set_is_aborted(true);
         LOG_WARNING("Transaction not found for end: %ld", tx_id);
     }
+    // Piggyback changed table row counts for the proxy's next transaction.
+    add_table_stats(request.stats_version(), response);
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleDbCreateTable(const std::string& message, std::string& result) {
+void LineairDBRpc::handleDbCreateTable(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling DbCreateTable");
 
-    LineairDB::Protocol::DbCreateTable::Request request;
-    LineairDB::Protocol::DbCreateTable::Response response;
+    auto& request = arena_message<LineairDB::Protocol::DbCreateTable::Request>();
+    auto& response = arena_message<LineairDB::Protocol::DbCreateTable::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
-    bool success = db_manager_->get_database()->CreateTable(request.table_name());
+    bool success = db_manager_->create_table(request.table_name());
     response.set_success(success);
     LOG_DEBUG("CreateTable '%s': %s", request.table_name().c_str(), success ? "success" : "already exists");
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleDbSetTable(const std::string& message, std::string& result) {
+void LineairDBRpc::handleDbSetTable(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling DbSetTable");
 
-    LineairDB::Protocol::DbSetTable::Request request;
-    LineairDB::Protocol::DbSetTable::Response response;
+    auto& request = arena_message<LineairDB::Protocol::DbSetTable::Request>();
+    auto& response = arena_message<LineairDB::Protocol::DbSetTable::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
     int64_t tx_id = request.transaction_id();
     auto* tx = tx_manager_->get_transaction(tx_id);
     if (tx) {
         bool success = tx->SetTable(request.table_name());
+        selected_tx_id_ = -1;
+        if (auto* writes = write_set(tx_id)) writes->set_table(request.table_name());
         response.set_success(success);
         LOG_DEBUG("SetTable '%s' for tx=%ld: %s", request.table_name().c_str(), tx_id, success ? "success" : "failed");
     } else {
@@ -1114,20 +1522,40 @@ void LineairDBRpc::handleDbSetTable(const std::string& message, std::string& res
         LOG_WARNING("Transaction not found for set_table: %ld", tx_id);
     }
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
 }
 
-void LineairDBRpc::handleDbCreateSecondaryIndex(const std::string& message, std::string& result) {
+void LineairDBRpc::handleDbCreateSecondaryIndex(std::string_view message, std::string& result) {
     LOG_DEBUG("Handling DbCreateSecondaryIndex");
 
-    LineairDB::Protocol::DbCreateSecondaryIndex::Request request;
-    LineairDB::Protocol::DbCreateSecondaryIndex::Response response;
+    auto& request = arena_message<LineairDB::Protocol::DbCreateSecondaryIndex::Request>();
+    auto& response = arena_message<LineairDB::Protocol::DbCreateSecondaryIndex::Response>();
 
-    request.ParseFromString(message);
+    parse_request(message, request);
 
-    bool success = db_manager_->get_database()->CreateSecondaryIndex(
+    bool success = db_manager_->create_secondary_index(
         request.table_name(), request.index_name(), request.index_type());
     response.set_success(success);
 
-    result = response.SerializeAsString();
+    response.SerializeToString(&result);
+}
+
+void LineairDBRpc::handleDbResolveHandles(std::string_view message, std::string& result) {
+    LOG_DEBUG("Handling DbResolveHandles");
+
+    auto& request = arena_message<LineairDB::Protocol::DbResolveHandles::Request>();
+    auto& response = arena_message<LineairDB::Protocol::DbResolveHandles::Response>();
+
+    parse_request(message, request);
+
+    uint32_t table_id = handles_->table(request.table_name());
+    response.set_table_id(table_id);
+    for (const auto& index_name : request.index_names()) {
+        response.add_index_ids(handles_->index(table_id, index_name));
+    }
+    response.set_handle_epoch(handles_->epoch());
+    LOG_DEBUG("ResolveHandles '%s': table_id=%u, %d indexes",
+              request.table_name().c_str(), table_id, request.index_names_size());
+
+    response.SerializeToString(&result);
 }
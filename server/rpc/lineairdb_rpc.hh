@@ -1,88 +1,167 @@
 #pragma once
 
+#include <condition_variable>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <unordered_map>
+#include <vector>
+
+#include <google/protobuf/arena.h>
 
 #include "../protocol/message.hh"
 #include "../storage/database_manager.hh"
+#include "../storage/table_handles.hh"
+#include "../storage/table_row_counts.hh"
 #include "../storage/transaction_manager.hh"
 
-// Server-wide table row count tracker, shared across all connections.
-struct TableRowCounts {
-    std::shared_mutex s_mutex;
-    std::unordered_map<std::string, int64_t> counts;
-
-    template <typename T>
-    void apply_deltas(const T& deltas) {
-        std::unique_lock<std::shared_mutex> lock(s_mutex);
-        for (const auto& row_delta : deltas) {
-            auto& count = counts[row_delta.table_name()];
-            count += row_delta.delta();
-            if (count < 0) count = 0;
-        }
-    }
+// Durability of a fenced commit: completed by the transaction's commit
+// callback, which LineairDB runs once the transaction's epoch is stable (and,
+// with logging, flushed), or with the checkpointer's durable redo log once
+// the commit's record is on disk.
+class CommitSignal {
+public:
+    void complete();
+    void wait();
+    // Run fn once complete: right away if it already is, otherwise on the
+    // thread that completes it (one of LineairDB's)
+    void on_done(std::function<void()> fn);
 
-    std::unordered_map<std::string, int64_t> snapshot() {
-        std::shared_lock<std::shared_mutex> lock(s_mutex);
-        return counts;
-    }
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool done_ = false;
+    std::function<void()> then_;
 };
 
 class LineairDBRpc {
 public:
     LineairDBRpc(std::shared_ptr<DatabaseManager> db_manager,
                  std::shared_ptr<TransactionManager> tx_manager,
-                 std::shared_ptr<TableRowCounts> row_counts);
+                 std::shared_ptr<TableRowCounts> row_counts,
+                 std::shared_ptr<TableHandles> handles);
     ~LineairDBRpc() = default;
 
     void handle_rpc(uint64_t sender_id, MessageType message_type,
-                   const std::string& message, std::string& result);
+                   std::string_view message, std::string& result);
+    // Point RPCs in the fixed binary layout of common/point_codec.h
+    void handle_binary_rpc(MessageType message_type, std::string_view message, std::string& result);
+
+    // Version agreed in the connection's SESSION_HELLO (1 if it sent none)
+    void set_protocol_version(uint32_t protocol_version);
+
+    // Event-loop transports must not block on a fenced commit. With
+    // async_fence the handler builds the response without waiting and leaves
+    // the commit's signal in take_durable_wait(); the caller holds the
+    // response back until the signal completes.
+    void set_async_fence(bool async_fence) { async_fence_ = async_fence; }
+    // The last RPC's pending fenced commit, or null
+    std::shared_ptr<CommitSignal> take_durable_wait() { return std::move(durable_wait_); }
+
+    static constexpr size_t kArenaBlockSize = 64 * 1024;
 
 private:
     std::shared_ptr<DatabaseManager> db_manager_;
     std::shared_ptr<TransactionManager> tx_manager_;
     std::shared_ptr<TableRowCounts> row_counts_;
+    std::shared_ptr<TableHandles> handles_;
+
+    // Registry entries this connection has looked up, indexed by handle
+    std::vector<const std::string*> table_names_;
+    std::vector<const TableHandles::Index*> indexes_;
+    // Table last selected by handle, so a run of requests on one table
+    // skips LineairDB's SetTable() name lookup
+    int64_t selected_tx_id_ = -1;
+    uint32_t selected_table_id_ = 0;
+    // Scan responses use the front-coded layout of common/scan_codec.h
+    bool front_coded_keys_ = false;
+    bool async_fence_ = false;
+    std::shared_ptr<CommitSignal> durable_wait_;
+    // Writes of each open transaction, for the redo log
+    std::unordered_map<int64_t, RedoLog::WriteSet> write_sets_;
+    int64_t write_set_tx_id_ = -1;
+    RedoLog::WriteSet* write_set_ = nullptr;
+
+    // Request/response messages of the protobuf handlers, reset after every
+    // RPC once its response is serialized
+    std::unique_ptr<char[]> arena_block_;
+    google::protobuf::Arena arena_;
+
+    template <typename Message>
+    Message& arena_message() {
+        return *google::protobuf::Arena::CreateMessage<Message>(&arena_);
+    }
+
+    // Scope tx to the request's table, by handle when table_id != 0. An
+    // unknown handle aborts tx.
+    void select_table(LineairDB::Transaction* tx, int64_t tx_id, uint32_t table_id,
+                      std::string_view table_name);
+    // Where tx_id's writes are recorded for the redo log; null when the
+    // server keeps none
+    RedoLog::WriteSet* write_set(int64_t tx_id);
+    // Index name for the request's index handle or name; an unknown handle
+    // aborts tx and yields ""
+    std::string_view select_index(LineairDB::Transaction* tx, uint32_t index_id,
+                                  std::string_view index_name);
+
+    // Table row counts changed since since_version, into a BEGIN/END response
+    template <typename Response>
+    void add_table_stats(uint64_t since_version, Response& response);
+
+    // Begin a transaction and register it; returns its ID
+    int64_t begin_transaction(LineairDB::Transaction*& tx);
+    // Commit tx (an aborted one just ends) and unregister it; row_deltas are
+    // applied if it committed, and its writes go to the redo log, if any.
+    // With fence, returns once tx is durable (blocking only the calling
+    // thread), or with async_fence_ right away, leaving the wait in
+    // durable_wait_.
+    template <typename RowDeltas>
+    bool end_transaction(LineairDB::Transaction* tx, int64_t tx_id, bool fence,
+                         const RowDeltas& row_deltas);
 
     // Transaction lifecycle
-    void handleTxBeginTransaction(const std::string& message, std::string& result);
-    void handleTxAbort(const std::string& message, std::string& result);
+    void handleTxBeginTransaction(std::string_view message, std::string& result);
+    void handleTxAbort(std::string_view message, std::string& result);
 
     // Primary key operations
-    void handleTxRead(const std::string& message, std::string& result);
-    void handleTxBatchRead(const std::string& message, std::string& result);
-    void handleTxBatchWrite(const std::string& message, std::string& result);
-    void handleTxWrite(const std::string& message, std::string& result);
-    void handleTxDelete(const std::string& message, std::string& result);
+    void handleTxRead(std::string_view message, std::string& result);
+    void handleTxBatchRead(std::string_view message, std::string& result);
+    void handleTxBatchWrite(std::string_view message, std::string& result);
+    void handleBinaryBatchRead(std::string_view message, std::string& result);
+    void handleTxWrite(std::string_view message, std::string& result);
+    void handleTxDelete(std::string_view message, std::string& result);
+    void handleTxMulti(std::string_view message, std::string& result);
 
     // Secondary index operations
-    void handleTxReadSecondaryIndex(const std::string& message, std::string& result);
-    void handleTxWriteSecondaryIndex(const std::string& message, std::string& result);
-    void handleTxDeleteSecondaryIndex(const std::string& message, std::string& result);
-    void handleTxUpdateSecondaryIndex(const std::string& message, std::string& result);
+    void handleTxReadSecondaryIndex(std::string_view message, std::string& result);
+    void handleTxWriteSecondaryIndex(std::string_view message, std::string& result);
+    void handleTxDeleteSecondaryIndex(std::string_view message, std::string& result);
+    void handleTxUpdateSecondaryIndex(std::string_view message, std::string& result);
 
     // Primary key scan operations
-    void handleTxGetMatchingKeysInRange(const std::string& message, std::string& result);
-    void handleTxGetMatchingKeysAndValuesInRange(const std::string& message, std::string& result);
-    void handleTxGetMatchingKeysAndValuesFromPrefix(const std::string& message, std::string& result);
-    void handleTxFetchLastKeyInRange(const std::string& message, std::string& result);
-    void handleTxFetchFirstKeyWithPrefix(const std::string& message, std::string& result);
-    void handleTxFetchNextKeyWithPrefix(const std::string& message, std::string& result);
+    void handleTxGetMatchingKeysInRange(std::string_view message, std::string& result);
+    void handleTxGetMatchingKeysAndValuesInRange(std::string_view message, std::string& result);
+    void handleTxGetMatchingKeysAndValuesFromPrefix(std::string_view message, std::string& result);
+    void handleTxFetchLastKeyInRange(std::string_view message, std::string& result);
+    void handleTxFetchFirstKeyWithPrefix(std::string_view message, std::string& result);
+    void handleTxFetchNextKeyWithPrefix(std::string_view message, std::string& result);
 
     // Secondary index scan operations
-    void handleTxGetMatchingPrimaryKeysInRange(const std::string& message, std::string& result);
-    void handleTxGetMatchingPrimaryKeysFromPrefix(const std::string& message, std::string& result);
-    void handleTxFetchLastPrimaryKeyInSecondaryRange(const std::string& message, std::string& result);
-    void handleTxFetchLastSecondaryEntryInRange(const std::string& message, std::string& result);
+    void handleTxGetMatchingPrimaryKeysInRange(std::string_view message, std::string& result);
+    void handleTxGetMatchingPrimaryKeysFromPrefix(std::string_view message, std::string& result);
+    void handleTxFetchLastPrimaryKeyInSecondaryRange(std::string_view message, std::string& result);
+    void handleTxFetchLastSecondaryEntryInRange(std::string_view message, std::string& result);
 
     // Database operations
-    void handleDbFence(const std::string& message, std::string& result);
-    void handleDbEndTransaction(const std::string& message, std::string& result);
-    void handleDbCreateTable(const std::string& message, std::string& result);
-    void handleDbSetTable(const std::string& message, std::string& result);
-    void handleDbCreateSecondaryIndex(const std::string& message, std::string& result);
+    void handleDbFence(std::string_view message, std::string& result);
+    void handleDbEndTransaction(std::string_view message, std::string& result);
+    void handleDbCreateTable(std::string_view message, std::string& result);
+    void handleDbSetTable(std::string_view message, std::string& result);
+    void handleDbCreateSecondaryIndex(std::string_view message, std::string& result);
+    void handleDbResolveHandles(std::string_view message, std::string& result);
 
     // utility
     bool key_prefix_is_matching(const std::string& key_prefix, const std::string& key);
@@ -0,0 +1,417 @@
+#include "server_config.hh"
+
+#include <arpa/inet.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+using CC = LineairDB::Config::ConcurrencyControl;
+using Index = LineairDB::Config::IndexStructure;
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+std::string lower(std::string s) {
+    for (auto& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+// Decimal, optionally with a K/M/G (binary) suffix
+bool parse_size(const std::string& text, uint64_t max, uint64_t& out) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+    errno = 0;
+    char* end;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    if (errno != 0) return false;
+    std::string suffix = lower(end);
+    unsigned shift = 0;
+    if (suffix == "k" || suffix == "kb") shift = 10;
+    else if (suffix == "m" || suffix == "mb") shift = 20;
+    else if (suffix == "g" || suffix == "gb") shift = 30;
+    else if (!suffix.empty()) return false;
+    if (value > (max >> shift)) return false;
+    out = static_cast<uint64_t>(value) << shift;
+    return true;
+}
+
+bool parse_bool(const std::string& text, bool& out) {
+    std::string v = lower(text);
+    if (v == "true" || v == "on" || v == "yes" || v == "1") {
+        out = true;
+    } else if (v == "false" || v == "off" || v == "no" || v == "0") {
+        out = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* bool_name(bool value) { return value ? "true" : "false"; }
+
+const char* cc_name(CC cc) {
+    switch (cc) {
+        case CC::Silo: return "silo";
+        case CC::SiloNWR: return "silo_nwr";
+        case CC::TwoPhaseLocking: return "2pl";
+    }
+    return "unknown";
+}
+
+const char* index_name(Index index) {
+    switch (index) {
+        case Index::Masstree: return "masstree";
+        case Index::HashTableWithPrecisionLockingIndex: return "hash";
+    }
+    return "unknown";
+}
+
+const char* io_model_name(IoModel model) {
+    switch (model) {
+        case IoModel::ThreadPerConnection: return "thread";
+        case IoModel::Reactor: return "reactor";
+        case IoModel::IoUring: return "io_uring";
+    }
+    return "unknown";
+}
+
+struct Option {
+    const char* key;
+    const char* help;
+    std::function<bool(ServerConfig&, const std::string&)> set;
+    std::function<std::string(const ServerConfig&)> get;
+};
+
+template <typename T>
+Option size_option(const char* key, const char* help, T ServerConfig::*section,
+                   size_t T::*field) {
+    return {key, help,
+            [section, field](ServerConfig& c, const std::string& v) {
+                uint64_t n;
+                if (!parse_size(v, std::numeric_limits<size_t>::max(), n)) return false;
+                c.*section.*field = static_cast<size_t>(n);
+                return true;
+            },
+            [section, field](const ServerConfig& c) { return std::to_string(c.*section.*field); }};
+}
+
+template <typename T>
+Option int_option(const char* key, const char* help, T ServerConfig::*section, int T::*field) {
+    return {key, help,
+            [section, field](ServerConfig& c, const std::string& v) {
+                uint64_t n;
+                if (!parse_size(v, std::numeric_limits<int>::max(), n)) return false;
+                c.*section.*field = static_cast<int>(n);
+                return true;
+            },
+            [section, field](const ServerConfig& c) { return std::to_string(c.*section.*field); }};
+}
+
+template <typename T>
+Option bool_option(const char* key, const char* help, T ServerConfig::*section, bool T::*field) {
+    return {key, help,
+            [section, field](ServerConfig& c, const std::string& v) {
+                return parse_bool(v, c.*section.*field);
+            },
+            [section, field](const ServerConfig& c) { return bool_name(c.*section.*field); }};
+}
+
+template <typename T>
+Option string_option(const char* key, const char* help, T ServerConfig::*section,
+                     std::string T::*field) {
+    return {key, help,
+            [section, field](ServerConfig& c, const std::string& v) {
+                c.*section.*field = v;
+                return true;
+            },
+            [section, field](const ServerConfig& c) { return c.*section.*field; }};
+}
+
+const std::vector<Option>& options() {
+    using Network = ServerConfig::Network;
+    using Scheduler = ServerConfig::Scheduler;
+    using Checkpoint = Checkpointer::Options;
+    static const std::vector<Option> table = {
+        {"engine.cc_protocol", "silo | silo_nwr | 2pl",
+         [](ServerConfig& c, const std::string& v) {
+             std::string name = lower(v);
+             if (name == "silo") c.engine.concurrency_control_protocol = CC::Silo;
+             else if (name == "silo_nwr" || name == "silonwr") c.engine.concurrency_control_protocol = CC::SiloNWR;
+             else if (name == "2pl" || name == "twophaselocking") c.engine.concurrency_control_protocol = CC::TwoPhaseLocking;
+             else return false;
+             return true;
+         },
+         [](const ServerConfig& c) { return std::string(cc_name(c.engine.concurrency_control_protocol)); }},
+        {"engine.index_structure", "masstree | hash (hash has no ordered scans)",
+         [](ServerConfig& c, const std::string& v) {
+             std::string name = lower(v);
+             if (name == "masstree") c.engine.index_structure = Index::Masstree;
+             else if (name == "hash") c.engine.index_structure = Index::HashTableWithPrecisionLockingIndex;
+             else return false;
+             return true;
+         },
+         [](const ServerConfig& c) { return std::string(index_name(c.engine.index_structure)); }},
+        {"engine.threads", "LineairDB worker threads (0 = one per allowed CPU)",
+         [](ServerConfig& c, const std::string& v) {
+             uint64_t n;
+             if (!parse_size(v, std::numeric_limits<size_t>::max(), n)) return false;
+             c.engine.max_thread = static_cast<size_t>(n);
+             return true;
+         },
+         [](const ServerConfig& c) { return std::to_string(c.engine.max_thread); }},
+        {"engine.epoch_duration_ms", "epoch length in milliseconds",
+         [](ServerConfig& c, const std::string& v) {
+             uint64_t n;
+             if (!parse_size(v, std::numeric_limits<size_t>::max(), n) || n == 0) return false;
+             c.engine.epoch_duration_ms = static_cast<size_t>(n);
+             return true;
+         },
+         [](const ServerConfig& c) { return std::to_string(c.engine.epoch_duration_ms); }},
+        {"engine.durability", "memory | wal: wal turns on logging and recovery together",
+         [](ServerConfig& c, const std::string& v) {
+             std::string name = lower(v);
+             if (name != "memory" && name != "wal") return false;
+             c.engine.enable_logging = c.engine.enable_recovery = name == "wal";
+             return true;
+         },
+         [](const ServerConfig& c) {
+             return std::string(c.engine.enable_logging ? "wal" : "memory");
+         }},
+        {"engine.logging", "write LineairDB's log (true | false)",
+         [](ServerConfig& c, const std::string& v) { return parse_bool(v, c.engine.enable_logging); },
+         [](const ServerConfig& c) { return std::string(bool_name(c.engine.enable_logging)); }},
+        {"engine.checkpointing", "take periodic checkpoints (true | false)",
+         [](ServerConfig& c, const std::string& v) { return parse_bool(v, c.engine.enable_checkpointing); },
+         [](const ServerConfig& c) { return std::string(bool_name(c.engine.enable_checkpointing)); }},
+        {"engine.recovery", "recover from the log at startup (true | false)",
+         [](ServerConfig& c, const std::string& v) { return parse_bool(v, c.engine.enable_recovery); },
+         [](const ServerConfig& c) { return std::string(bool_name(c.engine.enable_recovery)); }},
+        {"engine.checkpoint_period_s", "seconds between checkpoints",
+         [](ServerConfig& c, const std::string& v) {
+             uint64_t n;
+             if (!parse_size(v, std::numeric_limits<size_t>::max(), n) || n == 0) return false;
+             c.engine.checkpoint_period = static_cast<size_t>(n);
+             return true;
+         },
+         [](const ServerConfig& c) { return std::to_string(c.engine.checkpoint_period); }},
+        {"engine.work_dir", "directory for LineairDB's log and checkpoint files",
+         [](ServerConfig& c, const std::string& v) {
+             if (v.empty()) return false;
+             c.engine.work_dir = v;
+             return true;
+         },
+         [](const ServerConfig& c) { return c.engine.work_dir; }},
+
+        {"network.listen_address", "IPv4 address to listen on (0.0.0.0 = all)",
+         [](ServerConfig& c, const std::string& v) {
+             struct in_addr addr;
+             if (inet_pton(AF_INET, v.c_str(), &addr) != 1) return false;
+             c.network.listen_address = v;
+             return true;
+         },
+         [](const ServerConfig& c) { return c.network.listen_address; }},
+        {"network.port", "TCP port",
+         [](ServerConfig& c, const std::string& v) {
+             uint64_t n;
+             if (!parse_size(v, 65535, n) || n == 0) return false;
+             c.network.port = static_cast<uint16_t>(n);
+             return true;
+         },
+         [](const ServerConfig& c) { return std::to_string(c.network.port); }},
+        int_option("network.backlog", "listen() backlog", &ServerConfig::network, &Network::backlog),
+        size_option("network.io_workers", "reactor / io_uring workers (0 = one per CPU)",
+                    &ServerConfig::network, &Network::io_workers),
+        int_option("network.socket_send_buffer", "SO_SNDBUF bytes, K/M suffix allowed (0 = kernel default)",
+                   &ServerConfig::network, &Network::socket_send_buffer),
+        int_option("network.socket_receive_buffer", "SO_RCVBUF bytes, K/M suffix allowed (0 = kernel default)",
+                   &ServerConfig::network, &Network::socket_receive_buffer),
+        string_option("network.shm_socket", "Unix socket for shared-memory connections (empty = off)",
+                      &ServerConfig::network, &Network::shm_socket),
+
+        {"scheduler.io_model", "thread | reactor | io_uring",
+         [](ServerConfig& c, const std::string& v) {
+             std::string name = lower(v);
+             if (name == "thread") c.scheduler.io_model = IoModel::ThreadPerConnection;
+             else if (name == "reactor") c.scheduler.io_model = IoModel::Reactor;
+             else if (name == "io_uring") c.scheduler.io_model = IoModel::IoUring;
+             else return false;
+             return true;
+         },
+         [](const ServerConfig& c) { return std::string(io_model_name(c.scheduler.io_model)); }},
+        {"scheduler.listeners", "none | numa | N pinned SO_REUSEPORT listener groups",
+         [](ServerConfig& c, const std::string& v) {
+             std::string name = lower(v);
+             uint64_t n;
+             if (name == "none") {
+                 c.scheduler.listener_groups = false;
+                 c.scheduler.listeners = 0;
+             } else if (name == "numa") {
+                 c.scheduler.listener_groups = true;
+                 c.scheduler.listeners = 0;
+             } else if (parse_size(name, std::numeric_limits<size_t>::max(), n) && n > 0) {
+                 c.scheduler.listener_groups = true;
+                 c.scheduler.listeners = static_cast<size_t>(n);
+             } else {
+                 return false;
+             }
+             return true;
+         },
+         [](const ServerConfig& c) {
+             if (!c.scheduler.listener_groups) return std::string("none");
+             return c.scheduler.listeners == 0 ? std::string("numa") : std::to_string(c.scheduler.listeners);
+         }},
+        bool_option("scheduler.engine_affinity", "bind serving threads to engine slots and their CPUs",
+                    &ServerConfig::scheduler, &Scheduler::engine_affinity),
+
+        string_option("checkpoint.dir", "directory for checkpoints (and the redo log with engine.durability=wal), loaded at startup (empty = off)",
+                      &ServerConfig::checkpoint, &Checkpoint::dir),
+        size_option("checkpoint.period_s", "seconds between checkpoints (0 = only on SIGUSR1)",
+                    &ServerConfig::checkpoint, &Checkpoint::period_s),
+        size_option("checkpoint.segment_size", "bytes per segment file, K/M/G suffix allowed",
+                    &ServerConfig::checkpoint, &Checkpoint::segment_bytes),
+        size_option("checkpoint.load_threads", "threads loading segments at startup (0 = one per engine slot)",
+                    &ServerConfig::checkpoint, &Checkpoint::load_threads),
+    };
+    return table;
+}
+
+// Flags from before the config file existed, kept as spellings of keys
+const char* legacy_key(const std::string& flag) {
+    if (flag == "io-model") return "scheduler.io_model";
+    if (flag == "io-workers") return "network.io_workers";
+    if (flag == "shm-socket") return "network.shm_socket";
+    if (flag == "listeners") return "scheduler.listeners";
+    if (flag == "engine-threads") return "engine.threads";
+    if (flag == "cc") return "engine.cc_protocol";
+    if (flag == "durability") return "engine.durability";
+    if (flag == "log-dir") return "engine.work_dir";
+    if (flag == "checkpoint-dir") return "checkpoint.dir";
+    if (flag == "port") return "network.port";
+    if (flag == "listen") return "network.listen_address";
+    return nullptr;
+}
+
+void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [--config=FILE] [--SECTION.KEY=VALUE ...]\n"
+              << "  --config=FILE   INI file with [engine], [network], [scheduler] and\n"
+              << "                  [checkpoint] sections; later command-line settings\n"
+              << "                  override it\n"
+              << "  --SECTION.KEY=VALUE  one setting, e.g. --engine.cc_protocol=2pl\n"
+              << "Shorthands: --io-model --io-workers --shm-socket --listeners\n"
+              << "            --engine-threads --cc --durability --log-dir --checkpoint-dir\n"
+              << "            --port --listen\n"
+              << "Settings:\n";
+    for (const auto& option : options()) {
+        std::cerr << "  " << option.key << "  " << option.help << "\n";
+    }
+}
+
+}  // namespace
+
+bool ServerConfig::set(const std::string& key, const std::string& value, std::string& error) {
+    for (const auto& option : options()) {
+        if (key != option.key) continue;
+        if (!option.set(*this, value)) {
+            error = "invalid value '" + value + "' for " + key + " (" + option.help + ")";
+            return false;
+        }
+        return true;
+    }
+    error = "unknown setting " + key;
+    return false;
+}
+
+bool ServerConfig::load_file(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open config file " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    std::string section;
+    std::string line;
+    for (size_t line_no = 1; std::getline(in, line); line_no++) {
+        size_t comment = line.find_first_of("#;");
+        if (comment != std::string::npos) line.erase(comment);
+        line = trim(line);
+        if (line.empty()) continue;
+
+        std::string where = path + ":" + std::to_string(line_no) + ": ";
+        if (line.front() == '[') {
+            if (line.back() != ']') {
+                error = where + "unterminated section header";
+                return false;
+            }
+            section = lower(trim(line.substr(1, line.size() - 2)));
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string::npos || section.empty()) {
+            error = where + (section.empty() ? "setting outside a [section]" : "expected key = value");
+            return false;
+        }
+        std::string value = trim(line.substr(eq + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+        if (!set(section + "." + lower(trim(line.substr(0, eq))), value, error)) {
+            error = where + error;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> ServerConfig::describe() const {
+    std::vector<std::string> lines;
+    for (const auto& option : options()) {
+        lines.push_back(std::string(option.key) + " = " + option.get(*this));
+    }
+    return lines;
+}
+
+bool load_server_config(int argc, char** argv, ServerConfig& config) {
+    std::string error;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--config=", 0) == 0 && !config.load_file(arg.substr(strlen("--config=")), error)) {
+            std::cerr << error << "\n";
+            return false;
+        }
+    }
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--config=", 0) == 0) continue;
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos) {
+            print_usage(argv[0]);
+            return false;
+        }
+        std::string name = arg.substr(2, eq - 2);
+        const char* key = legacy_key(name);
+        if (!config.set(key ? key : name, arg.substr(eq + 1), error)) {
+            std::cerr << error << "\n";
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+
+    // With checkpoint.dir the server logs and recovers commits itself (see
+    // RedoLog); LineairDB's own checkpoints would only be a second copy
+    if (!config.checkpoint.dir.empty() && config.engine.enable_checkpointing) {
+        std::cerr << "checkpoint.dir cannot be combined with engine.checkpointing\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "lineairdb/lineairdb.h"
+#include "network/tcp_server.hh"
+#include "storage/checkpointer.hh"
+#include "storage/database_manager.hh"
+
+// Everything lineairdb-server can be tuned with, grouped as in the config
+// file:
+//
+//   [engine]     LineairDB::Config: concurrency control, index, logging,
+//                checkpointing, worker threads, epoch length
+//   [network]    listen address and port, accept backlog, socket buffers,
+//                I/O worker count, shared-memory socket
+//   [scheduler]  I/O model, listener groups, engine slot affinity
+//   [checkpoint] the server's own snapshots, plus its own redo log with
+//                engine.durability=wal
+//
+// Values come from the built-in defaults, then the INI file named by
+// --config=PATH, then command-line overrides in order, so the last one wins.
+struct ServerConfig {
+    // engine.threads (max_thread) 0 = one per CPU this process may run on
+    LineairDB::Config engine = DatabaseManager::default_config();
+
+    struct Network {
+        std::string listen_address = "0.0.0.0";
+        uint16_t port = 9999;
+        int backlog = 128;
+        size_t io_workers = 0;            // 0 = one per hardware thread (or group CPU)
+        int socket_send_buffer = 0;       // SO_SNDBUF bytes, 0 = kernel default
+        int socket_receive_buffer = 0;    // SO_RCVBUF bytes, 0 = kernel default
+        std::string shm_socket;           // empty = TCP only
+    } network;
+
+    struct Scheduler {
+        IoModel io_model = IoModel::ThreadPerConnection;
+        bool listener_groups = false;
+        size_t listeners = 0;             // with listener_groups; 0 = one per NUMA node
+        bool engine_affinity = true;      // bind serving threads to engine slots
+    } scheduler;
+
+    // dir empty = no checkpoints; load_threads 0 = one per engine slot
+    Checkpointer::Options checkpoint;
+
+    // Set "section.key" from its text form. False (with error set) for an
+    // unknown key or a value that does not parse.
+    bool set(const std::string& key, const std::string& value, std::string& error);
+
+    // Apply an INI file: [section] headers, key = value lines, # or ;
+    // comments.
+    bool load_file(const std::string& path, std::string& error);
+
+    // Every setting as "section.key = value", in a fixed order
+    std::vector<std::string> describe() const;
+};
+
+// Build the configuration from argv: --config=PATH first, then the other
+// arguments in order. Prints usage or the error and returns false if they
+// do not parse.
+bool load_server_config(int argc, char** argv, ServerConfig& config);
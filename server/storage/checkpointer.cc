@@ -0,0 +1,791 @@
+#include "checkpointer.hh"
+#include "../../common/log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Segment file layout (integers in host byte order, as on the wire):
+//   header   SegmentHeader
+//   records  records x [key_len:4B][value_len:4B][key][value]
+// Table segments hold (primary key, row); index segments hold
+// (secondary key, primary key), one record per primary key.
+constexpr char kSegmentMagic[8] = {'O', 'R', 'D', 'O', 'S', 'E', 'G', '1'};
+constexpr uint32_t kRowRecords = 0;
+constexpr uint32_t kIndexRecords = 1;
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t kind;
+    uint32_t reserved;
+    uint64_t records;
+    uint64_t data_bytes;  // bytes after the header
+};
+static_assert(sizeof(SegmentHeader) == 32, "segment header is 32 bytes");
+
+// Version 2 adds the log line; version 1 checkpoints were consistent
+// without one
+constexpr const char* kManifestHeader = "ordo-checkpoint\t2";
+constexpr const char* kManifestHeaderV1 = "ordo-checkpoint\t1";
+// Records per transaction when loading
+constexpr size_t kLoadBatch = 1000;
+constexpr size_t kMaxLoadAttempts = 1000;
+// Records per read transaction when scanning, and the pause before an
+// aborted chunk is retried, doubled on each retry of the same chunk
+constexpr size_t kScanChunk = 1000;
+constexpr auto kMinRetryPause = std::chrono::microseconds(100);
+constexpr auto kMaxRetryPause = std::chrono::milliseconds(50);
+
+// Set by request(), possibly from a signal handler
+std::atomic<bool> checkpoint_requested{false};
+static_assert(std::atomic<bool>::is_always_lock_free, "request() must be signal-safe");
+
+double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool fsync_path(const fs::path& path, bool directory) {
+    int fd = ::open(path.c_str(), directory ? (O_RDONLY | O_DIRECTORY) : O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+bool write_file_synced(const fs::path& path, const std::string& content) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(content.data(), 1, content.size(), file) == content.size() &&
+              std::fflush(file) == 0 && ::fsync(fileno(file)) == 0;
+    return std::fclose(file) == 0 && ok;
+}
+
+bool read_file(const fs::path& path, std::string& content) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+std::vector<std::string> split(const std::string& line, char sep) {
+    std::vector<std::string> fields;
+    size_t begin = 0;
+    for (size_t pos; (pos = line.find(sep, begin)) != std::string::npos; begin = pos + 1) {
+        fields.push_back(line.substr(begin, pos - begin));
+    }
+    fields.push_back(line.substr(begin));
+    return fields;
+}
+
+// One segment file being written through a large stdio buffer; the header
+// is rewritten with the final counts on close
+class SegmentWriter {
+public:
+    ~SegmentWriter() {
+        if (file_) std::fclose(file_);
+    }
+
+    bool is_open() const { return file_ != nullptr; }
+    uint64_t records() const { return header_.records; }
+    uint64_t data_bytes() const { return header_.data_bytes; }
+
+    bool open(const fs::path& path, uint32_t kind) {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) return false;
+        std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+        std::memcpy(header_.magic, kSegmentMagic, sizeof(kSegmentMagic));
+        header_.kind = kind;
+        header_.reserved = 0;
+        header_.records = 0;
+        header_.data_bytes = 0;
+        return std::fwrite(&header_, sizeof(header_), 1, file_) == 1;
+    }
+
+    bool add(std::string_view key, std::string_view value) {
+        uint32_t lens[2] = {static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size())};
+        if (std::fwrite(lens, sizeof(lens), 1, file_) != 1 ||
+            std::fwrite(key.data(), 1, key.size(), file_) != key.size() ||
+            std::fwrite(value.data(), 1, value.size(), file_) != value.size()) {
+            return false;
+        }
+        header_.records++;
+        header_.data_bytes += sizeof(lens) + key.size() + value.size();
+        return true;
+    }
+
+    bool close() {
+        bool ok = std::fseek(file_, 0, SEEK_SET) == 0 &&
+                  std::fwrite(&header_, sizeof(header_), 1, file_) == 1 &&
+                  std::fflush(file_) == 0 && ::fsync(fileno(file_)) == 0;
+        ok = std::fclose(file_) == 0 && ok;
+        file_ = nullptr;
+        return ok;
+    }
+
+private:
+    std::FILE* file_ = nullptr;
+    SegmentHeader header_{};
+};
+
+// The checkpoint being written: its directory, manifest and totals
+struct CheckpointFiles {
+    fs::path dir;
+    size_t segment_bytes;
+    std::string manifest;
+    size_t segments = 0;
+    uint64_t bytes = 0;
+};
+
+// Segments of one table or index, started afresh every segment_bytes
+class SegmentSeries {
+public:
+    SegmentSeries(CheckpointFiles& files, const std::string& table, const std::string& index)
+        : files_(files), table_(table), index_(index) {}
+
+    bool add(std::string_view key, std::string_view value) {
+        if (!writer_.is_open() || writer_.data_bytes() >= files_.segment_bytes) {
+            if (writer_.is_open() && !close_segment()) return false;
+            char name[32];
+            std::snprintf(name, sizeof(name), "seg-%06zu", files_.segments++);
+            file_name_ = name;
+            if (!writer_.open(files_.dir / file_name_, index_.empty() ? kRowRecords : kIndexRecords)) {
+                return false;
+            }
+        }
+        return writer_.add(key, value);
+    }
+
+    bool finish() { return !writer_.is_open() || close_segment(); }
+
+private:
+    bool close_segment() {
+        uint64_t records = writer_.records();
+        files_.bytes += sizeof(SegmentHeader) + writer_.data_bytes();
+        files_.manifest += "segment\t" + file_name_ + "\t" + table_ + "\t" + index_ + "\t" +
+                           std::to_string(records) + "\n";
+        return writer_.close();
+    }
+
+    CheckpointFiles& files_;
+    const std::string table_;
+    const std::string index_;
+    SegmentWriter writer_;
+    std::string file_name_;
+};
+
+// One chunk of a table's rows, or of an index's (secondary key, primary
+// key) entries
+struct ScanChunk {
+    std::vector<std::pair<std::string, std::string>> records;
+    std::string last_key;  // to resume after, when more may follow
+    bool more = false;
+};
+
+// Read the records from begin on into chunk in one read-only transaction,
+// stopping at the first key that fills it to limit. False if the
+// transaction aborted.
+bool read_chunk(LineairDB::Database& db, const std::string& table, const std::string& index,
+                const std::string& begin, size_t limit, ScanChunk& chunk) {
+    chunk.records.clear();
+    chunk.more = false;
+    auto& tx = db.BeginTransaction();
+    tx.SetTable(table);
+    std::optional<size_t> scanned;
+    if (index.empty()) {
+        scanned = tx.Scan(begin, std::nullopt, [&](auto key, auto value) {
+            if (value.first == nullptr || value.second == 0) return false;  // deleted row
+            chunk.records.emplace_back(
+                std::string(key), std::string(static_cast<const char*>(value.first), value.second));
+            if (chunk.records.size() < limit) return false;
+            chunk.last_key.assign(key.data(), key.size());
+            chunk.more = true;
+            return true;
+        });
+    } else {
+        scanned = tx.ScanSecondaryIndex(
+            index, begin, std::nullopt,
+            [&](std::string_view secondary_key, const std::vector<std::string>& primary_keys) {
+                for (const auto& primary_key : primary_keys) {
+                    chunk.records.emplace_back(std::string(secondary_key), primary_key);
+                }
+                if (chunk.records.size() < limit) return false;
+                chunk.last_key.assign(secondary_key.data(), secondary_key.size());
+                chunk.more = true;
+                return true;
+            });
+    }
+    if (!scanned.has_value() || tx.IsAborted()) {
+        tx.Abort();
+    }
+    return db.EndTransaction(tx, [](LineairDB::TxStatus) {});
+}
+
+struct SegmentRef {
+    std::string file;
+    std::string table;
+    std::string index;  // empty for a table segment
+    uint64_t records;
+};
+
+// Parse the record at p, advancing p; false if it runs past end
+bool next_record(const char*& p, const char* end, std::string_view& key, std::string_view& value) {
+    uint32_t lens[2];
+    if (static_cast<size_t>(end - p) < sizeof(lens)) return false;
+    std::memcpy(lens, p, sizeof(lens));
+    p += sizeof(lens);
+    if (static_cast<size_t>(end - p) < static_cast<size_t>(lens[0]) + lens[1]) return false;
+    key = std::string_view(p, lens[0]);
+    value = std::string_view(p + lens[0], lens[1]);
+    p += static_cast<size_t>(lens[0]) + lens[1];
+    return true;
+}
+
+// Write one mapped segment's records into the database, kLoadBatch per
+// transaction
+bool load_segment(LineairDB::Database& db, const fs::path& path, const SegmentRef& ref) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Cannot open checkpoint segment %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SegmentHeader)) {
+        ::close(fd);
+        LOG_ERROR("Checkpoint segment %s is truncated", path.c_str());
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        LOG_ERROR("Cannot map checkpoint segment %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    ::madvise(map, size, MADV_SEQUENTIAL);
+
+    const char* base = static_cast<const char*>(map);
+    SegmentHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    uint32_t kind = ref.index.empty() ? kRowRecords : kIndexRecords;
+    bool ok = std::memcmp(header.magic, kSegmentMagic, sizeof(kSegmentMagic)) == 0 &&
+              header.kind == kind && header.records == ref.records &&
+              header.data_bytes == size - sizeof(header);
+    if (!ok) {
+        LOG_ERROR("Checkpoint segment %s does not match the manifest", path.c_str());
+    }
+
+    const char* p = base + sizeof(header);
+    const char* end = base + size;
+    std::string_view key, value;
+    while (ok && p < end) {
+        const char* batch = p;
+        size_t attempts = 0;
+        bool committed = false;
+        while (ok && !committed) {
+            p = batch;
+            auto& tx = db.BeginTransaction();
+            tx.SetTable(ref.table);
+            for (size_t n = 0; n < kLoadBatch && p < end; n++) {
+                if (!next_record(p, end, key, value)) {
+                    LOG_ERROR("Checkpoint segment %s is corrupt", path.c_str());
+                    ok = false;
+                    break;
+                }
+                const auto* bytes = reinterpret_cast<const std::byte*>(value.data());
+                if (kind == kRowRecords) {
+                    tx.Write(key, bytes, value.size());
+                } else {
+                    tx.WriteSecondaryIndex(ref.index, key, bytes, value.size());
+                }
+            }
+            if (!ok) tx.Abort();
+            committed = db.EndTransaction(tx, [](LineairDB::TxStatus) {});
+            // Only batches that share a secondary key with another
+            // segment's can conflict
+            if (ok && !committed && ++attempts == kMaxLoadAttempts) {
+                LOG_ERROR("Loading checkpoint segment %s keeps aborting", path.c_str());
+                ok = false;
+            }
+        }
+    }
+    ::munmap(map, size);
+    return ok;
+}
+
+// Rows to seed TableRowCounts with, in the shape apply_deltas() takes
+struct RowCount {
+    std::string name;
+    int64_t rows;
+    const std::string& table_name() const { return name; }
+    int64_t delta() const { return rows; }
+};
+
+using ViewPair = std::pair<std::string_view, std::string_view>;
+
+struct ViewPairHash {
+    size_t operator()(const ViewPair& pair) const {
+        size_t seed = std::hash<std::string_view>{}(pair.first);
+        return seed ^ (std::hash<std::string_view>{}(pair.second) + 0x9e3779b97f4a7c15ull +
+                       (seed << 6) + (seed >> 2));
+    }
+};
+
+// Run apply(tx, item) over items, kLoadBatch per transaction on table;
+// apply returns the item's row count change, added to rows once its batch
+// commits
+template <typename Item, typename Apply>
+bool apply_batches(LineairDB::Database& db, std::string_view table, const std::vector<Item>& items,
+                   Apply apply, int64_t& rows) {
+    for (size_t begin = 0; begin < items.size(); begin += kLoadBatch) {
+        size_t end = std::min(items.size(), begin + kLoadBatch);
+        for (size_t attempts = 0;;) {
+            auto& tx = db.BeginTransaction();
+            tx.SetTable(table);
+            int64_t delta = 0;
+            for (size_t i = begin; i < end && !tx.IsAborted(); i++) {
+                delta += apply(tx, items[i]);
+            }
+            if (db.EndTransaction(tx, [](LineairDB::TxStatus) {})) {
+                rows += delta;
+                break;
+            }
+            if (++attempts == kMaxLoadAttempts) {
+                LOG_ERROR("Replaying the redo log into %.*s keeps aborting",
+                          static_cast<int>(table.size()), table.data());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Bring every row and index entry the logged commits wrote to its last
+// logged state, and recreate the tables and indexes they created. Removals
+// go first, so a unique index never holds an old and a new entry at once.
+// counts gets each table's row count change.
+bool replay_log(DatabaseManager& db_manager, const RedoLog::Reader& log, std::vector<RowCount>& counts) {
+    using Op = RedoLog::Op;
+    // table -> key -> value, nullopt once erased
+    std::unordered_map<std::string_view, std::unordered_map<std::string_view, std::optional<std::string_view>>> rows;
+    // (table, index) -> (secondary key, primary key) -> present
+    std::unordered_map<ViewPair, std::unordered_map<ViewPair, bool, ViewPairHash>, ViewPairHash> entries;
+
+    for (std::string_view body : log.records()) {
+        std::string_view table;
+        bool ok = RedoLog::Reader::parse(body, [&](const RedoLog::OpView& op) {
+            const auto* f = op.fields;
+            switch (op.op) {
+                case Op::kTable:
+                    table = f[0];
+                    break;
+                case Op::kPut:
+                    rows[table][f[0]] = f[1];
+                    break;
+                case Op::kErase:
+                    rows[table][f[0]] = std::nullopt;
+                    break;
+                case Op::kAddEntry:
+                case Op::kRemoveEntry:
+                    entries[{table, f[0]}][{f[1], f[2]}] = op.op == Op::kAddEntry;
+                    break;
+                case Op::kCreateTable:
+                    db_manager.create_table(std::string(f[0]));
+                    break;
+                case Op::kCreateIndex: {
+                    uint32_t type;
+                    std::memcpy(&type, f[2].data(), sizeof(type));
+                    db_manager.create_secondary_index(std::string(f[0]), std::string(f[1]), type);
+                    break;
+                }
+            }
+        });
+        if (!ok) {
+            LOG_ERROR("Malformed redo log record");
+            return false;
+        }
+    }
+
+    auto& db = *db_manager.get_database();
+    using RowState = std::pair<std::string_view, std::optional<std::string_view>>;
+    using EntryState = std::pair<ViewPair, bool>;
+    auto apply_row = [](LineairDB::Transaction& tx, const RowState& row) -> int64_t {
+        auto current = tx.Read(row.first);
+        bool existed = current.first != nullptr && current.second != 0;
+        if (row.second) {
+            tx.Write(row.first, reinterpret_cast<const std::byte*>(row.second->data()), row.second->size());
+            return existed ? 0 : 1;
+        }
+        if (!existed) return 0;
+        tx.Delete(row.first);
+        return -1;
+    };
+    for (bool removals : {true, false}) {
+        for (const auto& [table, keys] : rows) {
+            std::vector<RowState> batch;
+            for (const auto& row : keys) {
+                if (row.second.has_value() != removals) batch.push_back(row);
+            }
+            int64_t delta = 0;
+            if (!apply_batches(db, table, batch, apply_row, delta)) return false;
+            if (delta != 0) counts.push_back({std::string(table), delta});
+        }
+        for (const auto& [table_index, keys] : entries) {
+            std::string_view index = table_index.second;
+            auto apply_entry = [index](LineairDB::Transaction& tx, const EntryState& entry) -> int64_t {
+                const auto& [secondary_key, primary_key] = entry.first;
+                bool present = false;
+                for (const auto& [ptr, size] : tx.ReadSecondaryIndex(index, secondary_key)) {
+                    present = present ||
+                              std::string_view(reinterpret_cast<const char*>(ptr), size) == primary_key;
+                }
+                const auto* bytes = reinterpret_cast<const std::byte*>(primary_key.data());
+                if (entry.second && !present) {
+                    tx.WriteSecondaryIndex(index, secondary_key, bytes, primary_key.size());
+                } else if (!entry.second && present) {
+                    tx.DeleteSecondaryIndex(index, secondary_key, bytes, primary_key.size());
+                }
+                return 0;
+            };
+            std::vector<EntryState> batch;
+            for (const auto& entry : keys) {
+                if (entry.second != removals) batch.push_back(entry);
+            }
+            int64_t unused = 0;
+            if (!apply_batches(db, table_index.first, batch, apply_entry, unused)) return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+Checkpointer::Checkpointer(Options options, std::shared_ptr<DatabaseManager> db_manager,
+                           std::shared_ptr<TableRowCounts> row_counts)
+    : options_(std::move(options)), db_manager_(std::move(db_manager)),
+      row_counts_(std::move(row_counts)) {
+    std::error_code ec;
+    fs::create_directories(options_.dir, ec);
+    if (ec) {
+        LOG_WARNING("Cannot create checkpoint directory %s: %s", options_.dir.c_str(), ec.message().c_str());
+    }
+    // Number new checkpoints past any already here, and drop the leftovers
+    // of one that was interrupted
+    for (const auto& entry : fs::directory_iterator(options_.dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("ckpt-", 0) != 0) continue;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0) {
+            fs::remove_all(entry.path(), ec);
+            continue;
+        }
+        uint64_t seq = std::strtoull(name.c_str() + 5, nullptr, 10);
+        next_seq_ = std::max(next_seq_, seq + 1);
+    }
+}
+
+Checkpointer::~Checkpointer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void Checkpointer::start() {
+    if (thread_.joinable()) return;
+    thread_ = std::thread([this] { run(); });
+}
+
+void Checkpointer::request() { checkpoint_requested.store(true); }
+
+void Checkpointer::run() {
+    auto last = Clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    // A signal handler cannot notify cv_, so requests are polled
+    while (!cv_.wait_for(lock, std::chrono::seconds(1), [this] { return stop_; })) {
+        bool due = options_.period_s > 0 &&
+                   Clock::now() - last >= std::chrono::seconds(options_.period_s);
+        if (!checkpoint_requested.exchange(false) && !due) continue;
+        lock.unlock();
+        checkpoint_now();
+        last = Clock::now();
+        lock.lock();
+    }
+}
+
+bool Checkpointer::stopping() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stop_;
+}
+
+bool Checkpointer::checkpoint_now() {
+    if (!log_) {
+        LOG_ERROR("Checkpoint skipped: the checkpointer was not loaded");
+        return false;
+    }
+    auto start = Clock::now();
+    // Commits from here on are logged; the catalog is read after, so a table
+    // created meanwhile is in it or in the log
+    uint64_t log_from = log_->begin_capture();
+    auto tables = db_manager_->catalog();
+    for (const auto& table : tables) {
+        bool bad = table.name.find_first_of("\t\n") != std::string::npos;
+        for (const auto& index : table.indexes) {
+            bad = bad || index.name.find_first_of("\t\n") != std::string::npos;
+        }
+        if (bad) {
+            log_->end_capture();
+            LOG_ERROR("Checkpoint skipped: table %s or one of its indexes has a tab or newline in its name",
+                      table.name.c_str());
+            return false;
+        }
+    }
+
+    std::string name = "ckpt-" + std::to_string(next_seq_);
+    fs::path dir(options_.dir);
+    CheckpointFiles files{dir / (name + ".tmp"), std::max<size_t>(options_.segment_bytes, 1), {}, 0, 0};
+    files.manifest = std::string(kManifestHeader) + "\n";
+    std::error_code ec;
+    fs::remove_all(files.dir, ec);
+    fs::create_directories(files.dir, ec);
+    if (ec) {
+        log_->end_capture();
+        LOG_ERROR("Cannot create %s: %s", files.dir.c_str(), ec.message().c_str());
+        return false;
+    }
+
+    // Each table and index in chunks of short read-only transactions. A
+    // chunk that aborts is retried at half the size after a pause, which
+    // doubles while the same chunk keeps aborting.
+    auto& db = *db_manager_->get_database();
+    bool io_ok = true;
+    bool stopped = false;
+    size_t retries = 0;
+    ScanChunk chunk;
+    auto scan = [&](const std::string& table, const std::string& index, SegmentSeries& series) {
+        std::string begin;
+        size_t limit = kScanChunk;
+        auto pause = std::chrono::duration_cast<std::chrono::microseconds>(kMinRetryPause);
+        uint64_t records = 0;
+        while (io_ok) {
+            if (!read_chunk(db, table, index, begin, limit, chunk)) {
+                if ((stopped = stopping())) break;
+                retries++;
+                std::this_thread::sleep_for(pause);
+                pause = std::min<std::chrono::microseconds>(pause * 2, kMaxRetryPause);
+                limit = std::max<size_t>(1, limit / 2);
+                continue;
+            }
+            pause = kMinRetryPause;
+            limit = std::min(kScanChunk, limit * 2);
+            for (const auto& [key, value] : chunk.records) {
+                io_ok = io_ok && series.add(key, value);
+            }
+            records += chunk.records.size();
+            if (!chunk.more) break;
+            begin = chunk.last_key;
+            begin.push_back('\0');  // the first key after it
+        }
+        io_ok = io_ok && series.finish();
+        return records;
+    };
+
+    uint64_t rows = 0;
+    uint64_t entries = 0;
+    for (const auto& table : tables) {
+        SegmentSeries data(files, table.name, "");
+        uint64_t live = scan(table.name, "", data);
+        files.manifest += "table\t" + table.name + "\t" + std::to_string(live) + "\n";
+        rows += live;
+
+        for (const auto& index : table.indexes) {
+            if (stopped || !io_ok) break;
+            files.manifest += "index\t" + table.name + "\t" + index.name + "\t" +
+                              std::to_string(index.type) + "\n";
+            SegmentSeries series(files, table.name, index.name);
+            entries += scan(table.name, index.name, series);
+        }
+        if (stopped || !io_ok) break;
+    }
+    // Loading replays log_from..log_to (log_to 0: the whole log from
+    // log_from) over the segments
+    uint64_t log_to = log_->end_capture();
+    files.manifest += "log\t" + std::to_string(log_from) + "\t" + std::to_string(log_to) + "\n";
+    if (stopped || !io_ok) {
+        fs::remove_all(files.dir, ec);
+        if (!io_ok) {
+            LOG_ERROR("Checkpoint %s failed writing to %s", name.c_str(), files.dir.c_str());
+        } else {
+            LOG_WARNING("Checkpoint %s abandoned: the server is stopping", name.c_str());
+        }
+        return false;
+    }
+
+    // Publish: manifest, rename, then CURRENT, each durable before the next
+    fs::path final_dir = dir / name;
+    bool ok = write_file_synced(files.dir / "MANIFEST", files.manifest) &&
+              fsync_path(files.dir, true);
+    if (ok) {
+        fs::rename(files.dir, final_dir, ec);
+        ok = !ec && fsync_path(dir, true) &&
+             write_file_synced(dir / "CURRENT.tmp", name + "\n");
+    }
+    if (ok) {
+        fs::rename(dir / "CURRENT.tmp", dir / "CURRENT", ec);
+        ok = !ec && fsync_path(dir, true);
+    }
+    if (!ok) {
+        LOG_ERROR("Checkpoint %s could not be published in %s", name.c_str(), options_.dir.c_str());
+        fs::remove_all(files.dir, ec);
+        return false;
+    }
+    next_seq_++;
+
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        std::string old = entry.path().filename().string();
+        if (old.rfind("ckpt-", 0) == 0 && old != name) {
+            fs::remove_all(entry.path(), ec);
+        }
+    }
+    log_->truncate(log_from);
+    LOG_INFO("Checkpoint %s: %zu tables, %lu rows, %lu index entries in %zu segments (%.1f MiB) "
+             "in %.1f ms, %zu chunk retries",
+             name.c_str(), tables.size(), rows, entries, files.segments,
+             files.bytes / (1024.0 * 1024.0), ms_since(start), retries);
+    return true;
+}
+
+bool Checkpointer::load() {
+    fs::path dir(options_.dir);
+    std::string current;
+    // A durable log is replayed even without a checkpoint under it
+    bool replay = options_.durable;
+    uint64_t log_from = 0;
+    uint64_t log_to = 0;
+    if (read_file(dir / "CURRENT", current)) {
+        current.erase(current.find_last_not_of("\r\n") + 1);
+        if (!load_segments(current, replay, log_from, log_to)) return false;
+    } else {
+        LOG_INFO("No checkpoint in %s%s", options_.dir.c_str(), replay ? "" : ", starting empty");
+    }
+
+    uint64_t next_lsn = std::max<uint64_t>(log_to, 1);
+    if (replay) {
+        auto start = Clock::now();
+        RedoLog::Reader reader;
+        std::vector<RowCount> counts;
+        if (!reader.open(options_.dir, log_from, log_to) ||
+            !replay_log(*db_manager_, reader, counts)) {
+            return false;
+        }
+        row_counts_->apply_deltas(counts);
+        next_lsn = std::max(next_lsn, reader.next_lsn());
+        LOG_INFO("Replayed %zu commits (%.1f MiB) from the redo log in %.1f ms", reader.records().size(),
+                 reader.bytes() / (1024.0 * 1024.0), ms_since(start));
+    }
+    log_ = std::make_shared<RedoLog>(options_.dir, options_.durable, next_lsn);
+    db_manager_->set_redo_log(log_);
+    return true;
+}
+
+bool Checkpointer::load_segments(const std::string& current, bool& replay, uint64_t& log_from,
+                                 uint64_t& log_to) {
+    auto start = Clock::now();
+    fs::path checkpoint = fs::path(options_.dir) / current;
+
+    std::string manifest;
+    if (!read_file(checkpoint / "MANIFEST", manifest)) {
+        LOG_ERROR("Checkpoint %s has no MANIFEST", checkpoint.c_str());
+        return false;
+    }
+    std::vector<std::string> lines = split(manifest, '\n');
+    if (lines.empty() || (lines[0] != kManifestHeader && lines[0] != kManifestHeaderV1)) {
+        LOG_ERROR("%s is not a checkpoint manifest this server can read", (checkpoint / "MANIFEST").c_str());
+        return false;
+    }
+
+    std::vector<RowCount> counts;
+    std::vector<SegmentRef> segments;
+    uint64_t rows = 0;
+    for (size_t i = 1; i < lines.size(); i++) {
+        if (lines[i].empty()) continue;
+        std::vector<std::string> f = split(lines[i], '\t');
+        if (f[0] == "table" && f.size() == 3) {
+            db_manager_->create_table(f[1]);
+            counts.push_back({f[1], std::strtoll(f[2].c_str(), nullptr, 10)});
+        } else if (f[0] == "index" && f.size() == 4) {
+            db_manager_->create_secondary_index(f[1], f[2],
+                                                static_cast<uint32_t>(std::strtoul(f[3].c_str(), nullptr, 10)));
+        } else if (f[0] == "segment" && f.size() == 5) {
+            segments.push_back({f[1], f[2], f[3], std::strtoull(f[4].c_str(), nullptr, 10)});
+            if (f[3].empty()) rows += segments.back().records;
+        } else if (f[0] == "log" && f.size() == 3) {
+            replay = true;
+            log_from = std::strtoull(f[1].c_str(), nullptr, 10);
+            log_to = std::strtoull(f[2].c_str(), nullptr, 10);
+        } else {
+            LOG_ERROR("Bad line %zu in %s", i + 1, (checkpoint / "MANIFEST").c_str());
+            return false;
+        }
+    }
+
+    // Largest segments first, so the last ones to finish are short
+    std::sort(segments.begin(), segments.end(),
+              [](const SegmentRef& a, const SegmentRef& b) { return a.records > b.records; });
+    size_t num_threads = options_.load_threads;
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    num_threads = std::max<size_t>(1, std::min(num_threads, segments.size()));
+
+    auto& db = *db_manager_->get_database();
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < num_threads; t++) {
+        workers.emplace_back([&] {
+            for (size_t i; !failed.load() && (i = next.fetch_add(1)) < segments.size();) {
+                if (!load_segment(db, checkpoint / segments[i].file, segments[i])) {
+                    failed = true;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    if (failed) {
+        return false;
+    }
+
+    row_counts_->apply_deltas(counts);
+    uint64_t bytes = 0;
+    std::error_code ec;
+    for (const auto& segment : segments) {
+        bytes += fs::file_size(checkpoint / segment.file, ec);
+    }
+    LOG_INFO("Loaded checkpoint %s: %zu tables, %lu rows, %zu segments (%.1f MiB) with %zu threads in %.1f ms",
+             current.c_str(), counts.size(), rows, segments.size(), bytes / (1024.0 * 1024.0),
+             num_threads, ms_since(start));
+    return true;
+}
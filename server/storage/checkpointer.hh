@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "database_manager.hh"
+#include "redo_log.hh"
+#include "table_row_counts.hh"
+
+// Periodic snapshots of every table and secondary index, loaded back in
+// parallel when the server starts, so an in-memory server can be restarted
+// without reloading its data through MySQL.
+//
+// A checkpoint scans each table and index in chunks of short read-only
+// transactions, so concurrent commits do not abort it; a chunk that aborts
+// is retried at once, smaller, after a short pause. Each row or index entry
+// is then as of some moment during the scan. The checkpoint records where
+// the redo log (redo_log.hh) stood when the scan started, and loading it
+// replays the commits logged from there on over its segments, which leaves
+// the tables consistent with each other again: as of the end of the scan,
+// or with durable, as of the last commit logged before the server stopped.
+//
+// Rows, and (secondary key, primary key) index entries, stream in key order
+// into segment files of up to segment_bytes under <dir>/ckpt-<seq>.tmp. A
+// MANIFEST lists the catalog, each table's row count as scanned, the
+// segments and the log range. Once everything is fsynced the directory is
+// renamed to ckpt-<seq> and named in <dir>/CURRENT, and older checkpoints,
+// and the log before this one's start, are removed.
+//
+// A segment is a 32-byte header followed by length-prefixed records, read
+// in place through mmap. Loading hands whole segments to load_threads
+// workers, and each worker writes its segment's records in batches of
+// transactions. Without durable, commits after the last checkpoint are lost
+// on restart; with it (engine.durability=wal) every commit is logged and
+// recovered, and LineairDB's own log is off.
+class Checkpointer {
+public:
+    struct Options {
+        std::string dir;
+        size_t period_s = 300;  // 0 = only on request()
+        size_t segment_bytes = 256u << 20;
+        size_t load_threads = 0;  // 0 = one per hardware thread
+        bool durable = false;     // log every commit, not just during checkpoints
+    };
+
+    Checkpointer(Options options, std::shared_ptr<DatabaseManager> db_manager,
+                 std::shared_ptr<TableRowCounts> row_counts);
+    ~Checkpointer();  // stops the periodic thread
+
+    // Recreate the catalog and data of the checkpoint named in <dir>/CURRENT,
+    // if there is one, replay the redo log over it and start logging. Call
+    // before serving and before anything else here. False if it cannot be
+    // read.
+    bool load();
+
+    // Take checkpoints every period_s, and whenever request() is called,
+    // from a background thread
+    void start();
+
+    // Ask the running checkpointer for a checkpoint within a second.
+    // Async-signal-safe; the server calls it on SIGUSR1.
+    static void request();
+
+    // Take one checkpoint now. False if it could not be written, or the
+    // checkpointer stopped meanwhile.
+    bool checkpoint_now();
+
+private:
+    void run();
+    bool stopping();
+    // Load the segments of checkpoint current; replay is set if it names the
+    // log range to replay over them
+    bool load_segments(const std::string& current, bool& replay, uint64_t& log_from,
+                       uint64_t& log_to);
+
+    const Options options_;
+    std::shared_ptr<DatabaseManager> db_manager_;
+    std::shared_ptr<TableRowCounts> row_counts_;
+    std::shared_ptr<RedoLog> log_;
+    uint64_t next_seq_ = 1;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+};
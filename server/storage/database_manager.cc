@@ -1,18 +1,82 @@
 #include "database_manager.hh"
 #include "../../common/log.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
+#include <system_error>
+#include <thread>
 
-DatabaseManager::DatabaseManager() {
-    // Initialize lineairdb
-    // TODO: make configurable
+LineairDB::Config DatabaseManager::default_config() {
     LineairDB::Config conf;
     conf.enable_checkpointing = false;
     conf.enable_recovery      = false;
     conf.enable_logging       = false;  // avoid per-thread LineairDB logs
-    conf.max_thread           = 1;
+    conf.max_thread           = 0;
     conf.concurrency_control_protocol = LineairDB::Config::ConcurrencyControl::Silo;
     conf.index_structure = LineairDB::Config::IndexStructure::Masstree;
+    return conf;
+}
+
+DatabaseManager::DatabaseManager(LineairDB::Config conf) {
+    if (conf.max_thread == 0) {
+        conf.max_thread = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (conf.enable_logging || conf.enable_checkpointing) {
+        std::error_code ec;
+        std::filesystem::create_directories(conf.work_dir, ec);
+        if (ec) {
+            LOG_WARNING("Cannot create LineairDB work_dir %s: %s", conf.work_dir.c_str(), ec.message().c_str());
+        }
+    }
     database_ = std::make_shared<LineairDB::Database>(conf);
-    LOG_INFO("Database manager initialized");
+    LOG_INFO("Database manager initialized (max_thread=%zu)", conf.max_thread);
+    if (conf.enable_logging) {
+        // Commits become durable a whole epoch at a time, when the epoch's
+        // log records are flushed
+        LOG_INFO("Durable mode: write-ahead log in %s, group commit every %zu ms%s",
+                 conf.work_dir.c_str(), conf.epoch_duration_ms,
+                 conf.enable_recovery ? ", recovering from it at startup" : "");
+    } else {
+        LOG_INFO("In-memory mode: nothing is logged");
+    }
+}
+
+bool DatabaseManager::create_table(const std::string& table_name) {
+    bool created = database_->CreateTable(table_name);
+    if (created && redo_log_) {
+        redo_log_->log_create_table(table_name);
+    }
+    std::lock_guard<std::mutex> lock(catalog_mutex_);
+    catalog_entry(table_name);  // also when it came back from recovery
+    return created;
+}
+
+bool DatabaseManager::create_secondary_index(const std::string& table_name,
+                                             const std::string& index_name, uint32_t index_type) {
+    bool created = database_->CreateSecondaryIndex(table_name, index_name, index_type);
+    if (created && redo_log_) {
+        redo_log_->log_create_index(table_name, index_name, index_type);
+    }
+    std::lock_guard<std::mutex> lock(catalog_mutex_);
+    auto& indexes = catalog_entry(table_name).indexes;
+    bool known = std::any_of(indexes.begin(), indexes.end(),
+                             [&index_name](const IndexDef& index) { return index.name == index_name; });
+    if (!known) {
+        indexes.push_back({index_name, index_type});
+    }
+    return created;
+}
+
+std::vector<DatabaseManager::TableDef> DatabaseManager::catalog() const {
+    std::lock_guard<std::mutex> lock(catalog_mutex_);
+    return tables_;
+}
+
+DatabaseManager::TableDef& DatabaseManager::catalog_entry(const std::string& table_name) {
+    for (auto& table : tables_) {
+        if (table.name == table_name) return table;
+    }
+    tables_.push_back({table_name, {}});
+    return tables_.back();
 }
@@ -1,16 +1,56 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 #include "lineairdb/lineairdb.h"
+#include "redo_log.hh"
 
 class DatabaseManager {
 public:
-    DatabaseManager();
+    // conf.max_thread 0 = one per hardware thread. With logging on,
+    // conf.work_dir is created if missing.
+    explicit DatabaseManager(LineairDB::Config conf = default_config());
     ~DatabaseManager() = default;
 
+    // In-memory Silo over Masstree, without logging, checkpoints or recovery
+    static LineairDB::Config default_config();
+
     std::shared_ptr<LineairDB::Database> get_database() const { return database_; }
-    
+
+    struct IndexDef {
+        std::string name;
+        uint32_t type;  // as passed to CreateSecondaryIndex
+    };
+    struct TableDef {
+        std::string name;
+        std::vector<IndexDef> indexes;
+    };
+
+    // CreateTable / CreateSecondaryIndex that also record the table or index
+    // in the catalog (checkpoints need the list); false if it already existed
+    bool create_table(const std::string& table_name);
+    bool create_secondary_index(const std::string& table_name, const std::string& index_name,
+                                uint32_t index_type);
+    // Tables and their indexes in creation order
+    std::vector<TableDef> catalog() const;
+
+    // The checkpointer's redo log, which commits and DDL are recorded in;
+    // set once before serving, null without checkpoint.dir
+    void set_redo_log(std::shared_ptr<RedoLog> redo_log) { redo_log_ = std::move(redo_log); }
+    RedoLog* redo_log() const { return redo_log_.get(); }
+
 private:
     std::shared_ptr<LineairDB::Database> database_;
+    std::shared_ptr<RedoLog> redo_log_;
+
+    // Only DDL and checkpoints take it
+    mutable std::mutex catalog_mutex_;
+    std::vector<TableDef> tables_;
+
+    TableDef& catalog_entry(const std::string& table_name);  // under catalog_mutex_
 };
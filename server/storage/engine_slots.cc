@@ -0,0 +1,93 @@
+#include "engine_slots.hh"
+#include "../network/cpu_groups.hh"
+#include "../../common/log.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <limits>
+
+// A thread's slot; released when the thread exits
+struct EngineSlots::Binding {
+    std::shared_ptr<EngineSlots> owner;
+    size_t slot = 0;
+
+    ~Binding() {
+        if (owner) owner->release(slot);
+    }
+};
+
+EngineSlots::EngineSlots(std::vector<int> cpus, size_t count) {
+    if (cpus.empty()) {
+        cpus.push_back(0);  // no affinity mask to go by; pinning will just fail
+    }
+    if (count == 0) {
+        count = cpus.size();
+    }
+    slot_cpus_.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        slot_cpus_.push_back(cpus[i % cpus.size()]);
+    }
+    load_.assign(count, 0);
+}
+
+size_t EngineSlots::bind_current_thread() {
+    thread_local Binding binding;
+    if (binding.owner.get() == this) {
+        return binding.slot;
+    }
+    size_t slot = pick_slot();
+    binding.owner = shared_from_this();
+    binding.slot = slot;
+
+    CpuGroup cpu;
+    cpu.cpus.push_back(slot_cpus_[slot]);
+    pin_to_group(cpu);
+    LOG_DEBUG("Bound serving thread to engine slot %zu (cpu %d)", slot, slot_cpus_[slot]);
+    return slot;
+}
+
+size_t EngineSlots::pick_slot() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool have_mask = pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed) == 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t best = 0;
+    uint32_t best_load = std::numeric_limits<uint32_t>::max();
+    bool best_allowed = false;
+    for (size_t i = 0; i < slot_cpus_.size(); i++) {
+        bool is_allowed = have_mask && CPU_ISSET(slot_cpus_[i], &allowed);
+        // Any slot on an allowed CPU beats every slot elsewhere
+        if (is_allowed != best_allowed ? is_allowed : load_[i] < best_load) {
+            best = i;
+            best_load = load_[i];
+            best_allowed = is_allowed;
+        }
+    }
+    load_[best]++;
+    return best;
+}
+
+void EngineSlots::release(size_t slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    load_[slot]--;
+}
+
+std::string EngineSlots::describe() const {
+    std::vector<int> cpus = slot_cpus_;
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+
+    std::string out = std::to_string(slot_cpus_.size()) + " slots on cpus ";
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+        if (i > 0) out += ",";
+        out += std::to_string(cpus[i]);
+        if (j > i) out += "-" + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// LineairDB thread slots and the server threads bound to them.
+//
+// The engine is configured with one thread per slot (Config::max_thread),
+// and each slot owns one CPU. Every thread that serves connections binds
+// itself to a slot before its first transaction and is pinned to the slot's
+// CPU, so the per-thread epoch and log state LineairDB creates for it is
+// only ever touched from that core. A thread picks the least loaded slot
+// among those on CPUs it may already run on (its listener group's, with
+// --listeners), falling back to any slot; with more serving threads than
+// slots (thread-per-connection with many proxies) threads share slots
+// evenly. A thread's binding is released when the thread exits.
+class EngineSlots : public std::enable_shared_from_this<EngineSlots> {
+public:
+    // count slots dealt round-robin over cpus (0 = one per CPU)
+    EngineSlots(std::vector<int> cpus, size_t count);
+
+    size_t size() const { return slot_cpus_.size(); }
+
+    // Bind the calling thread to a slot if it has none yet and return the
+    // slot. Safe to call repeatedly.
+    size_t bind_current_thread();
+
+    // "8 slots on cpus 0-7" style description for logs.
+    std::string describe() const;
+
+private:
+    struct Binding;
+
+    size_t pick_slot();
+    void release(size_t slot);
+
+    std::vector<int> slot_cpus_;
+    std::mutex mutex_;
+    std::vector<uint32_t> load_;  // threads bound to each slot
+};
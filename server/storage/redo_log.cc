@@ -0,0 +1,528 @@
+#include "redo_log.hh"
+#include "../../common/log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kRecordHeader = 16;  // body_len, crc32c, lsn
+constexpr const char* kFilePrefix = "wal-";
+
+// CRC-32C (Castagnoli), bytewise
+class Crc32c {
+public:
+    Crc32c() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0x82f63b78u & (0u - (crc & 1)));
+            }
+            table_[i] = crc;
+        }
+    }
+
+    uint32_t extend(uint32_t crc, const void* data, size_t size) const {
+        const auto* p = static_cast<const uint8_t*>(data);
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++) {
+            crc = table_[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+private:
+    uint32_t table_[256];
+};
+
+const Crc32c& crc32c() {
+    static const Crc32c table;
+    return table;
+}
+
+size_t hash_bytes(std::string_view bytes) { return std::hash<std::string_view>{}(bytes); }
+
+size_t combine(size_t seed, size_t hash) {
+    return seed ^ (hash + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+void append_field(std::string& out, std::string_view field) {
+    uint32_t len = static_cast<uint32_t>(field.size());
+    out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    out.append(field.data(), field.size());
+}
+
+// Log files in dir by the lsn they start at, in lsn order
+std::vector<std::pair<uint64_t, fs::path>> list_files(const std::string& dir) {
+    std::vector<std::pair<uint64_t, fs::path>> files;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind(kFilePrefix, 0) != 0) continue;
+        char* end = nullptr;
+        uint64_t lsn = std::strtoull(name.c_str() + std::strlen(kFilePrefix), &end, 10);
+        if (end && *end == '\0') files.emplace_back(lsn, entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+bool write_all(int fd, const std::string& bytes) {
+    const char* p = bytes.data();
+    size_t left = bytes.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+}  // namespace
+
+void RedoLog::WriteSet::set_table(std::string_view table) {
+    if (table == table_) return;
+    table_.assign(table.data(), table.size());
+    table_hash_ = hash_bytes(table);
+    table_logged_ = false;
+}
+
+void RedoLog::WriteSet::begin_op(Op op, uint64_t stripe_hash) {
+    bool in_table = op >= Op::kPut && op <= Op::kRemoveEntry;
+    if (in_table && !table_logged_) {
+        ops_.push_back(static_cast<char>(Op::kTable));
+        append_field(ops_, table_);
+        table_logged_ = true;
+    }
+    ops_.push_back(static_cast<char>(op));
+    if (in_table) {
+        stripes_.push_back(static_cast<uint32_t>(stripe_hash % kStripes));
+    }
+}
+
+void RedoLog::WriteSet::put(std::string_view key, std::string_view value) {
+    begin_op(Op::kPut, combine(table_hash_, hash_bytes(key)));
+    append_field(ops_, key);
+    append_field(ops_, value);
+}
+
+void RedoLog::WriteSet::erase(std::string_view key) {
+    begin_op(Op::kErase, combine(table_hash_, hash_bytes(key)));
+    append_field(ops_, key);
+}
+
+// An index entry's stripe covers its whole secondary key, which a unique
+// index's writers contend on
+void RedoLog::WriteSet::add_entry(std::string_view index, std::string_view secondary_key,
+                                  std::string_view primary_key) {
+    begin_op(Op::kAddEntry, combine(combine(table_hash_, hash_bytes(index)), hash_bytes(secondary_key)));
+    append_field(ops_, index);
+    append_field(ops_, secondary_key);
+    append_field(ops_, primary_key);
+}
+
+void RedoLog::WriteSet::remove_entry(std::string_view index, std::string_view secondary_key,
+                                     std::string_view primary_key) {
+    begin_op(Op::kRemoveEntry, combine(combine(table_hash_, hash_bytes(index)), hash_bytes(secondary_key)));
+    append_field(ops_, index);
+    append_field(ops_, secondary_key);
+    append_field(ops_, primary_key);
+}
+
+void RedoLog::WriteSet::create_table(std::string_view table) {
+    begin_op(Op::kCreateTable, 0);
+    append_field(ops_, table);
+}
+
+void RedoLog::WriteSet::create_index(std::string_view table, std::string_view index, uint32_t type) {
+    begin_op(Op::kCreateIndex, 0);
+    append_field(ops_, table);
+    append_field(ops_, index);
+    append_field(ops_, std::string_view(reinterpret_cast<const char*>(&type), sizeof(type)));
+}
+
+RedoLog::Commit::Commit(RedoLog& log, WriteSet& write_set) : log_(log), write_set_(write_set) {
+    if (write_set_.empty()) return;
+    if (log_.durable_) {
+        logging_ = true;
+    } else {
+        // Count this commit in its phase; a phase switch waits for it
+        while (true) {
+            uint64_t phase = log_.phase_.load();
+            log_.in_flight_[phase & 1].commits.fetch_add(1);
+            if (log_.phase_.load() == phase) {
+                phase_ = static_cast<int>(phase & 1);
+                logging_ = phase_ == 1;
+                break;
+            }
+            log_.in_flight_[phase & 1].commits.fetch_sub(1);
+        }
+    }
+    if (logging_) {
+        // In ascending order, so commits sharing stripes cannot deadlock
+        auto& stripes = write_set_.stripes_;
+        std::sort(stripes.begin(), stripes.end());
+        stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+        for (uint32_t stripe : stripes) {
+            log_.stripes_[stripe].lock();
+        }
+        locked_ = true;
+    }
+}
+
+RedoLog::Commit::~Commit() { release(); }
+
+uint64_t RedoLog::Commit::log(bool committed) {
+    uint64_t lsn;
+    if (committed && logging_) {
+        lsn = log_.append(write_set_);
+    } else if (log_.durable_) {
+        std::lock_guard<std::mutex> lock(log_.mutex_);
+        lsn = log_.next_lsn_ - 1;
+    } else {
+        lsn = 0;
+    }
+    release();
+    return lsn;
+}
+
+void RedoLog::Commit::release() {
+    if (locked_) {
+        const auto& stripes = write_set_.stripes_;
+        for (auto it = stripes.rbegin(); it != stripes.rend(); ++it) {
+            log_.stripes_[*it].unlock();
+        }
+        locked_ = false;
+    }
+    if (phase_ >= 0) {
+        log_.in_flight_[phase_].commits.fetch_sub(1);
+        phase_ = -1;
+    }
+}
+
+RedoLog::Reader::~Reader() {
+    for (const auto& [map, size] : maps_) {
+        ::munmap(map, size);
+    }
+}
+
+bool RedoLog::Reader::open(const std::string& dir, uint64_t from, uint64_t to) {
+    auto files = list_files(dir);
+    if (from == 0) {
+        from = files.empty() ? 1 : files.front().first;
+    }
+    // Start in the last file that begins at or before from
+    size_t first = 0;
+    while (first + 1 < files.size() && files[first + 1].first <= from) first++;
+
+    uint64_t expected = from;
+    const auto& crc = crc32c();
+    for (size_t i = first; i < files.size() && (to == 0 || expected < to); i++) {
+        if (files[i].first > expected) break;  // a gap: nothing after it belongs
+        const fs::path& path = files[i].second;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG_ERROR("Cannot open redo log %s: %s", path.c_str(), std::strerror(errno));
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            LOG_ERROR("Cannot stat redo log %s: %s", path.c_str(), std::strerror(errno));
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        if (size < kRecordHeader) {
+            ::close(fd);
+            continue;
+        }
+        void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            LOG_ERROR("Cannot map redo log %s: %s", path.c_str(), std::strerror(errno));
+            return false;
+        }
+        ::madvise(map, size, MADV_SEQUENTIAL);
+        maps_.emplace_back(map, size);
+
+        const char* p = static_cast<const char*>(map);
+        const char* end = p + size;
+        while (static_cast<size_t>(end - p) >= kRecordHeader && (to == 0 || expected < to)) {
+            uint32_t body_len, stored_crc;
+            uint64_t lsn;
+            std::memcpy(&body_len, p, 4);
+            std::memcpy(&stored_crc, p + 4, 4);
+            std::memcpy(&lsn, p + 8, 8);
+            if (static_cast<size_t>(end - p - kRecordHeader) < body_len) break;  // torn
+            std::string_view body(p + kRecordHeader, body_len);
+            if (crc.extend(crc.extend(0, body.data(), body.size()), &lsn, sizeof(lsn)) != stored_crc ||
+                lsn > expected) {
+                break;
+            }
+            if (lsn == expected) {
+                records_.push_back(body);
+                bytes_ += kRecordHeader + body_len;
+                expected++;
+            }
+            p += kRecordHeader + body_len;
+        }
+    }
+    next_lsn_ = expected;
+    if (to != 0 && expected < to) {
+        LOG_ERROR("Redo log in %s ends at %lu, before %lu", dir.c_str(), expected, to);
+        return false;
+    }
+    return true;
+}
+
+bool RedoLog::Reader::parse(std::string_view body, const std::function<void(const OpView&)>& fn) {
+    const char* p = body.data();
+    const char* end = p + body.size();
+    while (p < end) {
+        OpView view{static_cast<Op>(*p++), {}};
+        size_t fields;
+        switch (view.op) {
+            case Op::kTable:
+            case Op::kErase:
+            case Op::kCreateTable:
+                fields = 1;
+                break;
+            case Op::kPut:
+                fields = 2;
+                break;
+            case Op::kAddEntry:
+            case Op::kRemoveEntry:
+            case Op::kCreateIndex:
+                fields = 3;
+                break;
+            default:
+                return false;
+        }
+        for (size_t i = 0; i < fields; i++) {
+            uint32_t len;
+            if (static_cast<size_t>(end - p) < sizeof(len)) return false;
+            std::memcpy(&len, p, sizeof(len));
+            p += sizeof(len);
+            if (static_cast<size_t>(end - p) < len) return false;
+            view.fields[i] = std::string_view(p, len);
+            p += len;
+        }
+        if (view.op == Op::kCreateIndex && view.fields[2].size() != sizeof(uint32_t)) return false;
+        fn(view);
+    }
+    return true;
+}
+
+RedoLog::RedoLog(std::string dir, bool durable, uint64_t next_lsn)
+    : dir_(std::move(dir)), durable_(durable), stripes_(new std::mutex[kStripes]),
+      next_lsn_(next_lsn), file_lsn_(next_lsn), durable_lsn_(next_lsn - 1) {
+    std::error_code ec;
+    for (const auto& [lsn, path] : list_files(dir_)) {
+        if (lsn >= next_lsn) fs::remove(path, ec);
+    }
+    if (durable_) {
+        pending_.push_back({file_lsn_, {}});  // open it right away
+    }
+    thread_ = std::thread([this] { flusher(); });
+}
+
+RedoLog::~RedoLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    flush_cv_.notify_one();
+    thread_.join();
+    if (fd_ >= 0) ::close(fd_);
+}
+
+std::string RedoLog::file_name(uint64_t lsn) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%s%020lu", kFilePrefix, static_cast<unsigned long>(lsn));
+    return name;
+}
+
+void RedoLog::log_create_table(const std::string& table) {
+    WriteSet write_set;
+    write_set.create_table(table);
+    Commit(*this, write_set).log(true);
+}
+
+void RedoLog::log_create_index(const std::string& table, const std::string& index, uint32_t type) {
+    WriteSet write_set;
+    write_set.create_index(table, index, type);
+    Commit(*this, write_set).log(true);
+}
+
+uint64_t RedoLog::append(const WriteSet& write_set) {
+    const auto& crc = crc32c();
+    const std::string& body = write_set.ops_;
+    uint32_t body_crc = crc.extend(0, body.data(), body.size());
+    uint32_t body_len = static_cast<uint32_t>(body.size());
+
+    uint64_t lsn;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lsn = next_lsn_++;
+        if (pending_.empty() || pending_.back().file_lsn != file_lsn_) {
+            pending_.push_back({file_lsn_, {}});
+        }
+        std::string& out = pending_.back().bytes;
+        uint32_t record_crc = crc.extend(body_crc, &lsn, sizeof(lsn));
+        out.append(reinterpret_cast<const char*>(&body_len), sizeof(body_len));
+        out.append(reinterpret_cast<const char*>(&record_crc), sizeof(record_crc));
+        out.append(reinterpret_cast<const char*>(&lsn), sizeof(lsn));
+        out.append(body);
+    }
+    flush_cv_.notify_one();
+    return lsn;
+}
+
+uint64_t RedoLog::begin_capture() {
+    uint64_t from;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        from = next_lsn_;
+        file_lsn_ = from;
+        if (pending_.empty() || pending_.back().file_lsn != from) {
+            pending_.push_back({from, {}});
+        }
+    }
+    flush_cv_.notify_one();
+    if (!durable_) {
+        switch_phase();
+    }
+    return from;
+}
+
+uint64_t RedoLog::end_capture() {
+    if (durable_) return 0;
+    switch_phase();
+    uint64_t end;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        end = next_lsn_;
+    }
+    sync();
+    return end;
+}
+
+void RedoLog::switch_phase() {
+    uint64_t previous = phase_.fetch_add(1);
+    while (in_flight_[previous & 1].commits.load() != 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void RedoLog::truncate(uint64_t lsn) {
+    auto files = list_files(dir_);
+    // Keep the last file that starts at or before lsn: it may hold lsn
+    size_t keep = 0;
+    while (keep + 1 < files.size() && files[keep + 1].first <= lsn) keep++;
+    std::error_code ec;
+    for (size_t i = 0; i < keep; i++) {
+        fs::remove(files[i].second, ec);
+    }
+}
+
+void RedoLog::when_durable(uint64_t lsn, std::function<void()> done) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (lsn > durable_lsn_) {
+            waiters_.emplace_back(lsn, std::move(done));
+            return;
+        }
+    }
+    done();
+}
+
+void RedoLog::sync() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = next_lsn_ - 1;
+    durable_cv_.wait(lock, [&] { return durable_lsn_ >= target; });
+}
+
+bool RedoLog::open_file(uint64_t file_lsn) {
+    if (fd_ >= 0) {
+        bool ok = ::fdatasync(fd_) == 0;
+        ::close(fd_);
+        fd_ = -1;
+        if (!ok) return false;
+    }
+    fs::path path = fs::path(dir_) / file_name(file_lsn);
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) return false;
+    open_file_lsn_ = file_lsn;
+    // Make the new file's name durable before records in it count
+    int dir_fd = ::open(dir_.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0) return false;
+    bool ok = ::fsync(dir_fd) == 0;
+    ::close(dir_fd);
+    return ok;
+}
+
+void RedoLog::flusher() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        flush_cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+        if (pending_.empty()) break;  // stopping, and everything is written
+
+        // Everything appended while the last batch was flushed goes out in
+        // one write and one fsync
+        std::deque<Pending> batch;
+        batch.swap(pending_);
+        uint64_t upto = next_lsn_ - 1;
+        lock.unlock();
+
+        bool ok = true;
+        bool wrote = false;
+        for (const auto& pending : batch) {
+            if (ok && (fd_ < 0 || pending.file_lsn != open_file_lsn_)) {
+                ok = open_file(pending.file_lsn);
+            }
+            if (ok && !pending.bytes.empty()) {
+                ok = write_all(fd_, pending.bytes);
+                wrote = true;
+            }
+        }
+        if (ok && wrote) {
+            ok = ::fdatasync(fd_) == 0;
+        }
+        if (!ok) {
+            // Commits waiting for this flush can neither be confirmed nor
+            // taken back
+            LOG_PANIC("Cannot write the redo log in %s: %s", dir_.c_str(), std::strerror(errno));
+        }
+
+        lock.lock();
+        durable_lsn_ = upto;
+        std::vector<std::function<void()>> done;
+        auto ready = std::partition(waiters_.begin(), waiters_.end(),
+                                    [upto](const auto& waiter) { return waiter.first > upto; });
+        for (auto it = ready; it != waiters_.end(); ++it) {
+            done.push_back(std::move(it->second));
+        }
+        waiters_.erase(ready, waiters_.end());
+        lock.unlock();
+        durable_cv_.notify_all();
+        for (auto& fn : done) {
+            fn();
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// The server's own redo log, kept next to its checkpoints as files
+// <dir>/wal-<lsn of the first record>, one record per committed transaction.
+//
+// A checkpoint scans its tables in short transactions while commits go on,
+// so each row and index entry it writes is as of some moment during the
+// scan. Every commit from the scan's start on is logged here with the
+// after-images of the rows and index entries it wrote, and loading the
+// checkpoint replays them over its segments, which brings each of those
+// keys to its last committed state.
+//
+// durable (engine.durability=wal with checkpoint.dir): every commit is
+// logged, and a flusher thread writes and fsyncs whatever accumulated while
+// it flushed the last batch (group commit), so a checkpoint plus the log
+// after it recovers every acknowledged commit. LineairDB's own log is off
+// then; the engine can only replay it while it starts, under any
+// checkpoint loaded afterwards. Otherwise commits are only logged between
+// begin_capture() and end_capture(), i.e. while a checkpoint scans.
+//
+// A commit holds striped locks on the keys it wrote from before
+// EndTransaction until its record is appended, so commits that write the
+// same key are logged in the order LineairDB installed them.
+//
+// Record: [body_len:4B][crc32c:4B][lsn:8B][body], integers in host byte
+// order, the CRC over body and lsn. The body is a sequence of ops, each
+// [op:1B] followed by its length-prefixed ([len:4B][bytes]) fields.
+class RedoLog {
+public:
+    enum class Op : uint8_t {
+        kTable = 1,         // table: the table later row and index ops are in
+        kPut = 2,           // key, value
+        kErase = 3,         // key
+        kAddEntry = 4,      // index, secondary key, primary key
+        kRemoveEntry = 5,   // index, secondary key, primary key
+        kCreateTable = 6,   // table
+        kCreateIndex = 7,   // table, index, type (4 bytes)
+    };
+
+    struct OpView {
+        Op op;
+        std::string_view fields[3];
+    };
+
+    // What one transaction wrote, recorded as it runs
+    class WriteSet {
+    public:
+        // The table later calls refer to (the transaction's SetTable())
+        void set_table(std::string_view table);
+        void put(std::string_view key, std::string_view value);
+        void erase(std::string_view key);
+        void add_entry(std::string_view index, std::string_view secondary_key,
+                       std::string_view primary_key);
+        void remove_entry(std::string_view index, std::string_view secondary_key,
+                          std::string_view primary_key);
+        void create_table(std::string_view table);
+        void create_index(std::string_view table, std::string_view index, uint32_t type);
+
+        bool empty() const { return ops_.empty(); }
+
+    private:
+        friend class RedoLog;
+
+        void begin_op(Op op, uint64_t stripe_hash);
+
+        std::string table_;
+        size_t table_hash_ = 0;
+        bool table_logged_ = false;
+        std::string ops_;
+        std::vector<uint32_t> stripes_;
+    };
+
+    // Scope of one EndTransaction: takes the write set's stripes, if it
+    // has to be logged, until log() or destruction
+    class Commit {
+    public:
+        Commit(RedoLog& log, WriteSet& write_set);
+        ~Commit();
+        Commit(const Commit&) = delete;
+        Commit& operator=(const Commit&) = delete;
+
+        // Append the write set if the transaction committed. Returns the lsn
+        // the commit is durable at: its record's, or for one that logged
+        // nothing the last record appended before it (0 outside durable
+        // mode).
+        uint64_t log(bool committed);
+
+    private:
+        void release();
+
+        RedoLog& log_;
+        WriteSet& write_set_;
+        int phase_ = -1;  // capture phase counter held, outside durable mode
+        bool logging_ = false;
+        bool locked_ = false;
+    };
+
+    // The records of a log directory, mapped for replay
+    class Reader {
+    public:
+        Reader() = default;
+        ~Reader();
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        // Collect the bodies of records from..to-1 (from 0 = the oldest one
+        // there is, to 0 = every record from on). A torn or out-of-sequence record ends its file; reading goes
+        // on in the next file if that starts right after it. False if a file
+        // cannot be read, or the log ends before to.
+        bool open(const std::string& dir, uint64_t from, uint64_t to);
+
+        // Record bodies in lsn order, valid while the reader lives
+        const std::vector<std::string_view>& records() const { return records_; }
+        // The lsn after the last record read
+        uint64_t next_lsn() const { return next_lsn_; }
+        size_t bytes() const { return bytes_; }
+
+        // Call fn for each op of a record body; false if it is malformed
+        static bool parse(std::string_view body, const std::function<void(const OpView&)>& fn);
+
+    private:
+        std::vector<std::pair<void*, size_t>> maps_;
+        std::vector<std::string_view> records_;
+        uint64_t next_lsn_ = 1;
+        size_t bytes_ = 0;
+    };
+
+    // Log into dir from next_lsn on. Log files starting at or after it are
+    // left over from a run that did not get that far and are removed.
+    RedoLog(std::string dir, bool durable, uint64_t next_lsn);
+    ~RedoLog();  // flushes what was appended
+
+    bool durable() const { return durable_; }
+
+    // Log a table or index the server just created, if commits are logged
+    void log_create_table(const std::string& table);
+    void log_create_index(const std::string& table, const std::string& index, uint32_t type);
+
+    // Start a new log file and, outside durable mode, start logging
+    // commits; returns the first lsn it will hold. Every commit with a lower
+    // lsn, or not logged at all, finished before it returns.
+    uint64_t begin_capture();
+    // Outside durable mode: stop logging commits, wait until every record
+    // logged so far is on disk and return the lsn after the last. In durable
+    // mode the log goes on, and it returns 0.
+    uint64_t end_capture();
+    // Remove the log files that only hold records before lsn
+    void truncate(uint64_t lsn);
+
+    // Run done once every record up to lsn is on disk: right away if it
+    // already is, otherwise on the flusher thread
+    void when_durable(uint64_t lsn, std::function<void()> done);
+    // Block until every record appended so far is on disk
+    void sync();
+
+    static std::string file_name(uint64_t lsn);
+
+private:
+    static constexpr size_t kStripes = 1024;
+
+    // Appended records that go to the file starting at file_lsn
+    struct Pending {
+        uint64_t file_lsn;
+        std::string bytes;
+    };
+
+    uint64_t append(const WriteSet& write_set);
+    // Flip between logging and not logging commits (outside durable mode)
+    // and wait for the commits still in the previous phase
+    void switch_phase();
+    void flusher();
+    bool open_file(uint64_t file_lsn);
+
+    const std::string dir_;
+    const bool durable_;
+    std::unique_ptr<std::mutex[]> stripes_;
+
+    // Outside durable mode: odd while a checkpoint captures, with the
+    // commits in flight in each phase's parity
+    struct alignas(64) InFlight {
+        std::atomic<int64_t> commits{0};
+    };
+    std::atomic<uint64_t> phase_{0};
+    InFlight in_flight_[2];
+
+    std::mutex mutex_;
+    std::condition_variable flush_cv_;    // wakes the flusher
+    std::condition_variable durable_cv_;  // wakes sync()
+    uint64_t next_lsn_;
+    uint64_t file_lsn_;  // file the next record goes to
+    std::deque<Pending> pending_;
+    uint64_t durable_lsn_;  // every record up to it is on disk
+    std::vector<std::pair<uint64_t, std::function<void()>>> waiters_;
+    bool stop_ = false;
+
+    int fd_ = -1;  // flusher thread only
+    uint64_t open_file_lsn_ = 0;
+    std::thread thread_;
+};
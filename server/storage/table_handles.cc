@@ -0,0 +1,64 @@
+#include "table_handles.hh"
+
+#include <mutex>
+#include <random>
+
+namespace {
+
+uint64_t random_epoch() {
+    std::random_device rd;
+    uint64_t epoch = 0;
+    while (epoch == 0) {  // 0 means "no handles" to the proxy
+        epoch = (static_cast<uint64_t>(rd()) << 32) | rd();
+    }
+    return epoch;
+}
+
+}  // namespace
+
+TableHandles::TableHandles() : epoch_(random_epoch()) {}
+
+uint32_t TableHandles::table(const std::string& table_name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = table_ids_.find(table_name);
+        if (it != table_ids_.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto [it, inserted] = table_ids_.emplace(table_name, 0);
+    if (inserted) {
+        tables_.push_back(table_name);
+        it->second = static_cast<uint32_t>(tables_.size());
+    }
+    return it->second;
+}
+
+uint32_t TableHandles::index(uint32_t table_id, const std::string& index_name) {
+    std::string key = std::to_string(table_id);
+    key.push_back('\0');
+    key += index_name;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = index_ids_.find(key);
+        if (it != index_ids_.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto [it, inserted] = index_ids_.emplace(std::move(key), 0);
+    if (inserted) {
+        indexes_.push_back(Index{table_id, index_name});
+        it->second = static_cast<uint32_t>(indexes_.size());
+    }
+    return it->second;
+}
+
+const std::string* TableHandles::table_name(uint32_t table_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (table_id == 0 || table_id > tables_.size()) return nullptr;
+    return &tables_[table_id - 1];
+}
+
+const TableHandles::Index* TableHandles::index_entry(uint32_t index_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (index_id == 0 || index_id > indexes_.size()) return nullptr;
+    return &indexes_[index_id - 1];
+}
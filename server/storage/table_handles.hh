@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// Server-wide registry of numeric table and secondary-index handles.
+//
+// A proxy resolves each table (and index) name once with DB_RESOLVE_HANDLES
+// and then sends the 32-bit handle in every TX_* request instead of the name.
+// Handles are dense, start at 1 and are never reused or removed, so a
+// connection may cache the entries it has looked up without holding the lock.
+// epoch() is random per process; proxies compare it to tell that handles from
+// a previous server instance are no longer valid.
+class TableHandles {
+public:
+    struct Index {
+        uint32_t table_id;
+        std::string name;
+    };
+
+    TableHandles();
+
+    uint64_t epoch() const { return epoch_; }
+
+    // Handle for the table / index name, assigning a new one on first use
+    uint32_t table(const std::string& table_name);
+    uint32_t index(uint32_t table_id, const std::string& index_name);
+
+    // Entry behind a handle, or nullptr if it was never assigned. The returned
+    // pointer stays valid for the registry's lifetime.
+    const std::string* table_name(uint32_t table_id) const;
+    const Index* index_entry(uint32_t index_id) const;
+
+private:
+    const uint64_t epoch_;
+    mutable std::shared_mutex mutex_;
+    std::deque<std::string> tables_;  // tables_[id - 1]
+    std::deque<Index> indexes_;       // indexes_[id - 1]
+    std::unordered_map<std::string, uint32_t> table_ids_;
+    std::unordered_map<std::string, uint32_t> index_ids_;  // keyed by table_id + '\0' + name
+};
@@ -0,0 +1,141 @@
+#include "table_row_counts.hh"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Random, with headroom below 2^63 so the counter never wraps
+uint64_t random_base_version() {
+    std::random_device rd;
+    uint64_t base = (static_cast<uint64_t>(rd()) << 32) | rd();
+    return (base & ((1ull << 61) - 1)) | (1ull << 61);
+}
+
+// Shard slots handed out so far; slots are taken in order, so only the
+// first min(next_slot, num_shards) shards of any table can be non-zero
+std::atomic<size_t> next_slot{0};
+
+size_t shard_count(size_t max_shards) {
+    size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    size_t shards = 1;
+    while (shards < cores && shards < max_shards) shards <<= 1;
+    return shards;
+}
+
+}  // namespace
+
+TableRowCounts::TableRowCounts()
+    : base_version_(random_base_version()),
+      shard_mask_(shard_count(kMaxShards) - 1),
+      next_version_(base_version_),
+      published_(base_version_),
+      applied_(new std::atomic<uint64_t>[kPublishSlots]),
+      chunks_(new std::atomic<Chunk*>[kMaxChunks]) {
+    for (size_t i = 0; i < kPublishSlots; i++) {
+        applied_[i].store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kMaxChunks; i++) {
+        chunks_[i].store(nullptr, std::memory_order_relaxed);
+    }
+    directories_.push_back(std::make_unique<Directory>(64));
+    directory_.store(directories_.back().get(), std::memory_order_release);
+}
+
+TableRowCounts::~TableRowCounts() = default;
+
+int64_t TableRowCounts::Table::count() const {
+    size_t used = std::min(next_slot.load(), num_shards);
+    int64_t sum = 0;
+    for (size_t i = 0; i < used; i++) {
+        sum += shards[i].delta.load(std::memory_order_relaxed);
+    }
+    return sum < 0 ? 0 : sum;
+}
+
+TableRowCounts::Directory::Directory(size_t capacity)
+    : mask(capacity - 1), slots(new std::atomic<Table*>[capacity]) {
+    for (size_t i = 0; i < capacity; i++) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+TableRowCounts::Table* TableRowCounts::Directory::find(const std::string& table_name) const {
+    for (size_t i = std::hash<std::string>{}(table_name) & mask;; i = (i + 1) & mask) {
+        Table* table = slots[i].load(std::memory_order_acquire);
+        if (!table || table->name == table_name) return table;
+    }
+}
+
+void TableRowCounts::Directory::insert(Table* table) {
+    size_t i = std::hash<std::string>{}(table->name) & mask;
+    while (slots[i].load(std::memory_order_relaxed)) i = (i + 1) & mask;
+    slots[i].store(table, std::memory_order_release);
+    size++;
+}
+
+// Threads take shard slots round-robin on first use
+size_t TableRowCounts::shard_index() {
+    thread_local size_t slot = next_slot.fetch_add(1) & (kMaxShards - 1);
+    return slot;
+}
+
+TableRowCounts::Table& TableRowCounts::add_table(const std::string& table_name) {
+    std::lock_guard<std::mutex> lock(directory_mutex_);
+    Directory* directory = directories_.back().get();
+    if (Table* table = directory->find(table_name)) {
+        return *table;  // another commit added it first
+    }
+
+    size_t index = num_tables_.load(std::memory_order_relaxed);
+    if (index / kChunkSize >= kMaxChunks) {
+        throw std::length_error("TableRowCounts: too many tables");
+    }
+    if (index % kChunkSize == 0) {
+        chunk_storage_.push_back(std::make_unique<Chunk>());
+        chunks_[index / kChunkSize].store(chunk_storage_.back().get(), std::memory_order_release);
+    }
+    Chunk& chunk = *chunk_storage_.back();
+    table_storage_.push_back(std::make_unique<Table>(table_name, shard_mask_ + 1));
+    Table* table = table_storage_.back().get();
+    table->version = &chunk.versions[index % kChunkSize];
+    table->chunk_version = &chunk.version;
+    chunk.tables[index % kChunkSize] = table;
+    num_tables_.store(index + 1, std::memory_order_release);
+
+    // Keep the directory at most half full; readers still probing the old
+    // one find every table it held
+    if ((directory->size + 1) * 2 > directory->mask + 1) {
+        auto grown = std::make_unique<Directory>((directory->mask + 1) * 2);
+        for (size_t i = 0; i <= directory->mask; i++) {
+            if (Table* existing = directory->slots[i].load(std::memory_order_relaxed)) {
+                grown->insert(existing);
+            }
+        }
+        directories_.push_back(std::move(grown));
+        directory = directories_.back().get();
+    }
+    directory->insert(table);
+    directory_.store(directory, std::memory_order_release);
+    return *table;
+}
+
+void TableRowCounts::publish(uint64_t version) {
+    // The slot is reused kPublishSlots versions later; wait for it to drain
+    while (version - published_.load() >= kPublishSlots) {
+        std::this_thread::yield();
+    }
+    applied_[version % kPublishSlots].store(version);
+
+    // Whoever applies the oldest outstanding version carries published_
+    // forward over every later one that is already applied
+    uint64_t published = published_.load();
+    while (applied_[(published + 1) % kPublishSlots].load() == published + 1) {
+        if (published_.compare_exchange_weak(published, published + 1)) {
+            published++;
+        }
+    }
+}
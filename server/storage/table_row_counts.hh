@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Server-wide table row count tracker, shared across all connections.
+//
+// Commits never take a lock here once their tables are known. Each table's
+// count is a set of cache-line-padded atomic shards, one per core (like
+// LineairDB_share::rowcount_shards on the proxy side); committing threads
+// take shards round-robin.
+// Tables are found through an open-addressing directory published RCU-style:
+// readers probe whichever directory is current with plain atomic loads, the
+// rare commit that names a new table fills an empty slot under
+// directory_mutex_, and a directory that gets half full is replaced by a copy
+// of twice the size. Tables are never dropped, so retired directories are
+// only freed with the tracker (their sizes sum to less than the current one).
+//
+// Every commit that carries row deltas takes the next version, and each table
+// remembers the version that last changed it (as does each chunk of 64
+// tables), so BEGIN / END responses can carry only the tables a proxy has not
+// seen yet. version() only advances
+// past a commit once it and every earlier one have applied their deltas.
+// Versions start at a random base per process, which lets a version from a
+// previous server instance (or 0, from a proxy that has none yet) be told
+// apart and answered with every table.
+class TableRowCounts {
+public:
+    TableRowCounts();
+    ~TableRowCounts();
+
+    uint64_t version() const { return published_.load(std::memory_order_acquire); }
+
+    template <typename T>
+    void apply_deltas(const T& deltas) {
+        if (deltas.empty()) return;
+        uint64_t version = next_version_.fetch_add(1) + 1;
+        size_t shard = shard_index() & shard_mask_;
+        for (const auto& row_delta : deltas) {
+            Table& table = table_for(row_delta.table_name());
+            table.shards[shard].delta.fetch_add(row_delta.delta(), std::memory_order_relaxed);
+            raise_version(*table.version, version);
+            raise_version(*table.chunk_version, version);
+        }
+        publish(version);
+    }
+
+    // Calls fn(table_name, row_count) for every table changed after
+    // since_version and returns the version the caller is then up to date
+    // with. full is set when since_version was not issued by this instance
+    // and every table was reported.
+    template <typename Fn>
+    uint64_t changes_since(uint64_t since_version, bool& full, Fn&& fn) const {
+        uint64_t current = version();
+        full = since_version < base_version_ || since_version > current;
+        if (!full && since_version == current) {
+            return current;  // nothing changed
+        }
+        // Each chunk carries the newest version of its tables, so unchanged
+        // chunks are skipped without touching their tables
+        size_t num_tables = num_tables_.load(std::memory_order_acquire);
+        for (size_t first = 0; first < num_tables; first += kChunkSize) {
+            const Chunk& chunk = *chunks_[first / kChunkSize].load(std::memory_order_acquire);
+            if (!full && chunk.version.load(std::memory_order_acquire) <= since_version) continue;
+            size_t end = std::min(num_tables - first, kChunkSize);
+            for (size_t i = 0; i < end; i++) {
+                if (full || chunk.versions[i].load(std::memory_order_acquire) > since_version) {
+                    fn(chunk.tables[i]->name, chunk.tables[i]->count());
+                }
+            }
+        }
+        return current;
+    }
+
+private:
+    static constexpr size_t kMaxShards = 64;       // must be power-of-two
+    static constexpr size_t kPublishSlots = 4096;  // commits in flight at once
+    static constexpr size_t kChunkSize = 64;       // tables per chunk
+    static constexpr size_t kMaxChunks = 1 << 15;
+
+    struct alignas(64) Shard {
+        std::atomic<int64_t> delta{0};
+    };
+
+    struct Table {
+        Table(std::string table_name, size_t num_shards)
+            : name(std::move(table_name)), num_shards(num_shards), shards(new Shard[num_shards]) {}
+        int64_t count() const;
+
+        const std::string name;
+        std::atomic<uint64_t>* version = nullptr;        // slot in its Chunk
+        std::atomic<uint64_t>* chunk_version = nullptr;  // its Chunk's newest
+        const size_t num_shards;
+        std::unique_ptr<Shard[]> shards;
+    };
+
+    // Tables in creation order, with their versions packed together
+    struct Chunk {
+        std::atomic<uint64_t> version{0};
+        std::array<std::atomic<uint64_t>, kChunkSize> versions{};
+        std::array<Table*, kChunkSize> tables{};
+    };
+
+    struct Directory {
+        explicit Directory(size_t capacity);
+        Table* find(const std::string& table_name) const;
+        void insert(Table* table);  // writers only, under directory_mutex_
+
+        const size_t mask;  // capacity - 1, capacity a power of two
+        std::unique_ptr<std::atomic<Table*>[]> slots;
+        size_t size = 0;
+    };
+
+    static size_t shard_index();
+    static void raise_version(std::atomic<uint64_t>& slot, uint64_t version) {
+        uint64_t seen = slot.load(std::memory_order_relaxed);
+        while (seen < version &&
+               !slot.compare_exchange_weak(seen, version, std::memory_order_release)) {
+        }
+    }
+    Table& table_for(const std::string& table_name) {
+        Table* table = directory_.load(std::memory_order_acquire)->find(table_name);
+        return table ? *table : add_table(table_name);
+    }
+    Table& add_table(const std::string& table_name);
+    // Mark version applied and advance version() over every finished commit
+    void publish(uint64_t version);
+
+    const uint64_t base_version_;
+    const size_t shard_mask_;  // one shard per core, rounded up to a power of two
+    std::atomic<uint64_t> next_version_;
+    std::atomic<uint64_t> published_;
+    std::unique_ptr<std::atomic<uint64_t>[]> applied_;  // applied_[v % kPublishSlots] = v
+
+    std::atomic<const Directory*> directory_;
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks_;
+    std::atomic<size_t> num_tables_{0};
+
+    std::mutex directory_mutex_;  // taken only to add a table
+    std::deque<std::unique_ptr<Table>> table_storage_;
+    std::vector<std::unique_ptr<Chunk>> chunk_storage_;
+    std::vector<std::unique_ptr<Directory>> directories_;  // current and retired
+};
@@ -15,6 +15,7 @@ public:
     void store_transaction(int64_t tx_id, LineairDB::Transaction* tx);
     LineairDB::Transaction* get_transaction(int64_t tx_id);
     void remove_transaction(int64_t tx_id);
+    size_t open_transactions() const { return transactions_.size(); }
     
 private:
     std::unordered_map<int64_t, LineairDB::Transaction*> transactions_;
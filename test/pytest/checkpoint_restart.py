@@ -0,0 +1,259 @@
+import sys
+import os
+import shutil
+import signal
+import threading
+import time
+import mysql.connector
+from utils.connection import get_connection
+from utils.restart import restart_services, server_pid
+import argparse
+import concurrent.futures
+
+# lineairdb-server --checkpoint-dir takes a checkpoint on SIGUSR1 and loads
+# the newest one at startup. These tests kill the server with SIGKILL after
+# a checkpoint and check the rows, row counts and secondary indexes it comes
+# back with, first in memory mode, then with --durability=wal while
+# checkpoints are taken under concurrent writes.
+
+CHECKPOINT_DIR = "/tmp/ordo_test_checkpoint"
+ROWS = 2000
+WRITERS = 4
+
+def reset (db, cursor) :
+    cursor.execute('DROP DATABASE IF EXISTS ha_lineairdb_test')
+    cursor.execute('CREATE DATABASE ha_lineairdb_test')
+    cursor.execute('CREATE TABLE ha_lineairdb_test.items (\
+        id INT NOT NULL PRIMARY KEY,\
+        grp INT NOT NULL,\
+        content VARCHAR(50) NOT NULL,\
+        INDEX grp_idx (grp)\
+    ) ENGINE = LineairDB')
+    cursor.execute('CREATE TABLE ha_lineairdb_test.tags (\
+        id INT NOT NULL PRIMARY KEY,\
+        tag VARCHAR(20) NOT NULL,\
+        UNIQUE INDEX tag_uidx (tag)\
+    ) ENGINE = LineairDB')
+    db.commit()
+
+def load (db, cursor) :
+    for start in range(0, ROWS, 200):
+        values = ", ".join(f"({i}, {i % 10}, 'row{i}')" for i in range(start, start + 200))
+        cursor.execute(f'INSERT INTO ha_lineairdb_test.items (id, grp, content) VALUES {values}')
+        db.commit()
+    values = ", ".join(f"({i}, 'tag{i}')" for i in range(100))
+    cursor.execute(f'INSERT INTO ha_lineairdb_test.tags (id, tag) VALUES {values}')
+    db.commit()
+
+def snapshot (db, cursor) :
+    """Everything the checks compare: rows, counts and index lookups."""
+    state = {}
+    cursor.execute('SELECT id, grp, content FROM ha_lineairdb_test.items ORDER BY id')
+    state["items"] = cursor.fetchall()
+    cursor.execute('SELECT id, tag FROM ha_lineairdb_test.tags ORDER BY id')
+    state["tags"] = cursor.fetchall()
+    cursor.execute('SELECT COUNT(*) FROM ha_lineairdb_test.items')
+    state["items_count"] = cursor.fetchone()[0]
+    for grp in range(10):
+        cursor.execute('SELECT id FROM ha_lineairdb_test.items FORCE INDEX (grp_idx) '
+                       'WHERE grp = %s ORDER BY id', (grp,))
+        state[f"grp{grp}"] = cursor.fetchall()
+    cursor.execute('SELECT id FROM ha_lineairdb_test.tags FORCE INDEX (tag_uidx) '
+                   'WHERE tag = "tag42"')
+    state["tag42"] = cursor.fetchall()
+    db.commit()
+    return state
+
+def table_rows (db, cursor, table) :
+    """Row count the server reported, as MySQL's table statistics show it."""
+    cursor.execute('SET SESSION information_schema_stats_expiry = 0')
+    cursor.execute('SELECT TABLE_ROWS FROM information_schema.TABLES '
+                   'WHERE TABLE_SCHEMA = "ha_lineairdb_test" AND TABLE_NAME = %s', (table,))
+    rows = cursor.fetchone()[0]
+    db.commit()
+    return rows
+
+def read_current () :
+    try:
+        with open(os.path.join(CHECKPOINT_DIR, "CURRENT")) as f:
+            return f.read().strip()
+    except OSError:
+        return ""
+
+def checkpoint (timeout=60.0) :
+    """Ask the server for a checkpoint and wait until it is published."""
+    before = read_current()
+    os.kill(server_pid(), signal.SIGUSR1)
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        current = read_current()
+        if current and current != before:
+            return current
+        time.sleep(0.1)
+    return None
+
+def compare (expected, actual) :
+    for key in expected:
+        if expected[key] != actual.get(key):
+            print(f"\t{key} differs")
+            print("\t expected:", str(expected[key])[:200])
+            print("\t actual:  ", str(actual.get(key))[:200])
+            return False
+    return True
+
+def start (*server_args) :
+    return restart_services(f"--checkpoint-dir={CHECKPOINT_DIR}", "--checkpoint.period_s=0",
+                            *server_args)
+
+def memory_checkpoint_restart () :
+    print("CHECKPOINT RESTART TEST")
+
+    shutil.rmtree(CHECKPOINT_DIR, ignore_errors=True)
+    if not start():
+        print("\tFailed: server did not start")
+        return 1
+
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    reset(db, cursor)
+    load(db, cursor)
+    cursor.execute('UPDATE ha_lineairdb_test.items SET grp = 99 WHERE id < 10')
+    cursor.execute('DELETE FROM ha_lineairdb_test.items WHERE id >= 1990')
+    db.commit()
+    expected = snapshot(db, cursor)
+    db.close()
+
+    print("\tcheckpoint")
+    if not checkpoint():
+        print("\tFailed: checkpoint was not published")
+        return 1
+
+    print("\tkill -9 and restart")
+    if not start():
+        print("\tFailed: server did not load the checkpoint")
+        return 1
+
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    actual = snapshot(db, cursor)
+    if not compare(expected, actual):
+        print("\tCheck 1 Failed")
+        return 1
+
+    if table_rows(db, cursor, "items") != expected["items_count"]:
+        print("\tCheck 2 Failed: row count", table_rows(db, cursor, "items"),
+              "expected", expected["items_count"])
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def writer (n, stop) :
+    """Update, insert and delete rows of our own until stop is set."""
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    commits = 0
+    i = 0
+    while not stop.is_set():
+        row_id = ROWS + n * 100000 + i
+        try:
+            cursor.execute('INSERT INTO ha_lineairdb_test.items (id, grp, content) '
+                           'VALUES (%s, %s, %s)', (row_id, i % 10, f"w{n}"))
+            cursor.execute('UPDATE ha_lineairdb_test.items SET grp = (grp + 1) % 10, content = %s '
+                           'WHERE id = %s', (f"w{n}-{i}", (n * 397 + i) % ROWS))
+            if i % 3 == 2:
+                cursor.execute('DELETE FROM ha_lineairdb_test.items WHERE id = %s', (row_id - 1,))
+            db.commit()
+            commits += 1
+        except mysql.connector.Error:
+            db.rollback()
+        i += 1
+    db.close()
+    return commits
+
+def durable_checkpoint_under_writes () :
+    print("CHECKPOINT UNDER CONCURRENT WRITES TEST")
+
+    shutil.rmtree(CHECKPOINT_DIR, ignore_errors=True)
+    if not start("--durability=wal"):
+        print("\tFailed: server did not start")
+        return 1
+
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    reset(db, cursor)
+    load(db, cursor)
+
+    stop = threading.Event()
+    executor = concurrent.futures.ThreadPoolExecutor(max_workers=WRITERS)
+    futures = [executor.submit(writer, n, stop) for n in range(WRITERS)]
+    try:
+        time.sleep(1)
+        for k in range(3):
+            started = time.time()
+            name = checkpoint()
+            if not name:
+                print("\tFailed: checkpoint did not complete under concurrent writes")
+                return 1
+            print(f"\t{name} published in {time.time() - started:.1f} s under writes")
+    finally:
+        stop.set()
+        commits = sum(f.result() for f in futures)
+        executor.shutdown()
+    print(f"\t{commits} commits during the checkpoints")
+    if commits == 0:
+        print("\tFailed: no writes committed during the checkpoints")
+        return 1
+
+    # Commits after the last checkpoint are only in the redo log
+    cursor.execute('UPDATE ha_lineairdb_test.items SET content = "after checkpoint" WHERE id < 50')
+    cursor.execute('DELETE FROM ha_lineairdb_test.tags WHERE id = 7')
+    db.commit()
+    expected = snapshot(db, cursor)
+    db.close()
+
+    print("\tkill -9 and restart")
+    if not start("--durability=wal"):
+        print("\tFailed: server did not recover")
+        return 1
+
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    actual = snapshot(db, cursor)
+    if not compare(expected, actual):
+        print("\tCheck 1 Failed")
+        return 1
+
+    if table_rows(db, cursor, "items") != expected["items_count"]:
+        print("\tCheck 2 Failed: row count", table_rows(db, cursor, "items"),
+              "expected", expected["items_count"])
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def main():
+    failed = 0
+    if memory_checkpoint_restart() != 0:
+        failed += 1
+    if durable_checkpoint_under_writes() != 0:
+        failed += 1
+
+    if failed > 0:
+        print(f"\n{failed} test(s) failed")
+        sys.exit(1)
+
+    print("\nAll tests passed!")
+    sys.exit(0)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Connect to MySQL')
+    parser.add_argument('--user', metavar='user', type=str,
+                        help='name of user',
+                        default="root")
+    parser.add_argument('--password', metavar='pw', type=str,
+                        help='password for the user',
+                        default="")
+    args = parser.parse_args()
+    main()
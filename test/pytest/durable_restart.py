@@ -0,0 +1,135 @@
+import sys
+import os
+import shutil
+import mysql.connector
+from utils.connection import get_connection
+from utils.restart import restart_services
+import argparse
+import concurrent.futures
+
+# With --durability=wal a fenced commit (the proxy built with FENCE true,
+# as run_tests.py does) returns only once its epoch is on disk. This test
+# commits from several connections, kills the server with SIGKILL and
+# checks that every acknowledged commit is there after the restart.
+
+LOG_DIR = "/tmp/ordo_test_wal"
+SERVER_ARGS = ("--durability=wal", f"--log-dir={LOG_DIR}")
+WRITERS = 4
+COMMITS = 50
+
+def reset (db, cursor) :
+    cursor.execute('DROP DATABASE IF EXISTS ha_lineairdb_test')
+    cursor.execute('CREATE DATABASE ha_lineairdb_test')
+    cursor.execute('CREATE TABLE ha_lineairdb_test.items (\
+        id INT NOT NULL PRIMARY KEY,\
+        writer INT NOT NULL,\
+        content VARCHAR(50) NOT NULL,\
+        INDEX writer_idx (writer)\
+    ) ENGINE = LineairDB')
+    db.commit()
+
+def writer (n) :
+    """Commit COMMITS transactions on rows of our own; return the rows acknowledged."""
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    rows = {}
+    for i in range(COMMITS):
+        row_id = n * 1000 + i
+        try:
+            cursor.execute('INSERT INTO ha_lineairdb_test.items (id, writer, content) '
+                           'VALUES (%s, %s, %s)', (row_id, n, f"v{i}"))
+            if i % 5 == 4:
+                # Also overwrite and delete earlier rows of this writer
+                cursor.execute('UPDATE ha_lineairdb_test.items SET content = "updated" '
+                               'WHERE id = %s', (row_id - 1,))
+                cursor.execute('DELETE FROM ha_lineairdb_test.items WHERE id = %s', (row_id - 2,))
+            db.commit()
+        except mysql.connector.Error as err:
+            print(f"\twriter {n} commit {i} aborted: {err}")
+            db.rollback()
+            continue
+        rows[row_id] = (n, f"v{i}")
+        if i % 5 == 4:
+            if row_id - 1 in rows:
+                rows[row_id - 1] = (n, "updated")
+            rows.pop(row_id - 2, None)
+    db.close()
+    return rows
+
+def durable_restart () :
+    print("DURABLE RESTART TEST")
+
+    shutil.rmtree(LOG_DIR, ignore_errors=True)
+    os.makedirs(LOG_DIR)
+    if not restart_services(*SERVER_ARGS):
+        print("\tFailed: server did not start")
+        return 1
+
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    reset(db, cursor)
+    db.close()
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=WRITERS) as executor:
+        results = list(executor.map(writer, range(WRITERS)))
+    expected = {}
+    for rows in results:
+        expected.update(rows)
+    print(f"\t{len(expected)} rows acknowledged")
+
+    print("\tkill -9 and restart")
+    if not restart_services(*SERVER_ARGS):
+        print("\tFailed: server did not recover")
+        return 1
+
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    cursor.execute('SELECT id, writer, content FROM ha_lineairdb_test.items ORDER BY id')
+    rows = {row[0]: (row[1], row[2]) for row in cursor.fetchall()}
+    db.commit()
+    if rows != expected:
+        missing = sorted(set(expected) - set(rows))
+        extra = sorted(set(rows) - set(expected))
+        print("\tCheck 1 Failed")
+        print("\t missing:", missing[:20], "extra:", extra[:20])
+        return 1
+
+    for n in range(WRITERS):
+        cursor.execute('SELECT id FROM ha_lineairdb_test.items FORCE INDEX (writer_idx) '
+                       'WHERE writer = %s ORDER BY id', (n,))
+        ids = [row[0] for row in cursor.fetchall()]
+        db.commit()
+        if ids != sorted(k for k, v in expected.items() if v[0] == n):
+            print("\tCheck 2 Failed: secondary index of writer", n)
+            print("\t", ids)
+            return 1
+
+    # The recovered server keeps taking commits
+    cursor.execute('INSERT INTO ha_lineairdb_test.items (id, writer, content) '
+                   'VALUES (999999, 0, "after restart")')
+    db.commit()
+    cursor.execute('SELECT content FROM ha_lineairdb_test.items WHERE id = 999999')
+    rows = cursor.fetchall()
+    db.commit()
+    if rows != [("after restart",)]:
+        print("\tCheck 3 Failed")
+        print("\t", rows)
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def main():
+    sys.exit(durable_restart())
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Connect to MySQL')
+    parser.add_argument('--user', metavar='user', type=str,
+                        help='name of user',
+                        default="root")
+    parser.add_argument('--password', metavar='pw', type=str,
+                        help='password for the user',
+                        default="")
+    args = parser.parse_args()
+    main()
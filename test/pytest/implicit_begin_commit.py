@@ -0,0 +1,184 @@
+import sys
+import mysql.connector
+from utils.connection import get_connection
+import argparse
+
+# The proxy starts a transaction with its first request (no separate
+# BEGIN round trip) and sends the last write batch together with the
+# commit. These tests check that short autocommit statements and
+# transactions that abort partway still end all-or-nothing.
+
+def reset (db, cursor) :
+    cursor.execute('DROP DATABASE IF EXISTS ha_lineairdb_test')
+    cursor.execute('CREATE DATABASE ha_lineairdb_test')
+    cursor.execute('CREATE TABLE ha_lineairdb_test.items (\
+        id INT NOT NULL PRIMARY KEY,\
+        title VARCHAR(50) NOT NULL,\
+        INDEX title_idx (title)\
+    ) ENGINE = LineairDB')
+    db.commit()
+
+def select_all (cursor) :
+    cursor.execute('SELECT id, title FROM ha_lineairdb_test.items ORDER BY id')
+    return cursor.fetchall()
+
+def autocommit_statements (db, cursor) :
+    reset(db, cursor)
+    print("IMPLICIT BEGIN AUTOCOMMIT TEST")
+
+    db.autocommit = True
+    try:
+        # Each statement is a transaction of its own: begun by its first
+        # request, committed with its only write batch
+        cursor.execute('INSERT INTO ha_lineairdb_test.items (id, title) VALUES (1, "alice")')
+        cursor.execute('INSERT INTO ha_lineairdb_test.items (id, title) VALUES (2, "bob"), (3, "carol")')
+        cursor.execute('UPDATE ha_lineairdb_test.items SET title = "bobby" WHERE id = 2')
+        cursor.execute('DELETE FROM ha_lineairdb_test.items WHERE id = 3')
+        rows = select_all(cursor)
+    finally:
+        db.autocommit = False
+
+    if rows != [(1, "alice"), (2, "bobby")]:
+        print("\tCheck 1 Failed")
+        print("\t", rows)
+        return 1
+
+    # A second connection sees every autocommit statement committed
+    db2 = get_connection(user=args.user, password=args.password)
+    cursor2 = db2.cursor()
+    rows = select_all(cursor2)
+    db2.commit()
+    db2.close()
+    if rows != [(1, "alice"), (2, "bobby")]:
+        print("\tCheck 2 Failed")
+        print("\t", rows)
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def abort_in_statement (db, cursor) :
+    reset(db, cursor)
+    print("IMPLICIT BEGIN ABORT IN STATEMENT TEST")
+
+    cursor.execute('INSERT INTO ha_lineairdb_test.items (id, title) VALUES (2, "bob")')
+    db.commit()
+
+    db.autocommit = True
+    try:
+        # The third row collides with an existing key after two rows are
+        # already buffered; none of them may be left behind
+        try:
+            cursor.execute('INSERT INTO ha_lineairdb_test.items (id, title) VALUES '
+                           '(1, "alice"), (3, "carol"), (2, "duplicate"), (4, "dave")')
+            print("\tCheck 1 Failed: duplicate insert unexpectedly succeeded")
+            return 1
+        except mysql.connector.Error as err:
+            print(f"\tINSERT failed as expected: {err}")
+
+        rows = select_all(cursor)
+        if rows != [(2, "bob")]:
+            print("\tCheck 2 Failed")
+            print("\t", rows)
+            return 1
+
+        # The connection goes on with a fresh implicit transaction
+        cursor.execute('INSERT INTO ha_lineairdb_test.items (id, title) VALUES (5, "eve")')
+        rows = select_all(cursor)
+    finally:
+        db.autocommit = False
+
+    if rows != [(2, "bob"), (5, "eve")]:
+        print("\tCheck 3 Failed")
+        print("\t", rows)
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def abort_at_commit (db, cursor) :
+    reset(db, cursor)
+    print("IMPLICIT BEGIN ABORT AT COMMIT TEST")
+
+    cursor.execute('INSERT INTO ha_lineairdb_test.items (id, title) VALUES (1, "alice")')
+    db.commit()
+
+    print("\tTX1 BEGIN")
+    cursor.execute('BEGIN')
+    cursor.execute('SELECT title FROM ha_lineairdb_test.items WHERE id = 1')
+    cursor.fetchall()
+
+    # tx2 overwrites what tx1 read, so tx1 fails validation when its last
+    # write batch arrives with the commit
+    db2 = get_connection(user=args.user, password=args.password)
+    cursor2 = db2.cursor()
+    cursor2.execute('UPDATE ha_lineairdb_test.items SET title = "alice2" WHERE id = 1')
+    db2.commit()
+    db2.close()
+
+    cursor.execute('INSERT INTO ha_lineairdb_test.items (id, title) VALUES (2, "bob")')
+    cursor.execute('INSERT INTO ha_lineairdb_test.items (id, title) VALUES (3, "carol")')
+    cursor.execute('UPDATE ha_lineairdb_test.items SET title = "alice3" WHERE id = 1')
+    aborted = False
+    try:
+        print("\tTX1 COMMIT")
+        cursor.execute('COMMIT')
+        db.commit()
+    except mysql.connector.Error as err:
+        print(f"\tTX1 aborted: {err}")
+        aborted = True
+        db.rollback()
+
+    rows = select_all(cursor)
+    db.commit()
+    if aborted:
+        expected = [(1, "alice2")]
+    else:
+        expected = [(1, "alice3"), (2, "bob"), (3, "carol")]
+    if rows != expected:
+        print("\tCheck 1 Failed: commit was not all-or-nothing")
+        print("\t", rows)
+        return 1
+
+    cursor.execute('SELECT id FROM ha_lineairdb_test.items FORCE INDEX (title_idx) '
+                   'WHERE title = "bob"')
+    rows = cursor.fetchall()
+    db.commit()
+    if rows != ([] if aborted else [(2,)]):
+        print("\tCheck 2 Failed: secondary index does not match the rows")
+        print("\t", rows)
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def main():
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+
+    failed = 0
+    if autocommit_statements(db, cursor) != 0:
+        failed += 1
+    if abort_in_statement(db, cursor) != 0:
+        failed += 1
+    if abort_at_commit(db, cursor) != 0:
+        failed += 1
+
+    if failed > 0:
+        print(f"\n{failed} test(s) failed")
+        sys.exit(1)
+
+    print("\nAll tests passed!")
+    sys.exit(0)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Connect to MySQL')
+    parser.add_argument('--user', metavar='user', type=str,
+                        help='name of user',
+                        default="root")
+    parser.add_argument('--password', metavar='pw', type=str,
+                        help='password for the user',
+                        default="")
+    args = parser.parse_args()
+    main()
@@ -0,0 +1,151 @@
+import sys
+import mysql.connector
+from utils.connection import get_connection
+from utils.restart import restart_services
+import argparse
+import concurrent.futures
+
+# With --io-model=reactor one epoll worker serves many proxy connections,
+# while LineairDB keeps epoch and log state per thread. The server runs each
+# connection's open transaction on an executor thread of its own, so
+# transactions of connections sharing a worker never interleave on one
+# thread. These tests keep several transactions open at once behind a single
+# worker and check that every one of them commits or aborts as a whole.
+
+SERVER_ARGS = ("--io-model=reactor", "--io-workers=1")
+SESSIONS = 8
+WRITERS = 4
+INCREMENTS = 50
+
+def reset (db, cursor) :
+    cursor.execute('DROP DATABASE IF EXISTS ha_lineairdb_test')
+    cursor.execute('CREATE DATABASE ha_lineairdb_test')
+    cursor.execute('CREATE TABLE ha_lineairdb_test.items (\
+        id INT NOT NULL PRIMARY KEY,\
+        owner INT NOT NULL,\
+        content VARCHAR(50) NOT NULL,\
+        INDEX owner_idx (owner)\
+    ) ENGINE = LineairDB')
+    cursor.execute('CREATE TABLE ha_lineairdb_test.counter (\
+        id INT NOT NULL PRIMARY KEY,\
+        value INT NOT NULL\
+    ) ENGINE = LineairDB')
+    cursor.execute('INSERT INTO ha_lineairdb_test.counter (id, value) VALUES (1, 0)')
+    db.commit()
+
+def interleaved_sessions () :
+    print("REACTOR INTERLEAVED TRANSACTIONS TEST")
+
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    reset(db, cursor)
+
+    sessions = [get_connection(user=args.user, password=args.password) for _ in range(SESSIONS)]
+    cursors = [s.cursor() for s in sessions]
+    for c in cursors:
+        c.execute('BEGIN')
+
+    # Every session's transaction stays open while the others run statements
+    for step in range(3):
+        for n, c in enumerate(cursors):
+            c.execute('INSERT INTO ha_lineairdb_test.items (id, owner, content) '
+                      'VALUES (%s, %s, %s)', (n * 100 + step, n, f"s{n}-{step}"))
+            c.execute('SELECT id FROM ha_lineairdb_test.items FORCE INDEX (owner_idx) '
+                      'WHERE owner = %s ORDER BY id', (n,))
+            rows = c.fetchall()
+            if rows != [(n * 100 + k,) for k in range(step + 1)]:
+                print(f"\tCheck 1 Failed: session {n} does not read its own writes")
+                print("\t", rows)
+                return 1
+
+    # Odd sessions roll back, even ones commit
+    for n, s in enumerate(sessions):
+        if n % 2:
+            s.rollback()
+        else:
+            s.commit()
+        s.close()
+
+    cursor.execute('SELECT owner, COUNT(*) FROM ha_lineairdb_test.items GROUP BY owner ORDER BY owner')
+    rows = cursor.fetchall()
+    db.commit()
+    db.close()
+    expected = [(n, 3) for n in range(0, SESSIONS, 2)]
+    if rows != expected:
+        print("\tCheck 2 Failed: transactions were not all-or-nothing")
+        print("\t", rows)
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def increment (n) :
+    """Add 1 to the counter INCREMENTS times; return the commits that succeeded."""
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    commits = 0
+    for _ in range(INCREMENTS):
+        try:
+            cursor.execute('BEGIN')
+            cursor.execute('SELECT value FROM ha_lineairdb_test.counter WHERE id = 1')
+            value = cursor.fetchone()[0]
+            cursor.execute('UPDATE ha_lineairdb_test.counter SET value = %s WHERE id = 1', (value + 1,))
+            db.commit()
+            commits += 1
+        except mysql.connector.Error:
+            db.rollback()
+    db.close()
+    return commits
+
+def concurrent_increments () :
+    print("REACTOR CONCURRENT READ-MODIFY-WRITE TEST")
+
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+    reset(db, cursor)
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=WRITERS) as executor:
+        commits = sum(executor.map(increment, range(WRITERS)))
+
+    cursor.execute('SELECT value FROM ha_lineairdb_test.counter WHERE id = 1')
+    value = cursor.fetchone()[0]
+    db.commit()
+    db.close()
+    print(f"\t{commits} of {WRITERS * INCREMENTS} increments committed")
+    if value != commits:
+        print("\tCheck 1 Failed: lost or phantom update")
+        print("\t counter:", value, "commits:", commits)
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def main():
+    if not restart_services(*SERVER_ARGS):
+        print("\tFailed: server did not start")
+        sys.exit(1)
+
+    failed = 0
+    if interleaved_sessions() != 0:
+        failed += 1
+    if concurrent_increments() != 0:
+        failed += 1
+
+    if failed > 0:
+        print(f"\n{failed} test(s) failed")
+        sys.exit(1)
+
+    print("\nAll tests passed!")
+    sys.exit(0)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Connect to MySQL')
+    parser.add_argument('--user', metavar='user', type=str,
+                        help='name of user',
+                        default="root")
+    parser.add_argument('--password', metavar='pw', type=str,
+                        help='password for the user',
+                        default="")
+    args = parser.parse_args()
+    main()
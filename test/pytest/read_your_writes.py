@@ -0,0 +1,167 @@
+import sys
+import mysql.connector
+from utils.connection import get_connection
+import argparse
+
+# A read or scan right after buffered writes carries them to the server in
+# the same request, applied before the read. These tests check that the
+# transaction still sees its own writes, and nobody else sees them early.
+
+def reset (db, cursor) :
+    cursor.execute('DROP DATABASE IF EXISTS ha_lineairdb_test')
+    cursor.execute('CREATE DATABASE ha_lineairdb_test')
+    cursor.execute('CREATE TABLE ha_lineairdb_test.orders (\
+        id INT NOT NULL PRIMARY KEY,\
+        item VARCHAR(50) NOT NULL,\
+        qty INT NOT NULL,\
+        INDEX item_idx (item)\
+    ) ENGINE = LineairDB')
+    cursor.execute('CREATE TABLE ha_lineairdb_test.stock (\
+        item VARCHAR(50) NOT NULL PRIMARY KEY,\
+        qty INT NOT NULL\
+    ) ENGINE = LineairDB')
+    db.commit()
+
+def point_read_after_write (db, cursor) :
+    reset(db, cursor)
+    print("READ YOUR WRITES POINT READ TEST")
+
+    cursor.execute('INSERT INTO ha_lineairdb_test.stock (item, qty) VALUES ("apple", 10)')
+    db.commit()
+
+    print("\tTX1 BEGIN")
+    cursor.execute('BEGIN')
+    cursor.execute('INSERT INTO ha_lineairdb_test.orders (id, item, qty) VALUES (1, "apple", 3)')
+    cursor.execute('SELECT item, qty FROM ha_lineairdb_test.orders WHERE id = 1')
+    rows = cursor.fetchall()
+    if rows != [("apple", 3)]:
+        print("\tCheck 1 Failed")
+        print("\t", rows)
+        cursor.execute('ROLLBACK')
+        return 1
+
+    # NewOrder-like: a write to one table, then a read of another
+    cursor.execute('UPDATE ha_lineairdb_test.stock SET qty = qty - 3 WHERE item = "apple"')
+    cursor.execute('INSERT INTO ha_lineairdb_test.orders (id, item, qty) VALUES (2, "apple", 4)')
+    cursor.execute('SELECT qty FROM ha_lineairdb_test.stock WHERE item = "apple"')
+    rows = cursor.fetchall()
+    if rows != [(7,)]:
+        print("\tCheck 2 Failed")
+        print("\t", rows)
+        cursor.execute('ROLLBACK')
+        return 1
+
+    cursor.execute('DELETE FROM ha_lineairdb_test.orders WHERE id = 1')
+    cursor.execute('SELECT id FROM ha_lineairdb_test.orders WHERE id = 1')
+    rows = cursor.fetchall()
+    if rows:
+        print("\tCheck 3 Failed")
+        print("\t", rows)
+        cursor.execute('ROLLBACK')
+        return 1
+
+    print("\tTX1 COMMIT")
+    cursor.execute('COMMIT')
+    db.commit()
+
+    cursor.execute('SELECT id, item, qty FROM ha_lineairdb_test.orders ORDER BY id')
+    rows = cursor.fetchall()
+    if rows != [(2, "apple", 4)]:
+        print("\tCheck 4 Failed")
+        print("\t", rows)
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def scan_after_write (db, cursor) :
+    reset(db, cursor)
+    print("READ YOUR WRITES SCAN TEST")
+
+    cursor.execute('INSERT INTO ha_lineairdb_test.orders (id, item, qty) VALUES '
+                   '(1, "apple", 1), (2, "pear", 2)')
+    db.commit()
+
+    print("\tTX1 BEGIN")
+    cursor.execute('BEGIN')
+    cursor.execute('INSERT INTO ha_lineairdb_test.orders (id, item, qty) VALUES (3, "apple", 3)')
+    cursor.execute('UPDATE ha_lineairdb_test.orders SET item = "apple" WHERE id = 2')
+
+    # Full scan and secondary-index scan both see the buffered rows
+    cursor.execute('SELECT id, qty FROM ha_lineairdb_test.orders ORDER BY id')
+    rows = cursor.fetchall()
+    if rows != [(1, 1), (2, 2), (3, 3)]:
+        print("\tCheck 1 Failed")
+        print("\t", rows)
+        cursor.execute('ROLLBACK')
+        return 1
+
+    cursor.execute('SELECT id FROM ha_lineairdb_test.orders FORCE INDEX (item_idx) '
+                   'WHERE item = "apple" ORDER BY id')
+    rows = cursor.fetchall()
+    if rows != [(1,), (2,), (3,)]:
+        print("\tCheck 2 Failed")
+        print("\t", rows)
+        cursor.execute('ROLLBACK')
+        return 1
+
+    # Another connection sees none of it before the commit
+    db2 = get_connection(user=args.user, password=args.password)
+    cursor2 = db2.cursor()
+    try:
+        cursor2.execute('SELECT id, item FROM ha_lineairdb_test.orders ORDER BY id')
+        rows = cursor2.fetchall()
+        db2.commit()
+    except mysql.connector.errors.DatabaseError as e:
+        # Precision Locking may abort the reader; it saw nothing then either
+        print(f"\ttx2 aborted: {e}")
+        rows = [(1, "apple"), (2, "pear")]
+    db2.close()
+    if rows != [(1, "apple"), (2, "pear")]:
+        print("\tCheck 3 Failed")
+        print("\t", rows)
+        cursor.execute('ROLLBACK')
+        return 1
+
+    print("\tTX1 ROLLBACK")
+    cursor.execute('ROLLBACK')
+    db.commit()
+
+    cursor.execute('SELECT id, item, qty FROM ha_lineairdb_test.orders ORDER BY id')
+    rows = cursor.fetchall()
+    if rows != [(1, "apple", 1), (2, "pear", 2)]:
+        print("\tCheck 4 Failed")
+        print("\t", rows)
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def main():
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+
+    failed = 0
+    if point_read_after_write(db, cursor) != 0:
+        failed += 1
+    if scan_after_write(db, cursor) != 0:
+        failed += 1
+
+    if failed > 0:
+        print(f"\n{failed} test(s) failed")
+        sys.exit(1)
+
+    print("\nAll tests passed!")
+    sys.exit(0)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Connect to MySQL')
+    parser.add_argument('--user', metavar='user', type=str,
+                        help='name of user',
+                        default="root")
+    parser.add_argument('--password', metavar='pw', type=str,
+                        help='password for the user',
+                        default="")
+    args = parser.parse_args()
+    main()
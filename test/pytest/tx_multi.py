@@ -0,0 +1,148 @@
+import sys
+import mysql.connector
+from utils.connection import get_connection
+import argparse
+
+# Writes inside a transaction are buffered by the proxy and sent to the
+# server as one TX_MULTI batch, executed there in order. These tests check
+# that a batch mixing tables, updates, deletes and secondary-index changes
+# leaves the same rows as running the statements one by one.
+
+def reset (db, cursor) :
+    cursor.execute('DROP DATABASE IF EXISTS ha_lineairdb_test')
+    cursor.execute('CREATE DATABASE ha_lineairdb_test')
+    cursor.execute('CREATE TABLE ha_lineairdb_test.accounts (\
+        id INT NOT NULL PRIMARY KEY,\
+        owner VARCHAR(50) NOT NULL,\
+        balance INT NOT NULL,\
+        INDEX owner_idx (owner)\
+    ) ENGINE = LineairDB')
+    cursor.execute('CREATE TABLE ha_lineairdb_test.history (\
+        id INT NOT NULL PRIMARY KEY,\
+        account INT NOT NULL,\
+        amount INT NOT NULL,\
+        INDEX account_idx (account)\
+    ) ENGINE = LineairDB')
+    db.commit()
+
+def owners (cursor, owner) :
+    cursor.execute('SELECT id FROM ha_lineairdb_test.accounts FORCE INDEX (owner_idx) '
+                   'WHERE owner = %s ORDER BY id', (owner,))
+    return [row[0] for row in cursor.fetchall()]
+
+def buffered_update_delete (db, cursor) :
+    reset(db, cursor)
+    print("TX_MULTI BUFFERED UPDATE AND DELETE TEST")
+
+    cursor.execute('INSERT INTO ha_lineairdb_test.accounts (id, owner, balance) VALUES '
+                   '(1, "alice", 100), (2, "bob", 200), (3, "carol", 300)')
+    db.commit()
+
+    print("\tTX1 BEGIN")
+    cursor.execute('BEGIN')
+    cursor.execute('UPDATE ha_lineairdb_test.accounts SET balance = 150 WHERE id = 1')
+    cursor.execute('UPDATE ha_lineairdb_test.accounts SET owner = "dave" WHERE id = 2')
+    cursor.execute('DELETE FROM ha_lineairdb_test.accounts WHERE id = 3')
+    cursor.execute('INSERT INTO ha_lineairdb_test.accounts (id, owner, balance) '
+                   'VALUES (4, "alice", 400)')
+    print("\tTX1 COMMIT")
+    cursor.execute('COMMIT')
+    db.commit()
+
+    cursor.execute('SELECT id, owner, balance FROM ha_lineairdb_test.accounts ORDER BY id')
+    rows = cursor.fetchall()
+    expected = [(1, "alice", 150), (2, "dave", 200), (4, "alice", 400)]
+    if rows != expected:
+        print("\tCheck 1 Failed")
+        print("\t", rows)
+        return 1
+
+    # The secondary index must follow the update and the delete
+    if owners(cursor, "alice") != [1, 4] or owners(cursor, "dave") != [2] \
+            or owners(cursor, "bob") != [] or owners(cursor, "carol") != []:
+        print("\tCheck 2 Failed")
+        print("\t", owners(cursor, "alice"), owners(cursor, "dave"),
+              owners(cursor, "bob"), owners(cursor, "carol"))
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def mixed_table_ordering (db, cursor) :
+    reset(db, cursor)
+    print("TX_MULTI MIXED TABLE ORDERING TEST")
+
+    cursor.execute('INSERT INTO ha_lineairdb_test.accounts (id, owner, balance) VALUES '
+                   '(1, "alice", 100), (2, "bob", 200)')
+    db.commit()
+
+    # Writes alternate between the tables and hit the same keys more than
+    # once; only the last write of each key may survive
+    print("\tTX1 BEGIN")
+    cursor.execute('BEGIN')
+    cursor.execute('UPDATE ha_lineairdb_test.accounts SET balance = balance - 30 WHERE id = 1')
+    cursor.execute('INSERT INTO ha_lineairdb_test.history (id, account, amount) VALUES (1, 1, -30)')
+    cursor.execute('UPDATE ha_lineairdb_test.accounts SET balance = balance + 30 WHERE id = 2')
+    cursor.execute('INSERT INTO ha_lineairdb_test.history (id, account, amount) VALUES (2, 2, 30)')
+    cursor.execute('DELETE FROM ha_lineairdb_test.history WHERE id = 1')
+    cursor.execute('INSERT INTO ha_lineairdb_test.history (id, account, amount) VALUES (1, 1, -31)')
+    cursor.execute('UPDATE ha_lineairdb_test.accounts SET balance = balance - 1 WHERE id = 1')
+    cursor.execute('INSERT INTO ha_lineairdb_test.history (id, account, amount) VALUES (3, 2, 5)')
+    cursor.execute('DELETE FROM ha_lineairdb_test.history WHERE id = 3')
+    print("\tTX1 COMMIT")
+    cursor.execute('COMMIT')
+    db.commit()
+
+    cursor.execute('SELECT id, owner, balance FROM ha_lineairdb_test.accounts ORDER BY id')
+    rows = cursor.fetchall()
+    if rows != [(1, "alice", 69), (2, "bob", 230)]:
+        print("\tCheck 1 Failed")
+        print("\t", rows)
+        return 1
+
+    cursor.execute('SELECT id, account, amount FROM ha_lineairdb_test.history ORDER BY id')
+    rows = cursor.fetchall()
+    if rows != [(1, 1, -31), (2, 2, 30)]:
+        print("\tCheck 2 Failed")
+        print("\t", rows)
+        return 1
+
+    cursor.execute('SELECT id FROM ha_lineairdb_test.history FORCE INDEX (account_idx) '
+                   'WHERE account = 2 ORDER BY id')
+    rows = cursor.fetchall()
+    if rows != [(2,)]:
+        print("\tCheck 3 Failed")
+        print("\t", rows)
+        return 1
+
+    print("\tPassed!")
+    return 0
+
+def main():
+    db = get_connection(user=args.user, password=args.password)
+    cursor = db.cursor()
+
+    failed = 0
+    if buffered_update_delete(db, cursor) != 0:
+        failed += 1
+    if mixed_table_ordering(db, cursor) != 0:
+        failed += 1
+
+    if failed > 0:
+        print(f"\n{failed} test(s) failed")
+        sys.exit(1)
+
+    print("\nAll tests passed!")
+    sys.exit(0)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Connect to MySQL')
+    parser.add_argument('--user', metavar='user', type=str,
+                        help='name of user',
+                        default="root")
+    parser.add_argument('--password', metavar='pw', type=str,
+                        help='password for the user',
+                        default="")
+    args = parser.parse_args()
+    main()
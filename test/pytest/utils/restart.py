@@ -0,0 +1,51 @@
+"""Restart lineairdb-server (and MySQL in front of it) from inside a test."""
+
+import os
+import socket
+import time
+
+ROOT_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", "..", ".."))
+SERVER_HOST = "127.0.0.1"
+MYSQLD_PORT = "3307"
+SERVER_PORT = 9999
+PID_FILE = "/tmp/lineairdb_server.pid"
+QUIET = "> /dev/null 2>&1"
+
+
+def script(name: str) -> str:
+    return os.path.join(ROOT_DIR, "scripts", name)
+
+
+def wait_for_server(timeout: float = 120.0) -> bool:
+    """Wait until the server accepts connections (after recovery or loading)."""
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            with socket.create_connection((SERVER_HOST, SERVER_PORT), timeout=1):
+                return True
+        except OSError:
+            time.sleep(0.2)
+    return False
+
+
+def crash_server() -> None:
+    """Stop MySQL, then kill -9 the server: nothing is flushed on the way out."""
+    os.system(f"{script('stop_mysql.sh')} {QUIET}")
+    os.system(f"{script('stop_server.sh')} {QUIET}")
+    time.sleep(1)
+
+
+def restart_services(*server_args: str) -> bool:
+    """Crash the server and start it again with server_args, then MySQL."""
+    crash_server()
+    os.system(f"{script('start_server.sh')} {' '.join(server_args)} {QUIET}")
+    if not wait_for_server():
+        return False
+    os.system(f"{script('start_mysql.sh')} --mysqld-port {MYSQLD_PORT} "
+              f"--server-host {SERVER_HOST} --server-port {SERVER_PORT} {QUIET}")
+    return True
+
+
+def server_pid() -> int:
+    with open(PID_FILE) as f:
+        return int(f.read().strip())